@@ -0,0 +1,362 @@
+//
+//  EMBenchmarks.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#import "EMDisplayWidth.h"
+#import "EMFileDigest.h"
+#import "EMListCommand.h"
+#import "EMTunnelListView.h"
+#import "EMTunnelSnapshot.h"
+#import "EMUpdateFeed.h"
+#import "EMUtils.h"
+#import "EMVersion.h"
+#import "EMWindowBuffer.h"
+
+
+// libmalloc invokes this hook for every allocation (it's how malloc stack logging is implemented)
+typedef void (_EMMallocLogger)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numberOfFramesToSkip);
+extern _EMMallocLogger *malloc_logger;
+
+#define EM_MALLOC_LOG_TYPE_ALLOCATE 2
+
+static _Atomic uint64_t _EMBenchmarkAllocations = 0;
+
+static void _EMBenchmarkMallocLogger(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numberOfFramesToSkip) {
+    if (type & EM_MALLOC_LOG_TYPE_ALLOCATE) {
+        atomic_fetch_add_explicit(&_EMBenchmarkAllocations, 1, memory_order_relaxed);
+    }
+}
+
+static NSMutableDictionary<NSString*,NSDictionary*> *_EMBenchmarkResults = nil;
+static NSDictionary<NSString*,NSDictionary*> *_EMBenchmarkBaseline = nil;
+
+
+/*!
+ Benchmarks for the CLI's hot paths, reporting nanoseconds and allocations per operation.
+ 
+ Results are logged, and written as JSON to the path in EM_BENCHMARK_OUTPUT (if set). When EM_BENCHMARK_BASELINE points to the
+ results of a previous run, benchmarks fail if they're slower (or allocate more) than the baseline by more than EM_BENCHMARK_THRESHOLD,
+ which defaults to 0.1 (10%). Use `make benchmark` to run them with an optimized build.
+ */
+@interface EMBenchmarks : XCTestCase
+@end
+
+@implementation EMBenchmarks
+
++ (void)setUp {
+    _EMBenchmarkResults = [NSMutableDictionary dictionary];
+    
+    NSString *baselinePath = NSProcessInfo.processInfo.environment[@"EM_BENCHMARK_BASELINE"];
+    if (baselinePath.length > 0) {
+        NSData *data = [NSData dataWithContentsOfFile:baselinePath];
+        NSDictionary *baseline = data != nil ? [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL] : nil;
+        
+        if (![baseline isKindOfClass:[NSDictionary class]] || ![baseline[@"benchmarks"] isKindOfClass:[NSDictionary class]]) {
+            NSLog(@"Could not read benchmark baseline at %@", baselinePath);
+        } else {
+            _EMBenchmarkBaseline = baseline[@"benchmarks"];
+        }
+    }
+}
+
++ (void)tearDown {
+    NSString *outputPath = NSProcessInfo.processInfo.environment[@"EM_BENCHMARK_OUTPUT"];
+    
+    if (outputPath.length > 0 && _EMBenchmarkResults.count > 0) {
+        NSDictionary *payload = @{@"version": EMVersionDescription(EMVersionEmbedded()),
+                                  @"date": @((NSInteger)[NSDate date].timeIntervalSince1970),
+                                  @"benchmarks": _EMBenchmarkResults};
+        
+        NSData *data = [NSJSONSerialization dataWithJSONObject:payload options:NSJSONWritingPrettyPrinted|NSJSONWritingSortedKeys error:NULL];
+        [data writeToFile:outputPath atomically:YES];
+    }
+}
+
+- (void)setUp {
+    self.continueAfterFailure = YES;
+    YDCommandOutputStyleDisabled = NO;
+}
+
+#pragma mark - Harness
+
+/*!
+ Measure an operation, scaling the number of iterations so that each sample runs for a meaningful amount of time.
+ The median of several samples is reported to reduce noise from other processes.
+ */
+- (void)_benchmark:(NSString *)name block:(void(^)(void))block {
+    const uint64_t sampleDuration = 50 * NSEC_PER_MSEC;
+    const NSUInteger numberOfSamples = 7;
+    
+    uint64_t(^run)(NSUInteger, uint64_t*) = ^uint64_t(NSUInteger iterations, uint64_t *outAllocations) {
+        uint64_t allocations = atomic_load_explicit(&_EMBenchmarkAllocations, memory_order_relaxed);
+        uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        
+        for (NSUInteger i = 0; i < iterations; i++) {
+            @autoreleasepool {
+                block();
+            }
+        }
+        
+        uint64_t duration = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+        
+        if (outAllocations != NULL) {
+            (*outAllocations) = atomic_load_explicit(&_EMBenchmarkAllocations, memory_order_relaxed) - allocations;
+        }
+        
+        return duration;
+    };
+    
+    // Warm up caches, and find how many iterations fit within a sample
+    NSUInteger iterations = 1;
+    uint64_t duration;
+    
+    while ((duration = run(iterations, NULL)) < sampleDuration / 10 && iterations < (1 << 24)) {
+        iterations *= 2;
+    }
+    
+    iterations = MAX(1, (NSUInteger)((double)iterations * sampleDuration / MAX(duration, 1)));
+    
+    double nsPerOp[numberOfSamples], allocsPerOp[numberOfSamples];
+    
+    malloc_logger = _EMBenchmarkMallocLogger;
+    
+    for (NSUInteger i = 0; i < numberOfSamples; i++) {
+        uint64_t allocations = 0;
+        nsPerOp[i] = (double)run(iterations, &allocations) / iterations;
+        allocsPerOp[i] = (double)allocations / iterations;
+    }
+    
+    malloc_logger = NULL;
+    
+    qsort_b(nsPerOp, numberOfSamples, sizeof(double), ^int(const void *a, const void *b) {
+        return *(double *)a < *(double *)b ? -1 : (*(double *)a > *(double *)b ? 1 : 0);
+    });
+    
+    // Allocations are mostly deterministic; the minimum excludes allocations made by other threads
+    double minAllocsPerOp = allocsPerOp[0];
+    for (NSUInteger i = 1; i < numberOfSamples; i++) {
+        minAllocsPerOp = MIN(minAllocsPerOp, allocsPerOp[i]);
+    }
+    
+    NSDictionary *result = @{@"ns_per_op": @(round(nsPerOp[numberOfSamples / 2] * 10) / 10),
+                             @"allocs_per_op": @(round(minAllocsPerOp * 10) / 10),
+                             @"iterations": @(iterations)};
+    
+    _EMBenchmarkResults[name] = result;
+    
+    NSDictionary *baseline = _EMBenchmarkBaseline[name];
+    if (![baseline isKindOfClass:[NSDictionary class]]) {
+        NSLog(@"%@: %.1f ns/op, %.1f allocs/op", name, [result[@"ns_per_op"] doubleValue], [result[@"allocs_per_op"] doubleValue]);
+        return;
+    }
+    
+    double threshold = NSProcessInfo.processInfo.environment[@"EM_BENCHMARK_THRESHOLD"].doubleValue ?: 0.1;
+    double timeDelta = [result[@"ns_per_op"] doubleValue] / MAX([baseline[@"ns_per_op"] doubleValue], 1) - 1;
+    double allocsDelta = [result[@"allocs_per_op"] doubleValue] - [baseline[@"allocs_per_op"] doubleValue];
+    
+    NSLog(@"%@: %.1f ns/op (%+.1f%%), %.1f allocs/op (%+.1f)", name, [result[@"ns_per_op"] doubleValue], timeDelta * 100, [result[@"allocs_per_op"] doubleValue], allocsDelta);
+    
+    XCTAssertLessThanOrEqual(timeDelta, threshold, @"%@ is %.1f%% slower than the baseline", name, timeDelta * 100);
+    XCTAssertLessThanOrEqual(allocsDelta, MAX(1, [baseline[@"allocs_per_op"] doubleValue] * threshold), @"%@ allocates %.1f more times per op than the baseline", name, allocsDelta);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testSources {
+    NSArray<NSString*> *inputs = @[@"8080", @"localhost:3000", @"http://localhost:8080/path", @"https://emporter.app/docs", @"~/Sites/blog",
+                                   @"./public", @"7A1C1C55-1B0C-4F5B-9C0A-4C6F5D0C8A01"];
+    NSUInteger count = inputs.count;
+    __block NSUInteger i = 0;
+    
+    [self _benchmark:@"EMSourceTypeGuess" block:^{
+        EMSourceTypeGuess(inputs[i++ % count]);
+    }];
+    
+    [self _benchmark:@"EMSourceURLFromString" block:^{
+        NSString *input = inputs[i++ % count];
+        EMSourceURLFromString(input, EMSourceTypeGuess(input));
+    }];
+}
+
+- (void)testVersions {
+    NSArray<NSString*> *inputs = @[@"0.4.1", @"v8.8.0-rc2", @"1.0.0-beta.11", @"12.3", @"2.0.0"];
+    NSUInteger count = inputs.count;
+    __block NSUInteger i = 0;
+    
+    [self _benchmark:@"EMVersionFromString" block:^{
+        EMVersionFromString(inputs[i++ % count]);
+    }];
+    
+    EMVersion versionValues[] = {EMVersionFromString(@"0.4.1"), EMVersionFromString(@"8.8.0-rc2"), EMVersionFromString(@"8.8.0-rc1"), EMVersionFromString(@"8.8.0")};
+    EMVersion *versions = versionValues;
+    __block NSUInteger j = 0;
+    
+    [self _benchmark:@"EMVersionCompare" block:^{
+        EMVersionCompare(versions[j % 4], versions[(j + 1) % 4]);
+        j++;
+    }];
+}
+
+- (void)testListTunnels {
+    const NSUInteger count = 10000;
+    NSMutableArray<EMTunnelSnapshot*> *tunnels = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *name = [NSString stringWithFormat:@"site-%lu", i];
+        NSMutableDictionary *values = [@{@"id": [NSUUID UUID].UUIDString, @"name": name, @"isEnabled": @YES,
+                                         @"remoteUrl": [NSString stringWithFormat:@"https://%@.emporter.eu", (i % 5 == 0) ? @"random-name" : name]} mutableCopy];
+        
+        if (i % 2 == 0) {
+            values[@"kind"] = @(EmporterTunnelKindProxy);
+            values[@"proxyPort"] = @(10000 + i);
+        } else {
+            values[@"kind"] = @(EmporterTunnelKindDirectory);
+            values[@"directory"] = [NSURL fileURLWithPath:[NSString stringWithFormat:@"/Users/test/Sites/%@", name] isDirectory:YES];
+        }
+        
+        switch (i % 4) {
+            case 0: values[@"state"] = @(EmporterTunnelStateConnected); break;
+            case 1: values[@"state"] = @(EmporterTunnelStateConnecting); break;
+            case 2: values[@"state"] = @(EmporterTunnelStateDisconnected); break;
+            default:
+                values[@"state"] = @(EmporterTunnelStateConflicted);
+                values[@"conflictReason"] = @"Address already in use";
+                break;
+        }
+        
+        [tunnels addObject:[[EMTunnelSnapshot alloc] initWithValues:values]];
+    }
+    
+    [self _benchmark:@"EMListCommand.writeTunnels(10k)" block:^{
+        [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+            [EMListCommand writeTunnels:tunnels toOutput:output];
+        }];
+    }];
+    
+    // A frame of the run window only writes the rows which fit in the terminal
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = tunnels;
+    listView.scrollOffset = tunnels.count / 2;
+    
+    [self _benchmark:@"EMTunnelListView.write(10k, 50 lines)" block:^{
+        [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+            [listView writeToOutput:output numberOfLines:50];
+        }];
+    }];
+}
+
+- (void)testWindowWriter {
+    EMWindowSpanBuffer *arena = [[EMWindowSpanBuffer alloc] init];
+    EMWindowSpanBuffer *source = [arena bufferWithSharedArena];
+    
+    // Wide lines with a style run every few characters, mixing ASCII with double-width and combined characters
+    NSArray<NSString*> *words = @[@"emporter ", @"連接済み ", @"https://emporter.eu ", @"café ", @"🚀 ", @"[conflicted] ", @"ÅÄÖ "];
+    
+    YDCommandOutputStyle styles[] = {
+        YDCommandOutputStyleMake(YDCommandOutputStyleColorWhite, YDCommandOutputStyleColorGreen, YDCommandOutputStyleAttributeBold),
+        YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeUnderline),
+        YDCommandOutputStyleMake(YDCommandOutputStyleColorBlack, YDCommandOutputStyleColorYellow, YDCommandOutputStyleAttributeNormal),
+        0,
+        YDCommandOutputStyleMake(YDCommandOutputStyleColorWhite, YDCommandOutputStyleColorRed, YDCommandOutputStyleAttributeInvert),
+    };
+    
+    for (NSUInteger line = 0; line < 40; line++) {
+        for (NSUInteger i = 0; i < 60; i++) {
+            [source appendString:words[(line + i) % words.count] withStyle:styles[i % 5]];
+        }
+        
+        [source appendString:@"\n" withStyle:0];
+    }
+    
+    [self _benchmark:@"EMWindowWriter.truncation" block:^{
+        EMWindowSpanBuffer *frame = [arena bufferWithSharedArena];
+        [frame appendBuffer:source truncatedToWidth:80];
+        (void)frame.lines;
+    }];
+    
+    [self _benchmark:@"EMWindowWriter.alignment" block:^{
+        EMWindowSpanBuffer *frame = [arena bufferWithSharedArena];
+        [frame appendBuffer:source withAlignment:EMWindowTextAlignmentCenter width:120];
+        (void)frame.lines;
+    }];
+}
+
+- (void)testDisplayWidth {
+    // 64KB of printable ASCII (i.e. URLs and paths), and the same length of text mixing ASCII, wide characters and emoji
+    NSMutableString *ascii = [NSMutableString string];
+    NSMutableString *mixed = [NSMutableString string];
+    
+    while (ascii.length < 64 * 1024) {
+        [ascii appendString:@"https://emporter.eu/Users/test/Sites/site-0 "];
+    }
+    
+    while ([mixed lengthOfBytesUsingEncoding:NSUTF8StringEncoding] < 64 * 1024) {
+        [mixed appendString:@"emporter 連接済み café 🚀 👨‍👩‍👧 🇸🇪 "];
+    }
+    
+    NSData *asciiData = [ascii dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *mixedData = [mixed dataUsingEncoding:NSUTF8StringEncoding];
+    
+    [self _benchmark:@"EMDisplayWidth(ASCII, 64KB)" block:^{
+        EMDisplayWidthOfUTF8(asciiData.bytes, asciiData.length);
+    }];
+    
+    [self _benchmark:@"EMDisplayWidth(mixed, 64KB)" block:^{
+        EMDisplayWidthOfUTF8(mixedData.bytes, mixedData.length);
+    }];
+}
+
+- (void)testFileDigest {
+    // A file about the size of a universal build of the CLI
+    NSURL *tempDir = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    NSURL *fileURL = [tempDir URLByAppendingPathComponent:@"emporter"];
+    NSURL *cacheURL = [tempDir URLByAppendingPathComponent:@"Digests"];
+    
+    NSMutableData *data = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    arc4random_buf(data.mutableBytes, data.length);
+    
+    XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtURL:tempDir withIntermediateDirectories:YES attributes:nil error:NULL]);
+    XCTAssertTrue([data writeToURL:fileURL atomically:NO]);
+    
+    int fd = open(fileURL.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    
+    [self _benchmark:@"EMFileDigestOfDescriptor(16MB)" block:^{
+        EMFileDigest digest;
+        EMFileDigestOfDescriptor(fd, data.length, &digest);
+    }];
+    
+    close(fd);
+    
+    [self _benchmark:@"EMFileDigestOfPath(16MB, cached)" block:^{
+        EMFileDigest digest;
+        EMFileDigestOfPath(fileURL.fileSystemRepresentation, cacheURL.fileSystemRepresentation, &digest, NULL);
+    }];
+    
+    [[NSFileManager defaultManager] removeItemAtURL:tempDir error:NULL];
+}
+
+- (void)testUpdateFeed {
+    NSData *data = [NSData dataWithContentsOfURL:[[NSBundle bundleForClass:[self class]] URLForResource:@"Data/GitHub/libvips" withExtension:@"json"]];
+    XCTAssertNotNil(data);
+    
+    [self _benchmark:@"EMUpdateFeed.updatesFromData" block:^{
+        [EMUpdateFeed updatesFromData:data type:EMUpdateTypeGitHubRelease options:0 error:NULL];
+    }];
+    
+    [self _benchmark:@"EMUpdateFeed.updatesFromData(latest)" block:^{
+        [EMUpdateFeed updatesFromData:data type:EMUpdateTypeGitHubRelease options:EMUpdateFeedReadingOmitsBody error:NULL];
+    }];
+}
+
+@end
@@ -0,0 +1,158 @@
+//
+//  EMBinaryPatchTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <bzlib.h>
+
+#import "EMBinaryPatch.h"
+
+
+static void _EMAppendOffset(NSMutableData *data, int64_t value) {
+    uint64_t magnitude = value < 0 ? (uint64_t)(-value) : (uint64_t)value;
+    uint8_t bytes[8];
+    
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (uint8_t)(magnitude >> (i * 8));
+    }
+    
+    if (value < 0) {
+        bytes[7] |= 0x80;
+    }
+    
+    [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+static NSData *_EMBZ2Data(NSData *data) {
+    unsigned int length = (unsigned int)(data.length + data.length / 100 + 600);
+    NSMutableData *output = [NSMutableData dataWithLength:length];
+    
+    BZ2_bzBuffToBuffCompress(output.mutableBytes, &length, (char *)data.bytes, (unsigned int)data.length, 9, 0, 0);
+    output.length = length;
+    
+    return output;
+}
+
+/*! Create a patch (BSDIFF40) from control tuples of (add, copy, seek) and their diff/extra blocks */
+static NSData *_EMCreatePatch(NSArray<NSArray<NSNumber*>*> *controls, NSData *diff, NSData *extra, int64_t newLength) {
+    NSMutableData *control = [NSMutableData data];
+    for (NSArray<NSNumber*> *tuple in controls) {
+        for (NSNumber *value in tuple) {
+            _EMAppendOffset(control, value.longLongValue);
+        }
+    }
+    
+    NSData *compressedControl = _EMBZ2Data(control);
+    NSData *compressedDiff = _EMBZ2Data(diff);
+    
+    NSMutableData *patch = [[@"BSDIFF40" dataUsingEncoding:NSASCIIStringEncoding] mutableCopy];
+    _EMAppendOffset(patch, (int64_t)compressedControl.length);
+    _EMAppendOffset(patch, (int64_t)compressedDiff.length);
+    _EMAppendOffset(patch, newLength);
+    
+    [patch appendData:compressedControl];
+    [patch appendData:compressedDiff];
+    [patch appendData:_EMBZ2Data(extra)];
+    
+    return patch;
+}
+
+static NSData *_EMRandomData(NSUInteger length) {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    arc4random_buf(data.mutableBytes, length);
+    return data;
+}
+
+
+@interface EMBinaryPatchTests : XCTestCase
+@end
+
+@implementation EMBinaryPatchTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+- (void)testApply {
+    NSData *base = _EMRandomData(64 * 1024);
+    NSMutableData *expected = [base mutableCopy];
+    
+    // Change a few bytes and append new ones
+    uint8_t *expectedBytes = expected.mutableBytes;
+    for (NSUInteger i = 0; i < expected.length; i += 997) {
+        expectedBytes[i] ^= 0x5a;
+    }
+    
+    NSData *extra = _EMRandomData(1000);
+    [expected appendData:extra];
+    
+    NSMutableData *diff = [NSMutableData dataWithLength:base.length];
+    uint8_t *diffBytes = diff.mutableBytes;
+    for (NSUInteger i = 0; i < base.length; i++) {
+        diffBytes[i] = (uint8_t)(expectedBytes[i] - ((const uint8_t *)base.bytes)[i]);
+    }
+    
+    NSData *patch = _EMCreatePatch(@[@[@(base.length), @(extra.length), @0]], diff, extra, (int64_t)expected.length);
+    
+    NSError *error = nil;
+    NSData *result = EMBinaryPatchApply(base, patch, &error);
+    
+    XCTAssertNotNil(result, @"%@", error);
+    XCTAssertEqualObjects(result, expected);
+}
+
+- (void)testApplyWithNegativeSeek {
+    NSData *base = _EMRandomData(4096);
+    NSData *extra = [@"xyz" dataUsingEncoding:NSASCIIStringEncoding];
+    
+    // Reorder the base: base[1000..<2000] + "xyz" + base[0..<500]
+    NSMutableData *expected = [[base subdataWithRange:NSMakeRange(1000, 1000)] mutableCopy];
+    [expected appendData:extra];
+    [expected appendData:[base subdataWithRange:NSMakeRange(0, 500)]];
+    
+    NSArray *controls = @[@[@0, @0, @1000], @[@1000, @3, @(-2000)], @[@500, @0, @0]];
+    NSData *patch = _EMCreatePatch(controls, [NSMutableData dataWithLength:1500], extra, (int64_t)expected.length);
+    
+    NSError *error = nil;
+    NSData *result = EMBinaryPatchApply(base, patch, &error);
+    
+    XCTAssertNotNil(result, @"%@", error);
+    XCTAssertEqualObjects(result, expected);
+}
+
+- (void)testCorruptPatch {
+    NSData *base = _EMRandomData(1024);
+    NSData *patch = _EMCreatePatch(@[@[@(base.length), @0, @0]], [NSMutableData dataWithLength:base.length], [NSData data], (int64_t)base.length);
+    NSError *error = nil;
+    
+    XCTAssertEqualObjects(EMBinaryPatchApply(base, patch, &error), base, @"%@", error);
+    
+    // Invalid header
+    NSMutableData *invalidHeader = [patch mutableCopy];
+    ((uint8_t *)invalidHeader.mutableBytes)[0] = 'X';
+    XCTAssertNil(EMBinaryPatchApply(base, invalidHeader, &error));
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+    
+    // Truncated
+    error = nil;
+    XCTAssertNil(EMBinaryPatchApply(base, [patch subdataWithRange:NSMakeRange(0, patch.length - 16)], &error));
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+    
+    // Control data which exceeds the new length
+    error = nil;
+    NSData *overflow = _EMCreatePatch(@[@[@(base.length), @0, @0]], [NSMutableData dataWithLength:base.length], [NSData data], (int64_t)base.length - 1);
+    XCTAssertNil(EMBinaryPatchApply(base, overflow, &error));
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+    
+    // Missing control data
+    error = nil;
+    NSData *incomplete = _EMCreatePatch(@[@[@(base.length / 2), @0, @0]], [NSMutableData dataWithLength:base.length / 2], [NSData data], (int64_t)base.length);
+    XCTAssertNil(EMBinaryPatchApply(base, incomplete, &error));
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+}
+
+@end
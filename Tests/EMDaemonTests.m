@@ -0,0 +1,156 @@
+//
+//  EMDaemonTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#import "EMDaemon.h"
+
+
+@interface EMDaemonTests : XCTestCase
+@property(nonatomic) NSString *socketPath;
+@property(nonatomic) dispatch_queue_t queue;
+@property(nonatomic) EMDaemonServer *server;
+@end
+
+@implementation EMDaemonTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    // Socket paths are limited in length, so avoid deep temporary directories
+    _socketPath = [NSString stringWithFormat:@"/tmp/em-%@.sock", [[NSUUID UUID].UUIDString substringToIndex:8]];
+    _queue = dispatch_queue_create("net.youngdynasty.emporter-cli.tests.daemon", NULL);
+    
+    // A stand-in for Emporter which echoes the request
+    _server = [[EMDaemonServer alloc] initWithSocketPath:_socketPath queue:_queue handler:^int(EMDaemonRequest *request) {
+        dprintf(request.standardOutput, "%s|%s|%d", [request.arguments componentsJoinedByString:@" "].UTF8String, request.currentDirectoryPath.fileSystemRepresentation, request.outputStyleDisabled);
+        dprintf(request.standardError, "err");
+        return (int)request.arguments.count;
+    }];
+}
+
+- (void)tearDown {
+    [_server stop];
+    unlink(_socketPath.fileSystemRepresentation);
+}
+
+- (NSString *)_readPipe:(int *)fds {
+    close(fds[1]);
+    
+    NSData *data = [[[NSFileHandle alloc] initWithFileDescriptor:fds[0] closeOnDealloc:YES] readDataToEndOfFile];
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+}
+
+- (void)testRoundTrip {
+    NSError *error = nil;
+    XCTAssertTrue([_server startWithError:&error], @"%@", error);
+    XCTAssertTrue([EMDaemonClient isListeningAtSocketPath:_socketPath]);
+    
+    int outFds[2], errFds[2];
+    XCTAssertEqual(pipe(outFds), 0);
+    XCTAssertEqual(pipe(errFds), 0);
+    
+    EMDaemonRequest *request = [[EMDaemonRequest alloc] initWithArguments:@[@"get", @"8080"]];
+    request.currentDirectoryPath = @"/tmp";
+    request.outputStyleDisabled = YES;
+    request.standardOutput = outFds[1];
+    request.standardError = errFds[1];
+    
+    int status = -1;
+    XCTAssertTrue([EMDaemonClient sendRequest:request toSocketAtPath:_socketPath status:&status error:&error], @"%@", error);
+    XCTAssertEqual(status, 2);
+    
+    // The server no longer holds the write end, so the pipes close with the client's copy
+    XCTAssertEqualObjects([self _readPipe:outFds], @"get 8080|/tmp|1");
+    XCTAssertEqualObjects([self _readPipe:errFds], @"err");
+}
+
+- (void)testNotRunning {
+    NSError *error = nil;
+    EMDaemonRequest *request = [[EMDaemonRequest alloc] initWithArguments:@[@"list"]];
+    
+    XCTAssertFalse([EMDaemonClient isListeningAtSocketPath:_socketPath]);
+    XCTAssertFalse([EMDaemonClient sendRequest:request toSocketAtPath:_socketPath status:NULL error:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, ENOENT);
+    
+    // Stopped servers remove their socket
+    XCTAssertTrue([_server startWithError:&error], @"%@", error);
+    [_server stop];
+    
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:_socketPath]);
+}
+
+- (void)testStaleSocket {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strlcpy(addr.sun_path, _socketPath.fileSystemRepresentation, sizeof(addr.sun_path));
+    
+    // Bind a socket without listening on it (as if its server had crashed)
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    XCTAssertEqual(bind(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    close(fd);
+    
+    NSError *error = nil;
+    XCTAssertFalse([EMDaemonClient sendRequest:[[EMDaemonRequest alloc] initWithArguments:@[]] toSocketAtPath:_socketPath status:NULL error:&error]);
+    XCTAssertEqual(error.code, ECONNREFUSED);
+    
+    XCTAssertTrue([_server startWithError:&error], @"%@", error);
+    XCTAssertTrue([EMDaemonClient isListeningAtSocketPath:_socketPath]);
+}
+
+- (void)testSingleInstance {
+    NSError *error = nil;
+    XCTAssertTrue([_server startWithError:&error], @"%@", error);
+    
+    EMDaemonServer *otherServer = [[EMDaemonServer alloc] initWithSocketPath:_socketPath queue:_queue handler:^int(EMDaemonRequest *request) {
+        return 0;
+    }];
+    
+    XCTAssertFalse([otherServer startWithError:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, EADDRINUSE);
+    
+    // The first server is unaffected
+    XCTAssertTrue([EMDaemonClient sendRequest:[[EMDaemonRequest alloc] initWithArguments:@[]] toSocketAtPath:_socketPath status:NULL error:&error], @"%@", error);
+}
+
+- (void)testSocketPathTooLong {
+    NSString *socketPath = [@"/tmp/" stringByAppendingString:[@"" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0]];
+    EMDaemonServer *server = [[EMDaemonServer alloc] initWithSocketPath:socketPath queue:_queue handler:^int(EMDaemonRequest *request) {
+        return 0;
+    }];
+    
+    NSError *error = nil;
+    XCTAssertFalse([server startWithError:&error]);
+    XCTAssertEqual(error.code, ENAMETOOLONG);
+}
+
+- (void)testPerformanceRequestLatency {
+    NSError *error = nil;
+    XCTAssertTrue([_server startWithError:&error], @"%@", error);
+    
+    int devNull = open("/dev/null", O_WRONLY);
+    EMDaemonRequest *request = [[EMDaemonRequest alloc] initWithArguments:@[@"list", @"--json"]];
+    request.standardOutput = devNull;
+    request.standardError = devNull;
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            int status = -1;
+            XCTAssertTrue([EMDaemonClient sendRequest:request toSocketAtPath:self.socketPath status:&status error:NULL]);
+            XCTAssertEqual(status, 2);
+        }
+    }];
+    
+    close(devNull);
+}
+
+@end
@@ -0,0 +1,115 @@
+//
+//  EMDisplayWidthTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMDisplayWidth.h"
+
+
+@interface EMDisplayWidthTests : XCTestCase
+@end
+
+@implementation EMDisplayWidthTests
+
+- (NSString *)_prefixOfString:(NSString *)string fittingWidth:(NSUInteger)maximumWidth width:(NSUInteger *)outWidth {
+    const char *bytes = string.UTF8String;
+    NSUInteger length = EMDisplayPrefixLengthOfUTF8(bytes, strlen(bytes), maximumWidth, outWidth);
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+}
+
+- (void)testASCII {
+    XCTAssertEqual(EMDisplayWidth(@""), 0);
+    XCTAssertEqual(EMDisplayWidth(@"a"), 1);
+    XCTAssertEqual(EMDisplayWidth(@"https://emporter.eu/Users/test/Sites"), 36);
+    
+    // Control characters aren't displayed, whether they're found by the fast path or not
+    XCTAssertEqual(EMDisplayWidth(@"abcdefgh\tijklmnop"), 16);
+    XCTAssertEqual(EMDisplayWidth(@"abc\x1b" "defghijklmnop\x7f"), 16);
+}
+
+- (void)testWideCharacters {
+    XCTAssertEqual(EMDisplayWidth(@"連接済み"), 8);
+    XCTAssertEqual(EMDisplayWidth(@"한국어"), 6);
+    XCTAssertEqual(EMDisplayWidth(@"ＡＢＣ"), 6);
+    XCTAssertEqual(EMDisplayWidth(@"ｱｲｳ"), 3);
+    XCTAssertEqual(EMDisplayWidth(@"✓ done"), 6);
+}
+
+- (void)testGraphemeClusters {
+    XCTAssertEqual(EMDisplayWidth(@"café"), 4);
+    XCTAssertEqual(EMDisplayWidth(@"cafe\u0301"), 4);
+    XCTAssertEqual(EMDisplayWidth(@"🚀"), 2);
+    XCTAssertEqual(EMDisplayWidth(@"👍🏽"), 2);
+    XCTAssertEqual(EMDisplayWidth(@"👨‍👩‍👧"), 2);
+    XCTAssertEqual(EMDisplayWidth(@"🇸🇪🇯🇵"), 4);
+    XCTAssertEqual(EMDisplayWidth(@"❤"), 1);
+    XCTAssertEqual(EMDisplayWidth(@"❤️"), 2);
+    
+    // ASCII following a joiner is part of the same cluster
+    XCTAssertEqual(EMDisplayWidth(@"🏳‍abcdefghijk"), 11);
+}
+
+- (void)testInvalidUTF8 {
+    // Truncated and overlong sequences are measured one byte at a time
+    const uint8_t bytes[] = { 'a', 0xff, 0xe3, 0x81, 'b', 0xc0, 0xaf };
+    XCTAssertEqual(EMDisplayWidthOfUTF8((const char *)bytes, sizeof(bytes)), 7);
+}
+
+- (void)testPrefixDoesNotSplitClusters {
+    NSUInteger width = 0;
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"abcdefghijklmnop" fittingWidth:10 width:&width], @"abcdefghij");
+    XCTAssertEqual(width, 10);
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"a連接" fittingWidth:2 width:&width], @"a");
+    XCTAssertEqual(width, 1);
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"cafe\u0301s" fittingWidth:4 width:&width], @"cafe\u0301");
+    XCTAssertEqual(width, 4);
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"a🇸🇪b" fittingWidth:2 width:&width], @"a");
+    XCTAssertEqual(width, 1);
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"ab❤️" fittingWidth:3 width:&width], @"ab");
+    XCTAssertEqual(width, 2);
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"👨‍👩‍👧x" fittingWidth:2 width:&width], @"👨‍👩‍👧");
+    XCTAssertEqual(width, 2);
+    
+    XCTAssertEqualObjects([self _prefixOfString:@"連接" fittingWidth:0 width:&width], @"");
+    XCTAssertEqual(width, 0);
+}
+
+- (void)testFastPathMatchesCodePoints {
+    // Measure every suffix of every prefix, so each byte is measured at each alignment of the fast path
+    NSString *string = @"https://emporter.eu/連接?q=café&x=🚀\t0123456789ABCDEF";
+    const char *bytes = string.UTF8String;
+    NSUInteger length = strlen(bytes);
+    
+    for (NSUInteger start = 0; start < length; start++) {
+        for (NSUInteger end = start; end <= length; end++) {
+            NSUInteger expectedWidth = 0;
+            
+            for (NSUInteger i = start; i < end; i++) {
+                expectedWidth += EMDisplayWidthOfUTF8(bytes + i, 1);
+            }
+            
+            // Only compare ranges of ASCII, since single bytes of multibyte characters are measured as invalid
+            BOOL isASCII = YES;
+            for (NSUInteger i = start; i < end && isASCII; i++) {
+                isASCII = (bytes[i] & 0x80) == 0;
+            }
+            
+            if (isASCII) {
+                XCTAssertEqual(EMDisplayWidthOfUTF8(bytes + start, end - start), expectedWidth);
+            }
+        }
+    }
+}
+
+@end
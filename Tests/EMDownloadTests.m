@@ -0,0 +1,189 @@
+//
+//  EMDownloadTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMDownload.h"
+#import "EMTestHTTPServer.h"
+
+
+@interface EMDownloadTests : XCTestCase
+@property(nonatomic) NSURL *tempDir;
+@property(nonatomic) EMDownloadCache *cache;
+@property(nonatomic) NSData *data;
+@property(nonatomic) EMTestHTTPServer *server;
+@end
+
+@implementation EMDownloadTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _tempDir = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    _cache = [[EMDownloadCache alloc] initWithDirectoryURL:_tempDir];
+    
+    NSMutableData *data = [NSMutableData dataWithLength:1024 * 1024];
+    arc4random_buf(data.mutableBytes, data.length);
+    _data = data;
+    
+    _server = [[EMTestHTTPServer alloc] initWithData:_data entityTag:@"\"1\""];
+    XCTAssertNotNil(_server);
+}
+
+- (void)tearDown {
+    [_server stop];
+    [[NSFileManager defaultManager] removeItemAtURL:_tempDir error:NULL];
+}
+
+- (NSURL *)_runDownload:(EMDownload *)download receivedData:(NSMutableData *)receivedData error:(NSError **)outError {
+    XCTestExpectation *downloadExpectation = [self expectationWithDescription:@"download"];
+    __block NSURL *downloadedFileURL = nil;
+    __block NSError *downloadError = nil;
+    
+    download.dataHandler = ^BOOL(NSData *data) {
+        [receivedData appendData:data];
+        return YES;
+    };
+    
+    [download startWithCompletionHandler:^(NSURL *fileURL, NSError *error) {
+        downloadedFileURL = fileURL;
+        downloadError = error;
+        [downloadExpectation fulfill];
+    }];
+    
+    [self waitForExpectations:@[downloadExpectation] timeout:10];
+    
+    if (outError != NULL) {
+        (*outError) = downloadError;
+    }
+    
+    return downloadedFileURL;
+}
+
+- (void)testDownload {
+    EMDownload *download = [[EMDownload alloc] initWithURL:_server.url cache:_cache];
+    NSMutableData *receivedData = [NSMutableData data];
+    NSError *error = nil;
+    
+    NSURL *fileURL = [self _runDownload:download receivedData:receivedData error:&error];
+    
+    XCTAssertNotNil(fileURL, @"%@", error);
+    XCTAssertEqualObjects(fileURL, [_cache fileURLForURL:_server.url]);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], _data);
+    XCTAssertEqualObjects(receivedData, _data);
+    XCTAssertEqual(download.numberOfCachedBytes, 0);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[_cache partialFileURLForURL:_server.url].path]);
+    
+    // Progress is measured in bytes
+    XCTAssertEqualObjects(download.progress.kind, NSProgressKindFile);
+    XCTAssertEqual(download.progress.totalUnitCount, (int64_t)_data.length);
+    XCTAssertEqual(download.progress.completedUnitCount, (int64_t)_data.length);
+    
+    // Completed downloads are read from the cache
+    download = [[EMDownload alloc] initWithURL:_server.url cache:_cache];
+    receivedData = [NSMutableData data];
+    
+    XCTAssertEqualObjects([self _runDownload:download receivedData:receivedData error:&error], fileURL, @"%@", error);
+    XCTAssertEqualObjects(receivedData, _data);
+    XCTAssertEqual(download.numberOfCachedBytes, _data.length);
+    XCTAssertEqual(_server.requestHeaders.count, 1);
+    XCTAssertEqual(download.progress.completedUnitCount, (int64_t)_data.length);
+    
+    [_cache removeFilesForURL:_server.url];
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:fileURL.path]);
+}
+
+- (void)testResumeAfterInterruption {
+    NSUInteger truncateAfterLength = 300 * 1024;
+    _server.truncateAfterLength = truncateAfterLength;
+    
+    EMDownload *download = [[EMDownload alloc] initWithURL:_server.url cache:_cache];
+    NSMutableData *receivedData = [NSMutableData data];
+    NSError *error = nil;
+    
+    XCTAssertNil([self _runDownload:download receivedData:receivedData error:&error]);
+    XCTAssertNotNil(error);
+    
+    NSData *partialData = [NSData dataWithContentsOfURL:[_cache partialFileURLForURL:_server.url]];
+    XCTAssertGreaterThan(partialData.length, 0);
+    XCTAssertLessThanOrEqual(partialData.length, truncateAfterLength);
+    XCTAssertEqualObjects(partialData, [_data subdataWithRange:NSMakeRange(0, partialData.length)]);
+    XCTAssertEqualObjects([_cache validatorForURL:_server.url], @"\"1\"");
+    
+    // The next attempt only requests what's missing, but the data handler sees the whole download
+    download = [[EMDownload alloc] initWithURL:_server.url cache:_cache];
+    receivedData = [NSMutableData data];
+    
+    NSURL *fileURL = [self _runDownload:download receivedData:receivedData error:&error];
+    
+    XCTAssertNotNil(fileURL, @"%@", error);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], _data);
+    XCTAssertEqualObjects(receivedData, _data);
+    XCTAssertEqual(download.numberOfCachedBytes, partialData.length);
+    XCTAssertEqual(download.progress.totalUnitCount, (int64_t)_data.length);
+    XCTAssertEqual(download.progress.completedUnitCount, (int64_t)_data.length);
+    
+    NSDictionary *headers = _server.requestHeaders.lastObject;
+    XCTAssertEqualObjects(headers[@"range"], ([NSString stringWithFormat:@"bytes=%lu-", (unsigned long)partialData.length]));
+    XCTAssertEqualObjects(headers[@"if-range"], @"\"1\"");
+}
+
+- (void)testRestartWhenEntityChanges {
+    _server.truncateAfterLength = 300 * 1024;
+    
+    NSError *error = nil;
+    XCTAssertNil([self _runDownload:[[EMDownload alloc] initWithURL:_server.url cache:_cache] receivedData:[NSMutableData data] error:&error]);
+    
+    // The server ignores the range since the entity tag no longer matches
+    NSMutableData *data = [NSMutableData dataWithLength:512 * 1024];
+    arc4random_buf(data.mutableBytes, data.length);
+    
+    _server.data = data;
+    _server.entityTag = @"\"2\"";
+    
+    EMDownload *download = [[EMDownload alloc] initWithURL:_server.url cache:_cache];
+    NSMutableData *receivedData = [NSMutableData data];
+    NSURL *fileURL = [self _runDownload:download receivedData:receivedData error:&error];
+    
+    XCTAssertNotNil(fileURL, @"%@", error);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], data);
+    XCTAssertEqualObjects(receivedData, data);
+    XCTAssertEqual(download.numberOfCachedBytes, 0);
+    XCTAssertNotNil(_server.requestHeaders.lastObject[@"range"]);
+}
+
+- (void)testCancelFromDataHandler {
+    EMDownload *download = [[EMDownload alloc] initWithURL:_server.url cache:_cache];
+    XCTestExpectation *downloadExpectation = [self expectationWithDescription:@"download"];
+    
+    download.dataHandler = ^BOOL(NSData *data) {
+        return NO;
+    };
+    
+    [download startWithCompletionHandler:^(NSURL *fileURL, NSError *error) {
+        XCTAssertNil(fileURL);
+        XCTAssertEqualObjects(error.domain, NSCocoaErrorDomain);
+        XCTAssertEqual(error.code, NSUserCancelledError);
+        [downloadExpectation fulfill];
+    }];
+    
+    [self waitForExpectations:@[downloadExpectation] timeout:10];
+    
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[_cache fileURLForURL:_server.url].path]);
+}
+
+- (void)testBadResponse {
+    NSURL *url = [_server.url URLByAppendingPathComponent:@"missing"];
+    NSError *error = nil;
+    
+    XCTAssertNil([self _runDownload:[[EMDownload alloc] initWithURL:url cache:_cache] receivedData:[NSMutableData data] error:&error]);
+    XCTAssertEqualObjects(error.domain, NSURLErrorDomain);
+    XCTAssertEqual(error.code, NSURLErrorBadServerResponse);
+}
+
+@end
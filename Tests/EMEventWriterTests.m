@@ -0,0 +1,327 @@
+//
+//  EMEventWriterTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <poll.h>
+
+#import "EMEventWriter.h"
+
+
+/*! Reads a pipe into memory from a background queue, optionally pausing between reads to simulate a slow consumer */
+@interface EMEventWriterTestReader : NSObject
+@property(nonatomic,readonly) int fileDescriptor;
+@property(nonatomic,readonly) NSMutableData *data;
+@end
+
+@implementation EMEventWriterTestReader {
+    int _readFd;
+    dispatch_group_t _group;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return nil;
+    }
+    
+    _readFd = fds[0];
+    _fileDescriptor = fds[1];
+    _data = [NSMutableData data];
+    _group = dispatch_group_create();
+    
+    return self;
+}
+
+- (void)startWithDelay:(useconds_t)delay {
+    int fd = _readFd;
+    NSMutableData *data = _data;
+    
+    dispatch_group_async(_group, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        char buffer[4096];
+        ssize_t count;
+        
+        while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+            [data appendBytes:buffer length:(NSUInteger)count];
+            
+            if (delay > 0) {
+                usleep(delay);
+            }
+        }
+    });
+}
+
+- (NSArray *)finish {
+    close(_fileDescriptor);
+    dispatch_group_wait(_group, DISPATCH_TIME_FOREVER);
+    close(_readFd);
+    
+    NSMutableArray *objects = [NSMutableArray array];
+    NSString *string = [[NSString alloc] initWithData:_data encoding:NSUTF8StringEncoding];
+    
+    for (NSString *line in [string componentsSeparatedByString:@"\n"]) {
+        if (line.length > 0) {
+            id object = [NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:NULL];
+            [objects addObject:object ?: [NSNull null]];
+        }
+    }
+    
+    return objects;
+}
+
+@end
+
+
+@interface EMEventWriterTests : XCTestCase
+@end
+
+@implementation EMEventWriterTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+- (void)testEncoding {
+    NSArray *objects = @[
+                         @{@"string": @"a \"quoted\" \\ string\nwith\tcontrol\x01 characters and ünïcødé 🚀",
+                           @"numbers": @[@0, @(-42), @(INT32_MAX), @(0.1), @(1e300), @(3.5f)],
+                           @"booleans": @[@YES, @NO],
+                           @"null": [NSNull null],
+                           @"nested": @{@"empty": @{}, @"array": @[]}},
+                         @[],
+                         @"",
+                         ];
+    
+    for (id object in objects) {
+        NSMutableData *data = [NSMutableData data];
+        EMEventWriterAppendJSONObject(data, object);
+        
+        NSError *error = nil;
+        id decoded = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:&error];
+        
+        XCTAssertNotNil(decoded, @"%@", error);
+        XCTAssertEqualObjects(decoded, object);
+    }
+    
+    // Booleans aren't numbers
+    NSMutableData *data = [NSMutableData data];
+    EMEventWriterAppendJSONObject(data, @[@YES, @1, @(1.5)]);
+    XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], @"[true,1,1.5]");
+}
+
+- (void)testEncodingUnusualStrings {
+    NSMutableData *data = [NSMutableData data];
+    
+    // Null characters don't end strings early
+    NSString *null = [NSString stringWithCharacters:(unichar[]){ 0 } length:1];
+    EMEventWriterAppendJSONObject(data, @[[NSString stringWithFormat:@"a%@b", null], [NSString stringWithFormat:@"ü%@🚀", null]]);
+    XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], @"[\"a\\u0000b\",\"ü\\u0000🚀\"]");
+    
+    // Unpaired surrogates can't be encoded as UTF-8, so they're replaced
+    unichar characters[] = {'a', 0xD83D, 'b'};
+    NSString *string = [NSString stringWithCharacters:characters length:3];
+    
+    data.length = 0;
+    EMEventWriterAppendJSONObject(data, string);
+    
+    id decoded = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:NULL];
+    XCTAssertEqualObjects(decoded, @"a?b");
+}
+
+- (void)testSequenceAndTimestamp {
+    EMEventWriterTestReader *reader = [[EMEventWriterTestReader alloc] init];
+    [reader startWithDelay:0];
+    
+    EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:reader.fileDescriptor capacity:64 * 1024];
+    uint64_t start = (uint64_t)([NSDate date].timeIntervalSince1970 * 1000);
+    
+    for (NSUInteger i = 0; i < 100; i++) {
+        XCTAssertEqual([writer writeEvent:@"url.state" data:@{@"_id": @(i)}], i + 1);
+    }
+    
+    [writer writeEvent:@"app.launch" data:nil];
+    [writer close];
+    
+    NSArray *events = [reader finish];
+    XCTAssertEqual(events.count, 101);
+    
+    uint64_t lastTimestamp = start;
+    
+    for (NSUInteger i = 0; i < 100; i++) {
+        NSDictionary *event = events[i];
+        
+        XCTAssertEqualObjects(event[@"seq"], @(i + 1));
+        XCTAssertEqualObjects(event[@"event"], @"url.state");
+        XCTAssertEqualObjects(event[@"data"], @{@"_id": @(i)});
+        
+        XCTAssertGreaterThanOrEqual([event[@"ts"] unsignedLongLongValue], lastTimestamp);
+        lastTimestamp = [event[@"ts"] unsignedLongLongValue];
+    }
+    
+    XCTAssertEqualObjects(events.lastObject, (@{@"seq": @101, @"ts": [events.lastObject objectForKey:@"ts"], @"event": @"app.launch"}));
+    XCTAssertEqual(writer.numberOfDroppedEvents, 0);
+}
+
+- (void)testBatching {
+    EMEventWriterTestReader *reader = [[EMEventWriterTestReader alloc] init];
+    [reader startWithDelay:0];
+    
+    EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:reader.fileDescriptor capacity:64 * 1024];
+    writer.batchInterval = 0.2;
+    
+    for (NSUInteger i = 0; i < 10; i++) {
+        [writer writeEvent:@"url.state" data:@{@"_id": @(i)}];
+    }
+    
+    [writer flush];
+    
+    [writer writeEvent:@"url.removed" data:@{@"_id": @"last"}];
+    [writer close];
+    
+    NSArray *batches = [reader finish];
+    XCTAssertEqual(batches.count, 2);
+    
+    NSArray *firstBatch = batches.firstObject;
+    XCTAssertTrue([firstBatch isKindOfClass:[NSArray class]]);
+    XCTAssertEqual(firstBatch.count, 10);
+    XCTAssertEqualObjects([firstBatch valueForKey:@"seq"], (@[@1, @2, @3, @4, @5, @6, @7, @8, @9, @10]));
+    
+    XCTAssertEqualObjects([batches.lastObject valueForKey:@"event"], @[@"url.removed"]);
+}
+
+- (void)testBatchIsWrittenEarlyWhenQueueFills {
+    int fds[2];
+    XCTAssertEqual(pipe(fds), 0);
+    
+    EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:fds[1] capacity:4096];
+    writer.batchInterval = 60;
+    
+    NSString *padding = [@"" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0];
+    
+    // Half of the queue is used, so the batch is written without waiting out the interval
+    for (NSUInteger i = 0; i < 12; i++) {
+        [writer writeEvent:@"url.state" data:@{@"padding": padding}];
+    }
+    
+    struct pollfd pfd = { .fd = fds[0], .events = POLLIN };
+    XCTAssertEqual(poll(&pfd, 1, 5000), 1);
+    
+    [writer close];
+    
+    XCTAssertEqual(writer.numberOfDroppedEvents, 0);
+    
+    close(fds[0]);
+    close(fds[1]);
+}
+
+- (void)testDropsWhenFull {
+    EMEventWriterTestReader *reader = [[EMEventWriterTestReader alloc] init];
+    EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:reader.fileDescriptor capacity:4096];
+    NSString *padding = [@"" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0];
+    
+    // Nothing is reading yet, so the pipe fills and then the queue fills
+    for (NSUInteger i = 0; i < 2000; i++) {
+        [writer writeEvent:@"url.state" data:@{@"padding": padding}];
+    }
+    
+    XCTAssertGreaterThan(writer.numberOfDroppedEvents, 0);
+    
+    [reader startWithDelay:0];
+    [writer flush];
+    
+    uint64_t lastSequence = [writer writeEvent:@"url.removed" data:nil];
+    [writer close];
+    
+    NSArray *events = [reader finish];
+    XCTAssertEqualObjects([events.lastObject objectForKey:@"seq"], @(lastSequence));
+    
+    // Gaps in sequence numbers account for every dropped event, and are reported before the next event
+    uint64_t previousSequence = 0;
+    uint64_t missingCount = 0;
+    uint64_t reportedCount = 0;
+    
+    for (NSDictionary *event in events) {
+        uint64_t sequence = [event[@"seq"] unsignedLongLongValue];
+        
+        XCTAssertGreaterThan(sequence, previousSequence);
+        missingCount += sequence - previousSequence - 1;
+        previousSequence = sequence;
+        
+        if ([event[@"event"] isEqualToString:@"events.dropped"]) {
+            reportedCount += [event[@"data"][@"count"] unsignedLongLongValue];
+        }
+    }
+    
+    XCTAssertEqual(missingCount, writer.numberOfDroppedEvents);
+    XCTAssertEqual(reportedCount, writer.numberOfDroppedEvents);
+}
+
+- (void)testClosedReader {
+    int fds[2];
+    XCTAssertEqual(pipe(fds), 0);
+    close(fds[0]);
+    
+    signal(SIGPIPE, SIG_IGN);
+    
+    // Writes fail (but don't block) once the reader has gone away
+    EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:fds[1] capacity:4096];
+    [writer writeEvent:@"app.launch" data:nil];
+    [writer flush];
+    [writer writeEvent:@"app.launch" data:nil];
+    [writer close];
+    
+    XCTAssertEqual(writer.numberOfDroppedEvents, 1);
+    
+    signal(SIGPIPE, SIG_DFL);
+    close(fds[1]);
+}
+
+- (void)testPerformanceSlowReader {
+    NSDictionary *data = @{@"_id": @"C8D2F0C4-0A3B-4E0F-9F5B-2D1A6E5C7B91", @"state": @"connected", @"conns": @12, @"rx": @(1024 * 1024), @"tx": @(4096)};
+    const NSUInteger count = 100000;
+    
+    uint64_t *latencies = malloc(sizeof(uint64_t) * count);
+    __block NSTimeInterval elapsed = 0;
+    __block uint64_t droppedCount = 0;
+    
+    [self measureBlock:^{
+        EMEventWriterTestReader *reader = [[EMEventWriterTestReader alloc] init];
+        [reader startWithDelay:50];
+        
+        EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:reader.fileDescriptor capacity:4 * 1024 * 1024];
+        NSDate *startDate = [NSDate date];
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+            [writer writeEvent:@"url.state" data:data];
+            latencies[i] = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+        }
+        
+        elapsed = -startDate.timeIntervalSinceNow;
+        droppedCount = writer.numberOfDroppedEvents;
+        
+        [writer close];
+        [reader finish];
+    }];
+    
+    qsort_b(latencies, count, sizeof(uint64_t), ^int(const void *a, const void *b) {
+        uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    });
+    
+    NSLog(@"%.0f events/sec, p50 %.2fus, p99 %.2fus enqueue latency, %llu dropped",
+          count / elapsed, latencies[count / 2] / 1000.0, latencies[count * 99 / 100] / 1000.0, droppedCount);
+    
+    free(latencies);
+}
+
+@end
@@ -0,0 +1,122 @@
+//
+//  EMFileDigestTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#import "EMFileDigest.h"
+
+
+@interface EMFileDigestTests : XCTestCase
+@property(nonatomic) NSURL *tempDir;
+@end
+
+@implementation EMFileDigestTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _tempDir = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtURL:_tempDir withIntermediateDirectories:YES attributes:nil error:NULL]);
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtURL:_tempDir error:NULL];
+}
+
+- (NSData *)_dataForDigest:(const EMFileDigest *)digest {
+    return [NSData dataWithBytes:digest->bytes length:EMFileDigestLength];
+}
+
+/*! The digest of data, calculated one chunk at a time */
+- (NSData *)_expectedDigestOfData:(NSData *)data {
+    uint64_t size = data.length;
+    NSMutableData *tree = [NSMutableData dataWithBytes:&size length:sizeof(size)];
+    
+    for (NSUInteger offset = 0; offset < data.length; offset += EMFileDigestChunkSize) {
+        EMFileDigest chunkDigest;
+        EMFileDigestOfBytes((const uint8_t *)data.bytes + offset, MIN(EMFileDigestChunkSize, data.length - offset), &chunkDigest);
+        [tree appendBytes:chunkDigest.bytes length:EMFileDigestLength];
+    }
+    
+    EMFileDigest digest;
+    EMFileDigestOfBytes(tree.bytes, tree.length, &digest);
+    
+    return [self _dataForDigest:&digest];
+}
+
+- (void)testDigestOfBytes {
+    EMFileDigest digest;
+    EMFileDigestOfBytes("abc", 3, &digest);
+    
+    const uint8_t expected[EMFileDigestLength] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+    };
+    
+    XCTAssertEqualObjects([self _dataForDigest:&digest], [NSData dataWithBytes:expected length:sizeof(expected)]);
+}
+
+- (void)testDigestOfFile {
+    NSURL *fileURL = [_tempDir URLByAppendingPathComponent:@"file"];
+    NSUInteger sizes[] = { 0, 1, EMFileDigestChunkSize - 1, EMFileDigestChunkSize, EMFileDigestChunkSize + 1, EMFileDigestChunkSize * 3 + 5 };
+    
+    for (NSUInteger i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        NSMutableData *data = [NSMutableData dataWithLength:sizes[i]];
+        arc4random_buf(data.mutableBytes, data.length);
+        XCTAssertTrue([data writeToURL:fileURL atomically:NO]);
+        
+        int fd = open(fileURL.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+        XCTAssertGreaterThanOrEqual(fd, 0);
+        
+        EMFileDigest digest;
+        XCTAssertTrue(EMFileDigestOfDescriptor(fd, data.length, &digest));
+        XCTAssertEqualObjects([self _dataForDigest:&digest], [self _expectedDigestOfData:data], @"%lu bytes", (unsigned long)sizes[i]);
+        
+        // Files which are shorter than expected can't be hashed
+        XCTAssertFalse(EMFileDigestOfDescriptor(fd, data.length + 1, &digest));
+        
+        close(fd);
+    }
+}
+
+- (void)testDigestCache {
+    NSURL *fileURL = [_tempDir URLByAppendingPathComponent:@"file"];
+    NSURL *cacheURL = [_tempDir URLByAppendingPathComponent:@"Cache/Digests"];
+    
+    NSMutableData *data = [NSMutableData dataWithLength:EMFileDigestChunkSize * 2];
+    arc4random_buf(data.mutableBytes, data.length);
+    XCTAssertTrue([data writeToURL:fileURL atomically:NO]);
+    
+    EMFileDigest digest, cachedDigest;
+    EMFileIdentity identity, cachedIdentity;
+    
+    XCTAssertTrue(EMFileDigestOfPath(fileURL.fileSystemRepresentation, cacheURL.fileSystemRepresentation, &digest, &identity));
+    XCTAssertEqualObjects([self _dataForDigest:&digest], [self _expectedDigestOfData:data]);
+    XCTAssertEqual(identity.size, data.length);
+    XCTAssertEqual([[NSFileManager defaultManager] contentsOfDirectoryAtPath:cacheURL.path error:NULL].count, 1);
+    
+    XCTAssertTrue(EMFileDigestOfPath(fileURL.fileSystemRepresentation, cacheURL.fileSystemRepresentation, &cachedDigest, &cachedIdentity));
+    XCTAssertTrue(EMFileDigestEqual(&digest, &cachedDigest));
+    XCTAssertEqual(memcmp(&identity, &cachedIdentity, sizeof(identity)), 0);
+    
+    // Changes to the file (even of the same size) change its identity, so the cached digest isn't used
+    ((uint8_t *)data.mutableBytes)[0] ^= 0xff;
+    XCTAssertTrue([data writeToURL:fileURL atomically:NO]);
+    
+    XCTAssertTrue(EMFileDigestOfPath(fileURL.fileSystemRepresentation, cacheURL.fileSystemRepresentation, &cachedDigest, NULL));
+    XCTAssertFalse(EMFileDigestEqual(&digest, &cachedDigest));
+    XCTAssertEqualObjects([self _dataForDigest:&cachedDigest], [self _expectedDigestOfData:data]);
+    
+    // Directories don't have digests
+    XCTAssertFalse(EMFileDigestOfPath(_tempDir.fileSystemRepresentation, cacheURL.fileSystemRepresentation, &digest, NULL));
+}
+
+@end
@@ -0,0 +1,22 @@
+//
+//  EMHeadlessCanvas.h
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "EMWindowBuffer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! A canvas which records drawn rows instead of writing to a terminal */
+@interface EMHeadlessCanvas : NSObject <EMWindowCanvas>
+@property(nonatomic) NSUInteger numberOfColumns;
+@property(nonatomic) NSUInteger numberOfRows;
+@property(nonatomic,readonly) NSMutableDictionary<NSNumber*,NSMutableString*> *rows;
+@property(nonatomic,readonly) NSMutableIndexSet *drawnRows;
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,42 @@
+//
+//  EMHeadlessCanvas.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import "EMHeadlessCanvas.h"
+
+@implementation EMHeadlessCanvas
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _numberOfColumns = 80;
+    _numberOfRows = 24;
+    _rows = [NSMutableDictionary dictionary];
+    _drawnRows = [NSMutableIndexSet indexSet];
+    
+    return self;
+}
+
+- (void)clearRow:(NSUInteger)row {
+    _rows[@(row)] = [NSMutableString string];
+    [_drawnRows addIndex:row];
+}
+
+- (void)drawString:(NSString *)string withStyle:(YDCommandOutputStyle)style atRow:(NSUInteger)row column:(NSUInteger)column {
+    NSMutableString *contents = _rows[@(row)] ?: [NSMutableString string];
+    
+    while (contents.length < column) {
+        [contents appendString:@" "];
+    }
+    
+    [contents replaceCharactersInRange:NSMakeRange(column, MIN(string.length, contents.length - column)) withString:string];
+    _rows[@(row)] = contents;
+}
+
+@end
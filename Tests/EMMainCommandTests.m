@@ -0,0 +1,82 @@
+//
+//  EMMainCommandTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <unistd.h>
+
+#import "EMMainCommand.h"
+#import "EMStartupTrace.h"
+
+
+@interface EMMainCommandTests : XCTestCase
+@end
+
+@implementation EMMainCommandTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+- (void)testCommandsAreCreatedLazily {
+    EMMainCommand *command = [[EMMainCommand alloc] init];
+    XCTAssertEqual(command.loadedCommandNames.count, 0);
+    
+    // Only the command which is looked up is created
+    XCTAssertNotNil([command commandWithPath:@"version"]);
+    XCTAssertEqualObjects(command.loadedCommandNames, [NSSet setWithObject:@"version"]);
+    
+    XCTAssertNotNil([command commandWithPath:@"service"]);
+    XCTAssertEqualObjects(command.loadedCommandNames, ([NSSet setWithObjects:@"version", @"service", nil]));
+    
+    // Help lists every command, so they're all created
+    XCTAssertNotNil([command commandWithPath:@"help"]);
+    XCTAssertTrue([command.loadedCommandNames isSupersetOfSet:([NSSet setWithObjects:@"create", @"rm", @"edit", @"get", @"list", @"run", @"update", @"daemon", @"apply", nil])]);
+}
+
+- (void)testStartupTrace {
+    EMStartupTraceMark(EMStartupPhaseMain);
+    EMStartupTraceEnable(YES);
+    EMStartupTraceMark(EMStartupPhaseArgumentsParsed);
+    
+    // The first output is seen once it's relayed from stdout
+    XCTAssertEqual(write(STDOUT_FILENO, "\n", 1), 1);
+    
+    // Timings are written to stderr, which is captured in a file
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    XCTAssertTrue([[NSData data] writeToFile:path atomically:NO]);
+    
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+    int stderrCopy = dup(STDERR_FILENO);
+    
+    fflush(stderr);
+    dup2(fileHandle.fileDescriptor, STDERR_FILENO);
+    
+    EMStartupTraceFinish();
+    
+    fflush(stderr);
+    dup2(stderrCopy, STDERR_FILENO);
+    close(stderrCopy);
+    [fileHandle closeFile];
+    
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    
+    NSDictionary *event = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+    XCTAssertEqualObjects(event[@"event"], @"trace.startup");
+    
+    NSDictionary *phases = event[@"data"];
+    XCTAssertEqualObjects([NSSet setWithArray:phases.allKeys], ([NSSet setWithObjects:@"main", @"parse", @"resolve", @"output", @"exit", nil]));
+    
+    // Phases which were reached are timed in order (Emporter isn't resolved here)
+    XCTAssertTrue([phases[@"output"] isKindOfClass:[NSNumber class]]);
+    XCTAssertLessThanOrEqual([phases[@"main"] doubleValue], [phases[@"output"] doubleValue]);
+    XCTAssertLessThanOrEqual([phases[@"output"] doubleValue], [phases[@"exit"] doubleValue]);
+}
+
+@end
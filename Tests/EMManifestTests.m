@@ -0,0 +1,349 @@
+//
+//  EMManifestTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMManifest.h"
+
+
+/*! A mock Emporter backend which modifies tunnels in memory, recording each operation and how many were performed at once */
+@interface EMMockManifestBackend : NSObject <EMManifestBackend>
+@property(nonatomic,readonly) NSMutableDictionary<NSString*,NSMutableDictionary*> *tunnels;
+@property(nonatomic,readonly) NSMutableArray<NSString*> *operations;
+@property(nonatomic) useconds_t delay;
+@property(nonatomic) NSUInteger numberOfBulkFetches;
+@property(nonatomic) NSUInteger maximumConcurrentOperations;
+@property(nonatomic,nullable) NSString *failingName;
+- (void)addTunnelWithValues:(NSDictionary *)values;
+@end
+
+@implementation EMMockManifestBackend {
+    NSUInteger _numberOfConcurrentOperations;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _tunnels = [NSMutableDictionary dictionary];
+    _operations = [NSMutableArray array];
+    
+    return self;
+}
+
+- (void)addTunnelWithValues:(NSDictionary *)values {
+    _tunnels[values[@"id"]] = [values mutableCopy];
+}
+
+- (BOOL)_performOperation:(NSString *)operation block:(BOOL(^)(void))block {
+    @synchronized (self) {
+        [_operations addObject:operation];
+        _numberOfConcurrentOperations++;
+        _maximumConcurrentOperations = MAX(_maximumConcurrentOperations, _numberOfConcurrentOperations);
+    }
+    
+    usleep(_delay);
+    
+    @synchronized (self) {
+        _numberOfConcurrentOperations--;
+        return block();
+    }
+}
+
+- (NSArray<EMTunnelSnapshot *> *)fetchTunnelSnapshots {
+    _numberOfBulkFetches++;
+    
+    NSMutableArray *snapshots = [NSMutableArray array];
+    for (NSString *tunnelId in [_tunnels.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:_tunnels[tunnelId]]];
+    }
+    
+    return snapshots;
+}
+
+- (EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = _tunnels[identifier];
+    return values ? [[EMTunnelSnapshot alloc] initWithValues:values] : nil;
+}
+
+- (NSDictionary<NSString *,id> *)fetchValuesForKeys:(NSArray<NSString *> *)keys ofTunnelWithIdentifier:(NSString *)identifier {
+    return [_tunnels[identifier] dictionaryWithValuesForKeys:keys];
+}
+
+- (NSString *)createTunnelWithURL:(NSURL *)url name:(NSString *)name error:(NSError **)outError {
+    __block NSString *identifier = nil;
+    
+    [self _performOperation:[NSString stringWithFormat:@"create %@", name ?: url.port] block:^BOOL{
+        if (name != nil && [name isEqualToString:self.failingName ?: @""]) {
+            if (outError != NULL) {
+                (*outError) = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFeatureUnsupportedError userInfo:nil];
+            }
+            return NO;
+        }
+        
+        identifier = [NSUUID UUID].UUIDString;
+        
+        NSMutableDictionary *values = [NSMutableDictionary dictionaryWithObject:identifier forKey:@"id"];
+        values[@"name"] = name;
+        
+        if (url.isFileURL) {
+            values[@"kind"] = @(EmporterTunnelKindDirectory);
+            values[@"directory"] = url;
+        } else {
+            values[@"kind"] = @(EmporterTunnelKindProxy);
+            values[@"proxyPort"] = url.port;
+        }
+        
+        self.tunnels[identifier] = values;
+        return YES;
+    }];
+    
+    return identifier;
+}
+
+- (BOOL)setValues:(NSDictionary<NSString *,id> *)values ofTunnelWithIdentifier:(NSString *)identifier error:(NSError **)outError {
+    return [self _performOperation:[@"set " stringByAppendingString:identifier] block:^BOOL{
+        [self.tunnels[identifier] addEntriesFromDictionary:values];
+        return self.tunnels[identifier] != nil;
+    }];
+}
+
+- (BOOL)passwordProtectTunnelWithIdentifier:(NSString *)identifier username:(NSString *)username password:(NSString *)password error:(NSError **)outError {
+    return [self _performOperation:[@"auth " stringByAppendingString:identifier] block:^BOOL{
+        self.tunnels[identifier][@"isAuthEnabled"] = @YES;
+        return self.tunnels[identifier] != nil;
+    }];
+}
+
+- (BOOL)deleteTunnelWithIdentifier:(NSString *)identifier error:(NSError **)outError {
+    return [self _performOperation:[@"delete " stringByAppendingString:identifier] block:^BOOL{
+        BOOL exists = self.tunnels[identifier] != nil;
+        [self.tunnels removeObjectForKey:identifier];
+        return exists;
+    }];
+}
+
+@end
+
+
+@interface EMManifestTests : XCTestCase
+@property(nonatomic) EMMockManifestBackend *backend;
+@property(nonatomic) NSString *directoryPath;
+@end
+
+@implementation EMManifestTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _directoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"EMManifestTests-%@", [NSUUID UUID].UUIDString]];
+    XCTAssertTrue([NSFileManager.defaultManager createDirectoryAtPath:_directoryPath withIntermediateDirectories:YES attributes:nil error:NULL]);
+    
+    _backend = [EMMockManifestBackend new];
+    [_backend addTunnelWithValues:@{@"id": @"A", @"name": @"api", @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @8080,
+                                    @"proxyHostHeader": @"api.local", @"shouldRewriteHostHeader": @YES}];
+    [_backend addTunnelWithValues:@{@"id": @"B", @"name": @"site", @"kind": @(EmporterTunnelKindDirectory),
+                                    @"directory": [NSURL fileURLWithPath:_directoryPath isDirectory:YES], @"isBrowsingEnabled": @NO}];
+    [_backend addTunnelWithValues:@{@"id": @"C", @"name": @"old", @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @9000}];
+}
+
+- (void)tearDown {
+    [NSFileManager.defaultManager removeItemAtPath:_directoryPath error:NULL];
+}
+
+- (EMManifest *)_manifestWithObject:(id)object error:(NSError **)outError {
+    return [EMManifest manifestWithData:[NSJSONSerialization dataWithJSONObject:object options:0 error:NULL] error:outError];
+}
+
+- (void)testParse {
+    NSError *error = nil;
+    EMManifest *manifest = [self _manifestWithObject:@{@"prune": @YES, @"urls": @[
+                                                               @{@"source": @8080, @"name": @"api", @"auth": @"user:pass", @"host": @""},
+                                                               @{@"source": _directoryPath, @"index": @"index.html", @"browsing": @YES, @"liveReload": @NO},
+                                                               @{@"source": @"localhost:3000/path", @"delete": @YES},
+                                                               ]} error:&error];
+    
+    XCTAssertNotNil(manifest, @"%@", error);
+    XCTAssertTrue(manifest.prune);
+    XCTAssertEqual(manifest.items.count, 3);
+    
+    EMManifestItem *proxy = manifest.items[0];
+    XCTAssertEqual(proxy.sourceType, EMSourceTypePort);
+    XCTAssertEqualObjects(proxy.sourceURL, [NSURL URLWithString:@"http://localhost:8080"]);
+    XCTAssertEqualObjects(proxy.authUsername, @"user");
+    XCTAssertEqualObjects(proxy.authPassword, @"pass");
+    XCTAssertEqualObjects(proxy.proxyHost, @"");
+    XCTAssertFalse(proxy.shouldDelete);
+    
+    EMManifestItem *directory = manifest.items[1];
+    XCTAssertEqual(directory.sourceType, EMSourceTypeDirectory);
+    XCTAssertEqualObjects(directory.directoryIndexFile, @"index.html");
+    XCTAssertEqualObjects(directory.browsingEnabled, @YES);
+    XCTAssertEqualObjects(directory.liveReloadEnabled, @NO);
+    XCTAssertNil(directory.authUsername);
+    
+    EMManifestItem *url = manifest.items[2];
+    XCTAssertEqual(url.sourceType, EMSourceTypeURL);
+    XCTAssertTrue(url.shouldDelete);
+    
+    XCTAssertTrue([proxy matchesSnapshot:[_backend fetchTunnelSnapshotWithIdentifier:@"A"]]);
+    XCTAssertTrue([directory matchesSnapshot:[_backend fetchTunnelSnapshotWithIdentifier:@"B"]]);
+    XCTAssertFalse([url matchesSnapshot:[_backend fetchTunnelSnapshotWithIdentifier:@"A"]]);
+}
+
+- (void)testParseErrors {
+    NSArray *manifests = @[
+                           @[],
+                           @{},
+                           @{@"urls": @{}},
+                           @{@"urls": @[], @"prune": @"yes"},
+                           @{@"urls": @[], @"unknown": @YES},
+                           @{@"urls": @[@"8080"]},
+                           @{@"urls": @[@{}]},
+                           @{@"urls": @[@{@"source": @8080, @"unknown": @YES}]},
+                           @{@"urls": @[@{@"source": @8080, @"name": @42}]},
+                           @{@"urls": @[@{@"source": @8080, @"auth": @"user"}]},
+                           @{@"urls": @[@{@"source": @"not a source"}]},
+                           @{@"urls": @[@{@"source": @8080}, @{@"source": @"localhost:8080"}]},
+                           ];
+    
+    for (id object in manifests) {
+        NSError *error = nil;
+        
+        XCTAssertNil([self _manifestWithObject:object error:&error], @"%@", object);
+        XCTAssertNotNil(error.localizedFailureReason, @"%@", object);
+    }
+    
+    NSError *error = nil;
+    XCTAssertNil([EMManifest manifestWithData:[@"{" dataUsingEncoding:NSUTF8StringEncoding] error:&error]);
+    XCTAssertNotNil(error);
+}
+
+- (void)testDiff {
+    EMManifest *manifest = [self _manifestWithObject:@{@"prune": @YES, @"urls": @[
+                                                               @{@"source": @8080, @"name": @"api", @"host": @"api.local"},
+                                                               @{@"source": _directoryPath, @"browsing": @YES, @"auth": @"user:pass"},
+                                                               @{@"source": @3000, @"host": @"app.local"},
+                                                               @{@"source": @4000, @"delete": @YES},
+                                                               @{@"source": [NSUUID UUID].UUIDString, @"name": @"missing"},
+                                                               ]} error:NULL];
+    
+    NSArray<EMManifestChange*> *changes = [manifest changesFromSnapshots:[_backend fetchTunnelSnapshots] error:NULL];
+    XCTAssertEqual(changes.count, 6);
+    
+    XCTAssertEqual(changes[0].type, EMManifestChangeTypeNone);
+    XCTAssertEqualObjects(changes[0].tunnelIdentifier, @"A");
+    
+    XCTAssertEqual(changes[1].type, EMManifestChangeTypeUpdate);
+    XCTAssertEqualObjects(changes[1].values, @{@"isBrowsingEnabled": @YES});
+    XCTAssertTrue(changes[1].needsAuth);
+    
+    XCTAssertEqual(changes[2].type, EMManifestChangeTypeCreate);
+    XCTAssertNil(changes[2].tunnelIdentifier);
+    XCTAssertEqualObjects(changes[2].values, (@{@"proxyHostHeader": @"app.local", @"shouldRewriteHostHeader": @YES}));
+    
+    // Deleting a URL which doesn't exist is a no-op
+    XCTAssertEqual(changes[3].type, EMManifestChangeTypeNone);
+    
+    XCTAssertEqual(changes[4].type, EMManifestChangeTypeInvalid);
+    XCTAssertNotNil(changes[4].error);
+    
+    // Unlisted tunnels are pruned
+    XCTAssertEqual(changes[5].type, EMManifestChangeTypeDelete);
+    XCTAssertNil(changes[5].item);
+    XCTAssertEqualObjects(changes[5].tunnelIdentifier, @"C");
+    
+    // Disabling the Host header only changes the flag
+    manifest = [self _manifestWithObject:@{@"urls": @[@{@"source": @8080, @"host": @""}]} error:NULL];
+    changes = [manifest changesFromSnapshots:[_backend fetchTunnelSnapshots] error:NULL];
+    
+    XCTAssertEqual(changes.count, 1);
+    XCTAssertEqualObjects(changes[0].values, @{@"shouldRewriteHostHeader": @NO});
+}
+
+- (void)testConflictingItems {
+    NSString *tunnelId = [NSUUID UUID].UUIDString;
+    [_backend addTunnelWithValues:@{@"id": tunnelId, @"name": @"app", @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @5000}];
+    
+    // An id and a port which describe the same tunnel would delete and update it at once
+    EMManifest *manifest = [self _manifestWithObject:@{@"urls": @[@{@"source": tunnelId, @"delete": @YES}, @{@"source": @5000, @"name": @"renamed"}]} error:NULL];
+    XCTAssertNotNil(manifest);
+    
+    NSError *error = nil;
+    XCTAssertNil([manifest changesFromSnapshots:[_backend fetchTunnelSnapshots] error:&error]);
+    XCTAssertNotNil(error.localizedFailureReason);
+}
+
+- (void)testApply {
+    EMManifest *manifest = [self _manifestWithObject:@{@"prune": @YES, @"urls": @[
+                                                               @{@"source": @8080, @"name": @"renamed"},
+                                                               @{@"source": _directoryPath, @"auth": @"user:pass"},
+                                                               @{@"source": @3000, @"name": @"app", @"host": @"app.local"},
+                                                               @{@"source": @3001},
+                                                               ]} error:NULL];
+    
+    NSArray<EMManifestChange*> *changes = [manifest changesFromSnapshots:[_backend fetchTunnelSnapshots] error:NULL];
+    NSMutableArray *handled = [NSMutableArray array];
+    
+    _backend.delay = 10000;
+    EMManifestApplyChanges(changes, _backend, ^(EMManifestChange *change) {
+        [handled addObject:change];
+    });
+    
+    XCTAssertEqual(_backend.numberOfBulkFetches, 1);
+    XCTAssertEqual(handled.count, changes.count);
+    XCTAssertEqual(_backend.maximumConcurrentOperations, 1);
+    
+    for (EMManifestChange *change in changes) {
+        XCTAssertNil(change.error, @"%@", change.item);
+        XCTAssertNotNil(change.tunnelIdentifier, @"%@", change.item);
+        XCTAssertGreaterThan(change.duration, 0.009, @"%@", change.item);
+    }
+    
+    XCTAssertEqualObjects(_backend.tunnels[@"A"][@"name"], @"renamed");
+    XCTAssertEqualObjects(_backend.tunnels[@"B"][@"isAuthEnabled"], @YES);
+    XCTAssertNil(_backend.tunnels[@"C"]);
+    
+    NSDictionary *created = _backend.tunnels[changes[2].tunnelIdentifier];
+    XCTAssertEqualObjects(created[@"name"], @"app");
+    XCTAssertEqualObjects(created[@"proxyPort"], @3000);
+    XCTAssertEqualObjects(created[@"proxyHostHeader"], @"app.local");
+    
+    // Applying the same manifest again is a no-op
+    [_backend.operations removeAllObjects];
+    
+    changes = [manifest changesFromSnapshots:[_backend fetchTunnelSnapshots] error:NULL];
+    EMManifestApplyChanges(changes, _backend, nil);
+    
+    XCTAssertEqualObjects([changes valueForKey:@"type"], (@[@(EMManifestChangeTypeNone), @(EMManifestChangeTypeNone), @(EMManifestChangeTypeNone), @(EMManifestChangeTypeNone)]));
+    XCTAssertEqual(_backend.operations.count, 0);
+}
+
+- (void)testApplyErrors {
+    EMManifest *manifest = [self _manifestWithObject:@{@"urls": @[
+                                                               @{@"source": @3000, @"name": @"fails", @"host": @"app.local"},
+                                                               @{@"source": @3001, @"name": @"succeeds"},
+                                                               ]} error:NULL];
+    
+    _backend.failingName = @"fails";
+    
+    NSArray<EMManifestChange*> *changes = [manifest changesFromSnapshots:[_backend fetchTunnelSnapshots] error:NULL];
+    EMManifestApplyChanges(changes, _backend, nil);
+    
+    XCTAssertNotNil(changes[0].error);
+    XCTAssertNil(changes[0].tunnelIdentifier);
+    
+    XCTAssertNil(changes[1].error);
+    XCTAssertEqualObjects(_backend.tunnels[changes[1].tunnelIdentifier][@"name"], @"succeeds");
+    
+    // Failed creations aren't configured
+    XCTAssertEqual([_backend.operations filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF BEGINSWITH 'set'"]].count, 0);
+}
+
+@end
@@ -0,0 +1,207 @@
+//
+//  EMMetricsTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#import "EMMetrics.h"
+
+
+@interface EMMetricsTests : XCTestCase
+@property(nonatomic) NSString *directoryPath;
+@end
+
+@implementation EMMetricsTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    // Socket paths are limited in length, so avoid the (long) per-user temporary directory
+    _directoryPath = [NSString stringWithFormat:@"/tmp/em-metrics-%d", getpid()];
+    XCTAssertTrue([NSFileManager.defaultManager createDirectoryAtPath:_directoryPath withIntermediateDirectories:YES attributes:nil error:NULL]);
+}
+
+- (void)tearDown {
+    [NSFileManager.defaultManager removeItemAtPath:_directoryPath error:NULL];
+}
+
+- (void)testPrometheusText {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    
+    EMMetricsCounter *launches = [metrics counterWithName:@"test_notifications_total" help:@"Notifications" labels:@{@"type": @"launch"}];
+    EMMetricsCounter *quotes = [metrics counterWithName:@"test_notifications_total" help:@"Notifications" labels:@{@"type": @"a \"quoted\"\nvalue"}];
+    EMMetricsHistogram *histogram = [metrics histogramWithName:@"test_duration_seconds" help:@"Durations" labels:nil buckets:@[@1, @0.1, @10]];
+    
+    XCTAssertEqual([metrics counterWithName:@"test_notifications_total" help:@"Notifications" labels:@{@"type": @"launch"}], launches);
+    
+    [launches increment];
+    [launches incrementBy:2];
+    [quotes increment];
+    
+    for (NSNumber *value in @[@0.05, @0.1, @0.5, @5, @100]) {
+        [histogram observe:value.doubleValue];
+    }
+    
+    XCTAssertEqual(launches.value, 3);
+    XCTAssertEqual(histogram.count, 5);
+    XCTAssertEqualWithAccuracy(histogram.sum, 105.65, 0.0001);
+    XCTAssertEqualObjects(histogram.buckets, (@[@0.1, @1, @10]));
+    
+    NSString *expectedText = @"# HELP test_notifications_total Notifications\n"
+                             @"# TYPE test_notifications_total counter\n"
+                             @"test_notifications_total{type=\"a \\\"quoted\\\"\\nvalue\"} 1\n"
+                             @"test_notifications_total{type=\"launch\"} 3\n"
+                             @"# HELP test_duration_seconds Durations\n"
+                             @"# TYPE test_duration_seconds histogram\n"
+                             @"test_duration_seconds_bucket{le=\"0.1\"} 2\n"
+                             @"test_duration_seconds_bucket{le=\"1\"} 3\n"
+                             @"test_duration_seconds_bucket{le=\"10\"} 4\n"
+                             @"test_duration_seconds_bucket{le=\"+Inf\"} 5\n";
+    
+    XCTAssertTrue([metrics.prometheusText hasPrefix:expectedText], @"%@", metrics.prometheusText);
+    XCTAssertTrue([metrics.prometheusText containsString:@"test_duration_seconds_count 5\n"]);
+}
+
+- (void)testConcurrentRecording {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    EMMetricsCounter *counter = [metrics counterWithName:@"test_total" help:@"Test" labels:nil];
+    EMMetricsHistogram *histogram = [metrics histogramWithName:@"test_seconds" help:@"Test" labels:nil buckets:nil];
+    
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^(size_t iteration) {
+        for (NSUInteger i = 0; i < 10000; i++) {
+            [counter increment];
+            [histogram observe:0.5];
+        }
+    });
+    
+    XCTAssertEqual(counter.value, 80000);
+    XCTAssertEqual(histogram.count, 80000);
+    XCTAssertEqualWithAccuracy(histogram.sum, 40000, 0.0001);
+}
+
+- (void)testWriteToFile {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    EMMetricsCounter *counter = [metrics counterWithName:@"test_total" help:@"Test" labels:nil];
+    NSString *path = [_directoryPath stringByAppendingPathComponent:@"metrics.prom"];
+    
+    XCTAssertTrue([metrics startWritingToFile:path interval:0.1 error:NULL]);
+    XCTAssertTrue([[NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL] containsString:@"test_total 0\n"]);
+    
+    [counter increment];
+    
+    // Wait for the next interval
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+    while (![[NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL] containsString:@"test_total 1\n"] && deadline.timeIntervalSinceNow > 0) {
+        usleep(10000);
+    }
+    
+    XCTAssertTrue([[NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL] containsString:@"test_total 1\n"]);
+    
+    // Stopping writes the final values
+    [counter increment];
+    [metrics stop];
+    
+    XCTAssertTrue([[NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL] containsString:@"test_total 2\n"]);
+    
+    // Directories which don't exist are reported up front
+    NSError *error = nil;
+    XCTAssertFalse([metrics startWritingToFile:[_directoryPath stringByAppendingPathComponent:@"missing/metrics.prom"] interval:1 error:&error]);
+    XCTAssertNotNil(error);
+}
+
+- (void)testSocket {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    [[metrics counterWithName:@"test_total" help:@"Test" labels:nil] incrementBy:42];
+    
+    NSString *path = [_directoryPath stringByAppendingPathComponent:@"metrics.sock"];
+    NSError *error = nil;
+    
+    XCTAssertTrue([metrics startListeningOnSocketPath:path error:&error], @"%@", error);
+    
+    for (NSUInteger i = 0; i < 2; i++) {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        strlcpy(addr.sun_path, path.fileSystemRepresentation, sizeof(addr.sun_path));
+        
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        XCTAssertEqual(connect(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+        
+        NSMutableData *data = [NSMutableData data];
+        char buffer[1024];
+        ssize_t count;
+        
+        while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+            [data appendBytes:buffer length:(NSUInteger)count];
+        }
+        
+        close(fd);
+        
+        NSString *text = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        XCTAssertEqualObjects(text, metrics.prometheusText);
+        XCTAssertTrue([text containsString:@"test_total 42\n"]);
+    }
+    
+    [metrics stop];
+    XCTAssertFalse([NSFileManager.defaultManager fileExistsAtPath:path]);
+}
+
+- (void)testSessionMetrics {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    EMSessionMetrics *session = [[EMSessionMetrics alloc] initWithMetrics:metrics];
+    
+    EMMetricsCounter *counter = [session counterForNotification:@"EmporterDidLaunchNotification"];
+    XCTAssertEqual([session counterForNotification:@"EmporterDidLaunchNotification"], counter);
+    [counter increment];
+    
+    [session recordState:EmporterTunnelStateConnecting ofTunnelWithIdentifier:@"a"];
+    [session recordState:EmporterTunnelStateConnecting ofTunnelWithIdentifier:@"a"];
+    usleep(20000);
+    [session recordState:EmporterTunnelStateConnected ofTunnelWithIdentifier:@"a"];
+    
+    // Tunnels which fail to connect aren't measured
+    [session recordState:EmporterTunnelStateConnecting ofTunnelWithIdentifier:@"b"];
+    [session recordState:EmporterTunnelStateConflicted ofTunnelWithIdentifier:@"b"];
+    [session recordState:EmporterTunnelStateConnected ofTunnelWithIdentifier:@"b"];
+    
+    [session recordServiceState:EmporterServiceStateConflicted];
+    [session recordServiceState:EmporterServiceStateConflicted];
+    [session recordServiceState:EmporterServiceStateConnected];
+    
+    [session recordRelaunch:YES];
+    [session recordRelaunch:NO];
+    [session recordFrameWithRefreshDuration:0.002 renderDuration:0.001 eventCount:3];
+    
+    EMMetricsHistogram *connectDuration = [metrics histogramWithName:@"emporter_tunnel_connect_seconds" help:@"" labels:nil buckets:nil];
+    XCTAssertEqual(connectDuration.count, 1);
+    XCTAssertGreaterThanOrEqual(connectDuration.sum, 0.02);
+    
+    XCTAssertEqual([metrics histogramWithName:@"emporter_service_conflict_seconds" help:@"" labels:nil buckets:nil].count, 1);
+    XCTAssertEqual([metrics counterWithName:@"emporter_tunnel_transitions_total" help:@"" labels:@{@"state": @"connecting"}].value, 2);
+    XCTAssertEqual([metrics counterWithName:@"emporter_tunnel_transitions_total" help:@"" labels:@{@"state": @"connected"}].value, 2);
+    XCTAssertEqual([metrics counterWithName:@"emporter_app_relaunches_total" help:@"" labels:@{@"result": @"failure"}].value, 1);
+    XCTAssertEqual([metrics histogramWithName:@"emporter_frame_render_seconds" help:@"" labels:nil buckets:nil].count, 1);
+    XCTAssertEqual([metrics histogramWithName:@"emporter_frame_events" help:@"" labels:nil buckets:nil].sum, 3);
+    
+    XCTAssertTrue([metrics.prometheusText containsString:@"emporter_notifications_total{type=\"EmporterDidLaunchNotification\"} 1\n"]);
+}
+
+- (void)testPerformanceRecording {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    EMMetricsCounter *counter = [metrics counterWithName:@"test_total" help:@"Test" labels:nil];
+    EMMetricsHistogram *histogram = [metrics histogramWithName:@"test_seconds" help:@"Test" labels:nil buckets:nil];
+    
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 1000000; i++) {
+            [counter increment];
+            [histogram observe:(double)(i % 1000) / 1000];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,154 @@
+//
+//  EMProcessNodeTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMProcessNode.h"
+
+
+/*! A synthetic process table where each process (> 1) is the child of pid / 2 */
+@interface EMSyntheticProcessSource : NSObject <EMProcessSource>
+- (instancetype)initWithNumberOfProcesses:(pid_t)numberOfProcesses;
+@property(nonatomic,readonly) pid_t numberOfProcesses;
+@property(nonatomic) NSUInteger numberOfLookups;
+@property(nonatomic) NSUInteger numberOfEnumerations;
+@end
+
+@implementation EMSyntheticProcessSource
+
+- (instancetype)initWithNumberOfProcesses:(pid_t)numberOfProcesses {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _numberOfProcesses = numberOfProcesses;
+    
+    return self;
+}
+
+static void _EMSyntheticProcessInfo(pid_t pid, EMProcessInfo *outInfo) {
+    outInfo->pid = pid;
+    outInfo->parentPid = pid > 1 ? pid / 2 : 0;
+    snprintf(outInfo->name, sizeof(outInfo->name), "proc-%d", pid);
+}
+
+- (BOOL)getProcessInfo:(EMProcessInfo *)outInfo forPid:(pid_t)pid {
+    _numberOfLookups++;
+    
+    if (pid < 0 || pid >= _numberOfProcesses) {
+        return NO;
+    }
+    
+    _EMSyntheticProcessInfo(pid, outInfo);
+    return YES;
+}
+
+- (void)enumerateProcessesUsingBlock:(void (^)(const EMProcessInfo *, BOOL *))block {
+    _numberOfEnumerations++;
+    
+    BOOL stop = NO;
+    
+    // Enumerate in reverse to ensure children are sorted by the tree
+    for (pid_t pid = _numberOfProcesses - 1; pid >= 0 && !stop; pid--) {
+        EMProcessInfo info = {0};
+        _EMSyntheticProcessInfo(pid, &info);
+        block(&info, &stop);
+    }
+}
+
+@end
+
+
+@interface EMProcessNodeTests : XCTestCase
+@end
+
+@implementation EMProcessNodeTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+- (void)testChildWithPidOnlyLooksUpAncestors {
+    EMSyntheticProcessSource *source = [[EMSyntheticProcessSource alloc] initWithNumberOfProcesses:10000];
+    EMProcessNode *rootNode = [EMProcessNode rootNodeWithSource:source];
+    EMProcessNode *node = [rootNode childWithPid:9999];
+    
+    XCTAssertNotNil(node);
+    XCTAssertEqualObjects(node.name, @"proc-9999");
+    XCTAssertEqual(node.parent.pidValue, 4999);
+    
+    // 9999 → 4999 → … → 1 → 0
+    XCTAssertEqual(source.numberOfLookups, 15);
+    XCTAssertEqual(source.numberOfEnumerations, 0);
+}
+
+- (void)testChildWithPidRequiresAncestor {
+    EMSyntheticProcessSource *source = [[EMSyntheticProcessSource alloc] initWithNumberOfProcesses:100];
+    EMProcessNode *rootNode = [EMProcessNode rootNodeWithSource:source];
+    
+    EMProcessNode *node = [rootNode childWithPid:10];
+    XCTAssertEqual([node childWithPid:21].pidValue, 21);
+    XCTAssertEqual([node childWithPid:43].pidValue, 43);
+    XCTAssertNil([node childWithPid:12]);
+    XCTAssertNil([node childWithPid:10]);
+    XCTAssertNil([rootNode childWithPid:100]);
+}
+
+- (void)testChildren {
+    EMSyntheticProcessSource *source = [[EMSyntheticProcessSource alloc] initWithNumberOfProcesses:100];
+    EMProcessNode *rootNode = [EMProcessNode rootNodeWithSource:source];
+    EMProcessNode *node = [rootNode childWithPid:10];
+    
+    XCTAssertEqualObjects([rootNode.children valueForKey:@"pidValue"], @[@0]);
+    XCTAssertEqualObjects([node.children valueForKey:@"pidValue"], (@[@20, @21]));
+    
+    // Nodes which were looked up are reused once the table is loaded
+    XCTAssertEqual(node.parent, [rootNode childWithPid:5]);
+    XCTAssertEqual(source.numberOfEnumerations, 1);
+}
+
+- (void)testCurrentRootNode {
+    EMProcessNode *rootNode = [EMProcessNode currentRootNode];
+    EMProcessNode *node = [rootNode childWithPid:getpid()];
+    
+    XCTAssertNotNil(node);
+    XCTAssertEqual(node.parentPidValue, getppid());
+    XCTAssertEqual(node.parent.pidValue, getppid());
+    XCTAssertTrue([[rootNode.children valueForKey:@"pidValue"] containsObject:@0]);
+}
+
+- (void)testAncestorLookupPerformance {
+    EMSyntheticProcessSource *source = [[EMSyntheticProcessSource alloc] initWithNumberOfProcesses:10000];
+    
+    [self measureBlock:^{
+        for (pid_t pid = 9000; pid < 10000; pid++) {
+            [[EMProcessNode rootNodeWithSource:source] childWithPid:pid];
+        }
+    }];
+}
+
+- (void)testFullTablePerformance {
+    EMSyntheticProcessSource *source = [[EMSyntheticProcessSource alloc] initWithNumberOfProcesses:10000];
+    
+    [self measureBlock:^{
+        EMProcessNode *rootNode = [EMProcessNode rootNodeWithSource:source];
+        NSMutableArray<EMProcessNode*> *nodes = [rootNode.children mutableCopy];
+        NSUInteger count = 0;
+        
+        while (nodes.count > 0) {
+            EMProcessNode *node = nodes.lastObject;
+            [nodes removeLastObject];
+            [nodes addObjectsFromArray:node.children];
+            count++;
+        }
+        
+        XCTAssertEqual(count, 10000);
+    }];
+}
+
+@end
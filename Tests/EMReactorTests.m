@@ -0,0 +1,184 @@
+//
+//  EMReactorTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#import "EMReactor.h"
+
+
+@interface EMReactorTests : XCTestCase
+@end
+
+@implementation EMReactorTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+/*! Run a reactor, failing if it doesn't stop within a few seconds */
+- (void)_runReactor:(EMReactor *)reactor withBlock:(dispatch_block_t)block {
+    [reactor addTimerWithInterval:5 repeats:NO handler:^{
+        XCTFail(@"Reactor did not stop");
+        [reactor stop];
+    }];
+    
+    [reactor runWithBlock:block];
+    [reactor invalidate];
+}
+
+- (void)testTimers {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    __block NSUInteger repeatCount = 0;
+    __block BOOL didFire = NO;
+    
+    EMReactorSource *timer = [reactor addTimerWithInterval:0.01 repeats:NO handler:^{ didFire = YES; }];
+    
+    [reactor addTimerWithInterval:0.01 repeats:YES handler:^{
+        if (++repeatCount == 3) {
+            [reactor stop];
+        }
+    }];
+    
+    [self _runReactor:reactor withBlock:nil];
+    
+    XCTAssertTrue(didFire);
+    XCTAssertTrue(timer.isCancelled);
+    XCTAssertEqual(repeatCount, 3);
+}
+
+- (void)testWakeUpFromAnotherThread {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    __block NSUInteger numberOfInvocations = 0;
+    __block BOOL didWakeUp = NO;
+    
+    [self _runReactor:reactor withBlock:^{
+        // The block is invoked once when the reactor starts, and then only after events are handled
+        if (numberOfInvocations++ == 0) {
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_MSEC), dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+                didWakeUp = YES;
+                [reactor wakeUp];
+            });
+        } else if (didWakeUp) {
+            [reactor stop];
+        }
+    }];
+    
+    XCTAssertTrue(didWakeUp);
+    XCTAssertGreaterThanOrEqual(numberOfInvocations, 2);
+}
+
+- (void)testStopFromAnotherThread {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_MSEC), dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        [reactor stop];
+    });
+    
+    [self _runReactor:reactor withBlock:nil];
+    XCTAssertFalse(reactor.isRunning);
+}
+
+- (void)testSignals {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    __block BOOL didReceiveSignal = NO;
+    
+    [reactor addSignal:SIGUSR1 handler:^{
+        didReceiveSignal = YES;
+        [reactor stop];
+    }];
+    
+    [reactor addTimerWithInterval:0.01 repeats:NO handler:^{ kill(getpid(), SIGUSR1); }];
+    
+    [self _runReactor:reactor withBlock:nil];
+    XCTAssertTrue(didReceiveSignal);
+    
+    // The signal's previous action is restored once the source is cancelled
+    struct sigaction action;
+    sigaction(SIGUSR1, NULL, &action);
+    XCTAssertEqual(action.sa_handler, SIG_DFL);
+}
+
+- (void)testReadableFileDescriptors {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    NSMutableData *data = [NSMutableData data];
+    
+    int fds[2];
+    XCTAssertEqual(pipe(fds), 0);
+    
+    [reactor addReadableFileDescriptor:fds[0] handler:^{
+        char bytes[16];
+        ssize_t length = read(fds[0], bytes, sizeof(bytes));
+        
+        if (length > 0) {
+            [data appendBytes:bytes length:(NSUInteger)length];
+        } else {
+            [reactor stop];
+        }
+    }];
+    
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        write(fds[1], "hello", 5);
+        close(fds[1]);
+    });
+    
+    [self _runReactor:reactor withBlock:nil];
+    close(fds[0]);
+    
+    XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], @"hello");
+}
+
+- (void)testWritableFileDescriptors {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    __block NSUInteger numberOfWrites = 0;
+    
+    int fds[2];
+    XCTAssertEqual(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    
+    // Sockets with room in their send buffer are writable, so the handler is invoked until the source is cancelled
+    __block EMReactorSource *source = [reactor addWritableFileDescriptor:fds[0] handler:^{
+        XCTAssertEqual(write(fds[0], "hello", 5), 5);
+        
+        if (++numberOfWrites == 2) {
+            [source cancel];
+            [reactor addTimerWithInterval:0.05 repeats:NO handler:^{ [reactor stop]; }];
+        }
+    }];
+    
+    XCTAssertNotNil(source);
+    
+    [self _runReactor:reactor withBlock:nil];
+    
+    char bytes[16] = {0};
+    XCTAssertEqual(read(fds[1], bytes, sizeof(bytes)), 10);
+    XCTAssertEqual(numberOfWrites, 2);
+    
+    close(fds[0]);
+    close(fds[1]);
+}
+
+- (void)testCancelledSourcesAreNotHandled {
+    EMReactor *reactor = [[EMReactor alloc] init];
+    __block EMReactorSource *cancelledTimer = nil;
+    __block BOOL didFire = NO;
+    
+    // Both timers may fire within the same batch of events
+    [reactor addTimerWithInterval:0.01 repeats:NO handler:^{ [cancelledTimer cancel]; }];
+    cancelledTimer = [reactor addTimerWithInterval:0.01 repeats:NO handler:^{ didFire = YES; }];
+    [reactor addTimerWithInterval:0.05 repeats:NO handler:^{ [reactor stop]; }];
+    
+    [self _runReactor:reactor withBlock:nil];
+    
+    XCTAssertFalse(didFire);
+    XCTAssertTrue(cancelledTimer.isCancelled);
+}
+
+@end
@@ -0,0 +1,229 @@
+//
+//  EMSessionRecordingTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMSessionRecording.h"
+#import "EMTunnelSnapshotStore.h"
+
+
+/*! A mock Emporter which serves tunnel values from memory and posts notifications on demand */
+@interface EMMockSessionSource : NSObject <EMSessionSource>
+@property(nonatomic,readonly) NSMutableDictionary<NSString*,NSDictionary*> *tunnels;
+@property(nonatomic,readonly) NSMutableArray<NSString*> *tunnelIds;
+@property(nonatomic) EmporterServiceState serviceState;
+@property(nonatomic,nullable) NSString *serviceConflictReason;
+- (void)postNotificationName:(NSNotificationName)name tunnelId:(NSString *)tunnelId;
+@end
+
+@implementation EMMockSessionSource
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _tunnels = [NSMutableDictionary dictionary];
+    _tunnelIds = [NSMutableArray array];
+    _serviceState = EmporterServiceStateConnected;
+    
+    return self;
+}
+
+- (void)setValues:(NSDictionary *)values forTunnelWithIdentifier:(NSString *)tunnelId {
+    if (values == nil) {
+        [_tunnelIds removeObject:tunnelId];
+    } else if (_tunnels[tunnelId] == nil) {
+        [_tunnelIds addObject:tunnelId];
+    }
+    
+    _tunnels[tunnelId] = values;
+}
+
+- (void)postNotificationName:(NSNotificationName)name tunnelId:(NSString *)tunnelId {
+    [[NSNotificationCenter defaultCenter] postNotificationName:name object:self userInfo:tunnelId ? @{EmporterTunnelIdentifierUserInfoKey: tunnelId} : nil];
+}
+
+- (BOOL)isRunning {
+    return YES;
+}
+
+- (void)launchInBackgroundWithCompletionHandler:(void (^)(NSError *))completionHandler {
+    completionHandler(nil);
+}
+
+- (NSArray<EMTunnelSnapshot *> *)fetchTunnelSnapshots {
+    NSMutableArray *snapshots = [NSMutableArray array];
+    for (NSString *tunnelId in _tunnelIds) {
+        [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:_tunnels[tunnelId]]];
+    }
+    return snapshots;
+}
+
+- (EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = _tunnels[identifier];
+    return values ? [[EMTunnelSnapshot alloc] initWithValues:values] : nil;
+}
+
+- (NSDictionary<NSString *,id> *)fetchValuesForKeys:(NSArray<NSString *> *)keys ofTunnelWithIdentifier:(NSString *)identifier {
+    return [_tunnels[identifier] dictionaryWithValuesForKeys:keys];
+}
+
+@end
+
+
+@interface EMSessionRecordingTests : XCTestCase
+@property(nonatomic) NSString *path;
+@end
+
+@implementation EMSessionRecordingTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    _path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.session", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:NULL];
+}
+
+- (NSDictionary *)_valuesForTunnelWithIdentifier:(NSString *)tunnelId state:(EmporterTunnelState)state {
+    return @{@"id": tunnelId, @"name": tunnelId, @"kind": @(EmporterTunnelKindDirectory), @"state": @(state),
+             @"directory": [NSURL fileURLWithPath:[@"/Users/test/Sites" stringByAppendingPathComponent:tunnelId] isDirectory:YES]};
+}
+
+/*! Replay a recording as fast as possible, returning the names of notifications which were posted */
+- (NSArray<NSString*> *)_replayNotificationsFromReplay:(EMSessionReplay *)replay withinBlock:(void(^)(NSNotification *note))block {
+    NSMutableArray *names = [NSMutableArray array];
+    NSMutableArray *observers = [NSMutableArray array];
+    
+    for (NSNotificationName name in @[EmporterDidAddTunnelNotification, EmporterTunnelStateDidChangeNotification, EmporterServiceStateDidChangeNotification, EmporterDidRemoveTunnelNotification]) {
+        [observers addObject:[[NSNotificationCenter defaultCenter] addObserverForName:name object:replay queue:nil usingBlock:^(NSNotification *note) {
+            [names addObject:note.name];
+            block(note);
+        }]];
+    }
+    
+    XCTestExpectation *completion = [self expectationWithDescription:@"replay"];
+    [replay startWithSpeed:0 completionHandler:^{ [completion fulfill]; }];
+    [self waitForExpectations:@[completion] timeout:10];
+    
+    for (id observer in observers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+    
+    return names;
+}
+
+- (void)testRecordAndReplay {
+    EMMockSessionSource *source = [EMMockSessionSource new];
+    [source setValues:[self _valuesForTunnelWithIdentifier:@"a" state:EmporterTunnelStateConnected] forTunnelWithIdentifier:@"a"];
+    
+    NSError *error = nil;
+    EMSessionRecorder *recorder = [EMSessionRecorder recorderWithSource:source path:_path error:&error];
+    XCTAssertNotNil(recorder, @"%@", error);
+    
+    // Observers of the recorder read values in response to notifications, just as the run command would
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:recorder];
+    [store reload];
+    
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:nil object:recorder queue:nil usingBlock:^(NSNotification *note) {
+        NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
+        
+        if ([note.name isEqualToString:EmporterTunnelStateDidChangeNotification]) {
+            [store updateStateOfSnapshotWithIdentifier:tunnelId];
+        } else if ([note.name isEqualToString:EmporterDidAddTunnelNotification]) {
+            [store updateSnapshotWithIdentifier:tunnelId];
+        } else if ([note.name isEqualToString:EmporterServiceStateDidChangeNotification]) {
+            (void)recorder.serviceState;
+            (void)recorder.serviceConflictReason;
+        }
+    }];
+    
+    [source setValues:[self _valuesForTunnelWithIdentifier:@"b" state:EmporterTunnelStateConnecting] forTunnelWithIdentifier:@"b"];
+    [source postNotificationName:EmporterDidAddTunnelNotification tunnelId:@"b"];
+    
+    [source setValues:[self _valuesForTunnelWithIdentifier:@"b" state:EmporterTunnelStateConnected] forTunnelWithIdentifier:@"b"];
+    [source postNotificationName:EmporterTunnelStateDidChangeNotification tunnelId:@"b"];
+    
+    source.serviceState = EmporterServiceStateConflicted;
+    source.serviceConflictReason = @"Terms of Service";
+    [source postNotificationName:EmporterServiceStateDidChangeNotification tunnelId:nil];
+    
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    
+    XCTAssertEqual(recorder.numberOfEvents, 3);
+    [recorder close];
+    
+    // Replay the session without the source
+    EMSessionReplay *replay = [EMSessionReplay replayWithContentsOfFile:_path error:&error];
+    XCTAssertNotNil(replay, @"%@", error);
+    XCTAssertEqual(replay.numberOfEvents, 3);
+    
+    // Only the state before the first notification has been applied
+    XCTAssertEqualObjects([[replay fetchTunnelSnapshots] valueForKey:@"id"], @[@"a"]);
+    XCTAssertEqualObjects([replay fetchTunnelSnapshotWithIdentifier:@"a"].directory, [NSURL fileURLWithPath:@"/Users/test/Sites/a" isDirectory:YES]);
+    XCTAssertNil([replay fetchTunnelSnapshotWithIdentifier:@"b"]);
+    
+    NSMutableArray *states = [NSMutableArray array];
+    NSArray *names = [self _replayNotificationsFromReplay:replay withinBlock:^(NSNotification *note) {
+        NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
+        if (tunnelId != nil) {
+            [states addObject:@([replay fetchTunnelSnapshotWithIdentifier:tunnelId].state)];
+        }
+    }];
+    
+    XCTAssertEqualObjects(names, (@[EmporterDidAddTunnelNotification, EmporterTunnelStateDidChangeNotification, EmporterServiceStateDidChangeNotification]));
+    XCTAssertEqualObjects(states, (@[@(EmporterTunnelStateConnecting), @(EmporterTunnelStateConnected)]));
+    XCTAssertEqualObjects([[replay fetchTunnelSnapshots] valueForKey:@"id"], (@[@"a", @"b"]));
+    XCTAssertEqual(replay.serviceState, EmporterServiceStateConflicted);
+    XCTAssertEqualObjects(replay.serviceConflictReason, @"Terms of Service");
+}
+
+- (void)testInvalidRecording {
+    NSError *error = nil;
+    
+    [@"{\"format\":\"something-else\"}\n" writeToFile:_path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+    XCTAssertNil([EMSessionReplay replayWithContentsOfFile:_path error:&error]);
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+    
+    [@"{\"format\":\"emporter-session\",\"version\":1}\n{\"t\":1,\"n\":\"unknown\"}\n" writeToFile:_path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+    XCTAssertNil([EMSessionReplay replayWithContentsOfFile:_path error:&error]);
+    XCTAssertEqualObjects(error.localizedDescription, @"Invalid recording at line 2.");
+}
+
+- (void)testReplayThroughput {
+    const NSUInteger count = 20000;
+    NSMutableString *contents = [NSMutableString stringWithString:@"{\"format\":\"emporter-session\",\"version\":1}\n"];
+    
+    // A reconnect storm: tunnels flapping between connecting and connected
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *tunnelId = [NSString stringWithFormat:@"%lu", i % 100];
+        [contents appendFormat:@"{\"t\":%lu,\"n\":\"state\",\"id\":\"%@\"}\n", i * 10, tunnelId];
+        [contents appendFormat:@"{\"t\":%lu,\"id\":\"%@\",\"v\":{\"id\":\"%@\",\"state\":%d}}\n", i * 10 + 1, tunnelId, tunnelId,
+         (i % 2) ? EmporterTunnelStateConnected : EmporterTunnelStateConnecting];
+    }
+    
+    [contents writeToFile:_path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+    
+    EMSessionReplay *replay = [EMSessionReplay replayWithContentsOfFile:_path error:NULL];
+    replay.outputsSynchronously = YES;
+    
+    __block NSUInteger numberOfEvents = 0;
+    [self _replayNotificationsFromReplay:replay withinBlock:^(NSNotification *note) {
+        numberOfEvents++;
+    }];
+    
+    XCTAssertEqual(numberOfEvents, count);
+    XCTAssertEqual([replay fetchTunnelSnapshots].count, 100);
+    XCTAssertGreaterThan([replay latencyAtPercentile:99], 0);
+    
+    NSLog(@"Replayed %lu events in %.2fms (%.0f/s)", count, replay.duration * 1000, (double)count / replay.duration);
+}
+
+@end
@@ -0,0 +1,122 @@
+//
+//  EMSoakTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#import "EMMainCommand.h"
+#import "EMUtils.h"
+
+
+/*!
+ A soak test of `run --json`, which replays a synthetic session until EM_SOAK_EVENTS notifications have been posted and asserts that
+ resident memory stays flat once warmed up. It only runs when EM_SOAK_EVENTS is set (i.e. by `make soak`).
+ */
+@interface EMSoakTests : XCTestCase
+@property(nonatomic) NSString *path;
+@end
+
+@implementation EMSoakTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    _path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.session", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:NULL];
+}
+
+/*! Write a recording where tunnels are added, flap between states, are reconfigured and removed, returning the number of events */
+- (NSUInteger)_writeSyntheticRecordingWithNumberOfTunnels:(NSUInteger)numberOfTunnels {
+    NSMutableString *contents = [NSMutableString stringWithString:@"{\"format\":\"emporter-session\",\"version\":1}\n{\"service\":2}\n{\"all\":[]}\n"];
+    NSUInteger numberOfEvents = 0;
+    uint64_t time = 0;
+    
+    for (NSUInteger i = 0; i < numberOfTunnels; i++) {
+        NSString *tunnelId = [NSString stringWithFormat:@"%08lu-%@", i, [NSUUID UUID].UUIDString];
+        NSString *values = [NSString stringWithFormat:@"\"id\":\"%@\",\"name\":\"soak-%lu\",\"kind\":%d,\"proxyPort\":%lu,\"proxyHostHeader\":\"localhost\"",
+                            tunnelId, i, EmporterTunnelKindProxy, 8000 + (i % 1000)];
+        
+        [contents appendFormat:@"{\"t\":%llu,\"n\":\"add\",\"id\":\"%@\"}\n", time++, tunnelId];
+        [contents appendFormat:@"{\"id\":\"%@\",\"v\":{%@,\"state\":%d}}\n", tunnelId, values, EmporterTunnelStateConnecting];
+        numberOfEvents++;
+        
+        for (NSUInteger j = 0; j < 16; j++) {
+            NSString *remoteUrl = (j % 2) ? [NSString stringWithFormat:@"\"https://soak-%lu.emporter.eu\"", i] : @"null";
+            
+            [contents appendFormat:@"{\"t\":%llu,\"n\":\"state\",\"id\":\"%@\"}\n", time++, tunnelId];
+            [contents appendFormat:@"{\"id\":\"%@\",\"k\":{\"state\":%d,\"remoteUrl\":%@}}\n", tunnelId,
+             (j % 2) ? EmporterTunnelStateConnected : EmporterTunnelStateConnecting, remoteUrl];
+            numberOfEvents++;
+        }
+        
+        [contents appendFormat:@"{\"t\":%llu,\"n\":\"config\",\"id\":\"%@\"}\n", time++, tunnelId];
+        [contents appendFormat:@"{\"id\":\"%@\",\"v\":{%@,\"state\":%d,\"isAuthEnabled\":true}}\n", tunnelId, values, EmporterTunnelStateConnected];
+        numberOfEvents++;
+        
+        [contents appendFormat:@"{\"t\":%llu,\"n\":\"remove\",\"id\":\"%@\"}\n", time++, tunnelId];
+        numberOfEvents++;
+    }
+    
+    XCTAssertTrue([contents writeToFile:_path atomically:YES encoding:NSUTF8StringEncoding error:NULL]);
+    
+    return numberOfEvents;
+}
+
+- (void)testJSONRunHasFlatMemoryProfile {
+    NSUInteger targetNumberOfEvents = (NSUInteger)MAX([NSProcessInfo.processInfo.environment[@"EM_SOAK_EVENTS"] longLongValue], 0);
+    
+    // Soaking takes minutes, so it's only done on demand
+    if (targetNumberOfEvents == 0) {
+        return;
+    }
+    
+    NSUInteger numberOfEvents = [self _writeSyntheticRecordingWithNumberOfTunnels:1000];
+    NSUInteger repeatCount = MAX(targetNumberOfEvents / numberOfEvents, 4);
+    
+    // Sample resident memory from a background queue while the run loop is busy replaying
+    NSMutableArray<NSNumber*> *samples = [NSMutableArray array];
+    dispatch_queue_t sampleQueue = dispatch_queue_create("net.youngdynasty.emporter-cli.soak", DISPATCH_QUEUE_SERIAL);
+    dispatch_source_t sampleTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, sampleQueue);
+    dispatch_source_set_timer(sampleTimer, DISPATCH_TIME_NOW, 50 * NSEC_PER_MSEC, 10 * NSEC_PER_MSEC);
+    dispatch_source_set_event_handler(sampleTimer, ^{
+        [samples addObject:@(EMResidentMemorySize())];
+    });
+    
+    // Events are discarded; it's the memory used to produce them that matters
+    int stdoutCopy = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+    
+    dispatch_resume(sampleTimer);
+    
+    YDCommandReturnCode returnCode = [[EMMainCommand new] runWithArguments:@[@"--json", @"run", @"--replay", _path, @"--replay-speed", @"0",
+                                                                             @"--replay-repeat", [NSString stringWithFormat:@"%lu", repeatCount]]];
+    
+    dispatch_sync(sampleQueue, ^{ dispatch_source_cancel(sampleTimer); });
+    
+    dup2(stdoutCopy, STDOUT_FILENO);
+    close(stdoutCopy);
+    
+    XCTAssertEqual(returnCode, YDCommandReturnCodeOK);
+    XCTAssertGreaterThanOrEqual(samples.count, 8, @"The replay finished too quickly to sample memory");
+    
+    // Compare the peak after warming up (the first quarter) to the peak of the remainder, allowing for allocator noise
+    NSUInteger warmUpCount = samples.count / 4;
+    uint64_t warmUpPeak = [[[samples subarrayWithRange:NSMakeRange(0, warmUpCount)] valueForKeyPath:@"@max.self"] unsignedLongLongValue];
+    uint64_t peak = [[[samples subarrayWithRange:NSMakeRange(warmUpCount, samples.count - warmUpCount)] valueForKeyPath:@"@max.self"] unsignedLongLongValue];
+    uint64_t tolerance = MAX(warmUpPeak / 10, 16 * 1024 * 1024);
+    
+    XCTAssertLessThanOrEqual(peak, warmUpPeak + tolerance, @"Resident memory grew from %lluMB to %lluMB", warmUpPeak / 1024 / 1024, peak / 1024 / 1024);
+}
+
+@end
@@ -0,0 +1,90 @@
+//
+//  EMSpinnerTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMSpinner.h"
+#import "YDCommandOutput.h"
+
+
+@interface EMSpinnerTests : XCTestCase
+@end
+
+@implementation EMSpinnerTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+- (void)testThroughputAndTimeRemaining {
+    EMProgressEstimator *estimator = [[EMProgressEstimator alloc] init];
+    
+    // A single sample has no throughput
+    [estimator addSampleWithCompletedUnitCount:0 totalUnitCount:10000 timestamp:0];
+    XCTAssertEqual(estimator.throughput, 0);
+    XCTAssertLessThan(estimator.estimatedTimeRemaining, 0);
+    XCTAssertEqualObjects([estimator localizedDescriptionCountingBytes:YES], @"0%");
+    
+    [estimator addSampleWithCompletedUnitCount:1000 totalUnitCount:10000 timestamp:1];
+    XCTAssertEqualWithAccuracy(estimator.throughput, 1000, 0.001);
+    XCTAssertEqualWithAccuracy(estimator.estimatedTimeRemaining, 9, 0.001);
+    XCTAssertEqualObjects([estimator localizedDescriptionCountingBytes:YES], @"10%  1 KB/s  0:09 left");
+    XCTAssertEqualObjects([estimator localizedDescriptionCountingBytes:NO], @"10%  0:09 left");
+    
+    // Samples which follow too closely are ignored
+    [estimator addSampleWithCompletedUnitCount:5000 totalUnitCount:10000 timestamp:1.1];
+    XCTAssertEqualWithAccuracy(estimator.throughput, 1000, 0.001);
+    
+    // Changes in throughput are smoothed
+    [estimator addSampleWithCompletedUnitCount:4000 totalUnitCount:10000 timestamp:2];
+    XCTAssertGreaterThan(estimator.throughput, 1000);
+    XCTAssertLessThan(estimator.throughput, 3000);
+    
+    // Estimates start over when a progress goes backwards
+    [estimator addSampleWithCompletedUnitCount:0 totalUnitCount:10000 timestamp:3];
+    XCTAssertEqual(estimator.throughput, 0);
+    XCTAssertLessThan(estimator.estimatedTimeRemaining, 0);
+}
+
+- (void)testUnknownTotal {
+    EMProgressEstimator *estimator = [[EMProgressEstimator alloc] init];
+    
+    [estimator addSampleWithCompletedUnitCount:0 totalUnitCount:-1 timestamp:0];
+    [estimator addSampleWithCompletedUnitCount:2000 totalUnitCount:-1 timestamp:1];
+    
+    XCTAssertEqualWithAccuracy(estimator.throughput, 2000, 0.001);
+    XCTAssertLessThan(estimator.estimatedTimeRemaining, 0);
+    XCTAssertEqualObjects([estimator localizedDescriptionCountingBytes:YES], @"2 KB/s");
+    XCTAssertEqualObjects([estimator localizedDescriptionCountingBytes:NO], @"");
+}
+
+- (void)testLongTimeRemaining {
+    EMProgressEstimator *estimator = [[EMProgressEstimator alloc] init];
+    
+    [estimator addSampleWithCompletedUnitCount:0 totalUnitCount:3662 timestamp:0];
+    [estimator addSampleWithCompletedUnitCount:1 totalUnitCount:3662 timestamp:1];
+    
+    XCTAssertEqualObjects([estimator localizedDescriptionCountingBytes:NO], @"0%  1:01:01 left");
+}
+
+- (void)testNonInteractiveSpinning {
+    EMSpinner *spinner = [[EMSpinner alloc] initWithOutput:YDStandardOut];
+    spinner.isInteractive = NO;
+    spinner.message = @"Downloading update...";
+    
+    [spinner startSpinning];
+    XCTAssertTrue(spinner.isSpinning);
+    
+    spinner.message = @"Extracting update...";
+    XCTAssertEqualObjects(spinner.message, @"Extracting update...");
+    
+    [spinner stopSpinning:YES];
+    XCTAssertFalse(spinner.isSpinning);
+}
+
+@end
@@ -0,0 +1,278 @@
+//
+//  EMTarballReaderTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#import "EMTarballReader.h"
+
+
+static void _EMAppendTarEntry(NSMutableData *tarball, const char *path, char type, NSData *contents, mode_t mode) {
+    uint8_t header[512] = {0};
+    
+    strncpy((char *)header, path, 100);
+    snprintf((char *)header + 100, 8, "%07o", mode);
+    snprintf((char *)header + 108, 8, "%07o", 0);
+    snprintf((char *)header + 116, 8, "%07o", 0);
+    snprintf((char *)header + 124, 12, "%011llo", (unsigned long long)contents.length);
+    snprintf((char *)header + 136, 12, "%011o", 0);
+    memset(header + 148, ' ', 8);
+    header[156] = (uint8_t)type;
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    
+    unsigned int checksum = 0;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        checksum += header[i];
+    }
+    snprintf((char *)header + 148, 8, "%06o", checksum);
+    header[155] = ' ';
+    
+    [tarball appendBytes:header length:sizeof(header)];
+    [tarball appendData:contents];
+    [tarball increaseLengthBy:(512 - (contents.length % 512)) % 512];
+}
+
+static void _EMFinishTarball(NSMutableData *tarball) {
+    [tarball increaseLengthBy:1024];
+}
+
+static NSData *_EMGzipData(NSData *data) {
+    z_stream stream = {0};
+    deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    
+    NSMutableData *output = [NSMutableData dataWithLength:deflateBound(&stream, data.length)];
+    
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    stream.next_out = output.mutableBytes;
+    stream.avail_out = (uInt)output.length;
+    
+    deflate(&stream, Z_FINISH);
+    output.length = stream.total_out;
+    deflateEnd(&stream);
+    
+    return output;
+}
+
+
+@interface EMTarballReaderTests : XCTestCase
+@property(nonatomic) NSURL *tempDir;
+@property(nonatomic) NSURL *destinationURL;
+@property(nonatomic) NSData *executableData;
+@end
+
+@implementation EMTarballReaderTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _tempDir = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtURL:_tempDir withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    _destinationURL = [_tempDir URLByAppendingPathComponent:@"emporter"];
+    _executableData = [@"#!/bin/sh\necho emporter\n" dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtURL:_tempDir error:NULL];
+}
+
+- (NSURL *)_writeTarball:(NSData *)tarball {
+    NSURL *fileURL = [_tempDir URLByAppendingPathComponent:@"update.tar.gz"];
+    [_EMGzipData(tarball) writeToURL:fileURL atomically:NO];
+    return fileURL;
+}
+
+- (EMTarballReader *)_extractTarball:(NSData *)tarball error:(NSError **)outError {
+    return [EMTarballReader readerByExtractingEntryWithName:@"emporter" fromFileURL:[self _writeTarball:tarball] toURL:_destinationURL progress:nil error:outError];
+}
+
+- (void)testExtractEntry {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "README", '0', [NSData dataWithBytes:"readme" length:6], 0644);
+    _EMAppendTarEntry(tarball, "./emporter", '0', _executableData, 0755);
+    _EMAppendTarEntry(tarball, "LICENSE", '0', [NSData dataWithBytes:"license" length:7], 0644);
+    _EMFinishTarball(tarball);
+    
+    NSError *error = nil;
+    EMTarballReader *reader = [self _extractTarball:tarball error:&error];
+    
+    XCTAssertNotNil(reader);
+    XCTAssertNil(error);
+    XCTAssertTrue(reader.didExtractEntry);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:_destinationURL], _executableData);
+    
+    struct stat info;
+    XCTAssertEqual(stat(_destinationURL.fileSystemRepresentation, &info), 0);
+    XCTAssertEqual(info.st_mode & 0777, 0755);
+    
+    // Only the matching entry is written
+    NSArray *contents = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_tempDir.path error:NULL];
+    XCTAssertEqualObjects([contents sortedArrayUsingSelector:@selector(compare:)], (@[@"emporter", @"update.tar.gz"]));
+}
+
+- (void)testNestedEntriesAreIgnored {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "dist/", '5', [NSData data], 0755);
+    _EMAppendTarEntry(tarball, "dist/emporter", '0', _executableData, 0755);
+    _EMFinishTarball(tarball);
+    
+    NSError *error = nil;
+    EMTarballReader *reader = [self _extractTarball:tarball error:&error];
+    
+    XCTAssertNotNil(reader);
+    XCTAssertNil(error);
+    XCTAssertFalse(reader.didExtractEntry);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:_destinationURL.path]);
+}
+
+- (void)testExtendedNames {
+    NSMutableData *tarball = [NSMutableData data];
+    
+    // GNU long names
+    _EMAppendTarEntry(tarball, "././@LongLink", 'L', [NSData dataWithBytes:"nested/emporter\0" length:16], 0644);
+    _EMAppendTarEntry(tarball, "emporter", '0', [NSData dataWithBytes:"nested" length:6], 0755);
+    
+    // pax headers
+    NSData *paxHeader = [@"17 path=emporter\n" dataUsingEncoding:NSUTF8StringEncoding];
+    _EMAppendTarEntry(tarball, "PaxHeader/truncated", 'x', paxHeader, 0644);
+    _EMAppendTarEntry(tarball, "truncated", '0', _executableData, 0755);
+    _EMFinishTarball(tarball);
+    
+    NSError *error = nil;
+    EMTarballReader *reader = [self _extractTarball:tarball error:&error];
+    
+    XCTAssertTrue(reader.didExtractEntry);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:_destinationURL], _executableData);
+}
+
+- (void)testFixture {
+    NSURL *fileURL = [[NSBundle bundleForClass:[self class]] URLForResource:@"Data/deflate" withExtension:@"tar.gz"];
+    NSURL *expectedURL = [[NSBundle bundleForClass:[self class]] URLForResource:@"Data/deflate" withExtension:nil];
+    
+    NSError *error = nil;
+    EMTarballReader *reader = [EMTarballReader readerByExtractingEntryWithName:@"deflate" fromFileURL:fileURL toURL:_destinationURL progress:nil error:&error];
+    
+    XCTAssertTrue(reader.didExtractEntry);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:_destinationURL], [NSData dataWithContentsOfURL:expectedURL]);
+}
+
+- (void)testByteByByte {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "README", '0', [NSData dataWithBytes:"readme" length:6], 0644);
+    _EMAppendTarEntry(tarball, "emporter", '0', _executableData, 0755);
+    _EMFinishTarball(tarball);
+    
+    NSData *data = _EMGzipData(tarball);
+    EMTarballReader *reader = [[EMTarballReader alloc] initWithEntryName:@"emporter" destinationURL:_destinationURL];
+    
+    for (NSUInteger i = 0; i < data.length && !reader.didExtractEntry; i++) {
+        XCTAssertTrue([reader appendBytes:(const uint8_t *)data.bytes + i length:1 error:NULL]);
+    }
+    
+    XCTAssertTrue([reader finishWithError:NULL]);
+    XCTAssertTrue(reader.didExtractEntry);
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:_destinationURL], _executableData);
+}
+
+- (void)testTruncatedArchive {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "emporter", '0', [NSMutableData dataWithLength:64 * 1024], 0755);
+    _EMFinishTarball(tarball);
+    
+    NSData *data = _EMGzipData(tarball);
+    EMTarballReader *reader = [[EMTarballReader alloc] initWithEntryName:@"emporter" destinationURL:_destinationURL];
+    
+    XCTAssertTrue([reader appendBytes:data.bytes length:data.length / 2 error:NULL]);
+    
+    NSError *error = nil;
+    XCTAssertFalse([reader finishWithError:&error]);
+    XCTAssertEqualObjects(error.domain, NSCocoaErrorDomain);
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+    
+    // Partially written files are removed
+    XCTAssertFalse(reader.didExtractEntry);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:_destinationURL.path]);
+}
+
+- (void)testCorruptHeader {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "emporter", '0', _executableData, 0755);
+    _EMFinishTarball(tarball);
+    
+    ((uint8_t *)tarball.mutableBytes)[0] = 'E';
+    
+    NSError *error = nil;
+    XCTAssertNil([self _extractTarball:tarball error:&error]);
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+}
+
+- (void)testNotCompressed {
+    NSURL *fileURL = [_tempDir URLByAppendingPathComponent:@"update.tar"];
+    [_executableData writeToURL:fileURL atomically:NO];
+    
+    NSError *error = nil;
+    XCTAssertNil([EMTarballReader readerByExtractingEntryWithName:@"emporter" fromFileURL:fileURL toURL:_destinationURL progress:nil error:&error]);
+    XCTAssertEqual(error.code, NSFileReadCorruptFileError);
+}
+
+- (void)testProgress {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "emporter", '0', _executableData, 0755);
+    _EMAppendTarEntry(tarball, "README", '0', [NSMutableData dataWithLength:1024 * 1024], 0644);
+    _EMFinishTarball(tarball);
+    
+    NSURL *fileURL = [self _writeTarball:tarball];
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:0];
+    
+    XCTAssertNotNil([EMTarballReader readerByExtractingEntryWithName:@"emporter" fromFileURL:fileURL toURL:_destinationURL progress:progress error:NULL]);
+    
+    NSNumber *fileSize = nil;
+    [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+    
+    XCTAssertEqual(progress.totalUnitCount, fileSize.longLongValue);
+    XCTAssertEqual(progress.completedUnitCount, progress.totalUnitCount);
+}
+
+- (void)testCancelation {
+    NSMutableData *tarball = [NSMutableData data];
+    _EMAppendTarEntry(tarball, "emporter", '0', _executableData, 0755);
+    _EMFinishTarball(tarball);
+    
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:0];
+    [progress cancel];
+    
+    NSError *error = nil;
+    XCTAssertNil([EMTarballReader readerByExtractingEntryWithName:@"emporter" fromFileURL:[self _writeTarball:tarball] toURL:_destinationURL progress:progress error:&error]);
+    XCTAssertEqual(error.code, NSUserCancelledError);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:_destinationURL.path]);
+}
+
+- (void)testPerformance {
+    NSMutableData *tarball = [NSMutableData data];
+    NSMutableData *payload = [NSMutableData dataWithLength:64 * 1024 * 1024];
+    
+    for (NSUInteger i = 0; i < payload.length; i += 4096) {
+        ((uint8_t *)payload.mutableBytes)[i] = (uint8_t)(i / 4096);
+    }
+    
+    _EMAppendTarEntry(tarball, "README", '0', payload, 0644);
+    _EMAppendTarEntry(tarball, "emporter", '0', payload, 0755);
+    _EMFinishTarball(tarball);
+    
+    NSURL *fileURL = [self _writeTarball:tarball];
+    
+    [self measureBlock:^{
+        EMTarballReader *reader = [EMTarballReader readerByExtractingEntryWithName:@"emporter" fromFileURL:fileURL toURL:self.destinationURL progress:nil error:NULL];
+        XCTAssertTrue(reader.didExtractEntry);
+    }];
+}
+
+@end
@@ -0,0 +1,43 @@
+//
+//  EMTestHTTPServer.h
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A minimal HTTP server on the loopback interface, used to stand in for release servers.
+ 
+ The server responds to GET requests for its URL with its data, and supports range (Range/If-Range) and conditional (If-None-Match) requests.
+ */
+@interface EMTestHTTPServer : NSObject
+
+/*! Start a server for data with an entity tag. Returns nil if the server could not be started. */
+- (nullable instancetype)initWithData:(NSData *)data entityTag:(NSString *)entityTag;
+
+/*! The URL for the data */
+@property(nonatomic,readonly) NSURL *url;
+
+/*! The data returned by the server */
+@property(atomic) NSData *data;
+
+/*! The entity tag of the data */
+@property(atomic,copy) NSString *entityTag;
+
+/*! If non-zero, the connection for the next request is dropped after this many bytes of data have been sent */
+@property(atomic) NSUInteger truncateAfterLength;
+
+/*! The headers of each request received by the server (with lowercase names) */
+@property(atomic,readonly) NSArray<NSDictionary<NSString*,NSString*>*> *requestHeaders;
+
+/*! Stop accepting connections */
+- (void)stop;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,192 @@
+//
+//  EMTestHTTPServer.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#import "EMTestHTTPServer.h"
+
+
+static BOOL _EMWriteAll(int fd, const void *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t count = write(fd, bytes, length);
+        
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        
+        bytes = (const uint8_t *)bytes + count;
+        length -= (size_t)count;
+    }
+    
+    return YES;
+}
+
+@implementation EMTestHTTPServer {
+    int _fd;
+    dispatch_source_t _acceptSource;
+    NSMutableArray *_requestHeaders;
+}
+
+- (instancetype)initWithData:(NSData *)data entityTag:(NSString *)entityTag {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _data = data;
+    _entityTag = [entityTag copy];
+    _requestHeaders = [NSMutableArray array];
+    
+    struct sockaddr_in addr = {0};
+    addr.sin_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    socklen_t addrLength = sizeof(addr);
+    int on = 1;
+    
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    
+    if (_fd < 0 || bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(_fd, 8) != 0 || getsockname(_fd, (struct sockaddr *)&addr, &addrLength) != 0) {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+        return nil;
+    }
+    
+    _url = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%d/emporter.tar.gz", ntohs(addr.sin_port)]];
+    
+    int fd = _fd;
+    __weak EMTestHTTPServer *weakSelf = self;
+    
+    _acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0));
+    dispatch_source_set_event_handler(_acceptSource, ^{
+        int clientFd = accept(fd, NULL, NULL);
+        
+        if (clientFd >= 0) {
+            [weakSelf _handleConnection:clientFd];
+            close(clientFd);
+        }
+    });
+    dispatch_source_set_cancel_handler(_acceptSource, ^{
+        close(fd);
+    });
+    dispatch_resume(_acceptSource);
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self stop];
+}
+
+- (void)stop {
+    if (_acceptSource != nil) {
+        dispatch_source_cancel(_acceptSource);
+        _acceptSource = nil;
+    }
+}
+
+- (NSArray *)requestHeaders {
+    @synchronized (_requestHeaders) {
+        return [_requestHeaders copy];
+    }
+}
+
+- (void)_handleConnection:(int)fd {
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    
+    NSMutableData *request = [NSMutableData data];
+    NSData *separator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    uint8_t buffer[4096];
+    
+    while ([request rangeOfData:separator options:0 range:NSMakeRange(0, request.length)].location == NSNotFound) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count <= 0) {
+            return;
+        }
+        [request appendBytes:buffer length:(NSUInteger)count];
+    }
+    
+    NSArray<NSString*> *lines = [[[NSString alloc] initWithData:request encoding:NSASCIIStringEncoding] componentsSeparatedByString:@"\r\n"];
+    NSMutableDictionary *headers = [NSMutableDictionary dictionary];
+    
+    for (NSString *line in [lines subarrayWithRange:NSMakeRange(1, lines.count - 1)]) {
+        NSRange range = [line rangeOfString:@": "];
+        if (range.location != NSNotFound) {
+            headers[[line substringToIndex:range.location].lowercaseString] = [line substringFromIndex:NSMaxRange(range)];
+        }
+    }
+    
+    @synchronized (_requestHeaders) {
+        [_requestHeaders addObject:headers];
+    }
+    
+    if (![[lines.firstObject componentsSeparatedByString:@" "][1] isEqualToString:_url.path]) {
+        NSString *response = @"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        _EMWriteAll(fd, response.UTF8String, strlen(response.UTF8String));
+        return;
+    }
+    
+    NSData *data = self.data;
+    NSString *entityTag = self.entityTag;
+    NSUInteger truncateAfterLength = self.truncateAfterLength;
+    
+    // Connections are only dropped once
+    self.truncateAfterLength = 0;
+    
+    if ([headers[@"if-none-match"] isEqualToString:entityTag]) {
+        NSString *response = [NSString stringWithFormat:@"HTTP/1.1 304 Not Modified\r\nETag: %@\r\nConnection: close\r\n\r\n", entityTag];
+        _EMWriteAll(fd, response.UTF8String, strlen(response.UTF8String));
+        return;
+    }
+    
+    NSUInteger offset = 0;
+    BOOL isPartial = NO;
+    unsigned long long rangeOffset = 0;
+    
+    if (headers[@"range"] != nil && (headers[@"if-range"] == nil || [headers[@"if-range"] isEqualToString:entityTag])) {
+        NSScanner *scanner = [NSScanner scannerWithString:headers[@"range"]];
+        
+        if ([scanner scanString:@"bytes=" intoString:NULL] && [scanner scanUnsignedLongLong:&rangeOffset] && rangeOffset < data.length) {
+            offset = (NSUInteger)rangeOffset;
+            isPartial = YES;
+        }
+    }
+    
+    NSMutableString *response = [NSMutableString string];
+    
+    if (isPartial) {
+        [response appendString:@"HTTP/1.1 206 Partial Content\r\n"];
+        [response appendFormat:@"Content-Range: bytes %lu-%lu/%lu\r\n", (unsigned long)offset, (unsigned long)data.length - 1, (unsigned long)data.length];
+    } else {
+        [response appendString:@"HTTP/1.1 200 OK\r\n"];
+    }
+    
+    [response appendFormat:@"Content-Length: %lu\r\n", (unsigned long)(data.length - offset)];
+    [response appendFormat:@"ETag: %@\r\n", entityTag];
+    [response appendString:@"Accept-Ranges: bytes\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n"];
+    
+    NSUInteger length = data.length - offset;
+    if (truncateAfterLength > 0 && truncateAfterLength < length) {
+        length = truncateAfterLength;
+    }
+    
+    if (_EMWriteAll(fd, response.UTF8String, strlen(response.UTF8String))) {
+        _EMWriteAll(fd, (const uint8_t *)data.bytes + offset, length);
+    }
+}
+
+@end
@@ -0,0 +1,164 @@
+//
+//  EMTunnelFilterTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMTunnelFilter.h"
+
+
+@interface EMTunnelFilterTests : XCTestCase
+@property(nonatomic) NSArray<EMTunnelSnapshot*> *snapshots;
+@end
+
+@implementation EMTunnelFilterTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _snapshots = @[
+                   [[EMTunnelSnapshot alloc] initWithValues:@{@"id": @"7A1C1C55-1B0C-4F5B-9C0A-4C6F5D0C8A01", @"name": @"api", @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @8080,
+                                                              @"remoteUrl": @"https://api.emporter.eu"}],
+                   [[EMTunnelSnapshot alloc] initWithValues:@{@"id": @"7A1C1C55-1B0C-4F5B-9C0A-4C6F5D0C8A02", @"name": @"blog", @"kind": @(EmporterTunnelKindDirectory),
+                                                              @"directory": [NSURL fileURLWithPath:@"/Users/test/Sites/blog" isDirectory:YES]}],
+                   [[EMTunnelSnapshot alloc] initWithValues:@{@"id": @"7A1C1C55-1B0C-4F5B-9C0A-4C6F5D0C8A03", @"name": @"docs", @"kind": @(EmporterTunnelKindDirectory),
+                                                              @"directory": [NSURL fileURLWithPath:@"/Users/test/Projects/docs/public" isDirectory:YES]}],
+                   [[EMTunnelSnapshot alloc] initWithValues:@{@"id": @"7A1C1C55-1B0C-4F5B-9C0A-4C6F5D0C8A04", @"name": @"API-v2", @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @80}],
+                   ];
+}
+
+- (NSArray *)_namesMatchingFilters:(NSArray<NSString*> *)inputs {
+    EMTunnelFilter *filter = [[EMTunnelFilter alloc] init];
+    
+    for (NSString *input in inputs) {
+        XCTAssertTrue([filter addFilterWithString:input], @"%@", input);
+    }
+    
+    XCTAssertEqual(filter.count, inputs.count);
+    return [[filter filteredSnapshots:_snapshots] valueForKey:@"name"];
+}
+
+- (void)testEmpty {
+    EMTunnelFilter *filter = [[EMTunnelFilter alloc] init];
+    
+    XCTAssertEqual(filter.count, 0);
+    XCTAssertFalse(filter.isStatic);
+    XCTAssertNil(filter.filterDescription);
+    XCTAssertEqualObjects([filter filteredSnapshots:_snapshots], _snapshots);
+    XCTAssertFalse([filter matchesSnapshot:nil]);
+    XCTAssertFalse([filter addFilterWithString:@""]);
+}
+
+- (void)testSources {
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"8080"]], @[@"api"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"localhost"]], @[@"API-v2"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"http://localhost:8080/path"]], @[@"api"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"https://api.emporter.eu"]], @[@"api"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"https://api.emporter.eu:443"]], @[@"api"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"/Users/test/Sites/blog/"]], @[@"blog"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"7a1c1c55-1b0c-4f5b-9c0a-4c6f5d0c8a03"]], @[@"docs"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"9000"]], @[]);
+    
+    // Any filter can match
+    XCTAssertEqualObjects([self _namesMatchingFilters:(@[@"8080", @"/Users/test/Sites/blog", @"9000"])], (@[@"api", @"blog"]));
+}
+
+- (void)testGlobs {
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"api*"]], (@[@"api", @"API-v2"]));
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"/Users/test/*/blog"]], @[@"blog"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"/Users/test/Projects/*/public"]], @[@"docs"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"/Users/*/*/*"]], @[@"blog"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"/Users/test/Sites/[a-c]*"]], @[@"blog"]);
+    XCTAssertEqualObjects([self _namesMatchingFilters:@[@"/Users/test/Site?"]], @[]);
+}
+
+- (void)testStatic {
+    EMTunnelFilter *filter = [[EMTunnelFilter alloc] init];
+    [filter addFilterWithString:_snapshots[0].id];
+    [filter addFilterWithString:_snapshots[1].id];
+    
+    XCTAssertTrue(filter.isStatic);
+    XCTAssertEqualObjects(filter.tunnelIdentifiers, ([NSSet setWithObjects:_snapshots[0].id, _snapshots[1].id, nil]));
+    
+    // Identifiers match case-insensitively, but are kept as they were given
+    [filter addFilterWithString:_snapshots[2].id.lowercaseString];
+    
+    XCTAssertTrue([filter matchesSnapshot:_snapshots[2]]);
+    XCTAssertEqualObjects(filter.tunnelIdentifiers, ([NSSet setWithObjects:_snapshots[0].id, _snapshots[1].id, _snapshots[2].id.lowercaseString, nil]));
+    
+    [filter addFilterWithString:@"8080"];
+    XCTAssertFalse(filter.isStatic);
+    XCTAssertEqualObjects(filter.filterDescription, ([NSString stringWithFormat:@"%@, %@, %@, port 8080", _snapshots[0].id, _snapshots[1].id, _snapshots[2].id.lowercaseString]));
+}
+
+- (void)testPerformance {
+    const NSUInteger count = 1000;
+    
+    NSMutableArray<EMTunnelSnapshot*> *snapshots = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray<NSString*> *inputs = [NSMutableArray arrayWithCapacity:count];
+    
+    // Half of the tunnels are proxies and half are directories; every other tunnel is matched by a port, directory, id or glob
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *tunnelId = [NSUUID UUID].UUIDString;
+        NSString *directory = [NSString stringWithFormat:@"/Users/test/Sites/site-%lu", i];
+        
+        if (i % 2 == 0) {
+            [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:@{@"id": tunnelId, @"name": @(i).stringValue, @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @(10000 + i)}]];
+        } else {
+            [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:@{@"id": tunnelId, @"name": @(i).stringValue, @"kind": @(EmporterTunnelKindDirectory),
+                                                                            @"directory": [NSURL fileURLWithPath:directory isDirectory:YES]}]];
+        }
+        
+        switch (i % 8) {
+            case 0: [inputs addObject:@(10000 + i).stringValue]; break;
+            case 1: [inputs addObject:directory]; break;
+            case 2: [inputs addObject:tunnelId]; break;
+            case 3: [inputs addObject:[NSString stringWithFormat:@"/Users/test/Sites/site-%lu?", i / 10]]; break;
+            default: [inputs addObject:@(20000 + i).stringValue]; break;
+        }
+    }
+    
+    EMTunnelFilter *filter = [[EMTunnelFilter alloc] init];
+    for (NSString *input in inputs) {
+        [filter addFilterWithString:input];
+    }
+    
+    // An equivalent predicate, as evaluated by the previous implementation (one predicate per filter)
+    NSMutableArray *predicates = [NSMutableArray arrayWithCapacity:count];
+    for (NSString *input in inputs) {
+        if ([input hasPrefix:@"/"] && [input hasSuffix:@"?"]) {
+            [predicates addObject:[NSPredicate predicateWithFormat:@"directory.path LIKE %@", input]];
+        } else if ([input hasPrefix:@"/"]) {
+            [predicates addObject:[NSPredicate predicateWithFormat:@"directory.path == %@", input]];
+        } else if ([input containsString:@"-"]) {
+            [predicates addObject:[NSPredicate predicateWithFormat:@"id == %@", input]];
+        } else {
+            [predicates addObject:[NSPredicate predicateWithFormat:@"proxyPort == %@", @(input.integerValue)]];
+        }
+    }
+    
+    NSPredicate *predicate = [NSCompoundPredicate orPredicateWithSubpredicates:predicates];
+    NSUInteger expectedCount = [snapshots filteredArrayUsingPredicate:predicate].count;
+    
+    NSDate *predicateStart = [NSDate date];
+    [snapshots filteredArrayUsingPredicate:predicate];
+    NSTimeInterval predicateDuration = -predicateStart.timeIntervalSinceNow;
+    
+    __block NSUInteger matchedCount = 0;
+    __block NSTimeInterval filterDuration = 0;
+    
+    [self measureBlock:^{
+        NSDate *start = [NSDate date];
+        matchedCount = [filter filteredSnapshots:snapshots].count;
+        filterDuration = -start.timeIntervalSinceNow;
+    }];
+    
+    XCTAssertEqual(matchedCount, expectedCount);
+    NSLog(@"%lu filters × %lu tunnels: %.2fms indexed, %.2fms predicate", inputs.count, snapshots.count, filterDuration * 1000, predicateDuration * 1000);
+}
+
+@end
@@ -0,0 +1,157 @@
+//
+//  EMTunnelListViewTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMDisplayWidth.h"
+#import "EMTunnelListView.h"
+
+
+@interface EMTunnelListViewTests : XCTestCase
+@property(nonatomic) NSArray<EMTunnelSnapshot*> *tunnels;
+@end
+
+@implementation EMTunnelListViewTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    YDCommandOutputStyleDisabled = YES;
+    
+    NSMutableArray *tunnels = [NSMutableArray array];
+    
+    // The last tunnel has the widest source, so columns are only aligned across pages if every row is measured
+    for (NSUInteger i = 0; i < 10; i++) {
+        NSString *name = [NSString stringWithFormat:@"site-%lu", i];
+        NSString *directory = [NSString stringWithFormat:@"/Users/test/Sites/%@", i == 9 ? @"a-much-longer-directory-name" : name];
+        
+        [tunnels addObject:[[EMTunnelSnapshot alloc] initWithValues:@{@"id": name, @"name": name, @"kind": @(EmporterTunnelKindDirectory),
+                                                                      @"directory": [NSURL fileURLWithPath:directory isDirectory:YES],
+                                                                      @"state": @(EmporterTunnelStateConnected),
+                                                                      @"remoteUrl": [NSString stringWithFormat:@"https://%@.emporter.eu", name]}]];
+    }
+    
+    _tunnels = tunnels;
+}
+
+- (void)tearDown {
+    YDCommandOutputStyleDisabled = NO;
+}
+
+- (NSArray<NSString*> *)_linesWrittenByListView:(EMTunnelListView *)listView numberOfLines:(NSUInteger)numberOfLines {
+    NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+        [listView writeToOutput:output numberOfLines:numberOfLines];
+    }];
+    
+    NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    return [[string stringByTrimmingCharactersInSet:[NSCharacterSet newlineCharacterSet]] componentsSeparatedByString:@"\n"];
+}
+
+- (void)testWritesEveryRowWithoutLimit {
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = _tunnels;
+    
+    NSArray<NSString*> *lines = [self _linesWrittenByListView:listView numberOfLines:0];
+    
+    XCTAssertEqual(lines.count, 11);
+    XCTAssertTrue([lines[0] hasPrefix:@"      SOURCE"]);
+    XCTAssertTrue([lines[1] containsString:@"site-0/"]);
+    XCTAssertTrue([lines[10] containsString:@"https://site-9.emporter.eu"]);
+    
+    NSUInteger urlColumn = [lines[0] rangeOfString:@"URL"].location;
+    for (NSUInteger i = 1; i < lines.count; i++) {
+        XCTAssertEqual([lines[i] rangeOfString:@"https://"].location, urlColumn);
+    }
+}
+
+- (void)testColumnsAreAlignedByDisplayWidth {
+    NSMutableArray *tunnels = [_tunnels mutableCopy];
+    tunnels[1] = [tunnels[1] snapshotByApplyingValues:@{@"directory": [NSURL fileURLWithPath:@"/Users/test/Sites/ウェブサイト" isDirectory:YES]}];
+    
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = tunnels;
+    
+    NSArray<NSString*> *lines = [self _linesWrittenByListView:listView numberOfLines:0];
+    NSUInteger urlColumn = EMDisplayWidth([lines[0] substringToIndex:[lines[0] rangeOfString:@"URL"].location]);
+    
+    // Wide characters use 2 columns, so the row containing them is padded with fewer spaces
+    XCTAssertTrue([lines[2] containsString:@"ウェブサイト/"]);
+    
+    for (NSUInteger i = 1; i < lines.count; i++) {
+        XCTAssertEqual(EMDisplayWidth([lines[i] substringToIndex:[lines[i] rangeOfString:@"https://"].location]), urlColumn);
+    }
+}
+
+- (void)testWritesVisibleRows {
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = _tunnels;
+    
+    NSArray<NSString*> *lines = [self _linesWrittenByListView:listView numberOfLines:5];
+    
+    // The header, 3 rows and the position within the list
+    XCTAssertEqual(lines.count, 5);
+    XCTAssertTrue([lines[1] containsString:@"site-0/"]);
+    XCTAssertTrue([lines[3] containsString:@"site-2/"]);
+    XCTAssertTrue([lines[4] containsString:@"1-3 of 10 URLs"]);
+    
+    // Columns are aligned to the widest row, even if it isn't visible
+    XCTAssertEqual([lines[1] rangeOfString:@"https://"].location, [lines[0] rangeOfString:@"URL"].location);
+    XCTAssertGreaterThan([lines[0] rangeOfString:@"URL"].location, @"      site-0/".length + 5);
+}
+
+- (void)testScrolling {
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = _tunnels;
+    
+    NSString *header = [self _linesWrittenByListView:listView numberOfLines:5].firstObject;
+    
+    XCTAssertFalse([listView scrollWithKey:EMWindowKeyUp]);
+    XCTAssertTrue([listView scrollWithKey:EMWindowKeyDown]);
+    XCTAssertEqual(listView.scrollOffset, 1);
+    
+    XCTAssertTrue([listView scrollWithKey:EMWindowKeyEnd]);
+    XCTAssertEqual(listView.scrollOffset, 7);
+    XCTAssertFalse([listView scrollWithKey:EMWindowKeyPageDown]);
+    
+    NSArray<NSString*> *lines = [self _linesWrittenByListView:listView numberOfLines:5];
+    XCTAssertEqualObjects(lines[0], header);
+    XCTAssertTrue([lines[3] containsString:@"a-much-longer-directory-name/"]);
+    XCTAssertTrue([lines[4] containsString:@"8-10 of 10 URLs"]);
+    
+    XCTAssertTrue([listView scrollWithKey:EMWindowKeyPageUp]);
+    XCTAssertEqual(listView.scrollOffset, 4);
+    XCTAssertTrue([listView scrollWithKey:EMWindowKeyHome]);
+    XCTAssertEqual(listView.scrollOffset, 0);
+}
+
+- (void)testScrollOffsetIsClampedWhenTunnelsAreRemoved {
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = _tunnels;
+    listView.scrollOffset = 7;
+    
+    listView.tunnels = [_tunnels subarrayWithRange:NSMakeRange(0, 4)];
+    NSArray<NSString*> *lines = [self _linesWrittenByListView:listView numberOfLines:4];
+    
+    XCTAssertEqual(listView.scrollOffset, 2);
+    XCTAssertTrue([lines[1] containsString:@"site-2/"]);
+    XCTAssertTrue([lines[3] containsString:@"3-4 of 4 URLs"]);
+}
+
+- (void)testChangedTunnelsAreFormattedAgain {
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = _tunnels;
+    
+    NSMutableArray *tunnels = [_tunnels mutableCopy];
+    tunnels[0] = [tunnels[0] snapshotByApplyingValues:@{@"state": @(EmporterTunnelStateConflicted), @"conflictReason": @"Address already in use"}];
+    listView.tunnels = tunnels;
+    
+    NSArray<NSString*> *lines = [self _linesWrittenByListView:listView numberOfLines:0];
+    XCTAssertTrue([lines[1] containsString:@"Address already in use"]);
+    XCTAssertTrue([lines[2] containsString:@"https://site-1.emporter.eu"]);
+}
+
+@end
@@ -0,0 +1,176 @@
+//
+//  EMTunnelSnapshotStoreTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMTunnelSnapshotStore.h"
+#import "EMUtils.h"
+
+
+/*! A mock Emporter backend which serves tunnel values from memory and counts each fetch */
+@interface EMMockTunnelSource : NSObject <EMTunnelSnapshotSource>
+@property(nonatomic,readonly) NSMutableDictionary<NSString*,NSMutableDictionary*> *tunnels;
+@property(nonatomic,readonly) NSMutableArray<NSString*> *tunnelIds;
+@property(nonatomic) NSUInteger numberOfBulkFetches;
+@property(nonatomic) NSUInteger numberOfPropertyReads;
+- (void)addTunnelWithValues:(NSDictionary *)values;
+@end
+
+@implementation EMMockTunnelSource
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _tunnels = [NSMutableDictionary dictionary];
+    _tunnelIds = [NSMutableArray array];
+    
+    return self;
+}
+
+- (void)addTunnelWithValues:(NSDictionary *)values {
+    [_tunnelIds addObject:values[@"id"]];
+    _tunnels[values[@"id"]] = [values mutableCopy];
+}
+
+- (NSArray<EMTunnelSnapshot *> *)fetchTunnelSnapshots {
+    _numberOfBulkFetches++;
+    
+    NSMutableArray *snapshots = [NSMutableArray array];
+    for (NSString *tunnelId in _tunnelIds) {
+        [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:_tunnels[tunnelId]]];
+    }
+    
+    return snapshots;
+}
+
+- (EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = [self fetchValuesForKeys:EMTunnelSnapshot.allKeys ofTunnelWithIdentifier:identifier];
+    return values ? [[EMTunnelSnapshot alloc] initWithValues:values] : nil;
+}
+
+- (NSDictionary<NSString *,id> *)fetchValuesForKeys:(NSArray<NSString *> *)keys ofTunnelWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = _tunnels[identifier];
+    if (values == nil) {
+        return nil;
+    }
+    
+    _numberOfPropertyReads += keys.count;
+    return [values dictionaryWithValuesForKeys:keys];
+}
+
+@end
+
+
+@interface EMTunnelSnapshotStoreTests : XCTestCase
+@property(nonatomic) EMMockTunnelSource *source;
+@end
+
+@implementation EMTunnelSnapshotStoreTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _source = [EMMockTunnelSource new];
+    [_source addTunnelWithValues:@{@"id": @"a", @"name": @"a", @"state": @(EmporterTunnelStateConnecting), @"kind": @(EmporterTunnelKindProxy), @"proxyPort": @8080}];
+    [_source addTunnelWithValues:@{@"id": @"b", @"name": @"b", @"state": @(EmporterTunnelStateConnected), @"kind": @(EmporterTunnelKindDirectory), @"directory": [NSURL fileURLWithPath:@"/tmp/b"]}];
+}
+
+- (void)testReload {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    [store reload];
+    
+    XCTAssertEqual(_source.numberOfBulkFetches, 1);
+    XCTAssertEqual(_source.numberOfPropertyReads, 0);
+    XCTAssertEqualObjects([store.snapshots valueForKey:@"id"], (@[@"a", @"b"]));
+    XCTAssertEqualObjects([store snapshotWithIdentifier:@"b"].directory.path, @"/tmp/b");
+}
+
+- (void)testStateUpdateOnlyFetchesState {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    [store reload];
+    
+    _source.tunnels[@"a"][@"state"] = @(EmporterTunnelStateConnected);
+    _source.tunnels[@"a"][@"remoteUrl"] = @"https://a.emporter.eu";
+    _source.tunnels[@"a"][@"proxyPort"] = @9090;
+    
+    EMTunnelSnapshot *snapshot = [store updateStateOfSnapshotWithIdentifier:@"a"];
+    
+    XCTAssertEqual(_source.numberOfPropertyReads, EMTunnelSnapshot.stateKeys.count);
+    XCTAssertEqual(snapshot.state, EmporterTunnelStateConnected);
+    XCTAssertEqualObjects(snapshot.remoteUrl, @"https://a.emporter.eu");
+    
+    // Configuration isn't fetched for state changes
+    XCTAssertEqualObjects(snapshot.proxyPort, @8080);
+    XCTAssertEqualObjects([store snapshotWithIdentifier:@"a"], snapshot);
+}
+
+- (void)testStateUpdateForUnknownTunnelFetchesSnapshot {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    
+    EMTunnelSnapshot *snapshot = [store updateStateOfSnapshotWithIdentifier:@"b"];
+    
+    XCTAssertEqual(_source.numberOfPropertyReads, EMTunnelSnapshot.allKeys.count);
+    XCTAssertEqualObjects(snapshot.id, @"b");
+    XCTAssertEqual(store.snapshots.count, 1);
+}
+
+- (void)testConfigurationUpdate {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    [store reload];
+    
+    _source.tunnels[@"a"][@"proxyPort"] = @9090;
+    
+    XCTAssertEqualObjects([store updateSnapshotWithIdentifier:@"a"].proxyPort, @9090);
+    XCTAssertEqualObjects([store.snapshots valueForKey:@"id"], (@[@"a", @"b"]));
+}
+
+- (void)testRemovedTunnels {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    [store reload];
+    
+    XCTAssertEqualObjects([store removeSnapshotWithIdentifier:@"a"].id, @"a");
+    XCTAssertNil([store removeSnapshotWithIdentifier:@"a"]);
+    
+    // Tunnels which no longer exist are removed when updated
+    [_source.tunnels removeObjectForKey:@"b"];
+    XCTAssertNil([store updateStateOfSnapshotWithIdentifier:@"b"]);
+    XCTAssertEqual(store.snapshots.count, 0);
+}
+
+- (void)testPredicateEvaluation {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    [store reload];
+    
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"proxyPort == 8080"];
+    NSArray *snapshots = [store.snapshots filteredArrayUsingPredicate:predicate];
+    
+    XCTAssertEqualObjects([snapshots valueForKey:@"id"], (@[@"a"]));
+}
+
+- (void)testJSONObject {
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    [store reload];
+    
+    NSDictionary *proxy = EMJSONObjectForTunnelSnapshot([store snapshotWithIdentifier:@"a"], YES);
+    NSDictionary *directory = EMJSONObjectForTunnelSnapshot([store snapshotWithIdentifier:@"b"], NO);
+    
+    XCTAssertEqualObjects(proxy[@"kind"], @"proxy");
+    XCTAssertEqualObjects(proxy[@"proxyPort"], @8080);
+    XCTAssertEqualObjects(proxy[@"proxyHostHeader"], @"localhost");
+    XCTAssertEqualObjects(proxy[@"state"], @"connecting");
+    XCTAssertEqualObjects(proxy[@"url"], [NSNull null]);
+    
+    XCTAssertEqualObjects(directory[@"kind"], @"directory");
+    XCTAssertEqualObjects(directory[@"directory"], @"/tmp/b");
+    XCTAssertEqualObjects(directory[@"directoryIndexFile"], @"index.html");
+    XCTAssertNil(directory[@"state"]);
+}
+
+@end
@@ -0,0 +1,197 @@
+//
+//  EMTunnelSnapshotTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMTunnelSnapshot.h"
+
+
+/*! A fake Emporter backend which simulates the latency of each request (Apple Event) */
+@interface EMFakeTunnelBackend : NSObject
+@property(nonatomic) NSTimeInterval latency;
+@property(nonatomic) NSUInteger numberOfRequests;
+- (void)performRequest;
+@end
+
+@implementation EMFakeTunnelBackend
+
+- (void)performRequest {
+    _numberOfRequests++;
+    
+    if (_latency > 0) {
+        [NSThread sleepForTimeInterval:_latency];
+    }
+}
+
+@end
+
+
+/*! A fake tunnel which performs a request for every property read */
+@interface EMFakeTunnel : NSObject
+- (instancetype)initWithBackend:(EMFakeTunnelBackend *)backend values:(NSDictionary *)values;
+@property(nonatomic,readonly) EMFakeTunnelBackend *backend;
+@property(nonatomic,readonly) NSDictionary *values;
+@end
+
+@implementation EMFakeTunnel
+
+- (instancetype)initWithBackend:(EMFakeTunnelBackend *)backend values:(NSDictionary *)values {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _backend = backend;
+    _values = values;
+    
+    return self;
+}
+
+- (NSDictionary *)properties {
+    [_backend performRequest];
+    return @{@"name": _values[@"name"]};
+}
+
+- (NSString *)name {
+    [_backend performRequest];
+    return nil;
+}
+
+- (NSURL *)directory {
+    [_backend performRequest];
+    return _values[@"directory"];
+}
+
+- (id)valueForKey:(NSString *)key {
+    [_backend performRequest];
+    return _values[key];
+}
+
+@end
+
+
+/*! A fake array of tunnels which can fetch a property for every tunnel using a single request (like SBElementArray) */
+@interface EMFakeTunnelArray : NSArray
+- (instancetype)initWithBackend:(EMFakeTunnelBackend *)backend tunnels:(NSArray<EMFakeTunnel*> *)tunnels;
+@end
+
+@implementation EMFakeTunnelArray {
+    EMFakeTunnelBackend *_backend;
+    NSArray<EMFakeTunnel*> *_tunnels;
+}
+
+- (instancetype)initWithBackend:(EMFakeTunnelBackend *)backend tunnels:(NSArray<EMFakeTunnel *> *)tunnels {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _backend = backend;
+    _tunnels = [tunnels copy];
+    
+    return self;
+}
+
+- (NSUInteger)count {
+    return _tunnels.count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    return _tunnels[index];
+}
+
+- (NSArray *)arrayByApplyingSelector:(SEL)selector {
+    [_backend performRequest];
+    
+    NSString *key = NSStringFromSelector(selector);
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:_tunnels.count];
+    
+    for (EMFakeTunnel *tunnel in _tunnels) {
+        if ([key isEqualToString:@"properties"]) {
+            [values addObject:@{@"name": tunnel.values[@"name"]}];
+        } else {
+            [values addObject:tunnel.values[key] ?: [NSNull null]];
+        }
+    }
+    
+    return values;
+}
+
+@end
+
+
+@interface EMTunnelSnapshotTests : XCTestCase
+@property(nonatomic) EMFakeTunnelBackend *backend;
+@property(nonatomic) EMFakeTunnelArray *tunnels;
+@end
+
+@implementation EMTunnelSnapshotTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    
+    _backend = [EMFakeTunnelBackend new];
+    
+    NSMutableArray *tunnels = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 50; i++) {
+        NSDictionary *values = @{
+                                 @"id": [NSString stringWithFormat:@"%lu", i],
+                                 @"name": [NSString stringWithFormat:@"tunnel-%lu", i],
+                                 @"remoteUrl": [NSString stringWithFormat:@"https://tunnel-%lu.emporter.eu", i],
+                                 @"state": @(EmporterTunnelStateConnected),
+                                 @"kind": @(EmporterTunnelKindProxy),
+                                 @"proxyPort": @(8000 + i),
+                                 @"isEnabled": @YES,
+                                 };
+        
+        [tunnels addObject:[[EMFakeTunnel alloc] initWithBackend:_backend values:values]];
+    }
+    
+    _tunnels = [[EMFakeTunnelArray alloc] initWithBackend:_backend tunnels:tunnels];
+}
+
+- (void)testPrefetchedSnapshots {
+    NSArray<EMTunnelSnapshot*> *snapshots = [EMTunnelSnapshot snapshotsOfTunnels:(id)_tunnels];
+    
+    XCTAssertEqual(snapshots.count, 50);
+    XCTAssertEqualObjects(snapshots[7].id, @"7");
+    XCTAssertEqualObjects(snapshots[7].name, @"tunnel-7");
+    XCTAssertEqualObjects(snapshots[7].proxyPort, @8007);
+    XCTAssertEqual(snapshots[7].state, EmporterTunnelStateConnected);
+    XCTAssertTrue(snapshots[7].isEnabled);
+    XCTAssertNil(snapshots[7].directory);
+    
+    // One request per key (plus the properties record), regardless of the number of tunnels
+    XCTAssertEqual(_backend.numberOfRequests, EMTunnelSnapshot.allKeys.count + 1);
+}
+
+- (void)testUnbatchedSnapshotsMatchPrefetchedSnapshots {
+    NSArray<EMTunnelSnapshot*> *prefetchedSnapshots = [EMTunnelSnapshot snapshotsOfTunnels:(id)_tunnels];
+    NSArray<EMTunnelSnapshot*> *snapshots = [EMTunnelSnapshot snapshotsOfTunnels:(id)[NSArray arrayWithArray:_tunnels]];
+    
+    XCTAssertEqualObjects(snapshots, prefetchedSnapshots);
+}
+
+- (void)testPrefetchPerformance {
+    _backend.latency = 0.0005;
+    
+    [self measureBlock:^{
+        [EMTunnelSnapshot snapshotsOfTunnels:(id)self.tunnels];
+    }];
+}
+
+- (void)testUnbatchedPerformance {
+    _backend.latency = 0.0005;
+    
+    NSArray *tunnels = [NSArray arrayWithArray:_tunnels];
+    
+    [self measureBlock:^{
+        [EMTunnelSnapshot snapshotsOfTunnels:tunnels];
+    }];
+}
+
+@end
@@ -8,6 +8,7 @@
 
 #import <XCTest/XCTest.h>
 #import "EMUpdateFeed.h"
+#import "EMTestHTTPServer.h"
 
 @interface EMUpdateFeedTests : XCTestCase
 
@@ -46,4 +47,190 @@
     [self waitForExpectations:@[readExpectation] timeout:2];
 }
 
+- (NSData *)_gitHubFeedData {
+    return [NSData dataWithContentsOfURL:[[NSBundle bundleForClass:[self class]] URLForResource:@"Data/GitHub/libvips" withExtension:@"json"]];
+}
+
+- (void)testReadLatestUpdate {
+    NSURL *feedURL = [[NSBundle bundleForClass:[self class]] URLForResource:@"Data/GitHub/libvips" withExtension:@"json"];
+    EMUpdateFeed *feed = [[EMUpdateFeed alloc] initWithURL:feedURL type:EMUpdateTypeGitHubRelease];
+    
+    XCTestExpectation *readExpectation = [self expectationWithDescription:@"read"];
+    
+    [feed readLatestUpdateWithCompletionHandler:^(EMUpdate *update, NSError *error) {
+        XCTAssertNotNil(update, @"%@", error);
+        XCTAssertTrue(EMVersionEquals(update.version, (EMVersion){8, 8, 0, "rc2"}), @"%@", EMVersionDescription(update.version));
+        XCTAssertEqualObjects(update.title, @"v8.8.0-rc2");
+        XCTAssertEqualObjects(update.body, @"");
+        XCTAssertEqual(update.assetURLs.count, 3);
+        
+        [readExpectation fulfill];
+    }];
+    
+    [self waitForExpectations:@[readExpectation] timeout:2];
+}
+
+- (void)testReadLatestUpdateOfBackportedFeed {
+    // Releases are listed by when they were created, so a backport can be listed before a newer version
+    NSString *contents = @"[{\"tag_name\": \"v0.3.5\", \"name\": \"Backport\", \"body\": \"Fixes\", \"assets\": []}, "
+                         @"{\"tag_name\": \"v0.4.0\", \"name\": \"Latest\", \"body\": \"Features\", \"assets\": []}, "
+                         @"{\"tag_name\": \"v0.3.4\", \"name\": \"Old\", \"body\": \"\", \"assets\": []}]";
+    
+    NSURL *feedURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    XCTAssertTrue([contents writeToURL:feedURL atomically:NO encoding:NSUTF8StringEncoding error:NULL]);
+    
+    EMUpdateFeed *feed = [[EMUpdateFeed alloc] initWithURL:feedURL type:EMUpdateTypeGitHubRelease];
+    XCTestExpectation *readExpectation = [self expectationWithDescription:@"read"];
+    
+    [feed readLatestUpdateWithCompletionHandler:^(EMUpdate *update, NSError *error) {
+        XCTAssertNotNil(update, @"%@", error);
+        XCTAssertTrue(EMVersionEquals(update.version, (EMVersion){0, 4, 0}), @"%@", EMVersionDescription(update.version));
+        XCTAssertEqualObjects(update.title, @"Latest");
+        XCTAssertEqualObjects(update.body, @"");
+        
+        [readExpectation fulfill];
+    }];
+    
+    [self waitForExpectations:@[readExpectation] timeout:2];
+    [[NSFileManager defaultManager] removeItemAtURL:feedURL error:NULL];
+}
+
+- (void)testScannedFeedMatchesDeserializedFeed {
+    NSData *data = [self _gitHubFeedData];
+    NSArray *plists = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+    
+    NSError *error = nil;
+    NSArray<EMUpdate*> *updates = [EMUpdateFeed updatesFromData:data type:EMUpdateTypeGitHubRelease options:0 error:&error];
+    XCTAssertNotNil(updates, @"%@", error);
+    XCTAssertEqual(updates.count, plists.count);
+    
+    [updates enumerateObjectsUsingBlock:^(EMUpdate *update, NSUInteger idx, BOOL *stop) {
+        EMUpdate *expected = [[EMUpdate alloc] initWithPropertyList:plists[idx] type:EMUpdateTypeGitHubRelease error:NULL];
+        
+        XCTAssertTrue(EMVersionEquals(update.version, expected.version));
+        XCTAssertEqualObjects(update.title, expected.title);
+        XCTAssertEqualObjects(update.body, expected.body);
+        XCTAssertEqualObjects(update.publishDate, expected.publishDate);
+        XCTAssertEqualObjects(update.assetURLs, expected.assetURLs);
+    }];
+}
+
+- (void)testScanEscapedFeed {
+    NSString *feed = @"[{\"body\": \"\\\"Quoted\\\" \\u00e9\", \"draft\": false, \"author\": {\"name\": \"[}\\\\\"}, \"name\": null, "
+                     @"\"tag_name\": \"v1.2.3\", \"assets\": [{\"id\": 1, \"browser_download_url\": \"https://example.com/a.tar.gz\"}, {}]}]";
+    
+    NSError *error = nil;
+    NSArray<EMUpdate*> *updates = [EMUpdateFeed updatesFromData:[feed dataUsingEncoding:NSUTF8StringEncoding] type:EMUpdateTypeGitHubRelease options:0 error:&error];
+    XCTAssertNotNil(updates, @"%@", error);
+    XCTAssertEqual(updates.count, 1);
+    
+    EMUpdate *update = updates.firstObject;
+    XCTAssertTrue(EMVersionEquals(update.version, (EMVersion){1, 2, 3}));
+    XCTAssertEqualObjects(update.title, @"");
+    XCTAssertEqualObjects(update.body, @"\"Quoted\" \u00e9");
+    XCTAssertEqualObjects(update.assetURLs, @[[NSURL URLWithString:@"https://example.com/a.tar.gz"]]);
+}
+
+- (void)testScanInvalidFeed {
+    NSData *data = [self _gitHubFeedData];
+    NSError *error = nil;
+    
+    XCTAssertNil([EMUpdateFeed updatesFromData:[data subdataWithRange:NSMakeRange(0, data.length / 2)] type:EMUpdateTypeGitHubRelease options:0 error:&error]);
+    XCTAssertNotNil(error);
+    
+    error = nil;
+    XCTAssertNil([EMUpdateFeed updatesFromData:[@"{\"message\": \"API rate limit exceeded\"}" dataUsingEncoding:NSUTF8StringEncoding] type:EMUpdateTypeGitHubRelease options:0 error:&error]);
+    XCTAssertNotNil(error);
+}
+
+- (NSArray<EMUpdate*> *)_readFeed:(EMUpdateFeed *)feed {
+    XCTestExpectation *readExpectation = [self expectationWithDescription:@"read"];
+    __block NSArray *feedUpdates = nil;
+    
+    [feed readFeedWithCompletionHandler:^(NSArray<EMUpdate *> *updates, NSError *error) {
+        XCTAssertNotNil(updates, @"%@", error);
+        feedUpdates = updates;
+        [readExpectation fulfill];
+    }];
+    
+    [self waitForExpectations:@[readExpectation] timeout:5];
+    
+    return feedUpdates;
+}
+
+- (void)testCachedFeed {
+    NSURL *cacheDirectoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    EMTestHTTPServer *server = [[EMTestHTTPServer alloc] initWithData:[self _gitHubFeedData] entityTag:@"\"1\""];
+    XCTAssertNotNil(server);
+    
+    EMUpdateFeed *feed = [[EMUpdateFeed alloc] initWithURL:server.url type:EMUpdateTypeGitHubRelease];
+    feed.cacheDirectoryURL = cacheDirectoryURL;
+    feed.cacheTimeToLive = 0;
+    
+    XCTAssertEqual([self _readFeed:feed].count, 29);
+    XCTAssertNil(server.requestHeaders.lastObject[@"if-none-match"]);
+    
+    // Expired feeds are revalidated
+    XCTAssertEqual([self _readFeed:feed].count, 29);
+    XCTAssertEqual(server.requestHeaders.count, 2);
+    XCTAssertEqualObjects(server.requestHeaders.lastObject[@"if-none-match"], @"\"1\"");
+    
+    // Recently validated feeds aren't requested
+    feed.cacheTimeToLive = 60;
+    XCTAssertEqual([self _readFeed:feed].count, 29);
+    XCTAssertEqual(server.requestHeaders.count, 2);
+    
+    [server stop];
+    [[NSFileManager defaultManager] removeItemAtURL:cacheDirectoryURL error:NULL];
+}
+
+- (void)testScanPerformance {
+    NSData *data = [self _gitHubFeedData];
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            [EMUpdateFeed updatesFromData:data type:EMUpdateTypeGitHubRelease options:0 error:NULL];
+        }
+    }];
+}
+
+- (void)testScanLatestUpdatePerformance {
+    NSData *data = [self _gitHubFeedData];
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            [EMUpdateFeed updatesFromData:data type:EMUpdateTypeGitHubRelease options:EMUpdateFeedReadingOmitsBody error:NULL];
+        }
+    }];
+}
+
+- (void)testDeserializePerformance {
+    NSData *data = [self _gitHubFeedData];
+    
+    // Baseline for the scanner
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            for (NSDictionary *plist in [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL]) {
+                (void)[[EMUpdate alloc] initWithPropertyList:plist type:EMUpdateTypeGitHubRelease error:NULL];
+            }
+        }
+    }];
+}
+
+- (void)testPatchURL {
+    NSDictionary *properties = @{@"version": @"0.4.0",
+                                 @"url": @[[NSURL URLWithString:@"https://example.com/emporter.tar.gz"],
+                                           [NSURL URLWithString:@"https://example.com/emporter-0.2.0-0.4.0.bsdiff"],
+                                           [NSURL URLWithString:@"https://example.com/emporter-0.3.0-0.4.0.bsdiff"]]};
+    
+    NSError *error = nil;
+    EMUpdate *update = [[EMUpdate alloc] initWithPropertyList:properties type:EMUpdateTypeKeyValues error:&error];
+    XCTAssertNotNil(update, @"%@", error);
+    
+    XCTAssertEqualObjects([update patchURLFromVersion:(EMVersion){0, 3, 0}], [NSURL URLWithString:@"https://example.com/emporter-0.3.0-0.4.0.bsdiff"]);
+    XCTAssertEqualObjects([update patchURLFromVersion:(EMVersion){0, 2, 0}], [NSURL URLWithString:@"https://example.com/emporter-0.2.0-0.4.0.bsdiff"]);
+    XCTAssertNil([update patchURLFromVersion:(EMVersion){0, 1, 0}]);
+    XCTAssertNil([update patchURLFromVersion:(EMVersion){0, 3, 0, "beta"}]);
+}
+
 @end
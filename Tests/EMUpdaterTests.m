@@ -7,6 +7,8 @@
 //
 
 #import <XCTest/XCTest.h>
+#include <CommonCrypto/CommonDigest.h>
+
 #import "EMUpdater.h"
 #import "EMUpdate.h"
 
@@ -109,4 +111,69 @@
     XCTAssertEqualObjects(states, (@[@(EMUpdaterStateExtracting), @(EMUpdaterStateCanceled)]));
 }
 
+- (void)testDigestManifest {
+    NSString *manifest = @"# Checksums\n"
+                         @"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef  emporter.tar.gz\n"
+                         @"0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF *dist/emporter-1.0.0.tar.gz\n";
+    
+    NSDictionary<NSString*,NSData*> *digests = EMUpdaterDigestsFromManifest(manifest);
+    
+    XCTAssertEqual(digests.count, 2);
+    XCTAssertEqual(digests[@"emporter.tar.gz"].length, CC_SHA256_DIGEST_LENGTH);
+    XCTAssertEqualObjects(digests[@"emporter.tar.gz"], digests[@"emporter-1.0.0.tar.gz"]);
+    
+    XCTAssertNil(EMUpdaterDigestsFromManifest(@"0123 emporter.tar.gz"));
+    XCTAssertNil(EMUpdaterDigestsFromManifest(@"z123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef  emporter.tar.gz"));
+}
+
+- (NSError *)_applyPackageWithDigestManifest:(NSString *)manifest {
+    NSURL *packageURL = [[NSBundle bundleForClass:[self class]] URLForResource:@"Data/deflate" withExtension:@"tar.gz"];
+    NSURL *manifestURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    
+    [manifest writeToURL:manifestURL atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+    
+    XCTestExpectation *updateExpectation = [self expectationWithDescription:@"update"];
+    __block NSError *updateError = nil;
+    
+    [EMUpdater applyWithURL:packageURL patchURL:nil digestManifestURL:manifestURL stateHandler:^(EMUpdaterState state, NSProgress *progress, NSError *error) {
+        if (state == EMUpdaterStateComplete) {
+            updateError = error;
+            [updateExpectation fulfill];
+        }
+    }];
+    
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    [[NSFileManager defaultManager] removeItemAtURL:manifestURL error:NULL];
+    
+    return updateError;
+}
+
+- (void)testMatchingDigest {
+    NSURL *packageURL = [[NSBundle bundleForClass:[self class]] URLForResource:@"Data/deflate" withExtension:@"tar.gz"];
+    NSData *package = [NSData dataWithContentsOfURL:packageURL];
+    
+    uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(package.bytes, (CC_LONG)package.length, digest);
+    
+    NSMutableString *manifest = [NSMutableString string];
+    for (size_t i = 0; i < sizeof(digest); i++) {
+        [manifest appendFormat:@"%02x", digest[i]];
+    }
+    [manifest appendString:@"  deflate.tar.gz\n"];
+    
+    // The package passes verification but doesn't contain the test runner
+    NSError *error = [self _applyPackageWithDigestManifest:manifest];
+    XCTAssertEqualObjects(error.localizedDescription, @"Executable not found in update package");
+}
+
+- (void)testInvalidDigest {
+    NSError *error = [self _applyPackageWithDigestManifest:@"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef  deflate.tar.gz\n"];
+    XCTAssertEqualObjects(error.localizedDescription, @"Update package has an invalid checksum");
+}
+
+- (void)testMissingDigest {
+    NSError *error = [self _applyPackageWithDigestManifest:@"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef  emporter.tar.gz\n"];
+    XCTAssertEqualObjects(error.localizedDescription, @"Could not verify update package");
+}
+
 @end
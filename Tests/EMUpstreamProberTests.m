@@ -0,0 +1,194 @@
+//
+//  EMUpstreamProberTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#import "EMTestHTTPServer.h"
+#import "EMUpstreamProber.h"
+
+
+@interface EMUpstreamProberTests : XCTestCase
+@end
+
+@implementation EMUpstreamProberTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+/*! Create a socket on the loopback interface which is bound to an ephemeral port, optionally listening (without ever accepting) */
+- (int)_socketBoundToPort:(uint16_t *)outPort listening:(BOOL)listening {
+    struct sockaddr_in addr = {0};
+    addr.sin_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    socklen_t addrLength = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    
+    XCTAssertGreaterThanOrEqual(fd, 0);
+    XCTAssertEqual(bind(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    XCTAssertEqual(getsockname(fd, (struct sockaddr *)&addr, &addrLength), 0);
+    
+    if (listening) {
+        XCTAssertEqual(listen(fd, 8), 0);
+    }
+    
+    (*outPort) = ntohs(addr.sin_port);
+    return fd;
+}
+
+/*! Probe upstreams until each has been probed once */
+- (NSDictionary<NSString*,EMUpstreamStatistics*> *)_probeUpstreamURLs:(NSDictionary<NSString*,NSURL*> *)upstreamURLs timeout:(NSTimeInterval)timeout {
+    EMUpstreamProber *prober = [[EMUpstreamProber alloc] initWithInterval:60];
+    NSMutableDictionary<NSString*,EMUpstreamStatistics*> *statistics = [NSMutableDictionary dictionary];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Upstreams were probed"];
+    
+    prober.timeout = timeout;
+    prober.updateHandler = ^(NSDictionary<NSString*,EMUpstreamStatistics*> *changedStatistics) {
+        BOOL wasComplete = statistics.count == upstreamURLs.count;
+        [statistics addEntriesFromDictionary:changedStatistics];
+        
+        if (!wasComplete && statistics.count == upstreamURLs.count) {
+            [expectation fulfill];
+        }
+    };
+    
+    prober.upstreamURLs = upstreamURLs;
+    [prober start];
+    
+    [self waitForExpectationsWithTimeout:timeout + 5 handler:nil];
+    [prober stop];
+    
+    XCTAssertEqualObjects(prober.statistics, statistics);
+    
+    return statistics;
+}
+
+- (void)testReachableUpstream {
+    EMTestHTTPServer *server = [[EMTestHTTPServer alloc] initWithData:[NSData data] entityTag:@"\"1\""];
+    XCTAssertNotNil(server);
+    
+    EMUpstreamStatistics *statistics = [self _probeUpstreamURLs:@{@"upstream": server.url} timeout:5][@"upstream"];
+    
+    // Any HTTP response (even an error) means the upstream is reachable
+    XCTAssertTrue(statistics.isReachable);
+    XCTAssertNil(statistics.failureReason);
+    XCTAssertEqual(statistics.numberOfProbes, 1);
+    XCTAssertEqual(statistics.numberOfFailures, 0);
+    XCTAssertGreaterThanOrEqual(statistics.connectLatency, 0);
+    XCTAssertGreaterThanOrEqual(statistics.firstByteLatency, 0);
+    
+    NSDictionary *headers = server.requestHeaders.firstObject;
+    XCTAssertEqualObjects(headers[@"host"], ([NSString stringWithFormat:@"127.0.0.1:%@", server.url.port]));
+    XCTAssertEqualObjects(headers[@"user-agent"], @"emporter-cli");
+    
+    NSDictionary *JSONObject = statistics.JSONObject;
+    XCTAssertEqualObjects(JSONObject[@"isReachable"], @YES);
+    XCTAssertEqualObjects(JSONObject[@"failureReason"], [NSNull null]);
+    XCTAssertTrue([JSONObject[@"firstByteLatencyMs"] isKindOfClass:[NSNumber class]]);
+    XCTAssertTrue([NSJSONSerialization isValidJSONObject:JSONObject]);
+}
+
+- (void)testLocalHostsTryEachLoopbackAddress {
+    // The server only listens on 127.0.0.1, so connecting to ::1 is refused before falling back
+    EMTestHTTPServer *server = [[EMTestHTTPServer alloc] initWithData:[NSData data] entityTag:@"\"1\""];
+    XCTAssertNotNil(server);
+    
+    NSURL *url = [NSURL URLWithString:[NSString stringWithFormat:@"http://localhost:%@", server.url.port]];
+    EMUpstreamStatistics *statistics = [self _probeUpstreamURLs:@{@"upstream": url} timeout:5][@"upstream"];
+    
+    XCTAssertTrue(statistics.isReachable);
+    XCTAssertEqualObjects(server.requestHeaders.firstObject[@"host"], ([NSString stringWithFormat:@"localhost:%@", server.url.port]));
+}
+
+- (void)testUnchangedUpstreamsAreNotReported {
+    uint16_t port = 0;
+    close([self _socketBoundToPort:&port listening:NO]);
+    
+    EMUpstreamProber *prober = [[EMUpstreamProber alloc] initWithInterval:0.25];
+    __block NSUInteger numberOfUpdates = 0;
+    
+    prober.updateHandler = ^(NSDictionary<NSString*,EMUpstreamStatistics*> *statistics) {
+        numberOfUpdates++;
+    };
+    
+    prober.upstreamURLs = @{@"upstream": [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%d", port]]};
+    [prober start];
+    
+    // Updates are delivered on the main queue while waiting
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Upstream was probed repeatedly"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    [prober stop];
+    
+    // The upstream was probed several times, but it was refused each time
+    XCTAssertGreaterThan(prober.statistics[@"upstream"].numberOfProbes, 2);
+    XCTAssertEqual(numberOfUpdates, 1);
+}
+
+- (void)testRefusedUpstream {
+    uint16_t port = 0;
+    close([self _socketBoundToPort:&port listening:NO]);
+    
+    NSURL *url = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%d", port]];
+    EMUpstreamStatistics *statistics = [self _probeUpstreamURLs:@{@"upstream": url} timeout:5][@"upstream"];
+    
+    XCTAssertFalse(statistics.isReachable);
+    XCTAssertEqualObjects(statistics.failureReason, @"refused");
+    XCTAssertEqual(statistics.numberOfFailures, 1);
+    XCTAssertEqual(statistics.numberOfConsecutiveFailures, 1);
+    XCTAssertLessThan(statistics.connectLatency, 0);
+    XCTAssertEqualObjects(statistics.JSONObject[@"connectLatencyMs"], [NSNull null]);
+}
+
+- (void)testUnresponsiveUpstream {
+    // Connections to a listening socket are established by the kernel, but the request is never answered
+    uint16_t port = 0;
+    int fd = [self _socketBoundToPort:&port listening:YES];
+    
+    NSURL *url = [NSURL URLWithString:[NSString stringWithFormat:@"http://localhost:%d", port]];
+    NSDate *start = [NSDate date];
+    EMUpstreamStatistics *statistics = [self _probeUpstreamURLs:@{@"upstream": url} timeout:0.5][@"upstream"];
+    
+    close(fd);
+    
+    XCTAssertFalse(statistics.isReachable);
+    XCTAssertEqualObjects(statistics.failureReason, @"timed out");
+    XCTAssertGreaterThanOrEqual(-start.timeIntervalSinceNow, 0.5);
+}
+
+- (void)testManyUpstreams {
+    uint16_t port = 0;
+    close([self _socketBoundToPort:&port listening:NO]);
+    
+    // Probes are limited in number while in flight, but every upstream is eventually probed from a single thread
+    NSMutableDictionary<NSString*,NSURL*> *upstreamURLs = [NSMutableDictionary dictionary];
+    
+    for (NSUInteger i = 0; i < 500; i++) {
+        upstreamURLs[[NSString stringWithFormat:@"upstream-%lu", i]] = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%d", port]];
+    }
+    
+    NSDictionary<NSString*,EMUpstreamStatistics*> *statistics = [self _probeUpstreamURLs:upstreamURLs timeout:5];
+    
+    XCTAssertEqualObjects([NSSet setWithArray:statistics.allKeys], [NSSet setWithArray:upstreamURLs.allKeys]);
+    
+    for (EMUpstreamStatistics *upstreamStatistics in statistics.allValues) {
+        XCTAssertEqualObjects(upstreamStatistics.failureReason, @"refused");
+    }
+}
+
+@end
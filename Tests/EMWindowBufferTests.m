@@ -0,0 +1,247 @@
+//
+//  EMWindowBufferTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "EMHeadlessCanvas.h"
+#import "EMWindowBuffer.h"
+
+
+@interface EMWindowBufferTests : XCTestCase
+@end
+
+@implementation EMWindowBufferTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+    YDCommandOutputStyleDisabled = NO;
+}
+
+- (NSArray<EMWindowLine*> *)_linesWithStrings:(NSArray<NSString*> *)strings {
+    return [EMWindowLine linesFromStyledString:[strings componentsJoinedByString:@"\n"]];
+}
+
+- (void)testLinesFromStyledString {
+    NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+        [output appendString:@"one "];
+        [output applyStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold) withinBlock:^(id<YDCommandOutputWriter> output) {
+            [output appendString:@"two"];
+        }];
+        [output appendString:@"\r\nthree\n"];
+    }];
+    
+    NSArray<EMWindowLine*> *lines = [EMWindowLine linesFromStyledString:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+    
+    XCTAssertEqual(lines.count, 2);
+    XCTAssertEqualObjects(lines[0].text, @"one two");
+    XCTAssertEqualObjects(lines[1].text, @"three");
+}
+
+- (void)testSpanBufferLines {
+    EMWindowSpanBuffer *buffer = [EMWindowSpanBuffer new];
+    [buffer appendString:@"one " withStyle:0];
+    [buffer appendString:@"two" withStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold)];
+    [buffer appendString:@"\r\n\nthree\n" withStyle:0];
+    
+    NSArray<EMWindowLine*> *lines = buffer.lines;
+    
+    XCTAssertEqual(lines.count, 3);
+    XCTAssertEqualObjects(lines[0].text, @"one two");
+    XCTAssertEqualObjects(lines[1].text, @"");
+    XCTAssertEqualObjects(lines[2].text, @"three");
+    
+    // Lines written as spans should be identical to lines parsed from style escapes
+    NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+        [output appendString:@"one "];
+        [output applyStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold) withinBlock:^(id<YDCommandOutputWriter> output) {
+            [output appendString:@"two"];
+        }];
+    }];
+    
+    XCTAssertEqualObjects(lines[0], [EMWindowLine linesFromStyledString:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]][0]);
+}
+
+- (void)testSpanBufferTruncation {
+    EMWindowSpanBuffer *buffer = [EMWindowSpanBuffer new];
+    EMWindowSpanBuffer *nestedBuffer = [buffer bufferWithSharedArena];
+    
+    [nestedBuffer appendString:@"abc" withStyle:0];
+    [nestedBuffer appendString:@"defgh\nijk\n" withStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold)];
+    [buffer appendBuffer:nestedBuffer truncatedToWidth:5];
+    
+    NSArray<EMWindowLine*> *lines = buffer.lines;
+    NSMutableArray<NSString*> *runs = [NSMutableArray array];
+    
+    [lines[0] enumerateRunsUsingBlock:^(NSString *text, YDCommandOutputStyle style, BOOL *stop) {
+        [runs addObject:text];
+    }];
+    
+    XCTAssertEqualObjects(lines[0].text, @"abcd…");
+    XCTAssertEqualObjects(lines[1].text, @"ijk");
+    XCTAssertEqualObjects(runs, (@[@"abc", @"d…"]));
+}
+
+- (void)testSpanBufferAlignment {
+    EMWindowSpanBuffer *buffer = [EMWindowSpanBuffer new];
+    EMWindowSpanBuffer *nestedBuffer = [buffer bufferWithSharedArena];
+    
+    [nestedBuffer appendString:@"ab\n\nabcdef" withStyle:0];
+    [buffer appendBuffer:nestedBuffer withAlignment:EMWindowTextAlignmentCenter width:6];
+    [buffer appendString:@"\n" withStyle:0];
+    [buffer appendBuffer:nestedBuffer withAlignment:EMWindowTextAlignmentRight width:4];
+    
+    NSArray<NSString*> *lines = [buffer.lines valueForKey:@"text"];
+    XCTAssertEqualObjects(lines, (@[@"  ab", @"", @"abcdef", @"  ab", @"", @"abc…"]));
+}
+
+- (void)testSpanBufferTabWidth {
+    EMWindowSpanBuffer *buffer = [EMWindowSpanBuffer new];
+    EMWindowSpanBuffer *nestedBuffer = [buffer bufferWithSharedArena];
+    
+    [nestedBuffer appendString:@"a\tb\tc\n" withStyle:0];
+    [nestedBuffer appendString:@"aaa" withStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold)];
+    [nestedBuffer appendString:@"\tb\n" withStyle:0];
+    [buffer appendBuffer:nestedBuffer withTabWidth:2];
+    
+    NSArray<NSString*> *lines = [buffer.lines valueForKey:@"text"];
+    XCTAssertEqualObjects(lines, (@[@"a    b  c", @"aaa  b"]));
+}
+
+- (void)testSpanBufferMeasuresDisplayWidth {
+    EMWindowSpanBuffer *buffer = [EMWindowSpanBuffer new];
+    EMWindowSpanBuffer *nestedBuffer = [buffer bufferWithSharedArena];
+    
+    // Wide characters use 2 columns, so they're truncated before they would overflow
+    [nestedBuffer appendString:@"接続済み\ne\u0301te\u0301\n" withStyle:0];
+    [buffer appendBuffer:nestedBuffer truncatedToWidth:6];
+    [buffer appendBuffer:nestedBuffer withAlignment:EMWindowTextAlignmentRight width:6];
+    
+    NSArray<NSString*> *lines = [buffer.lines valueForKey:@"text"];
+    XCTAssertEqualObjects(lines, (@[@"接続…", @"e\u0301te\u0301", @"接続…", @"   e\u0301te\u0301"]));
+    
+    EMWindowSpanBuffer *tabBuffer = [EMWindowSpanBuffer new];
+    EMWindowSpanBuffer *nestedTabBuffer = [tabBuffer bufferWithSharedArena];
+    
+    [nestedTabBuffer appendString:@"接続\tb\nabc\tb\n" withStyle:0];
+    [tabBuffer appendBuffer:nestedTabBuffer withTabWidth:1];
+    
+    XCTAssertEqualObjects([tabBuffer.lines valueForKey:@"text"], (@[@"接続 b", @"abc  b"]));
+}
+
+- (void)testFirstFrameDrawsAllRows {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"bb", @"ccc"]]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 3);
+    XCTAssertEqual(buffer.lastFrameStatistics.cells, 6);
+    XCTAssertEqual(buffer.lastFrameStatistics.bytes, 6);
+    XCTAssertEqualObjects(canvas.rows[@2], @"ccc");
+}
+
+- (void)testIdenticalFrameDrawsNothing {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"b", @"c"]]];
+    [canvas.drawnRows removeAllIndexes];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"b", @"c"]]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 0);
+    XCTAssertEqual(buffer.lastFrameStatistics.bytes, 0);
+    XCTAssertEqual(canvas.drawnRows.count, 0);
+}
+
+- (void)testChangedRowIsRedrawn {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"b", @"c"]]];
+    [canvas.drawnRows removeAllIndexes];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"✓", @"c"]]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 1);
+    XCTAssertEqual(buffer.lastFrameStatistics.cells, 1);
+    XCTAssertEqual(buffer.lastFrameStatistics.bytes, 3);
+    XCTAssertEqualObjects(canvas.drawnRows, [NSIndexSet indexSetWithIndex:1]);
+    XCTAssertEqualObjects(canvas.rows[@1], @"✓");
+}
+
+- (void)testStyleChangeIsRedrawn {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    
+    NSString *(^styledString)(YDCommandOutputStyle) = ^(YDCommandOutputStyle style) {
+        NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+            [output applyStyle:style withinBlock:^(id<YDCommandOutputWriter> output) {
+                [output appendString:@"state"];
+            }];
+        }];
+        return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    };
+    
+    [buffer drawLines:[EMWindowLine linesFromStyledString:styledString(YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold))]];
+    [buffer drawLines:[EMWindowLine linesFromStyledString:styledString(YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeInvert))]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 1);
+}
+
+- (void)testRemovedRowsAreCleared {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"b", @"c"]]];
+    [canvas.drawnRows removeAllIndexes];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a"]]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 2);
+    XCTAssertEqual(buffer.lastFrameStatistics.cells, 0);
+    XCTAssertEqualObjects(canvas.rows[@1], @"");
+    XCTAssertEqualObjects(canvas.rows[@2], @"");
+}
+
+- (void)testInvalidateRedrawsAllRows {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"b", @"c"]]];
+    [buffer invalidate];
+    [buffer drawLines:[self _linesWithStrings:@[@"a", @"b", @"c"]]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 3);
+}
+
+- (void)testRowsAreClippedToCanvas {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    canvas.numberOfColumns = 4;
+    canvas.numberOfRows = 2;
+    
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    [buffer drawLines:[self _linesWithStrings:@[@"abcdef", @"b", @"c"]]];
+    
+    XCTAssertEqual(buffer.lastFrameStatistics.rows, 2);
+    XCTAssertEqualObjects(canvas.rows[@0], @"abcd");
+    XCTAssertNil(canvas.rows[@2]);
+}
+
+- (void)testWideCharactersAreClippedToCanvas {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    canvas.numberOfColumns = 5;
+    
+    EMWindowBuffer *buffer = [[EMWindowBuffer alloc] initWithCanvas:canvas];
+    [buffer drawLines:[self _linesWithStrings:@[@"接続済み"]]];
+    
+    XCTAssertEqualObjects(canvas.rows[@0], @"接続");
+    XCTAssertEqual(buffer.lastFrameStatistics.cells, 4);
+    XCTAssertEqual(buffer.lastFrameStatistics.bytes, 6);
+}
+
+@end
@@ -0,0 +1,82 @@
+//
+//  EMWindowTests.m
+//  emporter-cli-tests
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "EMHeadlessCanvas.h"
+#import "EMWindow.h"
+
+
+@interface EMWindowTests : XCTestCase
+@end
+
+@implementation EMWindowTests
+
+- (void)setUp {
+    self.continueAfterFailure = NO;
+}
+
+- (void)testRedrawsAreCoalescedIntoOneFrame {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindow *window = [[EMWindow alloc] initWithCanvas:canvas];
+    window.maximumFramesPerSecond = 10;
+    
+    __block NSUInteger numberOfFrames = 0;
+    __block CFAbsoluteTime firstFrameTime = 0;
+    __block CFAbsoluteTime secondFrameTime = 0;
+    
+    [window runDrawLoopWithBlock:^(id<EMWindowWriter> output) {
+        numberOfFrames++;
+        [output appendFormat:@"frame %lu", numberOfFrames];
+        
+        if (numberOfFrames == 1) {
+            firstFrameTime = CFAbsoluteTimeGetCurrent();
+            
+            // A burst of events (i.e. tunnels flapping) is drawn in the next frame once the frame budget has elapsed
+            for (NSUInteger i = 0; i < 8; i++) {
+                [window setNeedsDisplay];
+            }
+        } else {
+            secondFrameTime = CFAbsoluteTimeGetCurrent();
+            [window close];
+        }
+    }];
+    
+    XCTAssertTrue(window.isClosed);
+    XCTAssertEqual(numberOfFrames, 2);
+    XCTAssertGreaterThanOrEqual(secondFrameTime - firstFrameTime, 0.09);
+    XCTAssertEqualObjects(canvas.rows[@0], @"frame 2");
+}
+
+- (void)testContentsAreDrawnToCanvas {
+    EMHeadlessCanvas *canvas = [EMHeadlessCanvas new];
+    EMWindow *window = [[EMWindow alloc] initWithCanvas:canvas];
+    
+    __block NSUInteger numberOfFrames = 0;
+    
+    [window runDrawLoopWithBlock:^(id<EMWindowWriter> output) {
+        numberOfFrames++;
+        [output appendString:@"title\ncontents"];
+        
+        // The title isn't drawn to a canvas, but it still causes a redraw
+        if (numberOfFrames == 1) {
+            window.title = @"Title";
+        } else {
+            [window close];
+        }
+    }];
+    
+    XCTAssertEqual(numberOfFrames, 2);
+    XCTAssertEqualObjects(canvas.rows[@0], @"title");
+    XCTAssertEqualObjects(canvas.rows[@1], @"contents");
+    
+    // Only the first frame's rows were drawn, as the second frame was identical
+    XCTAssertEqualObjects(canvas.drawnRows, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+}
+
+@end
@@ -0,0 +1,18 @@
+//
+//  EMApplyCommand.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "YDCommand.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface EMApplyCommand : YDCommand
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,176 @@
+//
+//  EMApplyCommand.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <time.h>
+
+#import "YDCommand-Subclass.h"
+
+#import "EMApplyCommand.h"
+#import "EMMainCommand.h"
+
+#import "EMManifest.h"
+#import "EMUtils.h"
+
+static NSString *_EMManifestChangeTypeDescription(EMManifestChangeType type) {
+    switch (type) {
+        case EMManifestChangeTypeCreate:    return @"create";
+        case EMManifestChangeTypeUpdate:    return @"update";
+        case EMManifestChangeTypeDelete:    return @"delete";
+        case EMManifestChangeTypeInvalid:   return @"invalid";
+        default:                            return @"none";
+    }
+}
+
+static NSString *_EMManifestChangeSource(EMManifestChange *change) {
+    return change.item.source ?: change.snapshot.name ?: change.snapshot.remoteUrl ?: change.tunnelIdentifier ?: @"";
+}
+
+@implementation EMApplyCommand {
+    NSString *_manifestPath;
+    BOOL _dryRun;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    self.usage = @"-f MANIFEST\n\nCreate, configure or delete URLs described by a JSON manifest. Only URLs which differ from the manifest are changed.";
+    self.variables = @[
+                       [[YDCommandVariable string:&_manifestPath withName:@"-f" usage:@"Path to the manifest (or - to read from stdin)"] variableWithAlias:@"--file"],
+                       [YDCommandVariable boolean:&_dryRun withName:@"--dry-run" usage:@"Show changes without applying them"],
+                       ];
+    
+    return self;
+}
+
+- (YDCommandReturnCode)executeWithArguments:(NSArray<NSString *> *)arguments {
+    EMMainCommand *main = (EMMainCommand*)self.root;
+    
+    if (_manifestPath == nil) {
+        return YDCommandReturnCodeInvalidArgs;
+    }
+    
+    NSError *error = nil;
+    NSData *data = nil;
+    
+    if ([_manifestPath isEqualToString:@"-"]) {
+        data = [[NSFileHandle fileHandleWithStandardInput] readDataToEndOfFile];
+    } else {
+        data = [NSData dataWithContentsOfFile:[_manifestPath stringByExpandingTildeInPath] options:0 error:&error];
+    }
+    
+    EMManifest *manifest = data ? [EMManifest manifestWithData:data error:&error] : nil;
+    
+    if (manifest == nil) {
+        [self _outputManifestError:error];
+        return YDCommandReturnCodeError;
+    }
+    
+    YDCommandReturnCode exitCode = YDCommandReturnCodeOK;
+    Emporter *emporter = [main resolveEmporter:&exitCode didLaunch:NULL];
+    
+    if (exitCode != YDCommandReturnCodeOK) {
+        return exitCode;
+    }
+    
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    
+    // Fetch every tunnel at once so that the diff costs a fixed number of Apple Events
+    NSArray<EMManifestChange*> *changes = [manifest changesFromSnapshots:[emporter fetchTunnelSnapshots] error:&error];
+    
+    if (changes == nil) {
+        [self _outputManifestError:error];
+        return YDCommandReturnCodeError;
+    }
+    
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:changes.count];
+    __block NSUInteger numberOfAppliedChanges = 0;
+    __block BOOL failed = NO;
+    
+    void (^handler)(EMManifestChange *) = ^(EMManifestChange *change) {
+        failed = failed || (change.error != nil);
+        
+        if (change.error == nil && change.type != EMManifestChangeTypeNone) {
+            numberOfAppliedChanges++;
+        }
+        
+        if (main.outputJSON) {
+            [results addObject:[self _JSONObjectForChange:change]];
+        } else {
+            [self _outputChange:change];
+        }
+    };
+    
+    if (_dryRun) {
+        for (EMManifestChange *change in changes) {
+            handler(change);
+        }
+    } else {
+        EMManifestApplyChanges(changes, emporter, handler);
+    }
+    
+    NSTimeInterval duration = (NSTimeInterval)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / NSEC_PER_SEC;
+    
+    if (main.outputJSON) {
+        [YDStandardOut appendJSONObject:@{@"changes": results, @"ms": @(round(duration * 1000)), @"dryRun": @(_dryRun)}];
+    } else if (!_dryRun) {
+        [YDStandardOut appendFormat:@"Applied %lu change%@ in %.0fms\n", numberOfAppliedChanges, numberOfAppliedChanges == 1 ? @"" : @"s", duration * 1000];
+    }
+    
+    return failed ? YDCommandReturnCodeError : YDCommandReturnCodeOK;
+}
+
+- (void)_outputManifestError:(NSError *)error {
+    EMMainCommand *main = (EMMainCommand*)self.root;
+    NSString *reason = error.localizedFailureReason ?: error.localizedDescription;
+    
+    if (main.outputJSON) {
+        [YDStandardOut appendJSONObject:EMJSONErrorCreate(EMJSONErrorCodeBadRequest, @"Invalid manifest", @{@"reason": reason ?: [NSNull null]})];
+    } else {
+        EMOutputError(YDStandardError, @"Could not read manifest: %@\n", reason);
+    }
+}
+
+- (NSDictionary *)_JSONObjectForChange:(EMManifestChange *)change {
+    NSMutableDictionary *json = [NSMutableDictionary dictionary];
+    
+    json[@"_id"] = change.tunnelIdentifier ?: [NSNull null];
+    json[@"source"] = _EMManifestChangeSource(change);
+    json[@"change"] = _EMManifestChangeTypeDescription(change.type);
+    json[@"values"] = change.values;
+    json[@"ms"] = @(round(change.duration * 100000) / 100);
+    
+    if (change.error != nil) {
+        json[@"error"] = EMJSONErrorCreateInternal(change.error.localizedDescription, change.error);
+    }
+    
+    return json;
+}
+
+- (void)_outputChange:(EMManifestChange *)change {
+    NSString *source = _EMManifestChangeSource(change);
+    NSString *description = _EMManifestChangeTypeDescription(change.type);
+    
+    if (change.error != nil) {
+        EMOutputError(YDStandardError, @"Could not %@ %@: %@\n", change.type == EMManifestChangeTypeInvalid ? @"apply" : description, source, change.error.localizedDescription);
+    } else if (change.type == EMManifestChangeTypeNone) {
+        [YDStandardOut appendFormat:@"%@ is up to date\n", source];
+    } else if (_dryRun) {
+        NSArray *keys = [change.values.allKeys sortedArrayUsingSelector:@selector(compare:)];
+        if (change.needsAuth) {
+            keys = [keys arrayByAddingObject:@"auth"];
+        }
+        
+        [YDStandardOut appendFormat:@"Would %@ %@%@\n", description, source, keys.count > 0 ? [NSString stringWithFormat:@" (%@)", [keys componentsJoinedByString:@", "]] : @""];
+    } else {
+        EMOutputSuccess(YDStandardOut, @"%@d %@ in %.1fms\n", [description capitalizedString], source, change.duration * 1000);
+    }
+}
+
+@end
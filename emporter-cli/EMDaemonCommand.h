@@ -0,0 +1,23 @@
+//
+//  EMDaemonCommand.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "YDCommand.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Serves commands from a persistent process which keeps its connection to Emporter warm.
+ 
+ Commands which don't attach to the terminal are forwarded to the daemon automatically while it's running.
+ */
+@interface EMDaemonCommand : YDCommand
+
+@end
+
+NS_ASSUME_NONNULL_END
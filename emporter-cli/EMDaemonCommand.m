@@ -0,0 +1,132 @@
+//
+//  EMDaemonCommand.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#import "YDCommand-Subclass.h"
+#import "EMDaemonCommand.h"
+
+#import "EMDaemon.h"
+#import "EMMainCommand.h"
+#import "EMUtils.h"
+
+
+/*! Run a request as if it were the client by temporarily adopting its standard file descriptors and working directory */
+static int _EMDaemonRunRequest(EMDaemonRequest *request, Emporter *emporter, EmporterVersion version) {
+    int requestFds[] = {request.standardInput, request.standardOutput, request.standardError};
+    int savedFds[3];
+    
+    fflush(stdout);
+    fflush(stderr);
+    
+    for (int i = 0; i < 3; i++) {
+        savedFds[i] = dup(i);
+        dup2(requestFds[i], i);
+    }
+    
+    int savedDirectory = open(".", O_RDONLY | O_CLOEXEC);
+    BOOL savedOutputStyleDisabled = YDCommandOutputStyleDisabled;
+    
+    int status = YDCommandReturnCodeError;
+    
+    if (chdir(request.currentDirectoryPath.fileSystemRepresentation) == 0) {
+        YDCommandOutputStyleDisabled = request.outputStyleDisabled;
+        
+        @autoreleasepool {
+            status = [[[EMMainCommand alloc] initWithDaemonEmporter:emporter version:version] runWithArguments:request.arguments];
+        }
+    } else {
+        dprintf(STDERR_FILENO, "Could not change directory to %s: %s\n", request.currentDirectoryPath.fileSystemRepresentation, strerror(errno));
+    }
+    
+    fflush(stdout);
+    fflush(stderr);
+    
+    // Restore our own state (releasing the client's file descriptors)
+    YDCommandOutputStyleDisabled = savedOutputStyleDisabled;
+    
+    if (savedDirectory >= 0) {
+        fchdir(savedDirectory);
+        close(savedDirectory);
+    }
+    
+    for (int i = 0; i < 3; i++) {
+        dup2(savedFds[i], i);
+        close(savedFds[i]);
+    }
+    
+    return status;
+}
+
+
+@implementation EMDaemonCommand {
+    NSString *_socketPath;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    self.usage = @"[OPTIONS]\n\nServe commands from a persistent process.\n\nWhile the daemon is running, commands such as get, list and edit are forwarded to it to avoid reconnecting to Emporter.";
+    self.variables = @[
+                       [YDCommandVariable string:&_socketPath withName:@"--socket" usage:@"Path of the socket to listen on"],
+                       ];
+    
+    return self;
+}
+
+- (YDCommandReturnCode)executeWithArguments:(NSArray<NSString *> *)arguments {
+    EMMainCommand *main = (EMMainCommand*)self.root;
+    YDCommandReturnCode exitCode = YDCommandReturnCodeOK;
+    Emporter *emporter = [main resolveEmporter:&exitCode didLaunch:NULL];
+    
+    if (exitCode != YDCommandReturnCodeOK) {
+        return exitCode;
+    }
+    
+    EmporterVersion version = main.emporterVersion;
+    NSString *socketPath = _socketPath ?: EMDaemonDefaultSocketPath();
+    
+    // Writing to a client which has gone away shouldn't terminate the daemon
+    signal(SIGPIPE, SIG_IGN);
+    
+    EMDaemonServer *server = [[EMDaemonServer alloc] initWithSocketPath:socketPath queue:dispatch_get_main_queue() handler:^int(EMDaemonRequest *request) {
+        return _EMDaemonRunRequest(request, emporter, version);
+    }];
+    
+    NSError *error = nil;
+    
+    if (![server startWithError:&error]) {
+        BOOL isRunning = [error.domain isEqualToString:NSPOSIXErrorDomain] && error.code == EADDRINUSE;
+        NSString *message = isRunning ? @"Daemon is already running" : @"Could not start daemon";
+        
+        if (main.outputJSON) {
+            [YDStandardOut appendJSONObject:EMJSONErrorCreateInternal(message, error)];
+        } else {
+            EMOutputError(YDStandardError, @"%@: %@.\n", message, error.localizedDescription);
+        }
+        
+        return YDCommandReturnCodeError;
+    }
+    
+    if (main.outputJSON) {
+        [YDStandardOut appendJSONObject:@{@"event": @"daemon.listening", @"data": @{@"socket": socketPath, @"pid": @(getpid())}}];
+    } else {
+        EMOutputSuccess(YDStandardOut, @"Listening on %@ (Ctrl+C to exit)\n", socketPath);
+    }
+    
+    EMBlockRunLoopRun(nil);
+    
+    [server stop];
+    
+    return YDCommandReturnCodeOK;
+}
+
+@end
@@ -67,14 +67,17 @@
         return YDCommandReturnCodeError;
     }
     
+    NSArray<NSString*> *keys = (_quiet && !main.outputJSON) ? @[@"remoteUrl"] : EMTunnelSnapshot.allKeys;
+    EMTunnelSnapshot *snapshot = [[EMTunnelSnapshot alloc] initWithTunnel:tunnel keys:keys];
+    
     if (main.outputJSON) {
-        [YDStandardOut appendJSONObject:EMJSONObjectForTunnel(tunnel, YES)];
+        [YDStandardOut appendJSONObject:EMJSONObjectForTunnelSnapshot(snapshot, YES)];
     } else if (_quiet) {
-        if (tunnel.remoteUrl != nil) {
-            [YDStandardOut appendFormat:@"%@\n", tunnel.remoteUrl];
+        if (snapshot.remoteUrl != nil) {
+            [YDStandardOut appendFormat:@"%@\n", snapshot.remoteUrl];
         }
     } else {
-        [EMListCommand writeTunnels:@[tunnel] toOutput:YDStandardOut];
+        [EMListCommand writeTunnels:@[snapshot] toOutput:YDStandardOut];
     }
     
     return YDCommandReturnCodeOK;
@@ -11,11 +11,11 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class EmporterTunnel;
+@class EMTunnelSnapshot;
 
 @interface EMListCommand : YDCommand
 
-+ (void)writeTunnels:(NSArray<EmporterTunnel*> *)tunnels toOutput:(id <YDCommandOutputWriter>)output;
++ (void)writeTunnels:(NSArray<EMTunnelSnapshot*> *)tunnels toOutput:(id <YDCommandOutputWriter>)output;
 
 @end
 
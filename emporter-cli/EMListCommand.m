@@ -11,6 +11,7 @@
 #import "EMGetCommand.h"
 #import "EMListCommand.h"
 #import "EMMainCommand.h"
+#import "EMTunnelListView.h"
 #import "EMUtils.h"
 
 
@@ -42,7 +43,9 @@
         return exitCode;
     }
     
-    NSArray *tunnels = emporter.tunnels ?: @[];
+    // Prefetch all tunnels at once instead of reading properties from each tunnel individually
+    NSArray<NSString*> *keys = (_quiet && !main.outputJSON) ? @[@"id", @"remoteUrl"] : EMTunnelSnapshot.allKeys;
+    NSArray<EMTunnelSnapshot*> *tunnels = [EMTunnelSnapshot snapshotsOfTunnels:emporter.tunnels ?: @[] keys:keys];
     
     if (_limit > 0 && _limit < tunnels.count) {
         tunnels = [tunnels subarrayWithRange:NSMakeRange(0, _limit)];
@@ -51,13 +54,13 @@
     if (main.outputJSON) {
         NSMutableArray *payload = [NSMutableArray array];
         
-        for (EmporterTunnel *tunnel in tunnels) {
-            [payload addObject:EMJSONObjectForTunnel(tunnel, YES)];
+        for (EMTunnelSnapshot *tunnel in tunnels) {
+            [payload addObject:EMJSONObjectForTunnelSnapshot(tunnel, YES)];
         }
         
         [YDStandardOut appendJSONObject:payload];
     } else if (_quiet) {
-        for (EmporterTunnel *tunnel in tunnels) {
+        for (EMTunnelSnapshot *tunnel in tunnels) {
             if (tunnel.remoteUrl) {
                 [YDStandardOut appendFormat:@"%@\n", tunnel.remoteUrl];
             }
@@ -69,88 +72,11 @@
     return YDCommandReturnCodeOK;
 }
 
-+ (void)writeTunnels:(NSArray<EmporterTunnel*> *)tunnels toOutput:(id <YDCommandOutputWriter>)output {
-    BOOL isServicePartial = NO;
-    BOOL didHitServiceLimits = NO;
++ (void)writeTunnels:(NSArray<EMTunnelSnapshot*> *)tunnels toOutput:(id <YDCommandOutputWriter>)output {
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    listView.tunnels = tunnels;
     
-    BOOL(^isTunnelPartial)(EmporterTunnel*) = ^BOOL(EmporterTunnel *tunnel) {
-        NSString *remoteURL = tunnel.remoteUrl;
-        return remoteURL != nil && ![remoteURL localizedCaseInsensitiveContainsString:tunnel.properties[@"name"] ?: tunnel.name ?: @""];
-    };
-    
-    BOOL(^isTunnelAtCapacity)(EmporterTunnel*) = ^BOOL(EmporterTunnel *tunnel) {
-        return [(tunnel.conflictReason ?: @"") containsString:@"Too many"];
-    };
-    
-    for (EmporterTunnel *tunnel in tunnels) {
-        isServicePartial = isServicePartial || isTunnelPartial(tunnel);
-        didHitServiceLimits = didHitServiceLimits || isTunnelAtCapacity(tunnel);
-        
-        if (didHitServiceLimits) {
-            break;
-        }
-    }
-    
-    [output applyTabWidth:5 withinBlock:^(id<YDCommandOutputWriter> output) {
-        [output appendString:[@[@"      SOURCE", @"URL"] componentsJoinedByString:@"\t"]];
-        
-        if (didHitServiceLimits || isServicePartial) {
-            [output appendString:@"\t"];
-        }
-        
-        [output appendString:@"\n"];
-        
-        for (EmporterTunnel *tunnel in tunnels) {
-            [output appendString:@" "];
-            {
-                YDCommandOutputStyle stateStyle = 0;
-                NSString *stateDescription = EMTunnelStateDescription(tunnel, YES, &stateStyle);
-                
-                [output applyStyle:stateStyle withinBlock:^(id<YDCommandOutputWriter> output) {
-                    [output appendFormat:@" %@ ", stateDescription];
-                }];
-            }
-            [output appendString:@"  "];
-
-            [output appendString:[@[EMTunnelSourceDescription(tunnel), @""] componentsJoinedByString:@"\t"]];
-            
-            if (tunnel.state == EmporterTunnelStateConflicted && !isTunnelAtCapacity(tunnel)) {
-                [output appendString:tunnel.conflictReason ?: @""];
-            } else {
-                [output applyStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeUnderline) withinBlock:^(id<YDCommandOutputWriter> output) {
-                    [output appendString:tunnel.remoteUrl ?: @""];
-                }];
-            }
-            
-            if (didHitServiceLimits || isServicePartial) {
-                [output appendString:@"\t"];
-                
-                if (isTunnelPartial(tunnel)) {
-                    [output appendString:@"*"];
-                } else if (isTunnelAtCapacity(tunnel)) {
-                    [output appendString:@"**"];
-                }
-            }
-            
-            [output appendString:@"\n"];
-        }
-    }];
-    
-    if (isServicePartial || didHitServiceLimits) {
-        [output appendString:@"\n"];
-
-        if (isServicePartial) {
-            [output appendString:@" *  Paid subscriptions are required to reserve URL names.\n"];
-        }
-        
-        if (didHitServiceLimits) {
-            [output appendString:@" ** Too many URLs are active.\n"];
-        }
-        
-        if (isServicePartial) {
-            [output appendString:@"\nPurchase a subscription within the app for custom names, faster speeds, and more URLs.\n"];
-        }
-    }
+    [listView writeToOutput:output numberOfLines:0];
 }
 
 @end
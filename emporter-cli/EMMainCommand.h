@@ -14,11 +14,21 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface EMMainCommand : YDCommandTree
 
+/*!
+ Create a command which runs within the daemon. Commands reuse the daemon's connection to Emporter and are never forwarded.
+ \param emporter   The daemon's connection to Emporter
+ \param version    The version of Emporter
+ */
+- (instancetype)initWithDaemonEmporter:(Emporter *)emporter version:(EmporterVersion)version;
+
 @property(nonatomic,readonly) BOOL outputJSON;
 @property(nonatomic,readonly) BOOL noPrompt;
 
 @property(nonatomic,readonly) EmporterVersion emporterVersion;
 
+/*! The names of commands which have been created. Commands are only created once they're run or looked up (or when every command is listed). */
+@property(nonatomic,readonly) NSSet<NSString*> *loadedCommandNames;
+
 // Emporter may launch but without the correct permissions. Make sure to check the return code for OK before continuing.
 - (Emporter *__nullable)resolveEmporter:(YDCommandReturnCode *__nullable)returnCode didLaunch:(BOOL *__nullable)didLaunch;
 
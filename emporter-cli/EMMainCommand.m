@@ -19,6 +19,11 @@
 #import "EMVersionCommand.h"
 #import "EMRunCommand.h"
 #import "EMUpdateCommand.h"
+#import "EMDaemonCommand.h"
+#import "EMApplyCommand.h"
+
+#import "EMDaemon.h"
+#import "EMStartupTrace.h"
 
 #import "EMUtils.h"
 
@@ -27,7 +32,15 @@
     BOOL _printVersion;
     BOOL _noLaunch;
     BOOL _noColors;
+    BOOL _noDaemon;
+    BOOL _traceStartup;
+    
+    EmporterVersion _emporterVersion;
+    BOOL _didResolveEmporterVersion;
     
+    NSMutableArray<NSArray*> *_lazyCommands;
+    NSMutableSet<NSString*> *_commandNames;
+    Emporter *_daemonEmporter;
     EMWindow *_window;
 }
 
@@ -43,27 +56,59 @@
                        [YDCommandVariable boolean:&_noPrompt withName:@"--no-prompt" usage:@"Don't show prompts"],
                        [YDCommandVariable boolean:&_noLaunch withName:@"--no-launch" usage:@"Don't launch Emporter if it isn't running"],
                        [YDCommandVariable boolean:&_outputJSON withName:@"--json" usage:@"Output JSON to stdout"],
+                       [YDCommandVariable boolean:&_noDaemon withName:@"--no-daemon" usage:@"Don't forward commands to a running daemon"],
+                       [YDCommandVariable boolean:&_traceStartup withName:@"--trace-startup" usage:@"Print the timing of each phase of startup to stderr"],
                        [[YDCommandVariable boolean:&_printVersion withName:@"-v" usage:@"Print version and quit"] variableWithAlias:@"--version"],
                        ];
     
-    [self addCommand:[EMCreateCommand new] withName:@"create" description:@"Create a new URL from a local address or directory"];
-    [self addCommand:[EMDeleteCommand new] withName:@"rm" description:@"Delete the URL for a local address or directory"];
-    [self addCommand:[EMEditCommand new] withName:@"edit" description:@"Edit the URL for a local address or directory"];
-    [self addCommand:[EMGetCommand new] withName:@"get" description:@"Get the configuration for a local address or directory"];
-    [self addCommand:[EMHelpCommand new] withName:@"help" description:@"Show help for a command"];
-    [self addCommand:[EMListCommand new] withName:@"list" description:@"List configured URLs"];
-    [self addCommand:[EMServiceCommand new] withName:@"service" description:@"View or update the service"];
-    [self addCommand:[EMVersionCommand new] withName:@"version" description:@"Show version information"];
-    [self addCommand:[EMUpdateCommand new] withName:@"update" description:@"Update to the latest version"];
-    [self addCommand:[EMRunCommand new] withName:@"run" description:@"Serve URLs"];
+    // Commands are created when they're first needed (only one is typically run)
+    _lazyCommands = [NSMutableArray array];
+    _commandNames = [NSMutableSet set];
+    
+    [self _addCommandClass:[EMCreateCommand class] withName:@"create" description:@"Create a new URL from a local address or directory"];
+    [self _addCommandClass:[EMDeleteCommand class] withName:@"rm" description:@"Delete the URL for a local address or directory"];
+    [self _addCommandClass:[EMEditCommand class] withName:@"edit" description:@"Edit the URL for a local address or directory"];
+    [self _addCommandClass:[EMGetCommand class] withName:@"get" description:@"Get the configuration for a local address or directory"];
+    [self _addCommandClass:[EMHelpCommand class] withName:@"help" description:@"Show help for a command"];
+    [self _addCommandClass:[EMListCommand class] withName:@"list" description:@"List configured URLs"];
+    [self _addCommandClass:[EMServiceCommand class] withName:@"service" description:@"View or update the service"];
+    [self _addCommandClass:[EMVersionCommand class] withName:@"version" description:@"Show version information"];
+    [self _addCommandClass:[EMUpdateCommand class] withName:@"update" description:@"Update to the latest version"];
+    [self _addCommandClass:[EMRunCommand class] withName:@"run" description:@"Serve URLs"];
+    [self _addCommandClass:[EMDaemonCommand class] withName:@"daemon" description:@"Serve commands from a persistent process"];
+    [self _addCommandClass:[EMApplyCommand class] withName:@"apply" description:@"Create, configure or delete URLs from a manifest"];
 
     return self;
 }
 
+- (instancetype)initWithDaemonEmporter:(Emporter *)emporter version:(EmporterVersion)version {
+    self = [self init];
+    if (self == nil)
+        return nil;
+    
+    _daemonEmporter = emporter;
+    _emporterVersion = version;
+    _didResolveEmporterVersion = YES;
+    
+    return self;
+}
+
 - (YDCommandReturnCode)executeWithArguments:(NSArray<NSString *> *)arguments {
+    EMStartupTraceMark(EMStartupPhaseArgumentsParsed);
+    
+    if (_traceStartup && _daemonEmporter == nil) {
+        EMStartupTraceEnable(_outputJSON);
+    }
+    
     YDCommandOutputStyleDisabled = YDCommandOutputStyleDisabled || _noColors || _outputJSON;
     
-    [Emporter getVersion:&_emporterVersion];
+    if (_daemonEmporter == nil && !_noDaemon && !_printVersion && !_showHelp && [self _canForwardArguments:arguments]) {
+        YDCommandReturnCode returnCode = YDCommandReturnCodeOK;
+        
+        if ([self _forwardArguments:arguments returnCode:&returnCode]) {
+            return returnCode;
+        }
+    }
     
     if (_printVersion) {
         return [[self commandWithPath:@"version"] runWithArguments:@[]];
@@ -74,16 +119,140 @@
             return [[self commandWithPath:@"help"] runWithArguments:arguments];
         }
         
+        [self _loadCommandsForPath:nil];
         [self appendUsageToOutput:YDStandardOut withVariables:YES];
         return YDCommandReturnCodeOK;
     }
+    
+    [self _loadCommandsForPath:arguments.firstObject];
 
     return [super executeWithArguments:arguments];
 }
 
+- (YDCommand *)commandWithPath:(NSString *)path {
+    [self _loadCommandsForPath:path];
+    return [super commandWithPath:path];
+}
+
+- (EmporterVersion)emporterVersion {
+    // Resolving the version reads Emporter's bundle, which most commands don't need
+    if (!_didResolveEmporterVersion) {
+        _didResolveEmporterVersion = YES;
+        [Emporter getVersion:&_emporterVersion];
+    }
+    
+    return _emporterVersion;
+}
+
+#pragma mark - Lazy commands
+
+- (NSSet<NSString *> *)loadedCommandNames {
+    NSMutableSet<NSString*> *names = [_commandNames mutableCopy];
+    
+    for (NSArray *command in _lazyCommands) {
+        [names removeObject:command[0]];
+    }
+    
+    return names;
+}
+
+- (void)_addCommandClass:(Class)commandClass withName:(NSString *)name description:(NSString *)description {
+    [_lazyCommands addObject:@[name, commandClass, description]];
+    [_commandNames addObject:name];
+}
+
+- (void)_loadCommandsForPath:(NSString *)path {
+    if (_lazyCommands.count == 0) {
+        return;
+    }
+    
+    NSString *name = [path componentsSeparatedByString:@" "].firstObject;
+    NSUInteger index = [_lazyCommands indexOfObjectPassingTest:^BOOL(NSArray *command, NSUInteger idx, BOOL *stop) {
+        return [command[0] isEqualToString:name];
+    }];
+    
+    if (index == NSNotFound && name != nil && [_commandNames containsObject:name]) {
+        return;
+    }
+    
+    // Help and usage (including unknown commands) list every command, so they're all needed
+    if (index == NSNotFound || [name isEqualToString:@"help"]) {
+        NSArray *commands = [_lazyCommands copy];
+        [_lazyCommands removeAllObjects];
+        
+        for (NSArray *command in commands) {
+            [self addCommand:[command[1] new] withName:command[0] description:command[2]];
+        }
+    } else {
+        NSArray *command = _lazyCommands[index];
+        [_lazyCommands removeObjectAtIndex:index];
+        
+        [self addCommand:[command[1] new] withName:command[0] description:command[2]];
+    }
+}
+
+#pragma mark - Daemon
+
+- (BOOL)_canForwardArguments:(NSArray<NSString *> *)arguments {
+    NSString *commandName = arguments.firstObject;
+    
+    // Commands which attach to the terminal (or replace the executable) are always run locally
+    if ([commandName isEqualToString:@"create"]) {
+        return [arguments containsObject:@"-x"] || [arguments containsObject:@"--no-attach"];
+    }
+    
+    return commandName != nil && [@[@"get", @"list", @"rm", @"edit", @"service"] containsObject:commandName];
+}
+
+- (BOOL)_forwardArguments:(NSArray<NSString *> *)arguments returnCode:(YDCommandReturnCode *)outReturnCode {
+    NSMutableArray *forwardedArguments = [NSMutableArray array];
+    
+    if (_noColors) { [forwardedArguments addObject:@"--no-colors"]; }
+    if (_noPrompt) { [forwardedArguments addObject:@"--no-prompt"]; }
+    if (_noLaunch) { [forwardedArguments addObject:@"--no-launch"]; }
+    if (_outputJSON) { [forwardedArguments addObject:@"--json"]; }
+    
+    [forwardedArguments addObjectsFromArray:arguments];
+    
+    EMDaemonRequest *request = [[EMDaemonRequest alloc] initWithArguments:forwardedArguments];
+    request.outputStyleDisabled = YDCommandOutputStyleDisabled;
+    
+    // Flush anything we've buffered so it doesn't interleave with the daemon's output
+    fflush(stdout);
+    fflush(stderr);
+    
+    NSError *error = nil;
+    int status = 0;
+    
+    if ([EMDaemonClient sendRequest:request toSocketAtPath:EMDaemonDefaultSocketPath() status:&status error:&error]) {
+        (*outReturnCode) = status;
+        return YES;
+    }
+    
+    // Run the command locally if the daemon isn't running
+    if ([error.domain isEqualToString:NSPOSIXErrorDomain] && (error.code == ENOENT || error.code == ECONNREFUSED)) {
+        return NO;
+    }
+    
+    if (_outputJSON) {
+        [YDStandardError appendJSONObject:EMJSONErrorCreateInternal(@"Could not reach daemon", error)];
+    } else {
+        EMOutputError(YDStandardError, @"Could not reach daemon: %@. Use --no-daemon to run the command without it.\n", error.localizedDescription);
+    }
+    
+    (*outReturnCode) = YDCommandReturnCodeError;
+    return YES;
+}
+
 #pragma mark -
 
 - (Emporter *)resolveEmporter:(YDCommandReturnCode *)outReturnCode didLaunch:(BOOL *)outDidLaunch {
+    Emporter *emporter = [self _resolveEmporter:outReturnCode didLaunch:outDidLaunch];
+    EMStartupTraceMark(EMStartupPhaseEmporterResolved);
+    return emporter;
+}
+
+- (Emporter *)_resolveEmporter:(YDCommandReturnCode *)outReturnCode didLaunch:(BOOL *)outDidLaunch {
     if (![Emporter isInstalled]) {
         if (_outputJSON) {
             [YDStandardError appendJSONObject:EMJSONErrorCreate(EMJSONErrorCodeUnavailable, @"Emporter is not installed.", @{ @"url": Emporter.appStoreURL.absoluteString })];
@@ -104,7 +273,8 @@
         return nil;
     }
     
-    Emporter *emporter = [[Emporter alloc] init];
+    // Reuse the daemon's connection to avoid the cost of setting up a new one
+    Emporter *emporter = _daemonEmporter ?: [[Emporter alloc] init];
     
     // Launch Emporter in background if it's not running
     BOOL didLaunch = NO;
@@ -17,6 +17,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic) EMWindowWriterBlock __nullable footerBlock;
 @property(nonatomic) BOOL relaunchAutomatically;
 
+/*! The maximum number of times per second the window is redrawn (defaults to 10) */
+@property(nonatomic) NSInteger maximumFramesPerSecond;
+
+/*! The number of events which were coalesced into the most recently drawn frame */
+@property(nonatomic,readonly) NSUInteger lastFrameEventCount;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -11,23 +11,68 @@
 #import "YDCommand-Subclass.h"
 #import "Emporter.h"
 
+#import "EMEventWriter.h"
 #import "EMGetCommand.h"
-#import "EMListCommand.h"
 #import "EMMainCommand.h"
+#import "EMMetrics.h"
+#import "EMSessionRecording.h"
+#import "EMTunnelFilter.h"
+#import "EMTunnelListView.h"
+#import "EMTunnelSnapshotStore.h"
+#import "EMUpstreamProber.h"
 #import "EMUtils.h"
 
 
 @interface EMRunCommand()
 @property(nonatomic,readonly) Emporter *emporter;
+@property(nonatomic,readonly) id <EMSessionSource> source;
+@property(nonatomic,readonly) EMSessionRecorder *recorder;
+@property(nonatomic,readonly) EMSessionReplay *replay;
 
-@property(nonatomic) EMSourceType filterType;
-@property(nonatomic) NSString *filterDescription;
-@property(nonatomic) id filter;
+@property(nonatomic,readonly) EMTunnelFilter *filter;
+@property(nonatomic,readonly) EMSessionMetrics *sessionMetrics;
 
 @property(nonatomic,readonly) BOOL keepOpen;
+@property(nonatomic,readonly) NSInteger batchMilliseconds;
+
+@property(nonatomic,readonly) NSString *metricsPath;
+@property(nonatomic,readonly) NSString *metricsSocketPath;
+@property(nonatomic,readonly) NSInteger metricsInterval;
+
+@property(nonatomic,readonly) NSString *recordPath;
+@property(nonatomic,readonly) NSString *replayPath;
+@property(nonatomic,readonly) NSInteger replaySpeed;
+@property(nonatomic,readonly) NSInteger replayRepeatCount;
+
+@property(nonatomic,readonly) NSInteger maximumResidentMegabytes;
+@property(nonatomic,readonly) NSInteger probeInterval;
 @end
 
 
+/*! The local upstreams of proxy tunnels, keyed by tunnel id */
+static NSDictionary<NSString*,NSURL*> *_EMUpstreamURLsForTunnels(NSArray<EMTunnelSnapshot*> *tunnels) {
+    NSMutableDictionary<NSString*,NSURL*> *upstreamURLs = [NSMutableDictionary dictionary];
+    
+    for (EMTunnelSnapshot *tunnel in tunnels) {
+        if (tunnel.kind != EmporterTunnelKindProxy || tunnel.id == nil || tunnel.proxyPort == nil) {
+            continue;
+        }
+        
+        NSURLComponents *components = [[NSURLComponents alloc] init];
+        components.scheme = @"http";
+        components.host = (tunnel.shouldRewriteHostHeader && tunnel.proxyHostHeader.length > 0) ? tunnel.proxyHostHeader : @"localhost";
+        components.port = tunnel.proxyPort;
+        
+        NSURL *url = components.URL;
+        if (url != nil) {
+            upstreamURLs[tunnel.id] = url;
+        }
+    }
+    
+    return upstreamURLs;
+}
+
+
 @implementation EMRunCommand
 
 - (instancetype)init {
@@ -37,56 +82,130 @@
     
     self.usage = @"[OPTIONS]\n\nCreate and serve configured URLs.";
     
+    _maximumFramesPerSecond = 10;
+    _metricsInterval = 15;
+    _replaySpeed = 1;
+    _replayRepeatCount = 1;
+    _filter = [[EMTunnelFilter alloc] init];
+    
     __block EMRunCommand *weakSelf = self;
     
+    // Filters can be repeated, and are compiled into an index which is matched against snapshots
     BOOL (^filterBlock)(NSString *) = ^BOOL(NSString *input) {
         EMRunCommand *strongSelf = weakSelf;
-        if (strongSelf != nil) {
-            strongSelf.filterType = EMSourceTypeGuess(input);
-            strongSelf.filterDescription = EMSourceTypeDescriptionFromString(strongSelf.filterType, input);
-            
-            switch (strongSelf.filterType) {
-                case EMSourceTypeID:
-                    strongSelf.filter = input;
-                    break;
-                case EMSourceTypePort:
-                    strongSelf.filter = [Emporter tunnelPredicateForPort:@([input integerValue])];
-                    break;
-                default:
-                    strongSelf.filter = [Emporter tunnelPredicateForURL:EMSourceURLFromString(input, strongSelf.filterType)];
-                    break;
-            }
-        }
-        
-        return YES;
+        return strongSelf == nil || [strongSelf.filter addFilterWithString:input];
     };
     
     self.variables = @[
                        [YDCommandVariable boolean:&_relaunchAutomatically withName:@"--relaunch" usage:@"Relaunch Emporter automatically"],
                        [YDCommandVariable boolean:&_keepOpen withName:@"--keep-open" usage:@"Keep Emporter open after exit if it was launched"],
-                       [YDCommandVariable block:filterBlock withName:@"--filter" usage:@"Filter output by id, directory, port or URL"],
+                       [YDCommandVariable block:filterBlock withName:@"--filter" usage:@"Filter output by id, directory, port, URL or glob (repeat to show multiple URLs)"],
+                       [YDCommandVariable integer:&_maximumFramesPerSecond withName:@"--max-fps" usage:@"Maximum number of redraws per second (0 for no limit)"],
+                       [YDCommandVariable integer:&_batchMilliseconds withName:@"--batch-ms" usage:@"Write JSON events in arrays at most every n milliseconds (0 to write each event as it happens)"],
+                       [YDCommandVariable string:&_metricsPath withName:@"--metrics-file" usage:@"Write Prometheus metrics to a file"],
+                       [YDCommandVariable string:&_metricsSocketPath withName:@"--metrics-socket" usage:@"Serve Prometheus metrics over a Unix socket"],
+                       [YDCommandVariable integer:&_metricsInterval withName:@"--metrics-interval" usage:@"Number of seconds between writes to the metrics file (defaults to 15)"],
+                       [YDCommandVariable string:&_recordPath withName:@"--record" usage:@"Record notifications from Emporter (and the values read in response) to a file"],
+                       [YDCommandVariable string:&_replayPath withName:@"--replay" usage:@"Replay a recording instead of connecting to Emporter"],
+                       [YDCommandVariable integer:&_replaySpeed withName:@"--replay-speed" usage:@"Replay at n times the recorded speed (0 for as fast as possible)"],
+                       [YDCommandVariable integer:&_replayRepeatCount withName:@"--replay-repeat" usage:@"Replay the recording n times in a row"],
+                       [YDCommandVariable integer:&_maximumResidentMegabytes withName:@"--max-rss" usage:@"Warn when resident memory exceeds n megabytes"],
+                       [YDCommandVariable integer:&_probeInterval withName:@"--probe-interval" usage:@"Probe the local server of each proxy URL every n seconds, showing its latency (0 to disable)"],
                        ];
     
     return self;
 }
 
+- (YDCommandReturnCode)runWithArguments:(NSArray<NSString *> *)arguments {
+    // The command may be run more than once (i.e. by the create command), so options which are only set by parsing are reset.
+    // Public properties (i.e. the frame rate) are left as the caller set them.
+    _keepOpen = NO;
+    _filter = [[EMTunnelFilter alloc] init];
+    _batchMilliseconds = 0;
+    _metricsPath = nil;
+    _metricsSocketPath = nil;
+    _metricsInterval = 15;
+    _recordPath = nil;
+    _replayPath = nil;
+    _replaySpeed = 1;
+    _replayRepeatCount = 1;
+    _maximumResidentMegabytes = 0;
+    _probeInterval = 0;
+    return [super runWithArguments:arguments];
+}
+
 - (YDCommandReturnCode)executeWithArguments:(NSArray<NSString *> *)arguments {
     EMMainCommand *main = (EMMainCommand*)self.root;
     YDCommandReturnCode exitCode = YDCommandReturnCodeOK;
     
     BOOL didLaunch = NO;
-    _emporter = [main resolveEmporter:&exitCode didLaunch:&didLaunch];
+    
+    if (_replayPath != nil) {
+        NSError *error = nil;
+        _emporter = nil;
+        _replay = [EMSessionReplay replayWithContentsOfFile:[_replayPath stringByExpandingTildeInPath] error:&error];
+        _replay.repeatCount = (NSUInteger)MAX(_replayRepeatCount, 1);
+        _source = _replay;
+        
+        if (_replay == nil) {
+            [self _outputErrorWithMessage:@"Could not read recording" error:error];
+            exitCode = YDCommandReturnCodeError;
+        }
+    } else {
+        _emporter = [main resolveEmporter:&exitCode didLaunch:&didLaunch];
+        _source = _emporter;
+    }
+    
     _keepOpen = didLaunch ? _keepOpen : YES;
     
+    if (exitCode == YDCommandReturnCodeOK && _recordPath != nil) {
+        NSError *error = nil;
+        _recorder = [EMSessionRecorder recorderWithSource:_source path:[_recordPath stringByExpandingTildeInPath] error:&error];
+        _source = _recorder;
+        
+        if (_recorder == nil) {
+            [self _outputErrorWithMessage:@"Could not create recording" error:error];
+            exitCode = YDCommandReturnCodeError;
+        }
+    }
+    
+    EMMetrics *metrics = nil;
+    
+    if (exitCode == YDCommandReturnCodeOK && (_metricsPath != nil || _metricsSocketPath != nil)) {
+        metrics = [self _startMetrics:&exitCode];
+        _sessionMetrics = metrics ? [[EMSessionMetrics alloc] initWithMetrics:metrics] : nil;
+    }
+    
     if (exitCode == YDCommandReturnCodeOK) {
         // Resume service if it's suspended
         if (_emporter.serviceState == EmporterServiceStateSuspended) {
             [_emporter resumeService:NULL];
         }
-
+        
+        dispatch_source_t memoryCheck = _maximumResidentMegabytes > 0 ? [self _startMemoryCheck] : nil;
+        
         exitCode = main.outputJSON ? [self _runJSONLoop] : [self _runWindowLoop];
+        
+        if (memoryCheck != nil) {
+            dispatch_source_cancel(memoryCheck);
+        }
+    }
+    
+    [metrics stop];
+    _sessionMetrics = nil;
+    
+    [_recorder close];
+    
+    if (_replay != nil && exitCode != YDCommandReturnCodeError) {
+        [YDStandardError appendFormat:@"Replayed %lu events in %.2fs (%.0f/s). Latency to output: p50 %.2fms, p99 %.2fms, max %.2fms.\n",
+         _replay.numberOfPostedEvents, _replay.duration, _replay.duration > 0 ? (double)_replay.numberOfPostedEvents / _replay.duration : 0,
+         [_replay latencyAtPercentile:50] * 1000, [_replay latencyAtPercentile:99] * 1000, [_replay latencyAtPercentile:100] * 1000];
     }
     
+    _source = nil;
+    _recorder = nil;
+    _replay = nil;
+    
     if (!_keepOpen && _emporter != nil) {
         [_emporter quit];
     }
@@ -94,35 +213,141 @@
     return exitCode;
 }
 
+- (void)_outputErrorWithMessage:(NSString *)message error:(NSError *)error {
+    EMMainCommand *main = (EMMainCommand*)self.root;
+    
+    if (main.outputJSON) {
+        [YDStandardOut appendJSONObject:EMJSONErrorCreateInternal(message, error)];
+    } else {
+        EMOutputError(YDStandardError, @"%@: %@\n", message, error.localizedDescription);
+    }
+}
+
+- (EMMetrics *)_startMetrics:(YDCommandReturnCode *)outExitCode {
+    EMMetrics *metrics = [[EMMetrics alloc] init];
+    NSError *error = nil;
+    
+    if (_metricsPath != nil && ![metrics startWritingToFile:[_metricsPath stringByExpandingTildeInPath] interval:(NSTimeInterval)MAX(_metricsInterval, 1) error:&error]) {
+        metrics = nil;
+    } else if (_metricsSocketPath != nil && ![metrics startListeningOnSocketPath:[_metricsSocketPath stringByExpandingTildeInPath] error:&error]) {
+        [metrics stop];
+        metrics = nil;
+    }
+    
+    if (metrics == nil) {
+        [self _outputErrorWithMessage:@"Could not export metrics" error:error];
+        (*outExitCode) = YDCommandReturnCodeError;
+    }
+    
+    return metrics;
+}
+
+/*! Start probing the upstreams of proxy tunnels, or return nil if probes are disabled */
+- (EMUpstreamProber *)_startUpstreamProberWithUpdateHandler:(void(^)(NSDictionary<NSString*,EMUpstreamStatistics*> *statistics))updateHandler {
+    if (_probeInterval <= 0) {
+        return nil;
+    }
+    
+    EMUpstreamProber *prober = [[EMUpstreamProber alloc] initWithInterval:(NSTimeInterval)_probeInterval];
+    prober.updateHandler = updateHandler;
+    [prober start];
+    
+    return prober;
+}
+
+/*! Periodically check resident memory on the main queue, warning once each time it exceeds the limit */
+- (dispatch_source_t)_startMemoryCheck {
+    uint64_t limit = (uint64_t)_maximumResidentMegabytes * 1024 * 1024;
+    __block BOOL didExceedLimit = NO;
+    
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, 0), 10 * NSEC_PER_SEC, NSEC_PER_SEC);
+    dispatch_source_set_event_handler(timer, ^{
+        uint64_t residentSize = EMResidentMemorySize();
+        
+        if (residentSize > limit && !didExceedLimit) {
+            EMOutputWarning(YDStandardError, @"Resident memory (%lluMB) exceeds %ldMB\n", residentSize / 1024 / 1024, (long)self.maximumResidentMegabytes);
+        }
+        
+        didExceedLimit = residentSize > limit;
+    });
+    dispatch_resume(timer);
+    
+    return timer;
+}
+
+/*! Observe a notification from the source (Emporter or a recording), counting each notification when metrics are enabled */
+- (id)_observerForNotification:(NSNotificationName)name block:(void(^)(NSNotification *note))block {
+    EMMetricsCounter *counter = [_sessionMetrics counterForNotification:name];
+    
+    if (counter == nil) {
+        return EMNotificationObserverBlock(name, _source, block);
+    }
+    
+    return EMNotificationObserverBlock(name, _source, ^(NSNotification *note) {
+        [counter increment];
+        block(note);
+    });
+}
+
 - (YDCommandReturnCode)_runWindowLoop {
     EMMainCommand *main = (EMMainCommand*)self.root;
     
-    // Lazily refresh data based on observing events
+    // Lazily refresh data based on observing events. Events are coalesced until the next frame is drawn,
+    // so that a burst of notifications (i.e. while the service reconnects) results in a single refresh.
     NSMutableSet *observers = [NSMutableSet set];
     
-    __block BOOL refreshData = YES;
+    __block BOOL needsReload = YES;
+    __block BOOL needsServiceReload = YES;
+    __block NSUInteger pendingEventCount = 0;
+    NSMutableSet<NSString*> *dirtyTunnelIds = [NSMutableSet set];
+    
     void (^reloadData)(void) = ^{
-        refreshData = YES;
+        needsReload = YES;
+        needsServiceReload = YES;
+        [main.window setNeedsDisplay];
+    };
+    
+    void (^reloadTunnel)(NSNotification *) = ^(NSNotification *note) {
+        NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
+        
+        if (tunnelId != nil) {
+            [dirtyTunnelIds addObject:tunnelId];
+        } else {
+            needsReload = YES;
+        }
+        
+        pendingEventCount++;
         [main.window setNeedsDisplay];
     };
     
-    for (NSNotificationName notificationName in @[EmporterDidAddTunnelNotification,
-                                                  EmporterDidRemoveTunnelNotification,
-                                                  EmporterServiceStateDidChangeNotification,
-                                                  EmporterTunnelStateDidChangeNotification,
-                                                  EmporterTunnelConfigurationDidChangeNotification]) {
-        [observers addObject:EMNotificationObserverBlock(notificationName, self.emporter, ^(NSNotification *note) {
-            reloadData();
-        })];
+    for (NSNotificationName notificationName in @[EmporterDidAddTunnelNotification, EmporterDidRemoveTunnelNotification]) {
+        [observers addObject:[self _observerForNotification:notificationName block:^(NSNotification *note) {
+            pendingEventCount++;
+            needsReload = YES;
+            [main.window setNeedsDisplay];
+        }]];
+    }
+    
+    [observers addObject:[self _observerForNotification:EmporterServiceStateDidChangeNotification block:^(NSNotification *note) {
+        pendingEventCount++;
+        needsServiceReload = YES;
+        [main.window setNeedsDisplay];
+    }]];
+    
+    for (NSNotificationName notificationName in @[EmporterTunnelStateDidChangeNotification, EmporterTunnelConfigurationDidChangeNotification]) {
+        [observers addObject:[self _observerForNotification:notificationName block:reloadTunnel]];
     }
     
-    [observers addObject:EMNotificationObserverBlock(EmporterDidTerminateNotification, self.emporter, ^(NSNotification *note) {
+    [observers addObject:[self _observerForNotification:EmporterDidTerminateNotification block:^(NSNotification *note) {
         if (!self.relaunchAutomatically) {
             [YDStandardOut appendFormat:@"Emporter is no longer running"];
             return [main.window close];
         }
         
-        [self.emporter launchInBackgroundWithCompletionHandler:^(NSError *error) {
+        [self.source launchInBackgroundWithCompletionHandler:^(NSError *error) {
+            [self.sessionMetrics recordRelaunch:(error == nil)];
+            
             if (error == nil) {
                 reloadData();
             } else {
@@ -130,9 +355,9 @@
                 [main.window close];
             }
         }];
-    })];
+    }]];
     
-    __block NSArray<EmporterTunnel*> *tunnels = @[];
+    __block NSArray<EMTunnelSnapshot*> *tunnels = @[];
     __block EmporterServiceState serviceState = EmporterServiceStateSuspended;
     __block NSString *serviceConflictReason = nil;
     __block BOOL isTunnelRemoved = NO;
@@ -144,24 +369,122 @@
         appTitle = [appTitle stringByAppendingFormat:@" v%ld.%ld.%ld", appVersion.major, appVersion.minor, appVersion.patch];
     }
     
+    __block NSArray<NSString*> *tunnelIds = @[];
+    
+    // Rows are retained between frames, and only the rows which fit within the window are written
+    EMTunnelListView *listView = [[EMTunnelListView alloc] init];
+    
+    // Upstreams are probed from a background thread, and their statistics are read when the next frame is drawn
+    __block BOOL needsUpstreamReload = NO;
+    
+    EMUpstreamProber *prober = [self _startUpstreamProberWithUpdateHandler:^(NSDictionary<NSString*,EMUpstreamStatistics*> *statistics) {
+        needsUpstreamReload = YES;
+        [main.window setNeedsDisplay];
+    }];
+    
+    // Changes in latency alone aren't delivered, so statistics are also read again at the interval upstreams are probed
+    dispatch_source_t upstreamTimer = nil;
+    
+    if (prober != nil) {
+        upstreamTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+        dispatch_source_set_timer(upstreamTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(prober.interval * NSEC_PER_SEC)), (uint64_t)(prober.interval * NSEC_PER_SEC), NSEC_PER_SEC / 10);
+        dispatch_source_set_event_handler(upstreamTimer, ^{
+            needsUpstreamReload = YES;
+            [main.window setNeedsDisplay];
+        });
+        dispatch_resume(upstreamTimer);
+    }
+    
+    main.window.maximumFramesPerSecond = (NSUInteger)MAX(_maximumFramesPerSecond, 0);
+    main.window.keyHandler = ^(EMWindowKey key) {
+        if ([listView scrollWithKey:key]) {
+            [main.window setNeedsDisplay];
+        }
+    };
+    
     [main.window runDrawLoopWithBlock:^(id <EMWindowWriter> output) {
-        if (refreshData) {
+        uint64_t refreshStart = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        BOOL didRefreshTunnels = needsReload || dirtyTunnelIds.count > 0;
+        
+        if (!needsReload && dirtyTunnelIds.count > 0) {
+            // Only refetch tunnels named by events. If a tunnel we're not displaying has changed, it may now match our filter.
+            NSMutableArray<EMTunnelSnapshot*> *updatedTunnels = [tunnels mutableCopy];
+            
+            for (NSString *tunnelId in dirtyTunnelIds) {
+                NSUInteger idx = [tunnelIds indexOfObject:tunnelId];
+                
+                if (idx == NSNotFound) {
+                    needsReload = needsReload || (self.filter.count > 0 && !self.filter.isStatic);
+                    continue;
+                }
+                
+                EMTunnelSnapshot *tunnel = [self.source fetchTunnelSnapshotWithIdentifier:tunnelId];
+                
+                if (tunnel == nil || ![self.filter matchesSnapshot:tunnel]) {
+                    needsReload = YES;
+                    break;
+                }
+                
+                updatedTunnels[idx] = tunnel;
+            }
+            
+            tunnels = [updatedTunnels copy];
+        }
+        
+        if (needsReload) {
             BOOL isStatic = NO;
-            tunnels = [self _filteredTunnels:&isStatic];
+            NSArray<NSString*> *previousTunnelIds = tunnelIds;
+            
+            tunnels = [self _filteredTunnelSnapshots:&isStatic];
+            tunnelIds = [tunnels valueForKey:@"id"] ?: @[];
+            
+            if (self.sessionMetrics != nil) {
+                NSMutableSet *removedTunnelIds = [NSMutableSet setWithArray:previousTunnelIds];
+                [removedTunnelIds minusSet:[NSSet setWithArray:tunnelIds]];
+                
+                for (NSString *tunnelId in removedTunnelIds) {
+                    [self.sessionMetrics removeTunnelWithIdentifier:tunnelId];
+                }
+            }
             
             if (isStatic && tunnels.count == 0) {
                 isTunnelRemoved = YES;
                 [main.window close];
             }
+        }
+        
+        if (needsServiceReload) {
+            serviceState = self.source.serviceState;
+            serviceConflictReason = self.source.serviceConflictReason;
             
-            serviceState = self.emporter.serviceState;
-            serviceConflictReason = self.emporter.serviceConflictReason;
-
             main.window.title = [NSString stringWithFormat:@"%@ [%@]", appTitle, EMServiceStateDescription(serviceState, YES, NULL)];
-            
-            refreshData = NO;
+            [self.sessionMetrics recordServiceState:serviceState];
+        }
+        
+        if (didRefreshTunnels) {
+            listView.tunnels = tunnels;
+            prober.upstreamURLs = _EMUpstreamURLsForTunnels(tunnels);
         }
         
+        if (needsUpstreamReload) {
+            needsUpstreamReload = NO;
+            listView.upstreamStatistics = prober.statistics;
+        }
+        
+        if (didRefreshTunnels && self.sessionMetrics != nil) {
+            for (EMTunnelSnapshot *tunnel in tunnels) {
+                [self.sessionMetrics recordState:tunnel.state ofTunnelWithIdentifier:tunnel.id ?: @""];
+            }
+        }
+        
+        NSUInteger eventCount = pendingEventCount;
+        uint64_t renderStart = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        
+        needsReload = NO;
+        needsServiceReload = NO;
+        pendingEventCount = 0;
+        [dirtyTunnelIds removeAllObjects];
+        
         if (serviceState == EmporterServiceStateSuspended) {
             [output applyAlignment:EMWindowTextAlignmentCenter withinBlock:^(id<YDCommandOutputWriter> output) {
                 [output applyStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeUnderline) withinBlock:^(id<YDCommandOutputWriter> output) {
@@ -181,18 +504,22 @@
                     
                     [output appendString:@"\n\n"];
                     
-                    if (self.filterDescription != nil) {
-                        [output appendFormat:@"URL(s) for %@ will show up automatically once it's been created.", self.filterDescription];
+                    if (self.filter.filterDescription != nil) {
+                        [output appendFormat:@"URL(s) for %@ will show up automatically once it's been created.", self.filter.filterDescription];
                     } else {
                         [output appendString:@"URLs will show up automatically once they've been created."];
                     }
                 }];
             } else {
+                // Leave room for the footer (or the service's conflict reason) below the list
+                NSUInteger footerHeight = serviceConflictReason != nil ? 6 : (self.footerBlock != nil ? 2 : 0);
+                NSUInteger listHeight = output.height > footerHeight ? output.height - footerHeight : 1;
+                
                 [output applyTruncationWithinBlock:^(id<YDCommandOutputWriter> truncatedOutput) {
-                    [EMListCommand writeTunnels:tunnels toOutput:truncatedOutput];
+                    [listView writeToOutput:truncatedOutput numberOfLines:listHeight];
                 }];
             }
-
+            
             if (serviceConflictReason != nil) {
                 [output applyAlignment:EMWindowTextAlignmentCenter withinBlock:^(id<YDCommandOutputWriter> output) {
                     [output appendFormat:@"\n—\n\n%@\n", serviceConflictReason];
@@ -206,15 +533,36 @@
                 self.footerBlock(output);
             }
         }
+        
+        uint64_t renderEnd = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        [self.sessionMetrics recordFrameWithRefreshDuration:(NSTimeInterval)(renderStart - refreshStart) / NSEC_PER_SEC
+                                             renderDuration:(NSTimeInterval)(renderEnd - renderStart) / NSEC_PER_SEC
+                                                 eventCount:eventCount];
+        
+        self->_lastFrameEventCount = eventCount;
+        
+        // Recorded events are replayed once the initial frame has been drawn
+        [self.replay didOutputEvents];
+        [self.replay startWithSpeed:(double)self.replaySpeed completionHandler:^{
+            [main.window close];
+        }];
     }];
     
+    main.window.keyHandler = nil;
+    
+    if (upstreamTimer != nil) {
+        dispatch_source_cancel(upstreamTimer);
+    }
+    
+    [prober stop];
+    
     if (isTunnelRemoved) {
         [YDStandardOut appendString:@"URL was removed from Emporter.\n"];
     }
     
     if (main.window.isTerminated) {
         return YDCommandReturnCodeTerminated;
-    } else if (![self.emporter isRunning] || isTunnelRemoved) {
+    } else if (![self.source isRunning] || isTunnelRemoved) {
         return YDCommandReturnCodeError;
     } else {
         return YDCommandReturnCodeOK;
@@ -224,124 +572,161 @@
 - (YDCommandReturnCode)_runJSONLoop {
     NSMutableSet *observers = [NSMutableSet set];
     
+    // Events are written from a background thread so that a slow reader doesn't block the run loop (and Emporter's notifications)
+    EMEventWriter *writer = [[EMEventWriter alloc] initWithFileDescriptor:STDOUT_FILENO capacity:4 * 1024 * 1024];
+    writer.batchInterval = (NSTimeInterval)MAX(_batchMilliseconds, 0) / 1000;
+    
+    // URL events are emitted from a local store of snapshots which is patched as tunnels change,
+    // so that a change in state only needs to fetch state properties instead of the entire tunnel.
+    // The store isn't bounded: it shrinks as tunnels are removed, and evicting snapshots would drop tunnels from the output.
+    EMTunnelSnapshotStore *store = [[EMTunnelSnapshotStore alloc] initWithSource:_source];
+    
+    // Upstreams are probed from a background thread. Upstreams which become reachable (or unreachable) are written as url.state events.
+    EMUpstreamProber *prober = [self _startUpstreamProberWithUpdateHandler:^(NSDictionary<NSString*,EMUpstreamStatistics*> *statistics) {
+        for (NSString *tunnelId in [statistics.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+            EMTunnelSnapshot *snapshot = [store snapshotWithIdentifier:tunnelId];
+            
+            if (snapshot == nil || ![self.filter matchesSnapshot:snapshot]) {
+                continue;
+            }
+            
+            NSMutableDictionary *data = [NSMutableDictionary dictionaryWithObjectsAndKeys:tunnelId, @"_id", nil];
+            [data addEntriesFromDictionary:EMJSONObjectForTunnelSnapshotState(snapshot)];
+            data[@"upstream"] = statistics[tunnelId].JSONObject;
+            
+            [writer writeEvent:@"url.state" data:data];
+        }
+    }];
+    
+    void (^updateUpstreams)(void) = ^{
+        prober.upstreamURLs = _EMUpstreamURLsForTunnels([self.filter filteredSnapshots:store.snapshots]);
+    };
+    
     // App events
-    [observers addObject:EMNotificationObserverBlock(EmporterDidLaunchNotification, _emporter, ^(NSNotification *note) {
-        [YDStandardOut appendJSONObject:@{@"event": @"app.launch"}];
-    })];
+    [observers addObject:[self _observerForNotification:EmporterDidLaunchNotification block:^(NSNotification *note) {
+        // Tunnels from before Emporter was relaunched are gone without being removed
+        [store reload];
+        [self.sessionMetrics removeAllTunnels];
+        updateUpstreams();
+        
+        [writer writeEvent:@"app.launch" data:nil];
+    }]];
     
-    [observers addObject:EMNotificationObserverBlock(EmporterServiceStateDidChangeNotification, _emporter, ^(NSNotification *note) {
-        EmporterServiceState serviceState = self.emporter.serviceState;
+    [observers addObject:[self _observerForNotification:EmporterServiceStateDidChangeNotification block:^(NSNotification *note) {
+        EmporterServiceState serviceState = self.source.serviceState;
+        [self.sessionMetrics recordServiceState:serviceState];
         
         NSMutableDictionary *data = [NSMutableDictionary dictionaryWithObjectsAndKeys:EMServiceStateDescription(serviceState, NO, NULL) ?: [NSNull null], @"state", nil];
         if (serviceState == EmporterServiceStateConflicted) {
-            data[@"reason"] = self.emporter.serviceConflictReason ?: [NSNull null];
+            data[@"reason"] = self.source.serviceConflictReason ?: [NSNull null];
         }
         
-        [YDStandardOut appendJSONObject:@{@"event": @"app.service", @"data": data}];
-    })];
+        [writer writeEvent:@"app.service" data:data];
+    }]];
     
-    [observers addObject:EMNotificationObserverBlock(EmporterDidTerminateNotification, _emporter, ^(NSNotification *note) {
-        [YDStandardOut appendJSONObject:@{@"event": @"app.terminate", @"data": @{@"will_relaunch": @(self.relaunchAutomatically)} }];
+    [observers addObject:[self _observerForNotification:EmporterDidTerminateNotification block:^(NSNotification *note) {
+        [writer writeEvent:@"app.terminate" data:@{@"will_relaunch": @(self.relaunchAutomatically)}];
         
         if (!self.relaunchAutomatically) {
+            [writer close];
+            [self.sessionMetrics.metrics stop];
+            [self.recorder close];
             exit(YDCommandReturnCodeError);
         }
         
-        [self.emporter launchInBackgroundWithCompletionHandler:^(NSError *error) {
+        [self.source launchInBackgroundWithCompletionHandler:^(NSError *error) {
+            [self.sessionMetrics recordRelaunch:(error == nil)];
+            
             if (error == nil) {
                 return;
             }
             
-            [YDStandardOut appendJSONObject:@{@"event": @"app.terminate", @"data": @{@"will_relaunch": @(NO), @"error": error.localizedDescription } }];
+            [writer writeEvent:@"app.terminate" data:@{@"will_relaunch": @(NO), @"error": error.localizedDescription }];
+            [writer close];
+            [self.sessionMetrics.metrics stop];
+            [self.recorder close];
             exit(YDCommandReturnCodeError);
         }];
-    })];
-    
-    // URL events
-    
-    __block NSMutableSet *cachedTunnelIds = [NSMutableSet set];
-    BOOL(^isWatchingTunnelId)(NSString*) = ^(NSString *identifier) {
-        if ([cachedTunnelIds containsObject:identifier]) {
-            return YES;
-        } else {
-            EmporterTunnel *tunnel = [self.emporter tunnelWithIdentifier:identifier error:NULL];
-            if (tunnel != nil && [self _filterMatchesTunnel:tunnel]) {
-                [cachedTunnelIds addObject:tunnel.id ?: @""];
-                return YES;
-            }
-            return NO;
-        }
-    };
+    }]];
     
-    [observers addObject:EMNotificationObserverBlock(EmporterDidAddTunnelNotification, _emporter, ^(NSNotification *note) {
+    [observers addObject:[self _observerForNotification:EmporterDidAddTunnelNotification block:^(NSNotification *note) {
         NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
-        if (!isWatchingTunnelId(tunnelId)) {
+        EMTunnelSnapshot *snapshot = [store updateSnapshotWithIdentifier:tunnelId];
+        
+        if (![self.filter matchesSnapshot:snapshot]) {
             return;
         }
         
-        EmporterTunnel *tunnel = [self.emporter tunnelWithIdentifier:tunnelId error:nil];
-        tunnel = tunnel ? [tunnel get] : nil;
+        updateUpstreams();
+        [self.sessionMetrics recordState:snapshot.state ofTunnelWithIdentifier:tunnelId];
         
         NSMutableDictionary *data = [NSMutableDictionary dictionaryWithObjectsAndKeys:tunnelId, @"_id", nil];
-        if (tunnel != nil) {
-            [data addEntriesFromDictionary:EMJSONObjectForTunnel(tunnel, YES)];
-        }
+        [data addEntriesFromDictionary:EMJSONObjectForTunnelSnapshot(snapshot, YES)];
         
-        [YDStandardOut appendJSONObject:@{@"event": @"url.added", @"data": data }];
-    })];
+        [writer writeEvent:@"url.added" data:data];
+    }]];
     
-    [observers addObject:EMNotificationObserverBlock(EmporterDidRemoveTunnelNotification, _emporter, ^(NSNotification *note) {
+    [observers addObject:[self _observerForNotification:EmporterDidRemoveTunnelNotification block:^(NSNotification *note) {
         NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
-        if (!isWatchingTunnelId(tunnelId)) {
+        EMTunnelSnapshot *snapshot = [store removeSnapshotWithIdentifier:tunnelId];
+        [self.sessionMetrics removeTunnelWithIdentifier:tunnelId];
+        
+        if (![self.filter matchesSnapshot:snapshot]) {
             return;
         }
         
-        [YDStandardOut appendJSONObject:@{@"event": @"url.removed", @"data": @{@"_id": tunnelId} }];
+        updateUpstreams();
+        [writer writeEvent:@"url.removed" data:@{@"_id": tunnelId}];
         
-        // Signal to close if the URL we're observing by id was removed
-        if ([self.filter isKindOfClass:[NSString class]] && [self.filter isEqual:tunnelId]) {
+        // Signal to close once every URL we're observing by id was removed
+        if (self.filter.isStatic && [self.filter filteredSnapshots:store.snapshots].count == 0) {
             EMBlockRunLoopStop();
         }
-        
-        [cachedTunnelIds removeObject:tunnelId];
-    })];
+    }]];
     
-    [observers addObject:EMNotificationObserverBlock(EmporterTunnelStateDidChangeNotification, _emporter, ^(NSNotification *note) {
+    [observers addObject:[self _observerForNotification:EmporterTunnelStateDidChangeNotification block:^(NSNotification *note) {
         NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
-        if (!isWatchingTunnelId(tunnelId)) {
+        EMTunnelSnapshot *snapshot = [store snapshotWithIdentifier:tunnelId];
+        
+        // Only fetch the state of tunnels we're watching
+        if (snapshot != nil && ![self.filter matchesSnapshot:snapshot]) {
+            return;
+        } else if ((snapshot = [store updateStateOfSnapshotWithIdentifier:tunnelId]) == nil || ![self.filter matchesSnapshot:snapshot]) {
             return;
         }
         
-        EmporterTunnel *tunnel = [self.emporter tunnelWithIdentifier:tunnelId error:nil];
-        tunnel = tunnel ? [tunnel get] : nil;
+        [self.sessionMetrics recordState:snapshot.state ofTunnelWithIdentifier:tunnelId];
         
         NSMutableDictionary *data = [NSMutableDictionary dictionaryWithObjectsAndKeys:tunnelId, @"_id", nil];
-        if (tunnel != nil) {
-            [data addEntriesFromDictionary:EMJSONObjectForTunnelState(tunnel)];
+        [data addEntriesFromDictionary:EMJSONObjectForTunnelSnapshotState(snapshot)];
+        
+        EMUpstreamStatistics *upstream = prober.statistics[tunnelId];
+        if (upstream != nil) {
+            data[@"upstream"] = upstream.JSONObject;
         }
         
-        [YDStandardOut appendJSONObject:@{@"event": @"url.state", @"data": data }];
-    })];
+        [writer writeEvent:@"url.state" data:data];
+    }]];
     
-    [observers addObject:EMNotificationObserverBlock(EmporterTunnelConfigurationDidChangeNotification, _emporter, ^(NSNotification *note) {
+    [observers addObject:[self _observerForNotification:EmporterTunnelConfigurationDidChangeNotification block:^(NSNotification *note) {
         NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
-        if (!isWatchingTunnelId(tunnelId)) {
+        EMTunnelSnapshot *previousSnapshot = [store snapshotWithIdentifier:tunnelId];
+        EMTunnelSnapshot *snapshot = [store updateSnapshotWithIdentifier:tunnelId];
+        
+        // The tunnel's configuration may no longer apply to our filter (or it may now apply)
+        if (![self.filter matchesSnapshot:previousSnapshot] && ![self.filter matchesSnapshot:snapshot]) {
             return;
         }
         
-        EmporterTunnel *tunnel = [self.emporter tunnelWithIdentifier:tunnelId error:nil];
-        tunnel = tunnel ? [tunnel get] : nil;
+        updateUpstreams();
         
         NSMutableDictionary *data = [NSMutableDictionary dictionaryWithObjectsAndKeys:tunnelId, @"_id", nil];
-        if (tunnel != nil) {
-            [data addEntriesFromDictionary:EMJSONObjectForTunnel(tunnel, NO)];
+        if (snapshot != nil) {
+            [data addEntriesFromDictionary:EMJSONObjectForTunnelSnapshot(snapshot, NO)];
         }
         
-        [YDStandardOut appendJSONObject:@{@"event": @"url.config", @"data": data}];
-
-        // The tunnel's configuration has changed and it may no longer apply to our filter; remove from cache
-        [cachedTunnelIds removeObject:tunnelId];
-    })];
+        [writer writeEvent:@"url.config" data:data];
+    }]];
     
     // Output initial payload
     __block BOOL needsBootstrap = YES;
@@ -352,55 +737,63 @@
         }
         needsBootstrap = NO;
         
-        BOOL isStatic = NO;
-        NSArray *tunnels = [self _filteredTunnels:&isStatic];
+        // Populate the store with a single bulk fetch
+        [store reload];
+        updateUpstreams();
+        
+        NSMutableArray *urls = [NSMutableArray array];
+        
+        for (EMTunnelSnapshot *snapshot in store.snapshots) {
+            if ([self.filter matchesSnapshot:snapshot]) {
+                [self.sessionMetrics recordState:snapshot.state ofTunnelWithIdentifier:snapshot.id ?: @""];
+                [urls addObject:EMJSONObjectForTunnelSnapshot(snapshot, YES)];
+            }
+        }
         
-        if (isStatic && tunnels.count == 0) {
+        if (self.filter.isStatic && urls.count == 0) {
+            [writer flush];
             [YDStandardOut appendJSONObject:EMJSONErrorCreate(EMJSONErrorCodeNotFound, @"URL not found", nil)];
             EMBlockRunLoopStop();
         } else {
-            NSString *state = EMServiceStateDescription(self.emporter.serviceState ?: EmporterServiceStateSuspended, NO, NULL);
-            NSMutableArray *urls = [NSMutableArray array];
+            [self.sessionMetrics recordServiceState:self.source.serviceState];
             
-            for (EmporterTunnel *tunnel in tunnels) {
-                [urls addObject:EMJSONObjectForTunnel(tunnel, YES)];
-            }
+            NSString *state = EMServiceStateDescription(self.source.serviceState ?: EmporterServiceStateSuspended, NO, NULL);
+            [writer writeEvent:@"init" data:@{@"state": state, @"urls": urls}];
             
-            [YDStandardOut appendJSONObject:@{@"event": @"init", @"data": @{@"state": state, @"urls": urls}}];
+            // Recorded events are replayed once the initial payload has been written
+            self.replay.outputsSynchronously = YES;
+            [self.replay startWithSpeed:(double)self.replaySpeed completionHandler:^{
+                EMBlockRunLoopStop();
+            }];
         }
     });
     
-    return YDCommandReturnCodeTerminated;
+    [prober stop];
+    [writer close];
+    
+    return self.replay != nil ? YDCommandReturnCodeOK : YDCommandReturnCodeTerminated;
 }
 
-- (NSArray<EmporterTunnel*>*)_filteredTunnels:(BOOL*)outStatic {
-    if (_filter == nil) {
-        return [_emporter.tunnels get] ?: @[];
-    } else if ([_filter isKindOfClass:[NSString class]]) {
-        if (outStatic != NULL) {
-            (*outStatic) = YES;
-        }
-        
-        EmporterTunnel *tunnel = [self.emporter tunnelWithIdentifier:self.filter error:NULL];
-        tunnel = tunnel ? [tunnel get] : nil;
-        return tunnel ? @[tunnel] : @[];
-    } else {
-        return [self.emporter.tunnels filteredArrayUsingPredicate:self.filter] ?: @[];
+- (NSArray<EMTunnelSnapshot*>*)_filteredTunnelSnapshots:(BOOL*)outStatic {
+    if (!_filter.isStatic) {
+        // A single bulk fetch, matched against the filter's index locally
+        return [_filter filteredSnapshots:[self.source fetchTunnelSnapshots]];
     }
-}
-
-- (BOOL)_filterMatchesTunnel:(EmporterTunnel *)tunnel {
-    if (tunnel == nil) {
-        return NO;
-    } else if (_filter == nil) {
-        return YES;
-    } else if ([_filter isKindOfClass:[NSString class]]) {
-        return [(tunnel.id ?: @"") isEqualToString:_filter];
-    } else if ([_filter isKindOfClass:[NSPredicate class]]) {
-        return [(NSPredicate *)_filter evaluateWithObject:tunnel];
-    } else {
-        return NO;
+    
+    if (outStatic != NULL) {
+        (*outStatic) = YES;
     }
+    
+    NSMutableArray *snapshots = [NSMutableArray arrayWithCapacity:_filter.count];
+    
+    for (NSString *tunnelId in [_filter.tunnelIdentifiers.allObjects sortedArrayUsingSelector:@selector(compare:)]) {
+        EMTunnelSnapshot *snapshot = [self.source fetchTunnelSnapshotWithIdentifier:tunnelId];
+        if (snapshot != nil) {
+            [snapshots addObject:snapshot];
+        }
+    }
+    
+    return snapshots;
 }
 
 @end
@@ -45,7 +45,7 @@
     __block NSProgress *updaterProgress = nil;
     dispatch_queue_t progressQueue = dispatch_queue_create("net.youngdynasty.emporter-cli.update-progress", NULL);
     
-    [[EMUpdateFeed bundledFeed] readFeedWithCompletionHandler:^(NSArray<EMUpdate *> *updates, NSError *error) {
+    [[EMUpdateFeed bundledFeed] readLatestUpdateWithCompletionHandler:^(EMUpdate *latestUpdate, NSError *error) {
         if (error != nil) {
             if (main.outputJSON) {
                 [YDStandardOut appendJSONObject:@{@"status": @"error",
@@ -60,8 +60,6 @@
             exitCode = YDCommandReturnCodeError;
             return EMBlockRunLoopStop();
         }
-
-        EMUpdate *latestUpdate = updates.firstObject;
         
         if (latestUpdate == nil || EMVersionCompare(latestUpdate.version, EMVersionEmbedded()) != NSOrderedDescending) {
             if (main.outputJSON) {
@@ -104,7 +102,16 @@
             [YDStandardOut appendFormat:@"\n"];
         }
         
-        [EMUpdater applyWithURL:latestUpdate.assetURLs[tarballIdx] stateHandler:^(EMUpdaterState state, NSProgress *progress, NSError *error) {
+        // Releases may include a manifest of SHA-256 digests which is used to verify the package before it's applied
+        NSUInteger digestManifestIdx = [latestUpdate.assetURLs indexOfObjectPassingTest:^BOOL(NSURL *url, NSUInteger idx, BOOL *stop) {
+            return [url.lastPathComponent isEqualToString:@"SHA256SUMS"];
+        }];
+        NSURL *digestManifestURL = digestManifestIdx != NSNotFound ? latestUpdate.assetURLs[digestManifestIdx] : nil;
+        
+        // Releases may also include a (much smaller) binary patch from the current version
+        NSURL *patchURL = [latestUpdate patchURLFromVersion:EMVersionEmbedded()];
+        
+        [EMUpdater applyWithURL:latestUpdate.assetURLs[tarballIdx] patchURL:patchURL digestManifestURL:digestManifestURL stateHandler:^(EMUpdaterState state, NSProgress *progress, NSError *error) {
             dispatch_sync(progressQueue, ^{ updaterProgress = progress; });
             
             switch (state) {
@@ -114,6 +121,7 @@
                                                           @"message": @"Downloading update...",
                                                           @"version": EMVersionDescription(latestUpdate.version)}];
                     } else {
+                        spinner.progress = progress;
                         spinner.message = @"Downloading update...";
                     }
                     
@@ -124,6 +132,7 @@
                                                           @"message": @"Extracting update...",
                                                           @"version": EMVersionDescription(latestUpdate.version)}];
                     } else {
+                        spinner.progress = progress;
                         spinner.message = @"Extracting update...";
                     }
                     
@@ -0,0 +1,27 @@
+//
+//  EMBinaryPatch.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Apply a binary patch created by bsdiff(1) (BSDIFF40) to data.
+ 
+ Patches don't describe the data they were created from, so applying a patch to the wrong data will succeed with garbage as a result.
+ Callers are expected to verify the result (i.e. its code signature).
+ 
+ \param base        The data from which the patch was created
+ \param patch       The contents of the patch
+ \param outError    An optional pointer to an error describing why the patch is invalid
+ 
+ \returns The patched data, or nil if the patch is invalid.
+ */
+extern NSData *__nullable EMBinaryPatchApply(NSData *base, NSData *patch, NSError **__nullable outError);
+
+NS_ASSUME_NONNULL_END
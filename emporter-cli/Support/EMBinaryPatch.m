@@ -0,0 +1,178 @@
+//
+//  EMBinaryPatch.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <bzlib.h>
+
+#import "EMBinaryPatch.h"
+
+
+#define EMBinaryPatchHeaderSize 32
+
+/*! A bzip2 stream which is read in order, in exact lengths */
+typedef struct {
+    bz_stream stream;
+    BOOL isInitialized;
+} _EMBZ2Reader;
+
+static BOOL _EMBZ2ReaderInit(_EMBZ2Reader *reader, const uint8_t *bytes, size_t length) {
+    memset(reader, 0, sizeof(*reader));
+    
+    if (length > UINT_MAX) {
+        return NO;
+    }
+    
+    reader->stream.next_in = (char *)bytes;
+    reader->stream.avail_in = (unsigned int)length;
+    reader->isInitialized = BZ2_bzDecompressInit(&reader->stream, 0, 0) == BZ_OK;
+    
+    return reader->isInitialized;
+}
+
+static BOOL _EMBZ2ReaderRead(_EMBZ2Reader *reader, uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        unsigned int chunkLength = (unsigned int)MIN(length, (size_t)UINT_MAX);
+        
+        reader->stream.next_out = (char *)bytes;
+        reader->stream.avail_out = chunkLength;
+        
+        int status = BZ2_bzDecompress(&reader->stream);
+        size_t count = chunkLength - reader->stream.avail_out;
+        
+        bytes += count;
+        length -= count;
+        
+        if (status == BZ_STREAM_END) {
+            return length == 0;
+        } else if (status != BZ_OK || (count == 0 && reader->stream.avail_in == 0)) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+static void _EMBZ2ReaderEnd(_EMBZ2Reader *reader) {
+    if (reader->isInitialized) {
+        BZ2_bzDecompressEnd(&reader->stream);
+        reader->isInitialized = NO;
+    }
+}
+
+/*! Read a signed 64-bit integer stored as a little-endian magnitude with a sign bit */
+static int64_t _EMBinaryPatchReadOffset(const uint8_t *bytes) {
+    int64_t value = bytes[7] & 0x7f;
+    
+    for (int i = 6; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    
+    return (bytes[7] & 0x80) ? -value : value;
+}
+
+static NSError *_EMBinaryPatchCorruptError(NSString *reason) {
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{NSLocalizedDescriptionKey: @"The patch is corrupt", NSLocalizedFailureReasonErrorKey: reason}];
+}
+
+NSData *EMBinaryPatchApply(NSData *base, NSData *patch, NSError **outError) {
+    const uint8_t *patchBytes = patch.bytes;
+    
+    if (patch.length < EMBinaryPatchHeaderSize || memcmp(patchBytes, "BSDIFF40", 8) != 0) {
+        if (outError != NULL) {
+            (*outError) = _EMBinaryPatchCorruptError(@"Invalid header");
+        }
+        return nil;
+    }
+    
+    // The header is followed by three bzip2 streams: control tuples, bytewise differences and extra (new) bytes
+    int64_t controlLength = _EMBinaryPatchReadOffset(patchBytes + 8);
+    int64_t diffLength = _EMBinaryPatchReadOffset(patchBytes + 16);
+    int64_t newLength = _EMBinaryPatchReadOffset(patchBytes + 24);
+    int64_t bodyLength = (int64_t)patch.length - EMBinaryPatchHeaderSize;
+    
+    if (controlLength < 0 || diffLength < 0 || newLength < 0 || controlLength > bodyLength || diffLength > bodyLength - controlLength) {
+        if (outError != NULL) {
+            (*outError) = _EMBinaryPatchCorruptError(@"Invalid header");
+        }
+        return nil;
+    }
+    
+    const uint8_t *controlBytes = patchBytes + EMBinaryPatchHeaderSize;
+    const uint8_t *diffBytes = controlBytes + controlLength;
+    const uint8_t *extraBytes = diffBytes + diffLength;
+    size_t extraLength = (size_t)(bodyLength - controlLength - diffLength);
+    
+    _EMBZ2Reader control, diff, extra;
+    BOOL isValid = _EMBZ2ReaderInit(&control, controlBytes, (size_t)controlLength);
+    isValid = _EMBZ2ReaderInit(&diff, diffBytes, (size_t)diffLength) && isValid;
+    isValid = _EMBZ2ReaderInit(&extra, extraBytes, extraLength) && isValid;
+    
+    const uint8_t *baseBytes = base.bytes;
+    int64_t baseLength = (int64_t)base.length;
+    
+    // The header can claim any length, which may not be possible to allocate
+    NSMutableData *result = isValid ? [NSMutableData dataWithLength:(NSUInteger)newLength] : nil;
+    uint8_t *resultBytes = result.mutableBytes;
+    isValid = isValid && result != nil && (resultBytes != NULL || newLength == 0);
+    int64_t newPosition = 0;
+    int64_t basePosition = 0;
+    
+    while (isValid && newPosition < newLength) {
+        uint8_t tuple[24];
+        
+        if (!_EMBZ2ReaderRead(&control, tuple, sizeof(tuple))) {
+            isValid = NO;
+            break;
+        }
+        
+        int64_t addLength = _EMBinaryPatchReadOffset(tuple);
+        int64_t copyLength = _EMBinaryPatchReadOffset(tuple + 8);
+        int64_t seekLength = _EMBinaryPatchReadOffset(tuple + 16);
+        
+        if (addLength < 0 || copyLength < 0 || addLength > newLength - newPosition) {
+            isValid = NO;
+            break;
+        }
+        
+        // Add differences to the base
+        if (!_EMBZ2ReaderRead(&diff, resultBytes + newPosition, (size_t)addLength)) {
+            isValid = NO;
+            break;
+        }
+        
+        for (int64_t i = 0; i < addLength; i++) {
+            if (basePosition + i >= 0 && basePosition + i < baseLength) {
+                resultBytes[newPosition + i] += baseBytes[basePosition + i];
+            }
+        }
+        
+        newPosition += addLength;
+        basePosition += addLength;
+        
+        // Copy extra bytes as-is
+        if (copyLength > newLength - newPosition || !_EMBZ2ReaderRead(&extra, resultBytes + newPosition, (size_t)copyLength)) {
+            isValid = NO;
+            break;
+        }
+        
+        newPosition += copyLength;
+        basePosition += seekLength;
+    }
+    
+    _EMBZ2ReaderEnd(&control);
+    _EMBZ2ReaderEnd(&diff);
+    _EMBZ2ReaderEnd(&extra);
+    
+    if (!isValid) {
+        if (outError != NULL) {
+            (*outError) = _EMBinaryPatchCorruptError(@"Invalid patch data");
+        }
+        return nil;
+    }
+    
+    return result;
+}
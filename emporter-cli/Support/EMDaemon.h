@@ -0,0 +1,106 @@
+//
+//  EMDaemon.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The default location of the daemon's socket (within the user's temporary directory) */
+extern NSString *EMDaemonDefaultSocketPath(void);
+
+
+/*!
+ A command sent to the daemon.
+ 
+ Requests include the standard file descriptors of the client so that the daemon can run the command as if it were the client
+ (i.e. prompts and output go to the client's terminal).
+ */
+@interface EMDaemonRequest : NSObject
+
+/*!
+ The designated initializer.
+ \param arguments The arguments of the command (excluding the executable)
+ \returns A new request for the current process (using its working directory and standard file descriptors).
+ */
+- (instancetype)initWithArguments:(NSArray<NSString*> *)arguments NS_DESIGNATED_INITIALIZER;
+
+/*! The arguments of the command (excluding the executable) */
+@property(nonatomic,readonly) NSArray<NSString*> *arguments;
+
+/*! The working directory of the client */
+@property(nonatomic,copy) NSString *currentDirectoryPath;
+
+/*! Whether or not the client has disabled styled output */
+@property(nonatomic) BOOL outputStyleDisabled;
+
+/*! The standard input of the client */
+@property(nonatomic) int standardInput;
+
+/*! The standard output of the client */
+@property(nonatomic) int standardOutput;
+
+/*! The standard error of the client */
+@property(nonatomic) int standardError;
+
+@end
+
+
+/*!
+ A server which accepts requests on a Unix domain socket.
+ 
+ Requests are handled one at a time, and are only accepted from processes owned by the same user.
+ */
+@interface EMDaemonServer : NSObject
+
+/*!
+ The designated initializer.
+ \param socketPath  The path of the socket to listen on
+ \param queue       A serial queue used to handle requests
+ \param handler     The block used to handle requests, returning the status of the command
+ \returns A new instance of \c EMDaemonServer.
+ */
+- (instancetype)initWithSocketPath:(NSString *)socketPath queue:(dispatch_queue_t)queue handler:(int(^)(EMDaemonRequest *request))handler NS_DESIGNATED_INITIALIZER;
+
+/*! The path of the socket */
+@property(nonatomic,readonly) NSString *socketPath;
+
+/*!
+ Start listening for requests. Stale sockets are replaced, but the server will not start if another server is listening.
+ \param outError An optional pointer to an error describing why the server could not be started
+ \returns YES if the server was started.
+ */
+- (BOOL)startWithError:(NSError **__nullable)outError;
+
+/*! Stop listening for requests and remove the socket */
+- (void)stop;
+
+@end
+
+
+/*! A client used to send requests to the daemon */
+@interface EMDaemonClient : NSObject
+
+/*!
+ Send a request to the daemon and wait for the command to finish.
+ 
+ \param request         The request to send
+ \param socketPath      The path of the daemon's socket
+ \param outStatus       An optional pointer to the status of the command
+ \param outError        An optional pointer to an error. Errors in \c NSPOSIXErrorDomain with codes of ENOENT or ECONNREFUSED indicate
+                        that the daemon isn't running (and the request was not sent).
+ 
+ \returns YES if the command was run by the daemon.
+ */
++ (BOOL)sendRequest:(EMDaemonRequest *)request toSocketAtPath:(NSString *)socketPath status:(int *__nullable)outStatus error:(NSError **__nullable)outError;
+
+/*! Returns YES if a daemon is listening on the socket */
++ (BOOL)isListeningAtSocketPath:(NSString *)socketPath;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,375 @@
+//
+//  EMDaemon.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#import "EMDaemon.h"
+#import "EMUnixSocket.h"
+
+
+@interface EMDaemonRequest()
++ (nullable instancetype)_requestWithMessage:(NSDictionary *)message fileDescriptors:(const int *)fds;
+- (NSDictionary *)_message;
+@end
+
+
+#define EMDaemonMaximumMessageLength (1024 * 1024)
+#define EMDaemonNumberOfFileDescriptors 3
+
+NSString *EMDaemonDefaultSocketPath() {
+    return NSProcessInfo.processInfo.environment[@"EMPORTER_DAEMON_SOCKET"] ?: [NSTemporaryDirectory() stringByAppendingPathComponent:@"emporter-daemon.sock"];
+}
+
+static NSError *_EMDaemonPOSIXError(int code) {
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil];
+}
+
+static BOOL _EMDaemonWriteAll(int fd, const void *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t count = write(fd, bytes, length);
+        
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        
+        bytes = (const uint8_t *)bytes + count;
+        length -= (size_t)count;
+    }
+    
+    return YES;
+}
+
+static BOOL _EMDaemonReadAll(int fd, void *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t count = read(fd, bytes, length);
+        
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            if (count == 0) {
+                errno = ECONNRESET;
+            }
+            return NO;
+        }
+        
+        bytes = (uint8_t *)bytes + count;
+        length -= (size_t)count;
+    }
+    
+    return YES;
+}
+
+/*! Messages are binary property lists prefixed by their length (as a 32-bit big endian integer). File descriptors are sent with the length. */
+static BOOL _EMDaemonWriteMessage(int fd, NSDictionary *message, const int *fds, size_t fdCount, NSError **outError) {
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:message format:NSPropertyListBinaryFormat_v1_0 options:0 error:outError];
+    if (data == nil) {
+        return NO;
+    }
+    
+    uint32_t header = htonl((uint32_t)data.length);
+    struct iovec iov = { .iov_base = &header, .iov_len = sizeof(header) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    char control[CMSG_SPACE(sizeof(int) * EMDaemonNumberOfFileDescriptors)] = {0};
+    
+    if (fdCount > 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = (socklen_t)CMSG_SPACE(sizeof(int) * fdCount);
+        
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = (socklen_t)CMSG_LEN(sizeof(int) * fdCount);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fdCount);
+    }
+    
+    ssize_t count;
+    do {
+        count = sendmsg(fd, &msg, 0);
+    } while (count < 0 && errno == EINTR);
+    
+    BOOL success = count >= 0;
+    success = success && _EMDaemonWriteAll(fd, (const uint8_t *)&header + count, sizeof(header) - (size_t)count);
+    success = success && _EMDaemonWriteAll(fd, data.bytes, data.length);
+    
+    if (!success && outError != NULL) {
+        (*outError) = _EMDaemonPOSIXError(errno);
+    }
+    
+    return success;
+}
+
+static NSDictionary *_EMDaemonReadMessage(int fd, int *fds, size_t *fdCount, NSError **outError) {
+    uint32_t header = 0;
+    struct iovec iov = { .iov_base = &header, .iov_len = sizeof(header) };
+    char control[CMSG_SPACE(sizeof(int) * EMDaemonNumberOfFileDescriptors)];
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control) };
+    
+    size_t maximumFdCount = fdCount ? (*fdCount) : 0;
+    size_t receivedFdCount = 0;
+    
+    ssize_t count;
+    do {
+        count = recvmsg(fd, &msg, 0);
+    } while (count < 0 && errno == EINTR);
+    
+    if (count > 0) {
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            
+            const int *receivedFds = (const int *)CMSG_DATA(cmsg);
+            size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            
+            for (size_t i = 0; i < n; i++) {
+                if (receivedFdCount < maximumFdCount) {
+                    fcntl(receivedFds[i], F_SETFD, FD_CLOEXEC);
+                    fds[receivedFdCount++] = receivedFds[i];
+                } else {
+                    close(receivedFds[i]);
+                }
+            }
+        }
+    }
+    
+    if (fdCount != NULL) {
+        (*fdCount) = receivedFdCount;
+    }
+    
+    NSDictionary *message = nil;
+    int errorCode = 0;
+    
+    if (count <= 0 || (msg.msg_flags & MSG_CTRUNC)) {
+        errorCode = count == 0 ? ECONNRESET : (count < 0 ? errno : EPROTO);
+    } else if (!_EMDaemonReadAll(fd, (uint8_t *)&header + count, sizeof(header) - (size_t)count)) {
+        errorCode = errno;
+    } else if (ntohl(header) > EMDaemonMaximumMessageLength) {
+        errorCode = EMSGSIZE;
+    } else {
+        NSMutableData *data = [NSMutableData dataWithLength:ntohl(header)];
+        
+        if (!_EMDaemonReadAll(fd, data.mutableBytes, data.length)) {
+            errorCode = errno;
+        } else {
+            id plist = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:NULL];
+            message = [plist isKindOfClass:[NSDictionary class]] ? plist : nil;
+            errorCode = message ? 0 : EPROTO;
+        }
+    }
+    
+    if (message == nil) {
+        for (size_t i = 0; i < receivedFdCount; i++) {
+            close(fds[i]);
+        }
+        
+        if (fdCount != NULL) {
+            (*fdCount) = 0;
+        }
+        
+        if (outError != NULL) {
+            (*outError) = _EMDaemonPOSIXError(errorCode);
+        }
+    }
+    
+    return message;
+}
+
+
+@implementation EMDaemonRequest
+
+- (instancetype)init {
+    return [self initWithArguments:@[]];
+}
+
+- (instancetype)initWithArguments:(NSArray<NSString *> *)arguments {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _arguments = [arguments copy];
+    _currentDirectoryPath = [NSFileManager defaultManager].currentDirectoryPath;
+    _standardInput = STDIN_FILENO;
+    _standardOutput = STDOUT_FILENO;
+    _standardError = STDERR_FILENO;
+    
+    return self;
+}
+
+- (NSDictionary *)_message {
+    return @{@"arguments": _arguments, @"cwd": _currentDirectoryPath, @"outputStyleDisabled": @(_outputStyleDisabled)};
+}
+
++ (instancetype)_requestWithMessage:(NSDictionary *)message fileDescriptors:(const int *)fds {
+    NSArray *arguments = message[@"arguments"];
+    NSString *currentDirectoryPath = message[@"cwd"];
+    NSNumber *outputStyleDisabled = message[@"outputStyleDisabled"];
+    
+    if (![arguments isKindOfClass:[NSArray class]] || ![currentDirectoryPath isKindOfClass:[NSString class]] || ![outputStyleDisabled isKindOfClass:[NSNumber class]]) {
+        return nil;
+    }
+    
+    for (id argument in arguments) {
+        if (![argument isKindOfClass:[NSString class]]) {
+            return nil;
+        }
+    }
+    
+    EMDaemonRequest *request = [[self alloc] initWithArguments:arguments];
+    request.currentDirectoryPath = currentDirectoryPath;
+    request.outputStyleDisabled = outputStyleDisabled.boolValue;
+    request.standardInput = fds[0];
+    request.standardOutput = fds[1];
+    request.standardError = fds[2];
+    
+    return request;
+}
+
+@end
+
+
+@implementation EMDaemonServer {
+    dispatch_queue_t _queue;
+    int(^_handler)(EMDaemonRequest *);
+    dispatch_source_t _source;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithSocketPath:(NSString *)socketPath queue:(dispatch_queue_t)queue handler:(int (^)(EMDaemonRequest *))handler {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _socketPath = [socketPath copy];
+    _queue = queue;
+    _handler = [handler copy];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self stop];
+}
+
+- (BOOL)startWithError:(NSError **)outError {
+    if (_source != nil) {
+        return YES;
+    }
+    
+    if ([EMDaemonClient isListeningAtSocketPath:_socketPath]) {
+        if (outError != NULL) {
+            (*outError) = _EMDaemonPOSIXError(EADDRINUSE);
+        }
+        return NO;
+    }
+    
+    __weak EMDaemonServer *weakSelf = self;
+    
+    _source = EMUnixSocketListen(_socketPath, _queue, ^(int clientFd) {
+        [weakSelf _handleConnection:clientFd];
+    }, outError);
+    
+    return _source != nil;
+}
+
+- (void)stop {
+    if (_source != nil) {
+        dispatch_source_cancel(_source);
+        _source = nil;
+        
+        unlink(_socketPath.fileSystemRepresentation);
+    }
+}
+
+- (void)_handleConnection:(int)fd {
+    uid_t uid;
+    gid_t gid;
+    
+    if (getpeereid(fd, &uid, &gid) != 0 || uid != geteuid()) {
+        return;
+    }
+    
+    // Don't let a client which never sends its request block others
+    struct timeval timeout = { .tv_sec = 5 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    int fds[EMDaemonNumberOfFileDescriptors];
+    size_t fdCount = EMDaemonNumberOfFileDescriptors;
+    
+    NSDictionary *message = _EMDaemonReadMessage(fd, fds, &fdCount, NULL);
+    EMDaemonRequest *request = (message != nil && fdCount == EMDaemonNumberOfFileDescriptors) ? [EMDaemonRequest _requestWithMessage:message fileDescriptors:fds] : nil;
+    
+    if (request != nil) {
+        int status = _handler(request);
+        _EMDaemonWriteMessage(fd, @{@"status": @(status)}, NULL, 0, NULL);
+    }
+    
+    for (size_t i = 0; i < fdCount; i++) {
+        close(fds[i]);
+    }
+}
+
+@end
+
+
+@implementation EMDaemonClient
+
++ (BOOL)sendRequest:(EMDaemonRequest *)request toSocketAtPath:(NSString *)socketPath status:(int *)outStatus error:(NSError **)outError {
+    int fd = EMUnixSocketConnect(socketPath, outError);
+    if (fd < 0) {
+        return NO;
+    }
+    
+    int fds[EMDaemonNumberOfFileDescriptors] = {request.standardInput, request.standardOutput, request.standardError};
+    NSDictionary *response = nil;
+    
+    if (_EMDaemonWriteMessage(fd, [request _message], fds, EMDaemonNumberOfFileDescriptors, outError)) {
+        response = _EMDaemonReadMessage(fd, NULL, NULL, outError);
+    }
+    
+    close(fd);
+    
+    NSNumber *status = [response[@"status"] isKindOfClass:[NSNumber class]] ? response[@"status"] : nil;
+    
+    if (status == nil) {
+        if (response != nil && outError != NULL) {
+            (*outError) = _EMDaemonPOSIXError(EPROTO);
+        }
+        return NO;
+    }
+    
+    if (outStatus != NULL) {
+        (*outStatus) = status.intValue;
+    }
+    
+    return YES;
+}
+
++ (BOOL)isListeningAtSocketPath:(NSString *)socketPath {
+    int fd = EMUnixSocketConnect(socketPath, NULL);
+    
+    if (fd >= 0) {
+        close(fd);
+        return YES;
+    }
+    
+    return NO;
+}
+
+@end
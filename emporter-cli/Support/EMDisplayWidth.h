@@ -0,0 +1,35 @@
+//
+//  EMDisplayWidth.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ The number of terminal columns used to display UTF-8 text.
+
+ Text is measured in grapheme clusters: East Asian wide and fullwidth characters (and emoji) use 2 columns, while combining marks,
+ zero-width joiners, variation selectors and control characters use none. Invalid UTF-8 is measured as 1 column per byte.
+ Runs of printable ASCII are measured several bytes at a time.
+ */
+extern NSUInteger EMDisplayWidthOfUTF8(const char *bytes, NSUInteger length);
+
+/*! The number of terminal columns used to display a string */
+extern NSUInteger EMDisplayWidth(NSString *string);
+
+/*!
+ Measure the longest prefix of UTF-8 text which fits within a number of columns, without splitting grapheme clusters.
+ \param bytes           The UTF-8 text
+ \param length          The length of the text, in bytes
+ \param maximumWidth    The maximum number of columns
+ \param outWidth        An optional pointer to the number of columns used by the prefix
+ \returns The length of the prefix, in bytes.
+ */
+extern NSUInteger EMDisplayPrefixLengthOfUTF8(const char *bytes, NSUInteger length, NSUInteger maximumWidth, NSUInteger *__nullable outWidth);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,271 @@
+//
+//  EMDisplayWidth.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <string.h>
+
+#import "EMDisplayWidth.h"
+
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+} _EMCodePointRange;
+
+/*! Code points which extend the preceding grapheme cluster without using any columns (combining marks, joiners, variation selectors, etc.) */
+static const _EMCodePointRange _EMZeroWidthRanges[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7},
+    {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED},
+    {0x0711, 0x0711}, {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x07EB, 0x07F3}, {0x0816, 0x0819}, {0x081B, 0x0823}, {0x0825, 0x0827},
+    {0x0829, 0x082D}, {0x0859, 0x085B}, {0x08D3, 0x08E1}, {0x08E3, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948},
+    {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0981}, {0x09BC, 0x09BC}, {0x09C1, 0x09C4}, {0x09CD, 0x09CD},
+    {0x09E2, 0x09E3}, {0x0A01, 0x0A02}, {0x0A3C, 0x0A3C}, {0x0A41, 0x0A42}, {0x0A47, 0x0A48}, {0x0A4B, 0x0A4D}, {0x0A51, 0x0A51},
+    {0x0A70, 0x0A71}, {0x0A75, 0x0A75}, {0x0A81, 0x0A82}, {0x0ABC, 0x0ABC}, {0x0AC1, 0x0AC5}, {0x0AC7, 0x0AC8}, {0x0ACD, 0x0ACD},
+    {0x0AE2, 0x0AE3}, {0x0B01, 0x0B01}, {0x0B3C, 0x0B3C}, {0x0B3F, 0x0B3F}, {0x0B41, 0x0B44}, {0x0B4D, 0x0B4D}, {0x0B56, 0x0B56},
+    {0x0B62, 0x0B63}, {0x0B82, 0x0B82}, {0x0BC0, 0x0BC0}, {0x0BCD, 0x0BCD}, {0x0C00, 0x0C00}, {0x0C3E, 0x0C40}, {0x0C46, 0x0C48},
+    {0x0C4A, 0x0C4D}, {0x0C55, 0x0C56}, {0x0C62, 0x0C63}, {0x0CBC, 0x0CBC}, {0x0CCC, 0x0CCD}, {0x0CE2, 0x0CE3}, {0x0D00, 0x0D01},
+    {0x0D41, 0x0D44}, {0x0D4D, 0x0D4D}, {0x0D62, 0x0D63}, {0x0DCA, 0x0DCA}, {0x0DD2, 0x0DD4}, {0x0DD6, 0x0DD6}, {0x0E31, 0x0E31},
+    {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x0F18, 0x0F19}, {0x0F35, 0x0F35},
+    {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F71, 0x0F7E}, {0x0F80, 0x0F84}, {0x0F86, 0x0F87}, {0x0F8D, 0x0FBC}, {0x0FC6, 0x0FC6},
+    {0x102D, 0x1030}, {0x1032, 0x1037}, {0x1039, 0x103A}, {0x103D, 0x103E}, {0x1058, 0x1059}, {0x105E, 0x1060}, {0x1071, 0x1074},
+    {0x1082, 0x1082}, {0x1085, 0x1086}, {0x108D, 0x108D}, {0x109D, 0x109D}, {0x1160, 0x11FF}, {0x135D, 0x135F}, {0x1712, 0x1714},
+    {0x1732, 0x1734}, {0x1752, 0x1753}, {0x1772, 0x1773}, {0x17B4, 0x17B5}, {0x17B7, 0x17BD}, {0x17C6, 0x17C6}, {0x17C9, 0x17D3},
+    {0x17DD, 0x17DD}, {0x180B, 0x180D}, {0x1885, 0x1886}, {0x18A9, 0x18A9}, {0x1920, 0x1922}, {0x1927, 0x1928}, {0x1932, 0x1932},
+    {0x1939, 0x193B}, {0x1A17, 0x1A18}, {0x1A1B, 0x1A1B}, {0x1A56, 0x1A56}, {0x1A58, 0x1A5E}, {0x1A60, 0x1A60}, {0x1A62, 0x1A62},
+    {0x1A65, 0x1A6C}, {0x1A73, 0x1A7C}, {0x1A7F, 0x1A7F}, {0x1AB0, 0x1AFF}, {0x1B00, 0x1B03}, {0x1B34, 0x1B34}, {0x1B36, 0x1B3A},
+    {0x1B3C, 0x1B3C}, {0x1B42, 0x1B42}, {0x1B6B, 0x1B73}, {0x1B80, 0x1B81}, {0x1BA2, 0x1BA5}, {0x1BA8, 0x1BA9}, {0x1BAB, 0x1BAD},
+    {0x1BE6, 0x1BE6}, {0x1BE8, 0x1BE9}, {0x1BED, 0x1BED}, {0x1BEF, 0x1BF1}, {0x1C2C, 0x1C33}, {0x1C36, 0x1C37}, {0x1CD0, 0x1CD2},
+    {0x1CD4, 0x1CE0}, {0x1CE2, 0x1CE8}, {0x1CED, 0x1CED}, {0x1CF4, 0x1CF4}, {0x1CF8, 0x1CF9}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+    {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1}, {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF}, {0x302A, 0x302D},
+    {0x3099, 0x309A}, {0xA66F, 0xA672}, {0xA674, 0xA67D}, {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802}, {0xA806, 0xA806},
+    {0xA80B, 0xA80B}, {0xA825, 0xA826}, {0xA8C4, 0xA8C5}, {0xA8E0, 0xA8F1}, {0xA8FF, 0xA8FF}, {0xA926, 0xA92D}, {0xA947, 0xA951},
+    {0xA980, 0xA982}, {0xA9B3, 0xA9B3}, {0xA9B6, 0xA9B9}, {0xA9BC, 0xA9BD}, {0xA9E5, 0xA9E5}, {0xAA29, 0xAA2E}, {0xAA31, 0xAA32},
+    {0xAA35, 0xAA36}, {0xAA43, 0xAA43}, {0xAA4C, 0xAA4C}, {0xAA7C, 0xAA7C}, {0xAAB0, 0xAAB0}, {0xAAB2, 0xAAB4}, {0xAAB7, 0xAAB8},
+    {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1}, {0xAAEC, 0xAAED}, {0xAAF6, 0xAAF6}, {0xABE5, 0xABE5}, {0xABE8, 0xABE8}, {0xABED, 0xABED},
+    {0xD7B0, 0xD7FF}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}, {0x1D167, 0x1D169}, {0x1D173, 0x1D182},
+    {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD}, {0x1F3FB, 0x1F3FF}, {0xE0000, 0xE0FFF},
+};
+
+/*! Code points which use 2 columns (East Asian wide and fullwidth characters, and emoji presented as emoji by default) */
+static const _EMCodePointRange _EMWideRanges[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE},
+    {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE},
+    {0x26C4, 0x26C5}, {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA},
+    {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3},
+    {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18AFF},
+    {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F1E6, 0x1F1FF},
+    {0x1F200, 0x1F202}, {0x1F210, 0x1F23B}, {0x1F240, 0x1F248}, {0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320},
+    {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0},
+    {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E},
+    {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5},
+    {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB},
+    {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+#define _EMZeroWidthJoiner      0x200D
+#define _EMVariationSelector16  0xFE0F
+
+static BOOL _EMCodePointRangesContain(const _EMCodePointRange *ranges, size_t count, uint32_t codePoint) {
+    if (codePoint < ranges[0].first || codePoint > ranges[count - 1].last) {
+        return NO;
+    }
+    
+    size_t low = 0;
+    size_t high = count;
+    
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        
+        if (codePoint > ranges[mid].last) {
+            low = mid + 1;
+        } else if (codePoint < ranges[mid].first) {
+            high = mid;
+        } else {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+static inline BOOL _EMIsZeroWidth(uint32_t codePoint) {
+    return _EMCodePointRangesContain(_EMZeroWidthRanges, sizeof(_EMZeroWidthRanges) / sizeof(_EMZeroWidthRanges[0]), codePoint);
+}
+
+static inline BOOL _EMIsRegionalIndicator(uint32_t codePoint) {
+    return codePoint >= 0x1F1E6 && codePoint <= 0x1F1FF;
+}
+
+static NSUInteger _EMCodePointWidth(uint32_t codePoint) {
+    if (codePoint < 0x20 || (codePoint >= 0x7F && codePoint < 0xA0)) {
+        return 0;
+    } else if (codePoint < 0x300) {
+        return 1;
+    } else if (_EMIsZeroWidth(codePoint)) {
+        return 0;
+    } else if (_EMCodePointRangesContain(_EMWideRanges, sizeof(_EMWideRanges) / sizeof(_EMWideRanges[0]), codePoint)) {
+        return 2;
+    } else {
+        return 1;
+    }
+}
+
+/*! Decode a code point, returning the number of bytes it uses (invalid sequences decode as U+FFFD using a single byte) */
+static NSUInteger _EMDecodeUTF8(const uint8_t *bytes, NSUInteger length, uint32_t *outCodePoint) {
+    uint8_t lead = bytes[0];
+    NSUInteger sequenceLength;
+    uint32_t codePoint;
+    
+    if (lead < 0x80) {
+        (*outCodePoint) = lead;
+        return 1;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        sequenceLength = 2;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        sequenceLength = 3;
+        codePoint = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        sequenceLength = 4;
+        codePoint = lead & 0x07;
+    } else {
+        (*outCodePoint) = 0xFFFD;
+        return 1;
+    }
+    
+    if (sequenceLength > length) {
+        (*outCodePoint) = 0xFFFD;
+        return 1;
+    }
+    
+    for (NSUInteger i = 1; i < sequenceLength; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            (*outCodePoint) = 0xFFFD;
+            return 1;
+        }
+        
+        codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+    }
+    
+    // Reject overlong encodings, surrogates and code points beyond Unicode
+    if ((sequenceLength == 3 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) || (sequenceLength == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF))) {
+        (*outCodePoint) = 0xFFFD;
+        return 1;
+    }
+    
+    (*outCodePoint) = codePoint;
+    return sequenceLength;
+}
+
+/*! True if 8 bytes are all printable ASCII (0x20-0x7E), tested in parallel within a single word */
+static inline BOOL _EMIsPrintableASCIIWord(uint64_t word) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highBits = 0x8080808080808080ULL;
+    
+    // Any byte >= 0x80
+    if (word & highBits) {
+        return NO;
+    }
+    
+    // Any byte < 0x20: subtracting borrows into the high bit of the first such byte
+    if ((word - 0x20 * ones) & ~word & highBits) {
+        return NO;
+    }
+    
+    // Any byte == 0x7F (DEL): the byte is zero once XORed
+    uint64_t delBytes = word ^ (0x7F * ones);
+    return ((delBytes - ones) & ~delBytes & highBits) == 0;
+}
+
+static NSUInteger _EMDisplayMeasureUTF8(const uint8_t *bytes, NSUInteger length, NSUInteger maximumWidth, NSUInteger *outWidth) {
+    NSUInteger i = 0;
+    NSUInteger width = 0;
+    
+    // The current grapheme cluster, which is removed entirely if it's extended beyond the maximum width
+    NSUInteger clusterStart = 0;
+    NSUInteger clusterWidth = 0;
+    uint32_t previousCodePoint = 0;
+    NSUInteger regionalIndicatorCount = 0;
+    
+    while (i < length) {
+        // Printable ASCII is one column per byte; it only joins the previous cluster after a zero-width joiner
+        if (length - i >= sizeof(uint64_t) && maximumWidth - width >= sizeof(uint64_t) && previousCodePoint != _EMZeroWidthJoiner) {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(word));
+            
+            if (_EMIsPrintableASCIIWord(word)) {
+                i += sizeof(word);
+                width += sizeof(word);
+                
+                clusterStart = i - 1;
+                clusterWidth = 1;
+                previousCodePoint = bytes[i - 1];
+                regionalIndicatorCount = 0;
+                continue;
+            }
+        }
+        
+        uint32_t codePoint;
+        NSUInteger codePointLength = _EMDecodeUTF8(bytes + i, length - i, &codePoint);
+        
+        BOOL isExtending = i > 0 && (_EMIsZeroWidth(codePoint) || previousCodePoint == _EMZeroWidthJoiner ||
+                                     (_EMIsRegionalIndicator(codePoint) && regionalIndicatorCount % 2 == 1));
+        NSUInteger codePointWidth;
+        
+        if (!isExtending) {
+            codePointWidth = _EMCodePointWidth(codePoint);
+        } else if (codePoint == _EMVariationSelector16 && clusterWidth == 1) {
+            // Text-style symbols (i.e. ❤) are presented as emoji
+            codePointWidth = 1;
+        } else {
+            codePointWidth = 0;
+        }
+        
+        if (width + codePointWidth > maximumWidth) {
+            if (isExtending) {
+                width -= clusterWidth;
+                i = clusterStart;
+            }
+            break;
+        }
+        
+        if (!isExtending) {
+            clusterStart = i;
+            clusterWidth = 0;
+        }
+        
+        clusterWidth += codePointWidth;
+        width += codePointWidth;
+        i += codePointLength;
+        
+        regionalIndicatorCount = _EMIsRegionalIndicator(codePoint) ? regionalIndicatorCount + 1 : 0;
+        previousCodePoint = codePoint;
+    }
+    
+    if (outWidth != NULL) {
+        (*outWidth) = width;
+    }
+    
+    return i;
+}
+
+NSUInteger EMDisplayWidthOfUTF8(const char *bytes, NSUInteger length) {
+    NSUInteger width = 0;
+    _EMDisplayMeasureUTF8((const uint8_t *)bytes, length, NSUIntegerMax, &width);
+    return width;
+}
+
+NSUInteger EMDisplayWidth(NSString *string) {
+    const char *bytes = string.UTF8String;
+    return bytes != NULL ? EMDisplayWidthOfUTF8(bytes, strlen(bytes)) : 0;
+}
+
+NSUInteger EMDisplayPrefixLengthOfUTF8(const char *bytes, NSUInteger length, NSUInteger maximumWidth, NSUInteger *outWidth) {
+    return _EMDisplayMeasureUTF8((const uint8_t *)bytes, length, maximumWidth, outWidth);
+}
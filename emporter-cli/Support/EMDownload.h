@@ -0,0 +1,88 @@
+//
+//  EMDownload.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ An on-disk cache of downloads keyed by URL.
+ 
+ Files are written to the cache as they're downloaded, so that interrupted downloads can be resumed (using HTTP range requests)
+ instead of starting over.
+ */
+@interface EMDownloadCache : NSObject
+
+/*! A shared cache within the user's caches directory */
++ (instancetype)defaultCache;
+
+/*!
+ The designated initializer.
+ \param directoryURL The directory used to store downloads, which is created as needed
+ \returns A new instance of \c EMDownloadCache.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL NS_DESIGNATED_INITIALIZER;
+
+/*! The directory used to store downloads */
+@property(nonatomic,readonly) NSURL *directoryURL;
+
+/*! The location of a completed download (which may not exist) */
+- (NSURL *)fileURLForURL:(NSURL *)url;
+
+/*! The location of an incomplete download (which may not exist) */
+- (NSURL *)partialFileURLForURL:(NSURL *)url;
+
+/*! The entity tag (or last modified date) of an incomplete download, used to ensure it's resumed from the same entity */
+- (nullable NSString *)validatorForURL:(NSURL *)url;
+
+/*! Remove all files for a URL (i.e. when its contents are found to be invalid, or are no longer needed) */
+- (void)removeFilesForURL:(NSURL *)url;
+
+@end
+
+
+/*!
+ A download which is cached on disk and resumed where it left off.
+ 
+ The contents of the download are passed to its data handler in order, regardless of whether they come from the network or from the cache.
+ This allows the contents to be processed as they arrive (even across resumed attempts).
+ */
+@interface EMDownload : NSObject
+
+/*!
+ The designated initializer.
+ \param url     The URL to download
+ \param cache   The cache used to store the download
+ \returns A new instance of \c EMDownload.
+ */
+- (instancetype)initWithURL:(NSURL *)url cache:(EMDownloadCache *)cache NS_DESIGNATED_INITIALIZER;
+
+/*! The URL to download */
+@property(nonatomic,readonly) NSURL *url;
+
+/*! The cache used to store the download */
+@property(nonatomic,readonly) EMDownloadCache *cache;
+
+/*! The progress of the download, which can be canceled */
+@property(nonatomic,readonly) NSProgress *progress;
+
+/*! An optional block invoked (on a serial background queue) with the contents of the download. Returning NO cancels the download. */
+@property(nonatomic,copy,nullable) BOOL(^dataHandler)(NSData *data);
+
+/*! The number of bytes which were read from the cache instead of the network */
+@property(nonatomic,readonly) uint64_t numberOfCachedBytes;
+
+/*!
+ Start the download.
+ \param completionHandler The block to invoke (on a serial background queue) with the location of the completed download, or an error.
+ */
+- (void)startWithCompletionHandler:(void(^)(NSURL *__nullable fileURL, NSError *__nullable error))completionHandler;
+
+@end
+
+NS_ASSUME_NONNULL_END
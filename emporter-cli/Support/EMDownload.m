@@ -0,0 +1,404 @@
+//
+//  EMDownload.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <CommonCrypto/CommonDigest.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#import "EMDownload.h"
+
+
+#define EMDownloadReadBufferSize (256 * 1024)
+
+@interface EMDownloadCache()
+- (BOOL)_createDirectoryWithError:(NSError **)outError;
+- (void)_setValidator:(NSString *)validator forURL:(NSURL *)url;
+@end
+
+
+@implementation EMDownloadCache
+
++ (instancetype)defaultCache {
+    static dispatch_once_t onceToken;
+    static EMDownloadCache *defaultCache = nil;
+    
+    dispatch_once(&onceToken, ^{
+        NSURL *cachesURL = [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask].firstObject;
+        NSString *identifier = NSBundle.mainBundle.bundleIdentifier ?: @"net.youngdynasty.emporter-cli";
+        
+        cachesURL = [cachesURL ?: [NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:identifier];
+        defaultCache = [[self alloc] initWithDirectoryURL:[cachesURL URLByAppendingPathComponent:@"Downloads"]];
+    });
+    
+    return defaultCache;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _directoryURL = [directoryURL copy];
+    
+    return self;
+}
+
+- (NSString *)_keyForURL:(NSURL *)url {
+    NSData *data = [url.absoluteString dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+    
+    NSMutableString *key = [NSMutableString string];
+    for (size_t i = 0; i < 8; i++) {
+        [key appendFormat:@"%02x", digest[i]];
+    }
+    
+    // Keep the file name so the cache is legible
+    [key appendFormat:@"-%@", url.lastPathComponent.length > 0 ? url.lastPathComponent : @"download"];
+    
+    return key;
+}
+
+- (NSURL *)fileURLForURL:(NSURL *)url {
+    return [_directoryURL URLByAppendingPathComponent:[self _keyForURL:url]];
+}
+
+- (NSURL *)partialFileURLForURL:(NSURL *)url {
+    return [_directoryURL URLByAppendingPathComponent:[[self _keyForURL:url] stringByAppendingPathExtension:@"partial"]];
+}
+
+- (NSURL *)_validatorFileURLForURL:(NSURL *)url {
+    return [_directoryURL URLByAppendingPathComponent:[[self _keyForURL:url] stringByAppendingPathExtension:@"validator"]];
+}
+
+- (NSString *)validatorForURL:(NSURL *)url {
+    NSString *validator = [NSString stringWithContentsOfURL:[self _validatorFileURLForURL:url] encoding:NSUTF8StringEncoding error:NULL];
+    return validator.length > 0 ? validator : nil;
+}
+
+- (void)_setValidator:(NSString *)validator forURL:(NSURL *)url {
+    if (validator != nil) {
+        [validator writeToURL:[self _validatorFileURLForURL:url] atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+    } else {
+        [[NSFileManager defaultManager] removeItemAtURL:[self _validatorFileURLForURL:url] error:NULL];
+    }
+}
+
+- (void)removeFilesForURL:(NSURL *)url {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    
+    [fileManager removeItemAtURL:[self fileURLForURL:url] error:NULL];
+    [fileManager removeItemAtURL:[self partialFileURLForURL:url] error:NULL];
+    [fileManager removeItemAtURL:[self _validatorFileURLForURL:url] error:NULL];
+}
+
+- (BOOL)_createDirectoryWithError:(NSError **)outError {
+    return [[NSFileManager defaultManager] createDirectoryAtURL:_directoryURL withIntermediateDirectories:YES attributes:nil error:outError];
+}
+
+@end
+
+
+/*! The validator used to resume a download of the same entity. Weak entity tags can't be used for range requests. */
+static NSString *_EMDownloadValidatorFromResponse(NSHTTPURLResponse *response) {
+    NSString *entityTag = response.allHeaderFields[@"ETag"];
+    
+    if (entityTag.length > 0 && ![entityTag hasPrefix:@"W/"]) {
+        return entityTag;
+    }
+    
+    return response.allHeaderFields[@"Last-Modified"];
+}
+
+/*! The offset of a partial response ("Content-Range: bytes <start>-<end>/<length>"), or UINT64_MAX if it's invalid */
+static uint64_t _EMDownloadContentRangeOffset(NSHTTPURLResponse *response) {
+    NSScanner *scanner = [NSScanner scannerWithString:response.allHeaderFields[@"Content-Range"] ?: @""];
+    unsigned long long offset = 0;
+    
+    if (![scanner scanString:@"bytes" intoString:NULL] || ![scanner scanUnsignedLongLong:&offset] || ![scanner scanString:@"-" intoString:NULL]) {
+        return UINT64_MAX;
+    }
+    
+    return offset;
+}
+
+
+@interface EMDownload() <NSURLSessionDataDelegate>
+@end
+
+@implementation EMDownload {
+    NSOperationQueue *_queue;
+    int _fd;
+    uint64_t _resumeOffset;
+    NSError *_error;
+    void(^_completionHandler)(NSURL *, NSError *);
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithURL:(NSURL *)url cache:(EMDownloadCache *)cache {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _url = [url copy];
+    _cache = cache;
+    _fd = -1;
+    
+    // Progress is measured in bytes, which are unknown until the download starts
+    _progress = [NSProgress discreteProgressWithTotalUnitCount:-1];
+    _progress.kind = NSProgressKindFile;
+    [_progress setUserInfoObject:NSProgressFileOperationKindDownloading forKey:NSProgressFileOperationKindKey];
+    
+    // Data is handled in order, on a serial queue
+    _queue = [NSOperationQueue new];
+    _queue.maxConcurrentOperationCount = 1;
+    
+    return self;
+}
+
+- (void)startWithCompletionHandler:(void (^)(NSURL *, NSError *))completionHandler {
+    _completionHandler = [completionHandler copy];
+    
+    NSURL *fileURL = [_cache fileURLForURL:_url];
+    NSNumber *fileSize = nil;
+    
+    // Completed downloads are read from the cache
+    if ([fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL] && fileSize != nil) {
+        _progress.totalUnitCount = fileSize.longLongValue;
+        
+        [_queue addOperationWithBlock:^{
+            NSError *error = nil;
+            BOOL success = [self _readFileURL:fileURL length:fileSize.unsignedLongLongValue error:&error];
+            
+            self.progress.completedUnitCount = self.progress.totalUnitCount;
+            [self _completeWithFileURL:(success ? fileURL : nil) error:error];
+        }];
+        
+        return;
+    }
+    
+    NSError *error = nil;
+    if (![_cache _createDirectoryWithError:&error]) {
+        [_queue addOperationWithBlock:^{
+            [self _completeWithFileURL:nil error:error];
+        }];
+        
+        return;
+    }
+    
+    // The download is cached by us instead of the URL loading system
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:_url cachePolicy:NSURLRequestReloadIgnoringLocalCacheData timeoutInterval:60];
+    NSNumber *partialFileSize = nil;
+    NSString *validator = [_cache validatorForURL:_url];
+    
+    [[_cache partialFileURLForURL:_url] getResourceValue:&partialFileSize forKey:NSURLFileSizeKey error:NULL];
+    
+    // Resume from the end of the partial download, so long as the entity hasn't changed
+    if (partialFileSize.unsignedLongLongValue > 0 && validator != nil) {
+        _resumeOffset = partialFileSize.unsignedLongLongValue;
+        
+        [request setValue:[NSString stringWithFormat:@"bytes=%llu-", _resumeOffset] forHTTPHeaderField:@"Range"];
+        [request setValue:validator forHTTPHeaderField:@"If-Range"];
+    }
+    
+    NSURLSession *session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration] delegate:self delegateQueue:_queue];
+    __block NSURLSessionDataTask *task = [session dataTaskWithRequest:request];
+    
+    _progress.cancellationHandler = ^{
+        if (task != nil) {
+            [task cancel];
+            task = nil;
+        }
+    };
+    
+    [task resume];
+    [session finishTasksAndInvalidate];
+}
+
+- (BOOL)_readFileURL:(NSURL *)fileURL length:(uint64_t)length error:(NSError **)outError {
+    NSInputStream *input = [NSInputStream inputStreamWithURL:fileURL];
+    [input open];
+    
+    NSMutableData *buffer = [NSMutableData dataWithLength:EMDownloadReadBufferSize];
+    NSError *error = input.streamStatus == NSStreamStatusOpen ? nil : input.streamError;
+    
+    while (error == nil && length > 0) {
+        if (_progress.isCancelled) {
+            error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+            break;
+        }
+        
+        NSInteger count = [input read:buffer.mutableBytes maxLength:(NSUInteger)MIN((uint64_t)buffer.length, length)];
+        
+        if (count < 0) {
+            error = input.streamError;
+        } else if (count == 0) {
+            error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{NSURLErrorKey: fileURL}];
+        } else {
+            length -= (uint64_t)count;
+            _numberOfCachedBytes += (uint64_t)count;
+            _progress.completedUnitCount += count;
+            
+            if (_dataHandler != nil && !_dataHandler([NSData dataWithBytes:buffer.bytes length:(NSUInteger)count])) {
+                error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+            }
+        }
+    }
+    
+    [input close];
+    
+    if (error != nil) {
+        if (outError != NULL) {
+            (*outError) = error;
+        }
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)_completeWithFileURL:(NSURL *)fileURL error:(NSError *)error {
+    void(^completionHandler)(NSURL *, NSError *) = _completionHandler;
+    _completionHandler = nil;
+    
+    if (completionHandler != nil) {
+        completionHandler(fileURL, error);
+    }
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveResponse:(NSURLResponse *)response completionHandler:(void (^)(NSURLSessionResponseDisposition))completionHandler {
+    NSHTTPURLResponse *httpResponse = [response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil;
+    NSInteger statusCode = httpResponse ? httpResponse.statusCode : 200;
+    NSURL *partialFileURL = [_cache partialFileURLForURL:_url];
+    NSError *error = nil;
+    BOOL isResumed = NO;
+    
+    if (statusCode == 206 && _resumeOffset > 0 && _EMDownloadContentRangeOffset(httpResponse) == _resumeOffset) {
+        isResumed = YES;
+    } else if (statusCode != 200) {
+        NSDictionary *userInfo = @{NSLocalizedDescriptionKey: [NSHTTPURLResponse localizedStringForStatusCode:statusCode], NSURLErrorFailingURLErrorKey: _url};
+        error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:userInfo];
+    }
+    
+    // Start over if the server doesn't support ranges (or the entity has changed)
+    if (error == nil && !isResumed) {
+        _resumeOffset = 0;
+        
+        if ([[NSData data] writeToURL:partialFileURL options:0 error:&error]) {
+            [_cache _setValidator:(httpResponse ? _EMDownloadValidatorFromResponse(httpResponse) : nil) forURL:_url];
+        }
+    }
+    
+    if (error == nil && response.expectedContentLength >= 0) {
+        _progress.totalUnitCount = (int64_t)_resumeOffset + response.expectedContentLength;
+    }
+    
+    if (error == nil) {
+        _fd = open(partialFileURL.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CLOEXEC);
+        
+        if (_fd < 0) {
+            error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: partialFileURL.path}];
+        }
+    }
+    
+    // Replay the partial download before new data is received
+    if (error == nil && isResumed) {
+        [self _readFileURL:partialFileURL length:_resumeOffset error:&error];
+    }
+    
+    if (error != nil) {
+        _error = error;
+        completionHandler(NSURLSessionResponseCancel);
+    } else {
+        completionHandler(NSURLSessionResponseAllow);
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
+    __block NSError *error = nil;
+    
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        while (byteRange.length > 0) {
+            ssize_t count = write(self->_fd, bytes, byteRange.length);
+            
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                
+                error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+                (*stop) = YES;
+                return;
+            }
+            
+            bytes = (const uint8_t *)bytes + count;
+            byteRange.length -= (NSUInteger)count;
+        }
+    }];
+    
+    if (error == nil) {
+        _progress.completedUnitCount += (int64_t)data.length;
+    }
+    
+    if (error == nil && _dataHandler != nil && !_dataHandler(data)) {
+        error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+    }
+    
+    if (error != nil) {
+        _error = error;
+        [dataTask cancel];
+    }
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    
+    // Errors which occurred while handling data take precedence over the cancelation they caused
+    error = _error ?: error;
+    
+    NSURL *fileURL = nil;
+    
+    if (error == nil) {
+        fileURL = [_cache fileURLForURL:_url];
+        
+        // Downloads without a content length are complete once they've finished
+        _progress.totalUnitCount = _progress.completedUnitCount;
+        
+        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+        
+        if ([[NSFileManager defaultManager] moveItemAtURL:[_cache partialFileURLForURL:_url] toURL:fileURL error:&error]) {
+            [_cache _setValidator:nil forURL:_url];
+        } else {
+            fileURL = nil;
+        }
+    }
+    
+    [self _completeWithFileURL:fileURL error:error];
+}
+
+@end
@@ -0,0 +1,69 @@
+//
+//  EMEventWriter.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Writes events as newline-delimited JSON from a background thread.
+ 
+ Events are encoded into a reusable buffer and copied to a bounded queue, so that a slow reader never blocks the thread emitting events.
+ Each event is stamped with a sequence number and a timestamp:
+ 
+    {"seq":1,"ts":1792224000000,"event":"url.state","data":{...}}
+ 
+ When the queue is full, events are dropped (leaving a gap in sequence numbers) and an \c events.dropped event is written once there's room.
+ */
+@interface EMEventWriter : NSObject
+
+/*!
+ The designated initializer.
+ \param fd          The file descriptor to write to (which isn't closed by the writer)
+ \param capacity    The maximum number of bytes which can be queued
+ \returns A new instance of \c EMEventWriter.
+ */
+- (instancetype)initWithFileDescriptor:(int)fd capacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+/*! The file descriptor events are written to */
+@property(nonatomic,readonly) int fileDescriptor;
+
+/*! The maximum number of bytes which can be queued */
+@property(nonatomic,readonly) NSUInteger capacity;
+
+/*!
+ When greater than 0, events are written as JSON arrays at most once per interval instead of one per line, or sooner once half of the
+ queue is used. Defaults to 0. This must be set before writing events.
+ */
+@property(nonatomic) NSTimeInterval batchInterval;
+
+/*! The number of events which were dropped because the queue was full (or the file descriptor could no longer be written to) */
+@property(nonatomic,readonly) uint64_t numberOfDroppedEvents;
+
+/*!
+ Queue an event to be written. Events must be written from a single thread.
+ 
+ \param event   The name of the event
+ \param data    An optional JSON object (dictionaries, arrays, strings, numbers and null) describing the event
+ 
+ \returns The sequence number of the event, which is assigned even if the event is dropped.
+ */
+- (uint64_t)writeEvent:(NSString *)event data:(nullable id)data;
+
+/*! Wait until all queued events have been written (or can no longer be written) */
+- (void)flush;
+
+/*! Flush queued events and stop the writer's thread, which retains the writer until it's closed. Events written after closing are dropped. */
+- (void)close;
+
+@end
+
+/*! Encode a JSON object as compact JSON, appending it to data. Unsupported objects are encoded using their description. */
+extern void EMEventWriterAppendJSONObject(NSMutableData *data, id __nullable object);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,435 @@
+//
+//  EMEventWriter.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#import "EMEventWriter.h"
+
+
+#pragma mark - JSON
+
+static void _EMAppendEscapedJSONBytes(NSMutableData *data, const uint8_t *bytes, NSUInteger length) {
+    static const char hex[] = "0123456789abcdef";
+    
+    const uint8_t *run = bytes;
+    const uint8_t *end = bytes + length;
+    
+    // Append runs of bytes which don't need to be escaped
+    for (const uint8_t *c = bytes; c < end; c++) {
+        uint8_t byte = *c;
+        if (byte >= 0x20 && byte != '"' && byte != '\\') {
+            continue;
+        }
+        
+        [data appendBytes:run length:(NSUInteger)(c - run)];
+        run = c + 1;
+        
+        switch (byte) {
+            case '"':   [data appendBytes:"\\\"" length:2]; break;
+            case '\\':  [data appendBytes:"\\\\" length:2]; break;
+            case '\n':  [data appendBytes:"\\n" length:2]; break;
+            case '\r':  [data appendBytes:"\\r" length:2]; break;
+            case '\t':  [data appendBytes:"\\t" length:2]; break;
+            default: {
+                char escaped[] = {'\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xf]};
+                [data appendBytes:escaped length:sizeof(escaped)];
+                break;
+            }
+        }
+    }
+    
+    [data appendBytes:run length:(NSUInteger)(end - run)];
+}
+
+static void _EMAppendJSONString(NSMutableData *data, NSString *string) {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(cfString);
+    
+    [data appendBytes:"\"" length:1];
+    
+    // ASCII strings can usually be read without being converted, unless they contain a null character (which would end the C string early)
+    const char *cString = CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8);
+    
+    if (cString != NULL && strlen(cString) == (size_t)length) {
+        _EMAppendEscapedJSONBytes(data, (const uint8_t *)cString, (NSUInteger)length);
+    } else {
+        // Other strings are converted in chunks. Characters which can't be encoded (i.e. unpaired surrogates) are replaced with '?'.
+        uint8_t buffer[1024];
+        CFIndex location = 0;
+        
+        while (location < length) {
+            CFIndex usedLength = 0;
+            CFIndex convertedLength = CFStringGetBytes(cfString, CFRangeMake(location, length - location), kCFStringEncodingUTF8, '?', false,
+                                                       buffer, sizeof(buffer), &usedLength);
+            
+            if (convertedLength <= 0) {
+                break;
+            }
+            
+            _EMAppendEscapedJSONBytes(data, buffer, (NSUInteger)usedLength);
+            location += convertedLength;
+        }
+    }
+    
+    [data appendBytes:"\"" length:1];
+}
+
+static void _EMAppendJSONNumber(NSMutableData *data, NSNumber *number) {
+    if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+        if (number.boolValue) {
+            [data appendBytes:"true" length:4];
+        } else {
+            [data appendBytes:"false" length:5];
+        }
+        return;
+    }
+    
+    char buffer[32];
+    int length;
+    
+    switch (number.objCType[0]) {
+        case 'f':
+        case 'd': {
+            double value = number.doubleValue;
+            if (!isfinite(value)) {
+                [data appendBytes:"null" length:4];
+                return;
+            }
+            
+            // Prefer the shorter representation when it round trips
+            length = snprintf(buffer, sizeof(buffer), "%.15g", value);
+            if (strtod(buffer, NULL) != value) {
+                length = snprintf(buffer, sizeof(buffer), "%.17g", value);
+            }
+            break;
+        }
+        case 'C':
+        case 'S':
+        case 'I':
+        case 'L':
+        case 'Q':
+            length = snprintf(buffer, sizeof(buffer), "%llu", number.unsignedLongLongValue);
+            break;
+        default:
+            length = snprintf(buffer, sizeof(buffer), "%lld", number.longLongValue);
+            break;
+    }
+    
+    [data appendBytes:buffer length:(NSUInteger)length];
+}
+
+void EMEventWriterAppendJSONObject(NSMutableData *data, id object) {
+    if (object == nil || object == [NSNull null]) {
+        [data appendBytes:"null" length:4];
+    } else if ([object isKindOfClass:[NSString class]]) {
+        _EMAppendJSONString(data, object);
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        _EMAppendJSONNumber(data, object);
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        __block BOOL isFirst = YES;
+        
+        [data appendBytes:"{" length:1];
+        [(NSDictionary *)object enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+            if (!isFirst) {
+                [data appendBytes:"," length:1];
+            }
+            isFirst = NO;
+            
+            _EMAppendJSONString(data, [key isKindOfClass:[NSString class]] ? key : [key description]);
+            [data appendBytes:":" length:1];
+            EMEventWriterAppendJSONObject(data, value);
+        }];
+        [data appendBytes:"}" length:1];
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        BOOL isFirst = YES;
+        
+        [data appendBytes:"[" length:1];
+        for (id value in (NSArray *)object) {
+            if (!isFirst) {
+                [data appendBytes:"," length:1];
+            }
+            isFirst = NO;
+            
+            EMEventWriterAppendJSONObject(data, value);
+        }
+        [data appendBytes:"]" length:1];
+    } else {
+        _EMAppendJSONString(data, [object description]);
+    }
+}
+
+static void _EMAppendEvent(NSMutableData *buffer, uint64_t sequence, NSString *event, id data) {
+    char prefix[64];
+    int length = snprintf(prefix, sizeof(prefix), "{\"seq\":%llu,\"ts\":%llu,\"event\":", sequence, clock_gettime_nsec_np(CLOCK_REALTIME) / NSEC_PER_MSEC);
+    
+    [buffer appendBytes:prefix length:(NSUInteger)length];
+    _EMAppendJSONString(buffer, event);
+    
+    if (data != nil) {
+        [buffer appendBytes:",\"data\":" length:8];
+        EMEventWriterAppendJSONObject(buffer, data);
+    }
+    
+    [buffer appendBytes:"}\n" length:2];
+}
+
+/*! Write vectors in full, returning NO if the file descriptor can no longer be written to */
+static BOOL _EMWriteVectors(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        
+        if (count > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+    
+    return YES;
+}
+
+
+#pragma mark -
+
+@implementation EMEventWriter {
+    NSCondition *_condition;
+    
+    // Encoded events are queued in a ring buffer. The writer's thread owns queued bytes until it advances the head.
+    uint8_t *_queue;
+    NSUInteger _head;
+    NSUInteger _length;
+    
+    // Batches are written early once this many bytes are queued, so that events aren't dropped while waiting out the interval
+    NSUInteger _highWaterMark;
+    
+    BOOL _isClosed;
+    BOOL _isFinished;
+    BOOL _isFailed;
+    NSUInteger _numberOfFlushRequests;
+    
+    // Only accessed from the thread writing events
+    NSMutableData *_buffer;
+    uint64_t _sequence;
+    uint64_t _numberOfPendingDroppedEvents;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithFileDescriptor:(int)fd capacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _fileDescriptor = fd;
+    _capacity = MAX(capacity, 1);
+    _queue = malloc(_capacity);
+    _highWaterMark = MAX(_capacity / 2, 1);
+    _condition = [[NSCondition alloc] init];
+    _buffer = [NSMutableData dataWithCapacity:4096];
+    
+    // The thread retains the writer until it's closed
+    [NSThread detachNewThreadWithBlock:^{
+        [self _runWriteLoop];
+    }];
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_queue);
+}
+
+- (uint64_t)writeEvent:(NSString *)event data:(id)data {
+    uint64_t sequence = _sequence + 1;
+    
+    _buffer.length = 0;
+    
+    // Report dropped events before the next event which can be written
+    if (_numberOfPendingDroppedEvents > 0) {
+        _EMAppendEvent(_buffer, sequence++, @"events.dropped", @{@"count": @(_numberOfPendingDroppedEvents)});
+    }
+    
+    _EMAppendEvent(_buffer, sequence, event, data);
+    
+    if ([self _enqueueBytes:_buffer.bytes length:_buffer.length]) {
+        _sequence = sequence;
+        _numberOfPendingDroppedEvents = 0;
+    } else {
+        sequence = ++_sequence;
+        _numberOfPendingDroppedEvents++;
+        _numberOfDroppedEvents++;
+    }
+    
+    // Don't hold onto the memory of an unusually large event
+    if (_buffer.length > 64 * 1024) {
+        _buffer = [NSMutableData dataWithCapacity:4096];
+    }
+    
+    return sequence;
+}
+
+- (BOOL)_enqueueBytes:(const uint8_t *)bytes length:(NSUInteger)length {
+    [_condition lock];
+    
+    if (_isClosed || _isFailed || length > (_capacity - _length)) {
+        [_condition unlock];
+        return NO;
+    }
+    
+    NSUInteger tail = (_head + _length) % _capacity;
+    NSUInteger firstLength = MIN(length, _capacity - tail);
+    
+    memcpy(_queue + tail, bytes, firstLength);
+    memcpy(_queue, bytes + firstLength, length - firstLength);
+    
+    BOOL wasEmpty = _length == 0;
+    _length += length;
+    
+    // While batching, the writer only needs to be woken to start a batch or to write it early
+    if (_batchInterval <= 0 || wasEmpty || _length >= _highWaterMark) {
+        [_condition broadcast];
+    }
+    
+    [_condition unlock];
+    
+    return YES;
+}
+
+- (void)flush {
+    [_condition lock];
+    
+    _numberOfFlushRequests++;
+    [_condition broadcast];
+    
+    while (_length > 0) {
+        [_condition wait];
+    }
+    
+    _numberOfFlushRequests--;
+    
+    [_condition unlock];
+}
+
+- (void)close {
+    [_condition lock];
+    
+    _isClosed = YES;
+    [_condition broadcast];
+    
+    while (!_isFinished) {
+        [_condition wait];
+    }
+    
+    [_condition unlock];
+}
+
+#pragma mark - Writing
+
+- (void)_runWriteLoop {
+    [_condition lock];
+    
+    while (YES) {
+        while (_length == 0 && !_isClosed) {
+            [_condition wait];
+        }
+        
+        if (_length == 0) {
+            break;
+        }
+        
+        // Collect events until the batch interval elapses (unless they're needed sooner or the queue is filling up)
+        if (_batchInterval > 0) {
+            NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:_batchInterval];
+            
+            while (!_isClosed && _numberOfFlushRequests == 0 && _length < _highWaterMark && [_condition waitUntilDate:deadline]) {
+                continue;
+            }
+        }
+        
+        NSUInteger head = _head;
+        NSUInteger length = _length;
+        BOOL isFailed = _isFailed;
+        
+        [_condition unlock];
+        
+        // Queued bytes are discarded once the file descriptor can no longer be written to
+        BOOL success = isFailed || [self _writeQueuedBytesAtOffset:head length:length];
+        
+        [_condition lock];
+        
+        _head = (head + length) % _capacity;
+        _length -= length;
+        _isFailed = !success;
+        
+        [_condition broadcast];
+    }
+    
+    _isFinished = YES;
+    
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+- (BOOL)_writeQueuedBytesAtOffset:(NSUInteger)offset length:(NSUInteger)length {
+    struct iovec iov[4];
+    int count = 0;
+    
+    NSUInteger firstLength = MIN(length, _capacity - offset);
+    
+    if (_batchInterval > 0) {
+        // Each event ends with a newline (which can't appear within JSON), so joining events is a matter of replacing newlines with commas
+        for (NSUInteger i = 0; i < length - 1; i++) {
+            uint8_t *byte = _queue + ((offset + i) % _capacity);
+            if (*byte == '\n') {
+                *byte = ',';
+            }
+        }
+        
+        iov[count++] = (struct iovec){ .iov_base = (void *)"[", .iov_len = 1 };
+        
+        // Exclude the trailing newline
+        if (length - 1 <= firstLength) {
+            iov[count++] = (struct iovec){ .iov_base = _queue + offset, .iov_len = length - 1 };
+        } else {
+            iov[count++] = (struct iovec){ .iov_base = _queue + offset, .iov_len = firstLength };
+            iov[count++] = (struct iovec){ .iov_base = _queue, .iov_len = length - 1 - firstLength };
+        }
+        
+        iov[count++] = (struct iovec){ .iov_base = (void *)"]\n", .iov_len = 2 };
+    } else {
+        iov[count++] = (struct iovec){ .iov_base = _queue + offset, .iov_len = firstLength };
+        
+        if (length > firstLength) {
+            iov[count++] = (struct iovec){ .iov_base = _queue, .iov_len = length - firstLength };
+        }
+    }
+    
+    return _EMWriteVectors(_fileDescriptor, iov, count);
+}
+
+@end
@@ -0,0 +1,70 @@
+//
+//  EMFileDigest.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The length of a digest, in bytes */
+#define EMFileDigestLength 32
+
+/*! The size of the chunks which are hashed in parallel, in bytes */
+#define EMFileDigestChunkSize (1024 * 1024)
+
+/*! A SHA-256 digest */
+typedef struct {
+    uint8_t bytes[EMFileDigestLength];
+} EMFileDigest;
+
+/*!
+ The identity of a file's contents. If the contents of a file change, so does its identity.
+ 
+ The status change time is included as it can't be set by utimes(2), unlike the modification time.
+ */
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t modificationTime;
+    int64_t statusChangeTime;
+} EMFileIdentity;
+
+/*! Calculate the SHA-256 digest of bytes */
+extern void EMFileDigestOfBytes(const void *bytes, size_t length, EMFileDigest *outDigest);
+
+/*! Returns YES if both digests are equal */
+extern BOOL EMFileDigestEqual(const EMFileDigest *digest, const EMFileDigest *otherDigest);
+
+/*! Read the identity of an open file, which returns NO if the file isn't a regular file */
+extern BOOL EMFileIdentityOfDescriptor(int fileDescriptor, EMFileIdentity *outIdentity);
+
+/*!
+ Calculate the digest of an open file.
+ 
+ The file is split into chunks of \c EMFileDigestChunkSize bytes, which are read and hashed in parallel. The digest is the SHA-256 of the
+ file's size followed by the digest of each chunk, so it differs from the SHA-256 of the whole file. Universal binaries are hashed across
+ all slices at once, instead of one slice at a time.
+ 
+ \param fileDescriptor  The file to read, which isn't modified
+ \param size            The size of the file, in bytes
+ \param outDigest       The digest of the file
+ \returns YES if the file could be read.
+ */
+extern BOOL EMFileDigestOfDescriptor(int fileDescriptor, uint64_t size, EMFileDigest *outDigest);
+
+/*!
+ Calculate the digest of a file, which is read from a cache if the identity of the file hasn't changed since it was last calculated.
+ \param path            The path of a regular file
+ \param cacheDirectory  An optional directory used to cache digests, which is created if it doesn't exist
+ \param outDigest       The digest of the file
+ \param outIdentity     An optional pointer to the identity of the file
+ \returns YES if the digest was calculated.
+ */
+extern BOOL EMFileDigestOfPath(const char *path, const char *__nullable cacheDirectory, EMFileDigest *outDigest, EMFileIdentity *__nullable outIdentity);
+
+NS_ASSUME_NONNULL_END
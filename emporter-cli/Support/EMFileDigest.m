@@ -0,0 +1,433 @@
+//
+//  EMFileDigest.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <CommonCrypto/CommonDigest.h>
+#include <dispatch/dispatch.h>
+#else
+#include <pthread.h>
+#endif
+
+#import "EMFileDigest.h"
+
+
+/*! The size of the buffer used to read each chunk, which lives on the stack of the thread hashing it */
+#define _EMFileDigestReadSize (64 * 1024)
+
+#pragma mark - SHA-256
+
+#if defined(__APPLE__)
+
+typedef CC_SHA256_CTX _EMSHA256Context;
+
+static void _EMSHA256Init(_EMSHA256Context *context) {
+    CC_SHA256_Init(context);
+}
+
+static void _EMSHA256Update(_EMSHA256Context *context, const void *bytes, size_t length) {
+    CC_SHA256_Update(context, bytes, (CC_LONG)length);
+}
+
+static void _EMSHA256Final(_EMSHA256Context *context, EMFileDigest *outDigest) {
+    CC_SHA256_Final(outDigest->bytes, context);
+}
+
+#else
+
+// A portable implementation (FIPS 180-4), so that digests can be calculated (and benchmarked) without CommonCrypto
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t block[64];
+    size_t blockLength;
+} _EMSHA256Context;
+
+static const uint32_t _EMSHA256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define _EMSHA256Rotate(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void _EMSHA256Transform(_EMSHA256Context *context, const uint8_t *block) {
+    uint32_t w[64];
+    
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) | ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = _EMSHA256Rotate(w[i - 15], 7) ^ _EMSHA256Rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = _EMSHA256Rotate(w[i - 2], 17) ^ _EMSHA256Rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint32_t a = context->state[0], b = context->state[1], c = context->state[2], d = context->state[3];
+    uint32_t e = context->state[4], f = context->state[5], g = context->state[6], h = context->state[7];
+    
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = _EMSHA256Rotate(e, 6) ^ _EMSHA256Rotate(e, 11) ^ _EMSHA256Rotate(e, 25);
+        uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + _EMSHA256K[i] + w[i];
+        uint32_t s0 = _EMSHA256Rotate(a, 2) ^ _EMSHA256Rotate(a, 13) ^ _EMSHA256Rotate(a, 22);
+        uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+        
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    
+    context->state[0] += a; context->state[1] += b; context->state[2] += c; context->state[3] += d;
+    context->state[4] += e; context->state[5] += f; context->state[6] += g; context->state[7] += h;
+}
+
+static void _EMSHA256Init(_EMSHA256Context *context) {
+    static const uint32_t initialState[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    
+    memcpy(context->state, initialState, sizeof(initialState));
+    context->length = 0;
+    context->blockLength = 0;
+}
+
+static void _EMSHA256Update(_EMSHA256Context *context, const void *bytes, size_t length) {
+    const uint8_t *p = bytes;
+    context->length += length;
+    
+    if (context->blockLength > 0) {
+        size_t count = MIN(length, 64 - context->blockLength);
+        memcpy(context->block + context->blockLength, p, count);
+        context->blockLength += count;
+        p += count;
+        length -= count;
+        
+        if (context->blockLength < 64) {
+            return;
+        }
+        
+        _EMSHA256Transform(context, context->block);
+        context->blockLength = 0;
+    }
+    
+    for (; length >= 64; p += 64, length -= 64) {
+        _EMSHA256Transform(context, p);
+    }
+    
+    memcpy(context->block, p, length);
+    context->blockLength = length;
+}
+
+static void _EMSHA256Final(_EMSHA256Context *context, EMFileDigest *outDigest) {
+    uint64_t bitLength = context->length * 8;
+    uint8_t padding[72] = { 0x80 };
+    size_t paddingLength = (context->blockLength < 56 ? 56 : 120) - context->blockLength;
+    
+    for (int i = 0; i < 8; i++) {
+        padding[paddingLength + i] = (uint8_t)(bitLength >> (56 - i * 8));
+    }
+    
+    _EMSHA256Update(context, padding, paddingLength + 8);
+    
+    for (int i = 0; i < 8; i++) {
+        outDigest->bytes[i * 4] = (uint8_t)(context->state[i] >> 24);
+        outDigest->bytes[i * 4 + 1] = (uint8_t)(context->state[i] >> 16);
+        outDigest->bytes[i * 4 + 2] = (uint8_t)(context->state[i] >> 8);
+        outDigest->bytes[i * 4 + 3] = (uint8_t)context->state[i];
+    }
+}
+
+#endif
+
+void EMFileDigestOfBytes(const void *bytes, size_t length, EMFileDigest *outDigest) {
+    _EMSHA256Context context;
+    _EMSHA256Init(&context);
+    _EMSHA256Update(&context, bytes, length);
+    _EMSHA256Final(&context, outDigest);
+}
+
+BOOL EMFileDigestEqual(const EMFileDigest *digest, const EMFileDigest *otherDigest) {
+    return memcmp(digest->bytes, otherDigest->bytes, EMFileDigestLength) == 0;
+}
+
+#pragma mark - Files
+
+BOOL EMFileIdentityOfDescriptor(int fileDescriptor, EMFileIdentity *outIdentity) {
+    struct stat info;
+    
+    if (fstat(fileDescriptor, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return NO;
+    }
+    
+#if defined(__APPLE__)
+    struct timespec modificationTime = info.st_mtimespec;
+    struct timespec statusChangeTime = info.st_ctimespec;
+#else
+    struct timespec modificationTime = info.st_mtim;
+    struct timespec statusChangeTime = info.st_ctim;
+#endif
+
+    memset(outIdentity, 0, sizeof(EMFileIdentity));
+    outIdentity->device = (uint64_t)info.st_dev;
+    outIdentity->inode = (uint64_t)info.st_ino;
+    outIdentity->size = (uint64_t)info.st_size;
+    outIdentity->modificationTime = (int64_t)modificationTime.tv_sec * 1000000000 + modificationTime.tv_nsec;
+    outIdentity->statusChangeTime = (int64_t)statusChangeTime.tv_sec * 1000000000 + statusChangeTime.tv_nsec;
+    
+    return YES;
+}
+
+typedef struct {
+    int fileDescriptor;
+    uint64_t size;
+    EMFileDigest *chunkDigests;
+    atomic_bool didFail;
+#if !defined(__APPLE__)
+    size_t numberOfChunks;
+    atomic_size_t nextChunk;
+#endif
+} _EMFileDigestJob;
+
+static void _EMFileDigestHashChunk(void *context, size_t chunk) {
+    _EMFileDigestJob *job = context;
+    if (atomic_load_explicit(&job->didFail, memory_order_relaxed)) {
+        return;
+    }
+    
+    uint64_t offset = (uint64_t)chunk * EMFileDigestChunkSize;
+    uint64_t length = MIN((uint64_t)EMFileDigestChunkSize, job->size - offset);
+    uint8_t buffer[_EMFileDigestReadSize];
+    
+    _EMSHA256Context sha;
+    _EMSHA256Init(&sha);
+    
+    while (length > 0) {
+        ssize_t count = pread(job->fileDescriptor, buffer, (size_t)MIN(length, sizeof(buffer)), (off_t)offset);
+        
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            // The file was truncated (or couldn't be read)
+            atomic_store(&job->didFail, true);
+            return;
+        }
+        
+        _EMSHA256Update(&sha, buffer, (size_t)count);
+        offset += (uint64_t)count;
+        length -= (uint64_t)count;
+    }
+    
+    _EMSHA256Final(&sha, &job->chunkDigests[chunk]);
+}
+
+#if !defined(__APPLE__)
+static void *_EMFileDigestWorker(void *context) {
+    _EMFileDigestJob *job = context;
+    
+    for (size_t chunk = atomic_fetch_add(&job->nextChunk, 1); chunk < job->numberOfChunks; chunk = atomic_fetch_add(&job->nextChunk, 1)) {
+        _EMFileDigestHashChunk(job, chunk);
+    }
+    
+    return NULL;
+}
+#endif
+
+BOOL EMFileDigestOfDescriptor(int fileDescriptor, uint64_t size, EMFileDigest *outDigest) {
+    size_t numberOfChunks = (size_t)((size + EMFileDigestChunkSize - 1) / EMFileDigestChunkSize);
+    
+    _EMFileDigestJob job = { .fileDescriptor = fileDescriptor, .size = size };
+    job.chunkDigests = calloc(MAX(numberOfChunks, 1), sizeof(EMFileDigest));
+    atomic_init(&job.didFail, false);
+    
+    if (job.chunkDigests == NULL) {
+        return NO;
+    }
+    
+#if defined(__APPLE__)
+    dispatch_apply_f(numberOfChunks, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), &job, _EMFileDigestHashChunk);
+#else
+    job.numberOfChunks = numberOfChunks;
+    atomic_init(&job.nextChunk, 0);
+    
+    // The calling thread hashes chunks alongside workers, so a failure to create workers only means the file is hashed serially
+    long numberOfProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t numberOfWorkers = MIN((size_t)MAX(numberOfProcessors, 1), MAX(numberOfChunks, 1)) - 1;
+    pthread_t workers[15];
+    size_t numberOfStartedWorkers = 0;
+    
+    for (; numberOfStartedWorkers < MIN(numberOfWorkers, 15); numberOfStartedWorkers++) {
+        if (pthread_create(&workers[numberOfStartedWorkers], NULL, _EMFileDigestWorker, &job) != 0) {
+            break;
+        }
+    }
+    
+    _EMFileDigestWorker(&job);
+    
+    for (size_t i = 0; i < numberOfStartedWorkers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+#endif
+
+    BOOL success = !atomic_load(&job.didFail);
+    
+    if (success) {
+        uint8_t sizeBytes[8];
+        for (int i = 0; i < 8; i++) {
+            sizeBytes[i] = (uint8_t)(size >> (i * 8));
+        }
+        
+        _EMSHA256Context sha;
+        _EMSHA256Init(&sha);
+        _EMSHA256Update(&sha, sizeBytes, sizeof(sizeBytes));
+        _EMSHA256Update(&sha, job.chunkDigests, numberOfChunks * sizeof(EMFileDigest));
+        _EMSHA256Final(&sha, outDigest);
+    }
+    
+    free(job.chunkDigests);
+    
+    return success;
+}
+
+#pragma mark - Cache
+
+/*! Create a directory and its parents, returning YES if it exists */
+static BOOL _EMFileDigestCreateDirectory(const char *directory) {
+    char path[PATH_MAX];
+    
+    int length = snprintf(path, sizeof(path), "%s", directory);
+    if (length <= 0 || length >= PATH_MAX) {
+        return NO;
+    }
+    
+    for (char *p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+                return NO;
+            }
+            *p = '/';
+        }
+    }
+    
+    return mkdir(path, 0700) == 0 || errno == EEXIST;
+}
+
+/*! Format the path to a cache entry, which is named by the digest of its key */
+static BOOL _EMFileDigestCachePath(char path[PATH_MAX], const char *directory, const void *key, size_t keyLength, const char *extension) {
+    EMFileDigest name;
+    EMFileDigestOfBytes(key, keyLength, &name);
+    
+    char hex[EMFileDigestLength * 2 + 1];
+    for (int i = 0; i < EMFileDigestLength; i++) {
+        snprintf(hex + i * 2, 3, "%02x", name.bytes[i]);
+    }
+    
+    int length = snprintf(path, PATH_MAX, "%s/%s.%s", directory, hex, extension);
+    return length > 0 && length < PATH_MAX;
+}
+
+/*! Read a cache entry, returning YES if it contains the expected number of bytes */
+static BOOL _EMFileDigestCacheRead(const char *path, void *bytes, size_t length) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NO;
+    }
+    
+    ssize_t count = read(fd, bytes, length);
+    close(fd);
+    
+    return count == (ssize_t)length;
+}
+
+/*! Write a cache entry atomically, so that readers never see a partial entry */
+static BOOL _EMFileDigestCacheWrite(const char *directory, const char *path, const void *bytes, size_t length) {
+    char temporaryPath[PATH_MAX];
+    int pathLength = snprintf(temporaryPath, sizeof(temporaryPath), "%s/.entry-XXXXXX", directory);
+    
+    if (pathLength <= 0 || pathLength >= PATH_MAX || !_EMFileDigestCreateDirectory(directory)) {
+        return NO;
+    }
+    
+    int fd = mkstemp(temporaryPath);
+    if (fd < 0) {
+        return NO;
+    }
+    
+    BOOL success = write(fd, bytes, length) == (ssize_t)length;
+    success = (close(fd) == 0) && success;
+    success = success && rename(temporaryPath, path) == 0;
+    
+    if (!success) {
+        unlink(temporaryPath);
+    }
+    
+    return success;
+}
+
+BOOL EMFileDigestOfPath(const char *path, const char *cacheDirectory, EMFileDigest *outDigest, EMFileIdentity *outIdentity) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NO;
+    }
+    
+    EMFileIdentity identity;
+    if (!EMFileIdentityOfDescriptor(fd, &identity)) {
+        close(fd);
+        return NO;
+    }
+    
+    // Digests are cached by identity; entries repeat the identity so that they're never mistaken for another file's
+    struct {
+        EMFileIdentity identity;
+        EMFileDigest digest;
+    } entry;
+    
+    char entryPath[PATH_MAX];
+    BOOL isCached = NO;
+    BOOL canCache = cacheDirectory != NULL && _EMFileDigestCachePath(entryPath, cacheDirectory, &identity, sizeof(identity), "digest");
+    
+    if (canCache && _EMFileDigestCacheRead(entryPath, &entry, sizeof(entry))) {
+        isCached = memcmp(&entry.identity, &identity, sizeof(identity)) == 0;
+    }
+    
+    BOOL success = isCached || EMFileDigestOfDescriptor(fd, identity.size, &entry.digest);
+    
+    // Files which change while they're hashed have a new identity, so their digest isn't cached
+    if (success && !isCached && canCache) {
+        EMFileIdentity currentIdentity;
+        
+        if (EMFileIdentityOfDescriptor(fd, &currentIdentity) && memcmp(&currentIdentity, &identity, sizeof(identity)) == 0) {
+            entry.identity = identity;
+            _EMFileDigestCacheWrite(cacheDirectory, entryPath, &entry, sizeof(entry));
+        }
+    }
+    
+    close(fd);
+    
+    if (success) {
+        (*outDigest) = entry.digest;
+        
+        if (outIdentity != NULL) {
+            (*outIdentity) = identity;
+        }
+    }
+    
+    return success;
+}
@@ -0,0 +1,187 @@
+//
+//  EMManifest.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "EMTunnelSnapshot.h"
+#import "EMUtils.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class EMManifestItem;
+@class EMManifestChange;
+
+/*!
+ A declarative description of URLs, used to configure many URLs at once.
+ 
+ Manifests are JSON objects with an array of URLs, whose keys mirror the options of the create and edit commands:
+ 
+    {
+        "prune": false,
+        "urls": [
+            {"source": 8080, "name": "api", "auth": "user:password", "host": "api.local"},
+            {"source": "~/Sites/blog", "index": "index.html", "browsing": true, "liveReload": false},
+            {"source": "3000", "delete": true}
+        ]
+    }
+ 
+ Sources are parsed the same way as command-line input. When \c prune is true, URLs which aren't listed are deleted.
+ */
+@interface EMManifest : NSObject
+
+/*!
+ Parse a manifest from JSON.
+ \param data        The contents of the manifest
+ \param outError    An optional pointer to an error describing why the manifest is invalid
+ \returns A new manifest, or nil if it's invalid.
+ */
++ (nullable instancetype)manifestWithData:(NSData *)data error:(NSError **__nullable)outError;
+
+/*!
+ The designated initializer.
+ \param items   The URLs described by the manifest
+ \param prune   Whether or not URLs which aren't described should be deleted
+ \returns A new instance of \c EMManifest.
+ */
+- (instancetype)initWithItems:(NSArray<EMManifestItem*> *)items prune:(BOOL)prune NS_DESIGNATED_INITIALIZER;
+
+/*! The URLs described by the manifest */
+@property(nonatomic,readonly) NSArray<EMManifestItem*> *items;
+
+/*! Whether or not URLs which aren't described should be deleted */
+@property(nonatomic,readonly) BOOL prune;
+
+/*!
+ Determine the changes needed to make the given tunnels match the manifest.
+ \param snapshots Snapshots of every existing tunnel (i.e. from a single bulk fetch)
+ \param outError  An optional pointer to an error describing why the changes can't be determined (i.e. two items describe the same tunnel)
+ \returns A change for each item (in order), followed by deletions for unlisted tunnels when pruning, or nil if items conflict.
+ */
+- (nullable NSArray<EMManifestChange*> *)changesFromSnapshots:(NSArray<EMTunnelSnapshot*> *)snapshots error:(NSError **__nullable)outError;
+
+@end
+
+
+/*! A URL described by a manifest. Properties which are nil are left as they are. */
+@interface EMManifestItem : NSObject
+
+/*!
+ The designated initializer.
+ \param dictionary  The item's values from the manifest
+ \param outError    An optional pointer to an error describing why the item is invalid
+ \returns A new item, or nil if it's invalid.
+ */
+- (nullable instancetype)initWithDictionary:(NSDictionary<NSString*,id> *)dictionary error:(NSError **__nullable)outError NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! The source as written in the manifest */
+@property(nonatomic,readonly) NSString *source;
+
+/*! The type of the source */
+@property(nonatomic,readonly) EMSourceType sourceType;
+
+/*! The URL of the source (nil for tunnel identifiers) */
+@property(nonatomic,readonly,nullable) NSURL *sourceURL;
+
+@property(nonatomic,readonly,nullable) NSString *name;
+@property(nonatomic,readonly,nullable) NSString *authUsername;
+@property(nonatomic,readonly,nullable) NSString *authPassword;
+
+/*! The Host header used for proxy URLs. An empty string disables rewriting the Host header. */
+@property(nonatomic,readonly,nullable) NSString *proxyHost;
+
+@property(nonatomic,readonly,nullable) NSString *directoryIndexFile;
+@property(nonatomic,readonly,nullable) NSNumber *browsingEnabled;
+@property(nonatomic,readonly,nullable) NSNumber *liveReloadEnabled;
+
+/*! Whether or not the URL should be deleted */
+@property(nonatomic,readonly) BOOL shouldDelete;
+
+/*! Returns YES if the item describes the tunnel */
+- (BOOL)matchesSnapshot:(EMTunnelSnapshot *)snapshot;
+
+@end
+
+
+typedef NS_ENUM(NSUInteger, EMManifestChangeType) {
+    /*! The tunnel already matches the manifest */
+    EMManifestChangeTypeNone,
+    /*! A tunnel needs to be created (and configured) */
+    EMManifestChangeTypeCreate,
+    /*! An existing tunnel needs to be configured */
+    EMManifestChangeTypeUpdate,
+    /*! An existing tunnel needs to be deleted */
+    EMManifestChangeTypeDelete,
+    /*! The item can't be applied (i.e. its tunnel identifier doesn't exist) */
+    EMManifestChangeTypeInvalid,
+};
+
+/*! A change to a single tunnel, which records the result of applying it */
+@interface EMManifestChange : NSObject
+
+/*! The type of change */
+@property(nonatomic,readonly) EMManifestChangeType type;
+
+/*! The item which requires the change (or nil for tunnels which are pruned) */
+@property(nonatomic,readonly,nullable) EMManifestItem *item;
+
+/*! The existing tunnel (or nil for tunnels which need to be created) */
+@property(nonatomic,readonly,nullable) EMTunnelSnapshot *snapshot;
+
+/*! Property values which need to be set, keyed by the names of \c EmporterTunnel properties */
+@property(nonatomic,readonly) NSDictionary<NSString*,id> *values;
+
+/*! Whether or not the tunnel needs to be password protected */
+@property(nonatomic,readonly) BOOL needsAuth;
+
+/*! The identifier of the tunnel (which is set for created tunnels once the change is applied) */
+@property(nonatomic,readonly,nullable) NSString *tunnelIdentifier;
+
+/*! The error which occurred while applying the change (if any) */
+@property(nonatomic,readonly,nullable) NSError *error;
+
+/*! The time it took to apply the change */
+@property(nonatomic,readonly) NSTimeInterval duration;
+
+@end
+
+
+/*! A backend which can modify tunnels (i.e. Emporter, or a mock backend used for testing) */
+@protocol EMManifestBackend <EMTunnelSnapshotSource>
+
+/*! Create a tunnel, returning its identifier */
+- (nullable NSString *)createTunnelWithURL:(NSURL *)url name:(nullable NSString *)name error:(NSError **__nullable)outError;
+
+/*! Set property values of a tunnel, keyed by the names of \c EmporterTunnel properties */
+- (BOOL)setValues:(NSDictionary<NSString*,id> *)values ofTunnelWithIdentifier:(NSString *)identifier error:(NSError **__nullable)outError;
+
+/*! Password protect a tunnel */
+- (BOOL)passwordProtectTunnelWithIdentifier:(NSString *)identifier username:(NSString *)username password:(NSString *)password error:(NSError **__nullable)outError;
+
+/*! Delete a tunnel */
+- (BOOL)deleteTunnelWithIdentifier:(NSString *)identifier error:(NSError **__nullable)outError;
+
+@end
+
+
+/*!
+ Apply changes to a backend one at a time, in order. Scripting Bridge objects aren't thread-safe (and Emporter handles Apple Events
+ serially anyway), so changes are never applied concurrently. This function returns once every change has been applied.
+ 
+ \param changes The changes to apply
+ \param backend The backend used to modify tunnels
+ \param handler A block invoked (on the calling thread) as each change is applied
+ */
+extern void EMManifestApplyChanges(NSArray<EMManifestChange*> *changes, id<EMManifestBackend> backend, void(^__nullable handler)(EMManifestChange *change));
+
+
+@interface Emporter (EMManifestBackend) <EMManifestBackend>
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,495 @@
+//
+//  EMManifest.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <time.h>
+
+#import "EMManifest.h"
+
+#define CLASS_OR_NIL(v, k) (v != nil && [v isKindOfClass:[k class]] ? v : nil)
+
+
+static NSError *_EMManifestError(NSString *reason) {
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{NSLocalizedDescriptionKey: @"The manifest is invalid", NSLocalizedFailureReasonErrorKey: reason}];
+}
+
+static NSString *_EMManifestPathOfURL(NSURL *url) {
+    return (url.filePathURL ?: url).URLByResolvingSymlinksInPath.path ?: @"";
+}
+
+static BOOL _EMManifestDirectoryExists(NSURL *url) {
+    BOOL isDirectory = NO;
+    return [NSFileManager.defaultManager fileExistsAtPath:_EMManifestPathOfURL(url) isDirectory:&isDirectory] && isDirectory;
+}
+
+/*! A key which identifies where a tunnel's traffic is served from, used to match items to tunnels */
+static NSString *_EMManifestKeyForSnapshot(EMTunnelSnapshot *snapshot) {
+    switch (snapshot.kind) {
+        case EmporterTunnelKindDirectory:
+            return snapshot.directory ? [@"directory:" stringByAppendingString:_EMManifestPathOfURL(snapshot.directory)] : nil;
+        case EmporterTunnelKindProxy:
+            return snapshot.proxyPort ? [NSString stringWithFormat:@"port:%@", snapshot.proxyPort] : nil;
+        default:
+            return nil;
+    }
+}
+
+
+@interface EMManifestItem()
+@property(nonatomic,readonly) NSString *key;
+@end
+
+@interface EMManifestChange()
+- (instancetype)_initWithItem:(EMManifestItem *)item snapshot:(EMTunnelSnapshot *)snapshot;
+- (void)_applyWithBackend:(id<EMManifestBackend>)backend;
+@end
+
+
+#pragma mark -
+
+@implementation EMManifest
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
++ (instancetype)manifestWithData:(NSData *)data error:(NSError **)outError {
+    NSError *error = nil;
+    id object = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+    
+    NSDictionary *dict = CLASS_OR_NIL(object, NSDictionary);
+    NSArray *urls = CLASS_OR_NIL(dict[@"urls"], NSArray);
+    id prune = dict[@"prune"];
+    
+    if (dict == nil) {
+        error = error ?: _EMManifestError(@"Expected a JSON object");
+    } else if (urls == nil) {
+        error = _EMManifestError(@"Expected an array of URLs for \"urls\"");
+    } else if (prune != nil && CLASS_OR_NIL(prune, NSNumber) == nil) {
+        error = _EMManifestError(@"Expected a boolean for \"prune\"");
+    } else {
+        for (NSString *key in dict) {
+            if (![@[@"urls", @"prune"] containsObject:key]) {
+                error = _EMManifestError([NSString stringWithFormat:@"Unknown key \"%@\"", key]);
+                break;
+            }
+        }
+    }
+    
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:urls.count];
+    NSMutableSet *keys = [NSMutableSet setWithCapacity:urls.count];
+    
+    for (id value in (error == nil ? urls : @[])) {
+        NSDictionary *itemDict = CLASS_OR_NIL(value, NSDictionary);
+        EMManifestItem *item = nil;
+        
+        if (itemDict == nil) {
+            error = _EMManifestError([NSString stringWithFormat:@"Expected an object for URL %lu", items.count + 1]);
+        } else if ((item = [[EMManifestItem alloc] initWithDictionary:itemDict error:&error]) == nil) {
+            // Error is set by the item
+        } else if ([keys containsObject:item.key]) {
+            error = _EMManifestError([NSString stringWithFormat:@"\"%@\" is listed more than once", item.source]);
+        }
+        
+        if (error != nil) {
+            break;
+        }
+        
+        [keys addObject:item.key];
+        [items addObject:item];
+    }
+    
+    if (error != nil) {
+        if (outError != NULL) {
+            (*outError) = error;
+        }
+        
+        return nil;
+    }
+    
+    return [[self alloc] initWithItems:items prune:[prune boolValue]];
+}
+
+- (instancetype)initWithItems:(NSArray<EMManifestItem *> *)items prune:(BOOL)prune {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _items = [items copy];
+    _prune = prune;
+    
+    return self;
+}
+
+- (NSArray<EMManifestChange *> *)changesFromSnapshots:(NSArray<EMTunnelSnapshot *> *)snapshots error:(NSError **)outError {
+    NSMutableDictionary<NSString*,EMTunnelSnapshot*> *snapshotsByKey = [NSMutableDictionary dictionaryWithCapacity:snapshots.count * 2];
+    
+    for (EMTunnelSnapshot *snapshot in snapshots) {
+        NSString *key = _EMManifestKeyForSnapshot(snapshot);
+        
+        if (snapshot.id != nil) {
+            snapshotsByKey[[@"id:" stringByAppendingString:snapshot.id.uppercaseString]] = snapshot;
+        }
+        
+        // Prefer the first tunnel when multiple tunnels serve the same source
+        if (key != nil && snapshotsByKey[key] == nil) {
+            snapshotsByKey[key] = snapshot;
+        }
+    }
+    
+    NSMutableArray *changes = [NSMutableArray arrayWithCapacity:_items.count];
+    NSMutableDictionary<NSString*,EMManifestItem*> *matchedItems = [NSMutableDictionary dictionaryWithCapacity:_items.count];
+    
+    for (EMManifestItem *item in _items) {
+        EMTunnelSnapshot *snapshot = snapshotsByKey[item.key];
+        
+        // Items are unique, but an id and a source can still describe the same tunnel (whose changes would conflict)
+        if (snapshot.id != nil && matchedItems[snapshot.id] != nil) {
+            if (outError != NULL) {
+                (*outError) = _EMManifestError([NSString stringWithFormat:@"\"%@\" and \"%@\" describe the same URL", matchedItems[snapshot.id].source, item.source]);
+            }
+            
+            return nil;
+        }
+        
+        if (snapshot.id != nil) {
+            matchedItems[snapshot.id] = item;
+        }
+        
+        [changes addObject:[[EMManifestChange alloc] _initWithItem:item snapshot:snapshot]];
+    }
+    
+    if (_prune) {
+        for (EMTunnelSnapshot *snapshot in snapshots) {
+            if (snapshot.id != nil && matchedItems[snapshot.id] == nil) {
+                [changes addObject:[[EMManifestChange alloc] _initWithItem:nil snapshot:snapshot]];
+            }
+        }
+    }
+    
+    return changes;
+}
+
+@end
+
+
+#pragma mark -
+
+@implementation EMManifestItem
+
+- (instancetype)initWithDictionary:(NSDictionary<NSString *,id> *)dictionary error:(NSError **)outError {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    NSError *error = nil;
+    id source = dictionary[@"source"];
+    
+    if (CLASS_OR_NIL(source, NSNumber) != nil) {
+        source = [source stringValue];
+    }
+    
+    _source = CLASS_OR_NIL(source, NSString);
+    _name = CLASS_OR_NIL(dictionary[@"name"], NSString);
+    _proxyHost = CLASS_OR_NIL(dictionary[@"host"], NSString);
+    _directoryIndexFile = CLASS_OR_NIL(dictionary[@"index"], NSString);
+    _browsingEnabled = CLASS_OR_NIL(dictionary[@"browsing"], NSNumber);
+    _liveReloadEnabled = CLASS_OR_NIL(dictionary[@"liveReload"], NSNumber);
+    _shouldDelete = [CLASS_OR_NIL(dictionary[@"delete"], NSNumber) boolValue];
+    
+    NSString *auth = CLASS_OR_NIL(dictionary[@"auth"], NSString);
+    NSString *username = nil, *password = nil;
+    
+    if (_source.length == 0) {
+        error = _EMManifestError(@"Expected a source for each URL");
+    } else if ((_sourceType = EMSourceTypeGuess(_source)) == EMSourceTypeUnknown) {
+        error = _EMManifestError([NSString stringWithFormat:@"Could not determine source type of \"%@\"", _source]);
+    } else if (_sourceType != EMSourceTypeID && (_sourceURL = EMSourceURLFromString(_source, _sourceType)) == nil) {
+        error = _EMManifestError([NSString stringWithFormat:@"\"%@\" is not a valid source", _source]);
+    } else if (_sourceType == EMSourceTypeDirectory && !_shouldDelete && !_EMManifestDirectoryExists(_sourceURL)) {
+        error = _EMManifestError([NSString stringWithFormat:@"\"%@\" does not exist (or is not a directory)", _source]);
+    } else if (auth != nil && !EMUsernamePasswordBlock(&username, &password)(auth)) {
+        error = _EMManifestError([NSString stringWithFormat:@"Expected \"username:password\" for the auth of \"%@\"", _source]);
+    }
+    
+    // Values of the wrong type are errors (rather than being ignored)
+    NSDictionary *classes = @{@"source": [NSObject class], @"name": [NSString class], @"auth": [NSString class], @"host": [NSString class],
+                              @"index": [NSString class], @"browsing": [NSNumber class], @"liveReload": [NSNumber class], @"delete": [NSNumber class]};
+    
+    for (NSString *key in (error == nil ? dictionary : @{})) {
+        if (classes[key] == nil) {
+            error = _EMManifestError([NSString stringWithFormat:@"Unknown key \"%@\" for \"%@\"", key, _source]);
+        } else if (![dictionary[key] isKindOfClass:classes[key]]) {
+            error = _EMManifestError([NSString stringWithFormat:@"Unexpected value for \"%@\" of \"%@\"", key, _source]);
+        }
+        
+        if (error != nil) {
+            break;
+        }
+    }
+    
+    if (error != nil) {
+        if (outError != NULL) {
+            (*outError) = error;
+        }
+        
+        return nil;
+    }
+    
+    _authUsername = username;
+    _authPassword = password;
+    
+    switch (_sourceType) {
+        case EMSourceTypeID:
+            _key = [@"id:" stringByAppendingString:_source.uppercaseString];
+            break;
+        case EMSourceTypeDirectory:
+            _key = [@"directory:" stringByAppendingString:_EMManifestPathOfURL(_sourceURL)];
+            break;
+        default:
+            _key = [NSString stringWithFormat:@"port:%@", _sourceURL.port ?: ([_sourceURL.scheme isEqualToString:@"https"] ? @443 : @80)];
+            break;
+    }
+    
+    return self;
+}
+
+- (BOOL)matchesSnapshot:(EMTunnelSnapshot *)snapshot {
+    if (_sourceType == EMSourceTypeID) {
+        return snapshot.id != nil && [snapshot.id caseInsensitiveCompare:_source] == NSOrderedSame;
+    }
+    
+    return [_key isEqualToString:_EMManifestKeyForSnapshot(snapshot) ?: @""];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %@>", self.className, _source];
+}
+
+@end
+
+
+#pragma mark -
+
+@implementation EMManifestChange
+
+- (instancetype)_initWithItem:(EMManifestItem *)item snapshot:(EMTunnelSnapshot *)snapshot {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _item = item;
+    _snapshot = snapshot;
+    _tunnelIdentifier = snapshot.id;
+    _values = @{};
+    
+    if (item == nil || item.shouldDelete) {
+        _type = snapshot ? EMManifestChangeTypeDelete : EMManifestChangeTypeNone;
+    } else if (snapshot == nil && item.sourceType == EMSourceTypeID) {
+        _type = EMManifestChangeTypeInvalid;
+        _error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileNoSuchFileError userInfo:@{NSLocalizedDescriptionKey: @"URL does not exist"}];
+    } else {
+        _values = [self _valuesForItem:item snapshot:snapshot];
+        
+        // Credentials can't be read, so password protected URLs are left as they are
+        _needsAuth = item.authUsername != nil && !snapshot.isAuthEnabled;
+        
+        if (snapshot == nil) {
+            _type = EMManifestChangeTypeCreate;
+        } else {
+            _type = (_values.count > 0 || _needsAuth) ? EMManifestChangeTypeUpdate : EMManifestChangeTypeNone;
+        }
+    }
+    
+    return self;
+}
+
+- (NSDictionary *)_valuesForItem:(EMManifestItem *)item snapshot:(EMTunnelSnapshot *)snapshot {
+    NSMutableDictionary *values = [NSMutableDictionary dictionary];
+    EmporterTunnelKind kind = snapshot ? snapshot.kind : (item.sourceType == EMSourceTypeDirectory ? EmporterTunnelKindDirectory : EmporterTunnelKindProxy);
+    
+    // Names of new tunnels are set when they're created
+    if (snapshot != nil && item.name != nil && ![item.name isEqualToString:snapshot.name ?: @""]) {
+        values[@"name"] = item.name;
+    }
+    
+    switch (kind) {
+        case EmporterTunnelKindProxy:
+            if (item.proxyHost.length > 0) {
+                if (snapshot == nil || !snapshot.shouldRewriteHostHeader || ![item.proxyHost isEqualToString:snapshot.proxyHostHeader ?: @""]) {
+                    values[@"proxyHostHeader"] = item.proxyHost;
+                    values[@"shouldRewriteHostHeader"] = @YES;
+                }
+            } else if (item.proxyHost != nil && (snapshot == nil || snapshot.shouldRewriteHostHeader)) {
+                values[@"shouldRewriteHostHeader"] = @NO;
+            }
+            
+            break;
+        case EmporterTunnelKindDirectory:
+            if (item.directoryIndexFile != nil && ![item.directoryIndexFile isEqualToString:snapshot.directoryIndexFile ?: @""]) {
+                values[@"directoryIndexFile"] = item.directoryIndexFile;
+            }
+            
+            if (item.browsingEnabled != nil && (snapshot == nil || item.browsingEnabled.boolValue != snapshot.isBrowsingEnabled)) {
+                values[@"isBrowsingEnabled"] = @(item.browsingEnabled.boolValue);
+            }
+            
+            if (item.liveReloadEnabled != nil && (snapshot == nil || item.liveReloadEnabled.boolValue != snapshot.isLiveReloadEnabled)) {
+                values[@"isLiveReloadEnabled"] = @(item.liveReloadEnabled.boolValue);
+            }
+            
+            break;
+        default:
+            break;
+    }
+    
+    return values;
+}
+
+- (void)_applyWithBackend:(id<EMManifestBackend>)backend {
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    NSError *error = nil;
+    
+    switch (_type) {
+        case EMManifestChangeTypeCreate: {
+            NSString *name = _item.name;
+            if (name == nil && _item.sourceType == EMSourceTypeDirectory) {
+                name = [_item.sourceURL.lastPathComponent lowercaseString];
+            }
+            
+            _tunnelIdentifier = [backend createTunnelWithURL:_item.sourceURL name:name error:&error];
+            if (_tunnelIdentifier == nil) {
+                break;
+            }
+        }
+            // Fall through to configure the new tunnel
+        case EMManifestChangeTypeUpdate:
+            if (_values.count > 0 && ![backend setValues:_values ofTunnelWithIdentifier:_tunnelIdentifier error:&error]) {
+                break;
+            }
+            
+            if (_needsAuth) {
+                [backend passwordProtectTunnelWithIdentifier:_tunnelIdentifier username:_item.authUsername password:_item.authPassword error:&error];
+            }
+            
+            break;
+        case EMManifestChangeTypeDelete:
+            [backend deleteTunnelWithIdentifier:_tunnelIdentifier error:&error];
+            break;
+        default:
+            break;
+    }
+    
+    _error = _error ?: error;
+    _duration = (NSTimeInterval)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / NSEC_PER_SEC;
+}
+
+@end
+
+
+#pragma mark -
+
+void EMManifestApplyChanges(NSArray<EMManifestChange*> *changes, id<EMManifestBackend> backend, void(^handler)(EMManifestChange *change)) {
+    for (EMManifestChange *change in changes) {
+        @autoreleasepool {
+            if (change.type != EMManifestChangeTypeNone && change.type != EMManifestChangeTypeInvalid) {
+                [change _applyWithBackend:backend];
+            }
+            
+            if (handler != nil) {
+                handler(change);
+            }
+        }
+    }
+}
+
+
+#pragma mark -
+
+@implementation Emporter (EMManifestBackend)
+
+- (EmporterTunnel *)_manifestTunnelWithIdentifier:(NSString *)identifier error:(NSError **)outError {
+    EmporterTunnel *tunnel = [self tunnelWithIdentifier:identifier error:outError];
+    tunnel = tunnel ? [tunnel get] : nil;
+    
+    if (tunnel == nil && outError != NULL && (*outError) == nil) {
+        (*outError) = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileNoSuchFileError userInfo:@{NSLocalizedDescriptionKey: @"URL does not exist"}];
+    }
+    
+    return tunnel;
+}
+
+- (BOOL)_manifestCanUseAPIVersion02 {
+    static EmporterVersion version;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        [Emporter getVersion:&version];
+    });
+    
+    return IsEmporterAPIAvailable(version, 0, 2);
+}
+
+- (NSString *)createTunnelWithURL:(NSURL *)url name:(NSString *)name error:(NSError **)outError {
+    EmporterTunnel *tunnel = [self createTunnelWithURL:url properties:(name ? @{@"name": name} : @{}) error:outError];
+    return tunnel.id;
+}
+
+- (BOOL)setValues:(NSDictionary<NSString *,id> *)values ofTunnelWithIdentifier:(NSString *)identifier error:(NSError **)outError {
+    EmporterTunnel *tunnel = [self _manifestTunnelWithIdentifier:identifier error:outError];
+    if (tunnel == nil) {
+        return NO;
+    }
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+        // API version 0.1 (Emporter 0.3.5) shipped with a bad AppleEvent
+        // descriptor which incorrectly maps live reload to directory browsing
+        if ([key isEqualToString:@"isLiveReloadEnabled"] && ![self _manifestCanUseAPIVersion02]) {
+            return;
+        }
+        
+        [tunnel setValue:value forKey:key];
+    }];
+    
+    return YES;
+}
+
+- (BOOL)passwordProtectTunnelWithIdentifier:(NSString *)identifier username:(NSString *)username password:(NSString *)password error:(NSError **)outError {
+    EmporterTunnel *tunnel = [self _manifestTunnelWithIdentifier:identifier error:outError];
+    NSString *reason = nil;
+    
+    if (tunnel == nil) {
+        return NO;
+    } else if (![self _manifestCanUseAPIVersion02]) {
+        reason = @"Could not password protect URL because your version of Emporter is out of date";
+    } else if (![tunnel passwordProtectWithUsername:username password:password]) {
+        reason = @"Could not password protect URL";
+    } else {
+        return YES;
+    }
+    
+    if (outError != NULL) {
+        (*outError) = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFeatureUnsupportedError userInfo:@{NSLocalizedDescriptionKey: reason}];
+    }
+    
+    return NO;
+}
+
+- (BOOL)deleteTunnelWithIdentifier:(NSString *)identifier error:(NSError **)outError {
+    EmporterTunnel *tunnel = [self _manifestTunnelWithIdentifier:identifier error:outError];
+    if (tunnel == nil) {
+        return NO;
+    }
+    
+    [tunnel delete];
+    return YES;
+}
+
+@end
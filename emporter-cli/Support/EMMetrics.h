@@ -0,0 +1,130 @@
+//
+//  EMMetrics.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "Emporter.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! A monotonically increasing value. Counters can be incremented from any thread without locking. */
+@interface EMMetricsCounter : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (void)increment;
+- (void)incrementBy:(uint64_t)amount;
+
+@property(nonatomic,readonly) uint64_t value;
+
+@end
+
+
+/*! A distribution of observed values in fixed buckets. Values can be observed from any thread without locking. */
+@interface EMMetricsHistogram : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (void)observe:(double)value;
+
+/*! The upper bounds of each bucket (in ascending order, excluding +Inf) */
+@property(nonatomic,readonly) NSArray<NSNumber*> *buckets;
+
+@property(nonatomic,readonly) uint64_t count;
+@property(nonatomic,readonly) double sum;
+
+@end
+
+
+/*!
+ A registry of metrics which can be exported in the Prometheus text format.
+ 
+ Metrics are created up front and retained by the code recording them, so that recording a value is a single atomic operation.
+ Exports can either be written to a file (which is replaced atomically) on an interval or served to clients of a Unix socket.
+ */
+@interface EMMetrics : NSObject
+
+/*! Default histogram buckets, in seconds, suitable for latencies ranging from 1ms to a few minutes */
+@property(class,nonatomic,readonly) NSArray<NSNumber*> *defaultBuckets;
+
+/*!
+ Returns the counter with the given name and labels, creating it if needed.
+ \param name    The name of the metric (i.e. "emporter_notifications_total")
+ \param help    A description of the metric
+ \param labels  Optional labels which identify the series
+ */
+- (EMMetricsCounter *)counterWithName:(NSString *)name help:(NSString *)help labels:(nullable NSDictionary<NSString*,NSString*> *)labels;
+
+/*!
+ Returns the histogram with the given name and labels, creating it if needed.
+ \param name    The name of the metric (i.e. "emporter_frame_render_seconds")
+ \param help    A description of the metric
+ \param labels  Optional labels which identify the series
+ \param buckets The upper bounds of each bucket, or nil to use \c defaultBuckets
+ */
+- (EMMetricsHistogram *)histogramWithName:(NSString *)name help:(NSString *)help labels:(nullable NSDictionary<NSString*,NSString*> *)labels buckets:(nullable NSArray<NSNumber*> *)buckets;
+
+/*! Returns every metric in the Prometheus text format */
+- (NSString *)prometheusText;
+
+/*! Atomically replace the file at the given path with the Prometheus text of every metric */
+- (BOOL)writeToFile:(NSString *)path error:(NSError **__nullable)outError;
+
+/*!
+ Write metrics to a file now, and then on an interval until stopped.
+ \param path        The path to write to
+ \param interval    The number of seconds between writes
+ \param outError    An optional pointer to an error describing why the file couldn't be written
+ */
+- (BOOL)startWritingToFile:(NSString *)path interval:(NSTimeInterval)interval error:(NSError **__nullable)outError;
+
+/*!
+ Serve metrics over a Unix socket. Each client which connects is sent the Prometheus text of every metric before being disconnected.
+ \param path        The path of the socket, which is replaced if it already exists
+ \param outError    An optional pointer to an error describing why the socket couldn't be created
+ */
+- (BOOL)startListeningOnSocketPath:(NSString *)path error:(NSError **__nullable)outError;
+
+/*! Stop exporting metrics, writing to the file (if any) one last time */
+- (void)stop;
+
+@end
+
+
+/*! Records metrics describing an Emporter session (i.e. from the observers of the run command). Methods must be invoked from the main thread. */
+@interface EMSessionMetrics : NSObject
+
+- (instancetype)initWithMetrics:(EMMetrics *)metrics NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property(nonatomic,readonly) EMMetrics *metrics;
+
+/*! Returns a counter for notifications of the given name, so that observers can count notifications without a lookup */
+- (EMMetricsCounter *)counterForNotification:(NSNotificationName)name;
+
+/*! Record the current state of a tunnel, measuring the time it took to connect */
+- (void)recordState:(EmporterTunnelState)state ofTunnelWithIdentifier:(NSString *)tunnelId;
+
+/*! Stop tracking a tunnel which was removed */
+- (void)removeTunnelWithIdentifier:(NSString *)tunnelId;
+
+/*! Stop tracking every tunnel (i.e. after Emporter was relaunched) */
+- (void)removeAllTunnels;
+
+/*! Record the state of the service, measuring how long conflicts last */
+- (void)recordServiceState:(EmporterServiceState)state;
+
+/*! Record that Emporter was relaunched (or that it could not be) */
+- (void)recordRelaunch:(BOOL)success;
+
+/*! Record the time it took to refresh data and render a frame, and the number of events which were coalesced into it */
+- (void)recordFrameWithRefreshDuration:(NSTimeInterval)refreshDuration renderDuration:(NSTimeInterval)renderDuration eventCount:(NSUInteger)eventCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
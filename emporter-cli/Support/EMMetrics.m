@@ -0,0 +1,555 @@
+//
+//  EMMetrics.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#import "EMMetrics.h"
+#import "EMUnixSocket.h"
+
+
+static NSString *_EMMetricsEscapeLabelValue(NSString *value) {
+    value = [value stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"];
+    value = [value stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+    return [value stringByReplacingOccurrencesOfString:@"\n" withString:@"\\n"];
+}
+
+/*! Format labels as {a="1",b="2"} (sorted by name), optionally appending an extra label */
+static NSString *_EMMetricsFormatLabels(NSDictionary<NSString*,NSString*> *labels, NSString *extraName, NSString *extraValue) {
+    NSMutableArray *pairs = [NSMutableArray arrayWithCapacity:labels.count + 1];
+    
+    for (NSString *name in [labels.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [pairs addObject:[NSString stringWithFormat:@"%@=\"%@\"", name, _EMMetricsEscapeLabelValue(labels[name])]];
+    }
+    
+    if (extraName != nil) {
+        [pairs addObject:[NSString stringWithFormat:@"%@=\"%@\"", extraName, extraValue]];
+    }
+    
+    return pairs.count > 0 ? [NSString stringWithFormat:@"{%@}", [pairs componentsJoinedByString:@","]] : @"";
+}
+
+static NSString *_EMMetricsFormatValue(double value) {
+    if (isinf(value)) {
+        return value > 0 ? @"+Inf" : @"-Inf";
+    }
+    
+    return [NSString stringWithFormat:@"%.15g", value];
+}
+
+
+#pragma mark -
+
+@interface EMMetricsCounter()
+- (instancetype)_init;
+@end
+
+@implementation EMMetricsCounter {
+    _Atomic uint64_t _value;
+}
+
+- (instancetype)_init {
+    return [super init];
+}
+
+- (void)increment {
+    atomic_fetch_add_explicit(&_value, 1, memory_order_relaxed);
+}
+
+- (void)incrementBy:(uint64_t)amount {
+    atomic_fetch_add_explicit(&_value, amount, memory_order_relaxed);
+}
+
+- (uint64_t)value {
+    return atomic_load_explicit(&_value, memory_order_relaxed);
+}
+
+@end
+
+
+#pragma mark -
+
+@interface EMMetricsHistogram()
+- (instancetype)_initWithBuckets:(NSArray<NSNumber*> *)buckets;
+- (void)_getBucketCounts:(uint64_t *)counts count:(uint64_t *)outCount sum:(double *)outSum;
+@end
+
+@implementation EMMetricsHistogram {
+    double *_bounds;
+    NSUInteger _numberOfBounds;
+    
+    // Counts are per bucket (the last bucket being +Inf) and are only accumulated when exported
+    _Atomic uint64_t *_counts;
+    _Atomic uint64_t _count;
+    _Atomic double _sum;
+}
+
+- (instancetype)_initWithBuckets:(NSArray<NSNumber *> *)buckets {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _buckets = [buckets sortedArrayUsingSelector:@selector(compare:)];
+    _numberOfBounds = _buckets.count;
+    _bounds = malloc(sizeof(double) * MAX(_numberOfBounds, 1));
+    _counts = calloc(_numberOfBounds + 1, sizeof(_Atomic uint64_t));
+    
+    for (NSUInteger i = 0; i < _numberOfBounds; i++) {
+        _bounds[i] = _buckets[i].doubleValue;
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_bounds);
+    free((void *)_counts);
+}
+
+- (void)observe:(double)value {
+    // Binary search for the first bucket whose upper bound contains the value
+    NSUInteger low = 0, high = _numberOfBounds;
+    
+    while (low < high) {
+        NSUInteger mid = (low + high) / 2;
+        if (value <= _bounds[mid]) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    
+    atomic_fetch_add_explicit(&_counts[low], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed);
+    
+    double sum = atomic_load_explicit(&_sum, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&_sum, &sum, sum + value, memory_order_relaxed, memory_order_relaxed)) {
+        continue;
+    }
+}
+
+- (uint64_t)count {
+    return atomic_load_explicit(&_count, memory_order_relaxed);
+}
+
+- (double)sum {
+    return atomic_load_explicit(&_sum, memory_order_relaxed);
+}
+
+- (void)_getBucketCounts:(uint64_t *)counts count:(uint64_t *)outCount sum:(double *)outSum {
+    uint64_t total = 0;
+    
+    for (NSUInteger i = 0; i <= _numberOfBounds; i++) {
+        total += atomic_load_explicit(&_counts[i], memory_order_relaxed);
+        counts[i] = total;
+    }
+    
+    // The total is derived from the buckets so that an export is consistent, even while values are being observed
+    (*outCount) = total;
+    (*outSum) = self.sum;
+}
+
+@end
+
+
+#pragma mark -
+
+/*! Metrics which share a name (and differ by labels) */
+@interface _EMMetricsFamily : NSObject
+@property(nonatomic) NSString *name;
+@property(nonatomic) NSString *help;
+@property(nonatomic) NSString *type;
+@property(nonatomic) NSMutableDictionary<NSDictionary*,id> *series;
+@end
+
+@implementation _EMMetricsFamily
+@end
+
+
+@implementation EMMetrics {
+    NSLock *_lock;
+    NSMutableDictionary<NSString*,_EMMetricsFamily*> *_families;
+    NSMutableArray<NSString*> *_familyNames;
+    
+    dispatch_queue_t _q;
+    dispatch_source_t _timer;
+    dispatch_source_t _listenSource;
+    NSString *_filePath;
+    NSString *_socketPath;
+}
+
++ (NSArray<NSNumber *> *)defaultBuckets {
+    return @[@0.001, @0.0025, @0.005, @0.01, @0.025, @0.05, @0.1, @0.25, @0.5, @1, @2.5, @5, @10, @30, @60, @300];
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _lock = [[NSLock alloc] init];
+    _families = [NSMutableDictionary dictionary];
+    _familyNames = [NSMutableArray array];
+    _q = dispatch_queue_create("net.youngdynasty.emporter-cli.metrics", NULL);
+    
+    return self;
+}
+
+- (void)dealloc {
+    if (_timer != nil) {
+        dispatch_source_cancel(_timer);
+    }
+    
+    if (_listenSource != nil) {
+        dispatch_source_cancel(_listenSource);
+        unlink(_socketPath.fileSystemRepresentation);
+    }
+}
+
+- (id)_metricWithName:(NSString *)name help:(NSString *)help type:(NSString *)type labels:(NSDictionary *)labels create:(id(^)(void))createBlock {
+    [_lock lock];
+    
+    _EMMetricsFamily *family = _families[name];
+    if (family == nil) {
+        family = [_EMMetricsFamily new];
+        family.name = name;
+        family.help = help;
+        family.type = type;
+        family.series = [NSMutableDictionary dictionary];
+        
+        _families[name] = family;
+        [_familyNames addObject:name];
+    }
+    
+    NSAssert([family.type isEqualToString:type], @"%@ is already registered as a %@", name, family.type);
+    
+    labels = [labels copy] ?: @{};
+    id metric = family.series[labels];
+    
+    if (metric == nil) {
+        metric = family.series[labels] = createBlock();
+    }
+    
+    [_lock unlock];
+    
+    return metric;
+}
+
+- (EMMetricsCounter *)counterWithName:(NSString *)name help:(NSString *)help labels:(NSDictionary<NSString *,NSString *> *)labels {
+    return [self _metricWithName:name help:help type:@"counter" labels:labels create:^id{
+        return [[EMMetricsCounter alloc] _init];
+    }];
+}
+
+- (EMMetricsHistogram *)histogramWithName:(NSString *)name help:(NSString *)help labels:(NSDictionary<NSString *,NSString *> *)labels buckets:(NSArray<NSNumber *> *)buckets {
+    return [self _metricWithName:name help:help type:@"histogram" labels:labels create:^id{
+        return [[EMMetricsHistogram alloc] _initWithBuckets:buckets ?: EMMetrics.defaultBuckets];
+    }];
+}
+
+#pragma mark - Exporting
+
+- (NSString *)prometheusText {
+    NSMutableString *text = [NSMutableString string];
+    
+    [_lock lock];
+    
+    for (NSString *name in _familyNames) {
+        _EMMetricsFamily *family = _families[name];
+        
+        [text appendFormat:@"# HELP %@ %@\n", name, [[family.help stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"] stringByReplacingOccurrencesOfString:@"\n" withString:@"\\n"]];
+        [text appendFormat:@"# TYPE %@ %@\n", name, family.type];
+        
+        NSArray *sortedLabels = [family.series.allKeys sortedArrayUsingComparator:^NSComparisonResult(NSDictionary *a, NSDictionary *b) {
+            return [_EMMetricsFormatLabels(a, nil, nil) compare:_EMMetricsFormatLabels(b, nil, nil)];
+        }];
+        
+        for (NSDictionary *labels in sortedLabels) {
+            id metric = family.series[labels];
+            
+            if ([metric isKindOfClass:[EMMetricsCounter class]]) {
+                [text appendFormat:@"%@%@ %llu\n", name, _EMMetricsFormatLabels(labels, nil, nil), [(EMMetricsCounter *)metric value]];
+                continue;
+            }
+            
+            EMMetricsHistogram *histogram = metric;
+            NSUInteger numberOfBuckets = histogram.buckets.count;
+            uint64_t *counts = malloc(sizeof(uint64_t) * (numberOfBuckets + 1));
+            uint64_t count = 0;
+            double sum = 0;
+            
+            [histogram _getBucketCounts:counts count:&count sum:&sum];
+            
+            for (NSUInteger i = 0; i <= numberOfBuckets; i++) {
+                NSString *bound = i < numberOfBuckets ? _EMMetricsFormatValue(histogram.buckets[i].doubleValue) : @"+Inf";
+                [text appendFormat:@"%@_bucket%@ %llu\n", name, _EMMetricsFormatLabels(labels, @"le", bound), counts[i]];
+            }
+            
+            [text appendFormat:@"%@_sum%@ %@\n", name, _EMMetricsFormatLabels(labels, nil, nil), _EMMetricsFormatValue(sum)];
+            [text appendFormat:@"%@_count%@ %llu\n", name, _EMMetricsFormatLabels(labels, nil, nil), count];
+            
+            free(counts);
+        }
+    }
+    
+    [_lock unlock];
+    
+    return text;
+}
+
+- (BOOL)writeToFile:(NSString *)path error:(NSError **)outError {
+    // Written to a temporary file and renamed, so that readers never see a partial export
+    return [[self.prometheusText dataUsingEncoding:NSUTF8StringEncoding] writeToFile:path options:NSDataWritingAtomic error:outError];
+}
+
+- (BOOL)startWritingToFile:(NSString *)path interval:(NSTimeInterval)interval error:(NSError **)outError {
+    if (![self writeToFile:path error:outError]) {
+        return NO;
+    }
+    
+    __weak EMMetrics *weakSelf = self;
+    uint64_t intervalNanoseconds = (uint64_t)(MAX(interval, 0.1) * NSEC_PER_SEC);
+    
+    dispatch_sync(_q, ^{
+        if (self->_timer != nil) {
+            dispatch_source_cancel(self->_timer);
+        }
+        
+        self->_filePath = [path copy];
+        self->_timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self->_q);
+        
+        dispatch_source_set_timer(self->_timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)intervalNanoseconds), intervalNanoseconds, intervalNanoseconds / 10);
+        dispatch_source_set_event_handler(self->_timer, ^{
+            [weakSelf writeToFile:path error:NULL];
+        });
+        dispatch_resume(self->_timer);
+    });
+    
+    return YES;
+}
+
+- (BOOL)startListeningOnSocketPath:(NSString *)path error:(NSError **)outError {
+    __weak EMMetrics *weakSelf = self;
+    
+    dispatch_source_t source = EMUnixSocketListen(path, _q, ^(int fd) {
+        NSData *data = [weakSelf.prometheusText dataUsingEncoding:NSUTF8StringEncoding];
+        const uint8_t *bytes = data.bytes;
+        size_t remaining = data.length;
+        
+        while (remaining > 0) {
+            ssize_t written = write(fd, bytes, remaining);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written <= 0) {
+                break;
+            }
+            
+            bytes += written;
+            remaining -= (size_t)written;
+        }
+    }, outError);
+    
+    if (source == nil) {
+        return NO;
+    }
+    
+    dispatch_sync(_q, ^{
+        self->_socketPath = [path copy];
+        self->_listenSource = source;
+    });
+    
+    return YES;
+}
+
+- (void)stop {
+    __block NSString *filePath = nil;
+    
+    dispatch_sync(_q, ^{
+        if (self->_timer != nil) {
+            dispatch_source_cancel(self->_timer);
+            self->_timer = nil;
+        }
+        
+        if (self->_listenSource != nil) {
+            dispatch_source_cancel(self->_listenSource);
+            self->_listenSource = nil;
+            unlink(self->_socketPath.fileSystemRepresentation);
+        }
+        
+        filePath = self->_filePath;
+        self->_filePath = nil;
+        self->_socketPath = nil;
+    });
+    
+    if (filePath != nil) {
+        [self writeToFile:filePath error:NULL];
+    }
+}
+
+@end
+
+
+#pragma mark -
+
+static uint64_t _EMSessionMetricsNow(void) {
+    // Includes time spent asleep, which is part of how long a session is spent connecting (or in conflict)
+    return clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+}
+
+@implementation EMSessionMetrics {
+    NSMutableDictionary<NSString*,EMMetricsCounter*> *_notificationCounters;
+    NSMutableDictionary<NSNumber*,EMMetricsCounter*> *_transitionCounters;
+    
+    // The state of each tunnel, and when it started connecting (or 0)
+    NSMutableDictionary<NSString*,NSNumber*> *_tunnelStates;
+    NSMutableDictionary<NSString*,NSNumber*> *_tunnelConnectStartTimes;
+    
+    EMMetricsHistogram *_connectDuration;
+    EMMetricsHistogram *_conflictDuration;
+    EMMetricsCounter *_relaunches;
+    EMMetricsCounter *_failedRelaunches;
+    EMMetricsHistogram *_refreshDuration;
+    EMMetricsHistogram *_renderDuration;
+    EMMetricsHistogram *_frameEvents;
+    
+    EmporterServiceState _serviceState;
+    uint64_t _serviceConflictStartTime;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithMetrics:(EMMetrics *)metrics {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _metrics = metrics;
+    _notificationCounters = [NSMutableDictionary dictionary];
+    _transitionCounters = [NSMutableDictionary dictionary];
+    _tunnelStates = [NSMutableDictionary dictionary];
+    _tunnelConnectStartTimes = [NSMutableDictionary dictionary];
+    _serviceState = EmporterServiceStateSuspended;
+    
+    _connectDuration = [metrics histogramWithName:@"emporter_tunnel_connect_seconds" help:@"Time taken for URLs to connect" labels:nil buckets:nil];
+    _conflictDuration = [metrics histogramWithName:@"emporter_service_conflict_seconds" help:@"Duration of service conflicts" labels:nil
+                                           buckets:@[@1, @10, @60, @300, @900, @3600, @14400, @86400]];
+    _relaunches = [metrics counterWithName:@"emporter_app_relaunches_total" help:@"Number of times Emporter was relaunched" labels:@{@"result": @"success"}];
+    _failedRelaunches = [metrics counterWithName:@"emporter_app_relaunches_total" help:@"Number of times Emporter was relaunched" labels:@{@"result": @"failure"}];
+    _refreshDuration = [metrics histogramWithName:@"emporter_frame_refresh_seconds" help:@"Time taken to refresh data for a frame" labels:nil buckets:nil];
+    _renderDuration = [metrics histogramWithName:@"emporter_frame_render_seconds" help:@"Time taken to render a frame" labels:nil buckets:nil];
+    _frameEvents = [metrics histogramWithName:@"emporter_frame_events" help:@"Number of events coalesced into each frame" labels:nil
+                                      buckets:@[@0, @1, @2, @5, @10, @25, @50, @100, @250, @1000]];
+    
+    return self;
+}
+
+- (EMMetricsCounter *)counterForNotification:(NSNotificationName)name {
+    EMMetricsCounter *counter = _notificationCounters[name];
+    
+    if (counter == nil) {
+        counter = _notificationCounters[name] = [_metrics counterWithName:@"emporter_notifications_total" help:@"Number of notifications received from Emporter" labels:@{@"type": name}];
+    }
+    
+    return counter;
+}
+
+- (EMMetricsCounter *)_counterForTransitionToState:(EmporterTunnelState)state {
+    EMMetricsCounter *counter = _transitionCounters[@(state)];
+    
+    if (counter == nil) {
+        NSString *stateName;
+        
+        switch (state) {
+            case EmporterTunnelStateInitializing:   stateName = @"initializing"; break;
+            case EmporterTunnelStateConnecting:     stateName = @"connecting"; break;
+            case EmporterTunnelStateConnected:      stateName = @"connected"; break;
+            case EmporterTunnelStateDisconnecting:  stateName = @"disconnecting"; break;
+            case EmporterTunnelStateDisconnected:   stateName = @"disconnected"; break;
+            case EmporterTunnelStateConflicted:     stateName = @"conflicted"; break;
+            default:                                stateName = @"unknown"; break;
+        }
+        
+        counter = _transitionCounters[@(state)] = [_metrics counterWithName:@"emporter_tunnel_transitions_total" help:@"Number of URL state transitions" labels:@{@"state": stateName}];
+    }
+    
+    return counter;
+}
+
+- (void)recordState:(EmporterTunnelState)state ofTunnelWithIdentifier:(NSString *)tunnelId {
+    NSNumber *previousState = _tunnelStates[tunnelId];
+    
+    if (previousState != nil && previousState.unsignedIntegerValue == (NSUInteger)state) {
+        return;
+    }
+    
+    _tunnelStates[tunnelId] = @(state);
+    [[self _counterForTransitionToState:state] increment];
+    
+    switch (state) {
+        case EmporterTunnelStateInitializing:
+        case EmporterTunnelStateConnecting:
+            if (_tunnelConnectStartTimes[tunnelId] == nil) {
+                _tunnelConnectStartTimes[tunnelId] = @(_EMSessionMetricsNow());
+            }
+            break;
+        case EmporterTunnelStateConnected: {
+            NSNumber *startTime = _tunnelConnectStartTimes[tunnelId];
+            if (startTime != nil) {
+                [_connectDuration observe:(double)(_EMSessionMetricsNow() - startTime.unsignedLongLongValue) / NSEC_PER_SEC];
+                [_tunnelConnectStartTimes removeObjectForKey:tunnelId];
+            }
+            break;
+        }
+        default:
+            [_tunnelConnectStartTimes removeObjectForKey:tunnelId];
+            break;
+    }
+}
+
+- (void)removeTunnelWithIdentifier:(NSString *)tunnelId {
+    [_tunnelStates removeObjectForKey:tunnelId];
+    [_tunnelConnectStartTimes removeObjectForKey:tunnelId];
+}
+
+- (void)removeAllTunnels {
+    [_tunnelStates removeAllObjects];
+    [_tunnelConnectStartTimes removeAllObjects];
+}
+
+- (void)recordServiceState:(EmporterServiceState)state {
+    if (state == _serviceState) {
+        return;
+    }
+    
+    if (state == EmporterServiceStateConflicted) {
+        _serviceConflictStartTime = _EMSessionMetricsNow();
+    } else if (_serviceState == EmporterServiceStateConflicted) {
+        [_conflictDuration observe:(double)(_EMSessionMetricsNow() - _serviceConflictStartTime) / NSEC_PER_SEC];
+    }
+    
+    _serviceState = state;
+}
+
+- (void)recordRelaunch:(BOOL)success {
+    [(success ? _relaunches : _failedRelaunches) increment];
+}
+
+- (void)recordFrameWithRefreshDuration:(NSTimeInterval)refreshDuration renderDuration:(NSTimeInterval)renderDuration eventCount:(NSUInteger)eventCount {
+    [_refreshDuration observe:refreshDuration];
+    [_renderDuration observe:renderDuration];
+    [_frameEvents observe:(double)eventCount];
+}
+
+@end
@@ -7,15 +7,49 @@
 //
 
 #import <Foundation/Foundation.h>
+#include <sys/param.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
-/*! A class used to traverse processes hierarchically. */
+/*! Information about a single process */
+typedef struct {
+    pid_t pid;
+    pid_t parentPid;
+    char name[MAXCOMLEN + 1];
+} EMProcessInfo;
+
+
+/*! A source of process information (i.e. the local process table, or a synthetic table used for testing) */
+@protocol EMProcessSource <NSObject>
+
+/*! Look up a single process, returning NO if it doesn't exist */
+- (BOOL)getProcessInfo:(EMProcessInfo *)outInfo forPid:(pid_t)pid;
+
+/*! Enumerate every process in the table */
+- (void)enumerateProcessesUsingBlock:(void(^)(const EMProcessInfo *info, BOOL *stop))block;
+
+@end
+
+
+/*! A process source backed by sysctl(3) */
+@interface EMSystemProcessSource : NSObject <EMProcessSource>
+@end
+
+
+/*!
+ A class used to traverse processes hierarchically.
+ 
+ Nodes are indexed by pid and built lazily: looking up a process (or its parents) only queries the processes which are needed,
+ whereas the entire process table is only read when children are requested.
+ */
 @interface EMProcessNode : NSObject
 
 /*! The current root node of the processes running locally. */
 + (instancetype)currentRootNode;
 
+/*! The root node of processes from the given source */
++ (instancetype)rootNodeWithSource:(id <EMProcessSource>)source;
+
 /*! The name of the process (may be truncated) */
 @property(nonatomic,readonly) NSString *__nullable name;
 
@@ -32,7 +66,7 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic,readonly,copy) NSArray *children;
 
 /*!
- Traverse children recursively to find a child for a pid
+ Find a descendant of the receiver for a pid. The process is looked up by pid and its ancestors are traversed until the receiver is found.
  \param pid The id for the process you wish to find
  \returns A child process or nil
  */
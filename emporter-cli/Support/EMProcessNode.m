@@ -13,18 +13,39 @@
 
 typedef struct kinfo_proc kinfo_proc;
 
+static int _EMProcessList(kinfo_proc **procList, size_t *procCount);
+
+
+/*! An index of process nodes keyed by pid, shared by every node within a tree */
+@interface _EMProcessTree : NSObject
+- (instancetype)initWithSource:(id <EMProcessSource>)source;
+@property(nonatomic,readonly) id <EMProcessSource> source;
+@property(nonatomic,weak) EMProcessNode *rootNode;
+- (EMProcessNode *)nodeWithPid:(pid_t)pid;
+- (NSArray<EMProcessNode*> *)childrenOfNode:(EMProcessNode *)node;
+@end
+
 
 @interface EMProcessNode()
-@property(nonatomic,weak,setter=_setParent:) EMProcessNode *parent;
+- (instancetype)_initWithInfo:(const EMProcessInfo *)info tree:(_EMProcessTree *)tree;
+- (instancetype)_initRootNodeWithTree:(_EMProcessTree *)tree;
+@property(nonatomic,readonly,weak) _EMProcessTree *_tree;
 @end
 
 
 @implementation EMProcessNode {
-    NSMutableArray *_children;
+    _EMProcessTree *_ownedTree;
+    __weak EMProcessNode *_parent;
+    BOOL _isParentResolved;
 }
+@synthesize _tree = _tree;
 
 + (instancetype)currentRootNode {
-    return [[self alloc] _initRootNode];
+    return [self rootNodeWithSource:[EMSystemProcessSource new]];
+}
+
++ (instancetype)rootNodeWithSource:(id<EMProcessSource>)source {
+    return [[self alloc] _initRootNodeWithTree:[[_EMProcessTree alloc] initWithSource:source]];
 }
 
 - (instancetype)init {
@@ -32,96 +53,202 @@ typedef struct kinfo_proc kinfo_proc;
     return nil;
 }
 
-- (instancetype)_initWithProccess:(kinfo_proc)proc {
+- (instancetype)_initWithInfo:(const EMProcessInfo *)info tree:(_EMProcessTree *)tree {
     self = [super init];
     if (self == nil)
         return nil;
 
-    _name = [NSString stringWithCString:proc.kp_proc.p_comm encoding:NSUTF8StringEncoding];
-    _pidValue = proc.kp_proc.p_pid;
-    _parentPidValue = proc.kp_eproc.e_ppid;
-    _children = [NSMutableArray array];
+    _name = [NSString stringWithCString:info->name encoding:NSUTF8StringEncoding];
+    _pidValue = info->pid;
+    _parentPidValue = info->parentPid;
+    _tree = tree;
     
     return self;
 }
 
-- (instancetype)_initRootNode {
-    kinfo_proc *procs = NULL;
-    size_t procsLength;
-    
-    if (_EMProcessList(&procs, &procsLength) != noErr) {
-        return nil;
-    }
-    
+- (instancetype)_initRootNodeWithTree:(_EMProcessTree *)tree {
     self = [super init];
     if (self == nil)
         return nil;
     
-    NSMutableDictionary *nodes = [NSMutableDictionary dictionary];
+    // The root node owns the tree, which owns every other node
+    _ownedTree = tree;
+    _tree = tree;
+    _isParentResolved = YES;
     
-    for (int i = 0; i < procsLength; i++) {
-        EMProcessNode *process = [[EMProcessNode alloc] _initWithProccess:procs[i]];
-        nodes[@(process.pidValue)] = process;
-    }
-
-    _children = [NSMutableArray array];
-    
-    for (NSNumber *pid in nodes) {
-        EMProcessNode *node = nodes[pid];
-        EMProcessNode *parent = node.pidValue == 0 && node.parentPidValue == 0 ? self : nodes[@(node.parentPidValue)];
-        
-        if (parent != nil) {
-            [parent _addChild:node];
-        }
-    }
-    
-    free(procs);
+    tree.rootNode = self;
     
     return self;
 }
 
 - (NSString *)description {
-    return [NSString stringWithFormat:@"%@ (%d > %d) - %ld children", _name, _parentPidValue, _pidValue, _children.count];
+    return [NSString stringWithFormat:@"%@ (%d > %d) - %ld children", _name, _parentPidValue, _pidValue, self.children.count];
 }
 
 - (NSString *)debugDescription {
-    return [NSString stringWithFormat:@"%@ (%d > %d) - %@", _name, _parentPidValue, _pidValue, [_children debugDescription]];
+    return [NSString stringWithFormat:@"%@ (%d > %d) - %@", _name, _parentPidValue, _pidValue, [self.children debugDescription]];
+}
+
+- (EMProcessNode *)parent {
+    if (!_isParentResolved) {
+        _isParentResolved = YES;
+        
+        // The kernel is its own parent, so it's attached to the root node
+        if (_pidValue == 0 && _parentPidValue == 0) {
+            _parent = _tree.rootNode;
+        } else {
+            _parent = [_tree nodeWithPid:_parentPidValue];
+        }
+    }
+    
+    return _parent;
 }
 
 - (NSArray *)children {
-    return [_children copy];
+    return [_tree childrenOfNode:self] ?: @[];
 }
 
-- (void)_addChild:(EMProcessNode *)child {
-    child.parent = self;
-    
-    NSUInteger idx = 0;
+- (EMProcessNode *)childWithPid:(pid_t)pid {
+    EMProcessNode *node = [_tree nodeWithPid:pid];
     
-    for (EMProcessNode *sibling in _children) {
-        if (sibling.pidValue > child.pidValue) {
+    // Only return the node if the receiver is one of its ancestors
+    for (EMProcessNode *ancestor = node.parent; ancestor != nil; ancestor = ancestor.parent) {
+        if (ancestor == self) {
+            return node;
+        } else if (ancestor == node) {
             break;
         }
-        idx++;
     }
     
-    [_children insertObject:child atIndex:idx];
+    return nil;
 }
 
-- (EMProcessNode *)childWithPid:(pid_t)pid {
-    for (EMProcessNode *child in self.children) {
-        if (child.pidValue == pid) {
-            return child;
-        } else {
-            EMProcessNode *distantChild = [child childWithPid:pid];
-            if (distantChild != nil) {
-                return distantChild;
-            }
+@end
+
+
+@implementation _EMProcessTree {
+    NSMutableDictionary<NSNumber*,EMProcessNode*> *_nodesByPid;
+    NSMutableSet<NSNumber*> *_missingPids;
+    NSDictionary<NSNumber*,NSArray<EMProcessNode*>*> *_childrenByPid;
+}
+
+- (instancetype)initWithSource:(id<EMProcessSource>)source {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _source = source;
+    _nodesByPid = [NSMutableDictionary dictionary];
+    _missingPids = [NSMutableSet set];
+    
+    return self;
+}
+
+- (EMProcessNode *)nodeWithPid:(pid_t)pid {
+    NSNumber *key = @(pid);
+    EMProcessNode *node = _nodesByPid[key];
+    
+    if (node != nil || _childrenByPid != nil || [_missingPids containsObject:key]) {
+        return node;
+    }
+    
+    // Look up the process on its own rather than loading the entire process table
+    EMProcessInfo info = {0};
+    
+    if ([_source getProcessInfo:&info forPid:pid]) {
+        node = [[EMProcessNode alloc] _initWithInfo:&info tree:self];
+        _nodesByPid[key] = node;
+    } else {
+        [_missingPids addObject:key];
+    }
+    
+    return node;
+}
+
+- (NSArray<EMProcessNode *> *)childrenOfNode:(EMProcessNode *)node {
+    if (_childrenByPid == nil) {
+        [self _loadAllProcesses];
+    }
+    
+    return node == _rootNode ? _childrenByPid[@(-1)] : _childrenByPid[@(node.pidValue)];
+}
+
+- (void)_loadAllProcesses {
+    NSMutableDictionary<NSNumber*,NSMutableArray<EMProcessNode*>*> *childrenByPid = [NSMutableDictionary dictionary];
+    
+    [_source enumerateProcessesUsingBlock:^(const EMProcessInfo *info, BOOL *stop) {
+        NSNumber *key = @(info->pid);
+        EMProcessNode *node = self->_nodesByPid[key];
+        
+        // Reuse nodes which have already been looked up
+        if (node == nil) {
+            node = [[EMProcessNode alloc] _initWithInfo:info tree:self];
+            self->_nodesByPid[key] = node;
         }
+        
+        // The kernel is attached to the root node (which doesn't have a pid of its own)
+        NSNumber *parentKey = (info->pid == 0 && info->parentPid == 0) ? @(-1) : @(info->parentPid);
+        NSMutableArray *children = childrenByPid[parentKey];
+        
+        if (children == nil) {
+            childrenByPid[parentKey] = children = [NSMutableArray array];
+        }
+        
+        [children addObject:node];
+    }];
+    
+    for (NSMutableArray<EMProcessNode*> *children in childrenByPid.objectEnumerator) {
+        [children sortUsingComparator:^NSComparisonResult(EMProcessNode *a, EMProcessNode *b) {
+            return a.pidValue < b.pidValue ? NSOrderedAscending : (a.pidValue > b.pidValue ? NSOrderedDescending : NSOrderedSame);
+        }];
     }
     
-    return nil;
+    [_missingPids removeAllObjects];
+    _childrenByPid = childrenByPid;
 }
 
+@end
+
+
+@implementation EMSystemProcessSource
+
+static void _EMProcessInfoFromProcess(const kinfo_proc *proc, EMProcessInfo *outInfo) {
+    outInfo->pid = proc->kp_proc.p_pid;
+    outInfo->parentPid = proc->kp_eproc.e_ppid;
+    strlcpy(outInfo->name, proc->kp_proc.p_comm, sizeof(outInfo->name));
+}
+
+- (BOOL)getProcessInfo:(EMProcessInfo *)outInfo forPid:(pid_t)pid {
+    int name[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, pid };
+    kinfo_proc proc;
+    size_t length = sizeof(proc);
+    
+    if (sysctl(name, sizeof(name) / sizeof(*name), &proc, &length, NULL, 0) != 0 || length == 0) {
+        return NO;
+    }
+    
+    _EMProcessInfoFromProcess(&proc, outInfo);
+    return YES;
+}
+
+- (void)enumerateProcessesUsingBlock:(void (^)(const EMProcessInfo *, BOOL *))block {
+    kinfo_proc *procs = NULL;
+    size_t procsLength;
+    
+    if (_EMProcessList(&procs, &procsLength) != noErr) {
+        return;
+    }
+    
+    BOOL stop = NO;
+    
+    for (size_t i = 0; i < procsLength && !stop; i++) {
+        EMProcessInfo info = {0};
+        _EMProcessInfoFromProcess(&procs[i], &info);
+        block(&info, &stop);
+    }
+    
+    free(procs);
+}
 
 // From https://developer.apple.com/library/archive/qa/qa2001/qa1123.html
 static int _EMProcessList(kinfo_proc **procList, size_t *procCount)
@@ -0,0 +1,101 @@
+//
+//  EMReactor.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! An event source added to a reactor */
+@interface EMReactorSource : NSObject
+
+/*! Stop delivering events from the source. Signals are restored to the action they had before the source was added. */
+- (void)cancel;
+
+/*! True if the source was cancelled (non-repeating timers are cancelled once they fire) */
+@property(nonatomic,readonly) BOOL isCancelled;
+
+@end
+
+
+/*!
+ A single-threaded event loop which multiplexes signals, timers, readable (or writable) file descriptors and wake ups.
+
+ Events are delivered by the kernel (kqueue, or epoll on Linux) to a single queue, so a reactor with nothing to do never wakes up.
+ On macOS the queue is scheduled within the current thread's run loop, so notifications and blocks on the main queue continue to be
+ delivered while the reactor is running.
+
+ Handlers are invoked on the thread which runs the reactor.
+ */
+@interface EMReactor : NSObject
+
+/*!
+ Handle a signal. The signal's default action is suppressed until the source is cancelled.
+
+ On Linux signals are delivered to the reactor while they're blocked, and signal masks are per-thread. Signals should be blocked by
+ every thread using \c EMReactorBlockSignals, otherwise a signal may be delivered to (and take its default action on) another thread.
+ \param signal  The signal to handle (i.e. SIGINT)
+ \param handler The block invoked each time the signal is received. Signals received in quick succession may be coalesced.
+ \returns A source which can be cancelled, or nil if the signal could not be handled.
+ */
+- (EMReactorSource *__nullable)addSignal:(int)signal handler:(dispatch_block_t)handler;
+
+/*!
+ Handle a file descriptor becoming readable. The handler is responsible for reading (and closing) the file descriptor.
+ \returns A source which can be cancelled, or nil if the file descriptor could not be watched.
+ */
+- (EMReactorSource *__nullable)addReadableFileDescriptor:(int)fileDescriptor handler:(dispatch_block_t)handler;
+
+/*!
+ Handle a file descriptor becoming writable (i.e. a non-blocking socket which has connected). The handler is invoked for as long as the
+ file descriptor is writable, so the source should be cancelled once it's no longer needed.
+
+ A file descriptor can only be watched for reading or for writing at a time, and its sources should be cancelled before it's closed.
+ \returns A source which can be cancelled, or nil if the file descriptor could not be watched.
+ */
+- (EMReactorSource *__nullable)addWritableFileDescriptor:(int)fileDescriptor handler:(dispatch_block_t)handler;
+
+/*!
+ Handle a timer, whose first event is delivered after the given interval.
+ \param interval    The interval of the timer, in seconds
+ \param repeats     True if the timer should repeat until it's cancelled
+ \param handler     The block invoked each time the timer fires
+ \returns A source which can be cancelled, or nil if the timer could not be created.
+ */
+- (EMReactorSource *__nullable)addTimerWithInterval:(NSTimeInterval)interval repeats:(BOOL)repeats handler:(dispatch_block_t)handler;
+
+/*! Wake the reactor so that its run block is invoked. Wake ups are coalesced. This method is safe to call from any thread. */
+- (void)wakeUp;
+
+/*!
+ Run the reactor until \c stop is called, invoking a block once when the reactor starts and after each batch of events is handled
+ (including wake ups). The reactor waits indefinitely between events.
+ */
+- (void)runWithBlock:(dispatch_block_t __nullable)block;
+
+/*! Stop the reactor after the current batch of events is handled. This method is safe to call from any thread. */
+- (void)stop;
+
+/*! True while \c runWithBlock: is running */
+@property(nonatomic,readonly) BOOL isRunning;
+
+/*! Cancel all sources. This method is invoked automatically when the reactor is deallocated. */
+- (void)invalidate;
+
+@end
+
+/*!
+ Block signals which are handled by reactors in the calling thread, and in every thread it creates afterwards. Call this from main
+ before any threads are created. Blocked signals are only ever handled by reactors, so their default action no longer applies.
+ 
+ This is only needed on Linux, and does nothing on macOS (where signals are delivered to reactors even when they're ignored).
+ \param signals    The signals to block (i.e. SIGINT)
+ \param count      The number of signals
+ */
+extern void EMReactorBlockSignals(const int *signals, size_t count);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,514 @@
+//
+//  EMReactor.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#else
+#include <sys/event.h>
+#endif
+
+#import "EMReactor.h"
+
+
+typedef NS_ENUM(uint8_t, _EMReactorEventKind) {
+    _EMReactorEventKindSignal,
+    _EMReactorEventKindRead,
+    _EMReactorEventKindWrite,
+    _EMReactorEventKindTimer,
+    _EMReactorEventKindWakeUp,
+};
+
+/*! A source as it's registered with the kernel queue */
+typedef struct {
+    _EMReactorEventKind kind;
+    /*! The signal or file descriptor being watched (unused by timers and wake ups) */
+    int ident;
+    /*! A file descriptor created for the source, which is closed when it's removed (epoll only) */
+    int fd;
+    uint64_t intervalNanoseconds;
+    BOOL repeats;
+    /*! The action of a signal before it was handled, which is restored when the source is removed */
+    struct sigaction previousAction;
+    /*! Whether or not the signal was already blocked when it was handled, in which case it stays blocked once it's removed (epoll only) */
+    BOOL wasSignalBlocked;
+    /*! The source to which events are delivered */
+    void *context;
+} _EMReactorRegistration;
+
+/*! The maximum number of events read from the kernel queue at once */
+#define _EMReactorEventBatchSize 32
+
+#pragma mark - Kernel Queues
+
+// Each backend implements the same functions, which return 0 or an errno value on failure
+
+#if defined(__linux__)
+
+static int _EMReactorQueueCreate(void) {
+    return epoll_create1(EPOLL_CLOEXEC);
+}
+
+static int _EMReactorQueueAdd(int queue, _EMReactorRegistration *registration) {
+    int fd = -1;
+    
+    switch (registration->kind) {
+        case _EMReactorEventKindSignal: {
+            // Signals are only delivered to a signalfd while they're blocked (ignored signals are discarded). Other threads should
+            // already block the signal (see EMReactorBlockSignals), as the mask only applies to the current thread.
+            sigset_t mask, previousMask;
+            sigemptyset(&mask);
+            sigaddset(&mask, registration->ident);
+            pthread_sigmask(SIG_BLOCK, &mask, &previousMask);
+            registration->wasSignalBlocked = sigismember(&previousMask, registration->ident) == 1;
+            
+            fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+            break;
+        }
+        case _EMReactorEventKindRead:
+        case _EMReactorEventKindWrite:
+            break;
+        case _EMReactorEventKindTimer: {
+            fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            
+            // A zero value would disarm the timer
+            uint64_t interval = MAX(registration->intervalNanoseconds, 1);
+            struct itimerspec spec = { .it_value = { .tv_sec = (time_t)(interval / NSEC_PER_SEC), .tv_nsec = (long)(interval % NSEC_PER_SEC) } };
+            
+            if (registration->repeats) {
+                spec.it_interval = spec.it_value;
+            }
+            
+            if (fd != -1 && timerfd_settime(fd, 0, &spec, NULL) != 0) {
+                int error = errno;
+                close(fd);
+                return error;
+            }
+            break;
+        }
+        case _EMReactorEventKindWakeUp:
+            fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            break;
+    }
+    
+    BOOL isFileDescriptor = registration->kind == _EMReactorEventKindRead || registration->kind == _EMReactorEventKindWrite;
+    
+    if (!isFileDescriptor && fd == -1) {
+        return errno;
+    }
+    
+    struct epoll_event event = { .events = registration->kind == _EMReactorEventKindWrite ? EPOLLOUT : EPOLLIN, .data.ptr = registration };
+    
+    if (epoll_ctl(queue, EPOLL_CTL_ADD, fd != -1 ? fd : registration->ident, &event) != 0) {
+        int error = errno;
+        
+        if (fd != -1) {
+            close(fd);
+        }
+        
+        return error;
+    }
+    
+    registration->fd = fd;
+    return 0;
+}
+
+static void _EMReactorQueueRemove(int queue, _EMReactorRegistration *registration) {
+    epoll_ctl(queue, EPOLL_CTL_DEL, registration->fd != -1 ? registration->fd : registration->ident, NULL);
+    
+    if (registration->fd != -1) {
+        close(registration->fd);
+        registration->fd = -1;
+    }
+    
+    if (registration->kind == _EMReactorEventKindSignal && !registration->wasSignalBlocked) {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, registration->ident);
+        pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    }
+}
+
+static void _EMReactorQueueTrigger(int queue, _EMReactorRegistration *registration) {
+    uint64_t value = 1;
+    (void)write(registration->fd, &value, sizeof(value));
+}
+
+static int _EMReactorQueueWait(int queue, int timeoutMilliseconds, _EMReactorRegistration **outRegistrations) {
+    struct epoll_event events[_EMReactorEventBatchSize];
+    int count = epoll_wait(queue, events, _EMReactorEventBatchSize, timeoutMilliseconds);
+    
+    for (int i = 0; i < count; i++) {
+        _EMReactorRegistration *registration = events[i].data.ptr;
+        
+        // Consume the signal, expiration or wake up so that the descriptor is no longer readable
+        if (registration->fd != -1) {
+            char buffer[sizeof(struct signalfd_siginfo)];
+            while (read(registration->fd, buffer, sizeof(buffer)) > 0);
+        }
+        
+        outRegistrations[i] = registration;
+    }
+    
+    return MAX(count, 0);
+}
+
+#else
+
+static int _EMReactorQueueCreate(void) {
+    return kqueue();
+}
+
+static struct kevent _EMReactorQueueEvent(_EMReactorRegistration *registration, uint16_t flags) {
+    struct kevent event;
+    
+    switch (registration->kind) {
+        case _EMReactorEventKindSignal:
+            EV_SET(&event, registration->ident, EVFILT_SIGNAL, flags, 0, 0, registration);
+            break;
+        case _EMReactorEventKindRead:
+            EV_SET(&event, registration->ident, EVFILT_READ, flags, 0, 0, registration);
+            break;
+        case _EMReactorEventKindWrite:
+            EV_SET(&event, registration->ident, EVFILT_WRITE, flags, 0, 0, registration);
+            break;
+        case _EMReactorEventKindTimer:
+            EV_SET(&event, (uintptr_t)registration, EVFILT_TIMER, flags | (registration->repeats ? 0 : EV_ONESHOT), NOTE_NSECONDS, (intptr_t)registration->intervalNanoseconds, registration);
+            break;
+        case _EMReactorEventKindWakeUp:
+            EV_SET(&event, (uintptr_t)registration, EVFILT_USER, flags | EV_CLEAR, 0, 0, registration);
+            break;
+    }
+    
+    return event;
+}
+
+static int _EMReactorQueueAdd(int queue, _EMReactorRegistration *registration) {
+    // Signals are delivered to kqueue even when they're ignored, which is how their default action is suppressed
+    if (registration->kind == _EMReactorEventKindSignal) {
+        struct sigaction action = { 0 };
+        action.sa_handler = SIG_IGN;
+        sigaction(registration->ident, &action, &registration->previousAction);
+    }
+    
+    struct kevent event = _EMReactorQueueEvent(registration, EV_ADD);
+    
+    if (kevent(queue, &event, 1, NULL, 0, NULL) != 0) {
+        int error = errno;
+        
+        if (registration->kind == _EMReactorEventKindSignal) {
+            sigaction(registration->ident, &registration->previousAction, NULL);
+        }
+        
+        return error;
+    }
+    
+    return 0;
+}
+
+static void _EMReactorQueueRemove(int queue, _EMReactorRegistration *registration) {
+    // One-shot timers which have fired are already removed
+    struct kevent event = _EMReactorQueueEvent(registration, EV_DELETE);
+    kevent(queue, &event, 1, NULL, 0, NULL);
+    
+    if (registration->kind == _EMReactorEventKindSignal) {
+        sigaction(registration->ident, &registration->previousAction, NULL);
+    }
+}
+
+static void _EMReactorQueueTrigger(int queue, _EMReactorRegistration *registration) {
+    struct kevent event;
+    EV_SET(&event, (uintptr_t)registration, EVFILT_USER, 0, NOTE_TRIGGER, 0, registration);
+    kevent(queue, &event, 1, NULL, 0, NULL);
+}
+
+static int _EMReactorQueueWait(int queue, int timeoutMilliseconds, _EMReactorRegistration **outRegistrations) {
+    struct kevent events[_EMReactorEventBatchSize];
+    struct timespec timeout = { .tv_sec = timeoutMilliseconds / 1000, .tv_nsec = (timeoutMilliseconds % 1000) * NSEC_PER_MSEC };
+    int count = kevent(queue, NULL, 0, events, _EMReactorEventBatchSize, timeoutMilliseconds < 0 ? NULL : &timeout);
+    
+    for (int i = 0; i < count; i++) {
+        outRegistrations[i] = events[i].udata;
+    }
+    
+    return MAX(count, 0);
+}
+
+#endif
+
+
+@interface EMReactorSource()
+- (instancetype)_initWithReactor:(EMReactor *)reactor kind:(_EMReactorEventKind)kind handler:(dispatch_block_t __nullable)handler;
+@property(nonatomic,readonly) _EMReactorRegistration *_registration;
+@property(nonatomic,readonly,nullable) dispatch_block_t _handler;
+@property(nonatomic,setter=_setIsCancelled:) BOOL isCancelled;
+@end
+
+
+@interface EMReactor()
+- (void)_removeSource:(EMReactorSource *)source;
+@end
+
+
+@implementation EMReactorSource {
+    _EMReactorRegistration _registration;
+    __weak EMReactor *_reactor;
+}
+@synthesize _handler = _handler;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)_initWithReactor:(EMReactor *)reactor kind:(_EMReactorEventKind)kind handler:(dispatch_block_t)handler {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _reactor = reactor;
+    _handler = [handler copy];
+    
+    _registration.kind = kind;
+    _registration.ident = -1;
+    _registration.fd = -1;
+    _registration.context = (__bridge void *)self;
+    
+    return self;
+}
+
+- (_EMReactorRegistration *)_registration {
+    return &_registration;
+}
+
+- (void)cancel {
+    EMReactor *reactor = _reactor;
+    
+    if (reactor != nil) {
+        [reactor _removeSource:self];
+    } else {
+        _isCancelled = YES;
+    }
+}
+
+@end
+
+
+#if defined(__APPLE__)
+static void _EMReactorFileDescriptorCallBack(CFFileDescriptorRef fileDescriptor, CFOptionFlags callBackTypes, void *info);
+#endif
+
+@implementation EMReactor {
+    int _queue;
+    NSMutableSet<EMReactorSource*> *_sources;
+    EMReactorSource *_wakeUpSource;
+    atomic_bool _isStopped;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _queue = _EMReactorQueueCreate();
+    if (_queue == -1) {
+        [NSException raise:NSInternalInconsistencyException format:@"Could not create event queue: %s", strerror(errno)];
+    }
+    
+    _sources = [NSMutableSet set];
+    _wakeUpSource = [self _addSource:[[EMReactorSource alloc] _initWithReactor:self kind:_EMReactorEventKindWakeUp handler:nil]];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self invalidate];
+    
+    if (_wakeUpSource != nil) {
+        _EMReactorQueueRemove(_queue, _wakeUpSource._registration);
+    }
+    
+    close(_queue);
+}
+
+#pragma mark - Sources
+
+- (EMReactorSource *)_addSource:(EMReactorSource *)source {
+    if (_EMReactorQueueAdd(_queue, source._registration) != 0) {
+        source.isCancelled = YES;
+        return nil;
+    }
+    
+    [_sources addObject:source];
+    return source;
+}
+
+- (void)_removeSource:(EMReactorSource *)source {
+    if (source.isCancelled || ![_sources containsObject:source]) {
+        return;
+    }
+    
+    _EMReactorQueueRemove(_queue, source._registration);
+    source.isCancelled = YES;
+    
+    [_sources removeObject:source];
+}
+
+- (EMReactorSource *)addSignal:(int)signal handler:(dispatch_block_t)handler {
+    EMReactorSource *source = [[EMReactorSource alloc] _initWithReactor:self kind:_EMReactorEventKindSignal handler:handler];
+    source._registration->ident = signal;
+    
+    return [self _addSource:source];
+}
+
+- (EMReactorSource *)addReadableFileDescriptor:(int)fileDescriptor handler:(dispatch_block_t)handler {
+    EMReactorSource *source = [[EMReactorSource alloc] _initWithReactor:self kind:_EMReactorEventKindRead handler:handler];
+    source._registration->ident = fileDescriptor;
+    
+    return [self _addSource:source];
+}
+
+- (EMReactorSource *)addWritableFileDescriptor:(int)fileDescriptor handler:(dispatch_block_t)handler {
+    EMReactorSource *source = [[EMReactorSource alloc] _initWithReactor:self kind:_EMReactorEventKindWrite handler:handler];
+    source._registration->ident = fileDescriptor;
+    
+    return [self _addSource:source];
+}
+
+- (EMReactorSource *)addTimerWithInterval:(NSTimeInterval)interval repeats:(BOOL)repeats handler:(dispatch_block_t)handler {
+    EMReactorSource *source = [[EMReactorSource alloc] _initWithReactor:self kind:_EMReactorEventKindTimer handler:handler];
+    source._registration->intervalNanoseconds = (uint64_t)(MAX(interval, 0) * NSEC_PER_SEC);
+    source._registration->repeats = repeats;
+    
+    return [self _addSource:source];
+}
+
+- (void)invalidate {
+    for (EMReactorSource *source in [_sources copy]) {
+        if (source != _wakeUpSource) {
+            [self _removeSource:source];
+        }
+    }
+}
+
+#pragma mark - Running
+
+- (void)wakeUp {
+    _EMReactorQueueTrigger(_queue, _wakeUpSource._registration);
+}
+
+- (void)stop {
+    atomic_store(&_isStopped, true);
+    [self wakeUp];
+}
+
+/*! Handle pending events, waiting for the first batch (-1 to wait indefinitely) */
+- (void)_handleEventsWithTimeout:(int)timeoutMilliseconds {
+    _EMReactorRegistration *registrations[_EMReactorEventBatchSize];
+    int count = 0;
+    
+    do {
+        count = _EMReactorQueueWait(_queue, timeoutMilliseconds, registrations);
+        timeoutMilliseconds = 0;
+        
+        // Retain every source before invoking handlers, which may cancel other sources within the batch
+        NSMutableArray<EMReactorSource*> *sources = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+        for (int i = 0; i < count; i++) {
+            [sources addObject:(__bridge EMReactorSource *)registrations[i]->context];
+        }
+        
+        for (EMReactorSource *source in sources) {
+            if (source.isCancelled) {
+                continue;
+            } else if (source._registration->kind == _EMReactorEventKindTimer && !source._registration->repeats) {
+                [self _removeSource:source];
+            }
+            
+            if (source._handler != nil) {
+                @autoreleasepool { source._handler(); }
+            }
+        }
+    } while (count == _EMReactorEventBatchSize);
+}
+
+- (void)runWithBlock:(dispatch_block_t)block {
+    atomic_store(&_isStopped, false);
+    _isRunning = YES;
+    
+#if defined(__APPLE__)
+    // Schedule the queue within the run loop, which returns each time a source (ours or otherwise) is handled
+    CFFileDescriptorContext context = { .info = (__bridge void *)self };
+    CFFileDescriptorRef fileDescriptor = CFFileDescriptorCreate(NULL, _queue, false, &_EMReactorFileDescriptorCallBack, &context);
+    CFRunLoopSourceRef runLoopSource = CFFileDescriptorCreateRunLoopSource(NULL, fileDescriptor, 0);
+    CFRunLoopRef runLoop = CFRunLoopGetCurrent();
+    
+    CFRunLoopAddSource(runLoop, runLoopSource, kCFRunLoopCommonModes);
+    CFFileDescriptorEnableCallBacks(fileDescriptor, kCFFileDescriptorReadCallBack);
+    
+    do {
+        if (block != nil) {
+            @autoreleasepool { block(); }
+        }
+    } while (!atomic_load(&_isStopped) && CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1.0e10, true) != kCFRunLoopRunStopped);
+    
+    CFRunLoopRemoveSource(runLoop, runLoopSource, kCFRunLoopCommonModes);
+    CFRelease(runLoopSource);
+    CFFileDescriptorInvalidate(fileDescriptor);
+    CFRelease(fileDescriptor);
+#else
+    while (true) {
+        if (block != nil) {
+            @autoreleasepool { block(); }
+        }
+        
+        if (atomic_load(&_isStopped)) {
+            break;
+        }
+        
+        [self _handleEventsWithTimeout:-1];
+    }
+#endif
+
+    _isRunning = NO;
+}
+
+#if defined(__APPLE__)
+static void _EMReactorFileDescriptorCallBack(CFFileDescriptorRef fileDescriptor, CFOptionFlags callBackTypes, void *info) {
+    [(__bridge EMReactor *)info _handleEventsWithTimeout:0];
+    
+    // Callbacks are disabled each time they're invoked
+    CFFileDescriptorEnableCallBacks(fileDescriptor, kCFFileDescriptorReadCallBack);
+}
+#endif
+
+@end
+
+
+void EMReactorBlockSignals(const int *signals, size_t count) {
+#if defined(__linux__)
+    sigset_t mask;
+    sigemptyset(&mask);
+    
+    for (size_t i = 0; i < count; i++) {
+        sigaddset(&mask, signals[i]);
+    }
+    
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+#endif
+}
@@ -0,0 +1,114 @@
+//
+//  EMSessionRecording.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "Emporter.h"
+#import "EMTunnelSnapshot.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A source of Emporter's state and notifications used by the run command (i.e. Emporter, a recorder, or a recorded session).
+ Notifications are posted to the default notification center using the source as their object.
+ */
+@protocol EMSessionSource <EMTunnelSnapshotSource>
+
+@property(nonatomic,readonly) EmporterServiceState serviceState;
+@property(nonatomic,readonly,nullable) NSString *serviceConflictReason;
+@property(nonatomic,readonly) BOOL isRunning;
+
+- (void)launchInBackgroundWithCompletionHandler:(void(^)(NSError *__nullable error))completionHandler;
+
+@end
+
+
+@interface Emporter (EMSessionSource) <EMSessionSource>
+@end
+
+
+/*!
+ Records a session to a file by observing notifications from a source, along with every value read from it in response.
+ 
+ The recorder is itself a source, which reposts the notifications of the source it wraps. Each record is written as a line of JSON
+ with a timestamp (in microseconds) relative to the start of the recording.
+ */
+@interface EMSessionRecorder : NSObject <EMSessionSource>
+
+/*!
+ Start recording a session.
+ \param source      The source to record
+ \param path        The path of the recording, which is replaced if it already exists
+ \param outError    An optional pointer to an error describing why the recording couldn't be created
+ \returns A new recorder, or nil if the file could not be created.
+ */
++ (nullable instancetype)recorderWithSource:(id <EMSessionSource>)source path:(NSString *)path error:(NSError **__nullable)outError;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! The source being recorded */
+@property(nonatomic,readonly) id <EMSessionSource> source;
+
+/*! The number of notifications recorded */
+@property(nonatomic,readonly) NSUInteger numberOfEvents;
+
+/*! Stop recording and flush the recording to disk */
+- (void)close;
+
+@end
+
+
+/*!
+ Replays a recorded session without Emporter.
+ 
+ Values read in response to each notification are applied to a model of Emporter's state before the notification is posted, so reads
+ are answered from the model regardless of which values the observers of the replay read.
+ */
+@interface EMSessionReplay : NSObject <EMSessionSource>
+
+/*!
+ Load a recorded session. The state read before the first notification is applied immediately.
+ \param path        The path of the recording
+ \param outError    An optional pointer to an error describing why the recording couldn't be read
+ \returns A new replay, or nil if the recording is invalid.
+ */
++ (nullable instancetype)replayWithContentsOfFile:(NSString *)path error:(NSError **__nullable)outError;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! The number of notifications in the recording */
+@property(nonatomic,readonly) NSUInteger numberOfEvents;
+
+/*! The number of times the recording is replayed, starting from its initial state each time (defaults to 1) */
+@property(nonatomic) NSUInteger repeatCount;
+
+/*! The number of notifications posted so far, across repeats */
+@property(nonatomic,readonly) NSUInteger numberOfPostedEvents;
+
+/*!
+ Post recorded notifications on the main queue, starting now. Subsequent calls are ignored.
+ \param speed               A multiplier of the recorded speed, or 0 to replay notifications as fast as possible
+ \param completionHandler   The block to invoke on the main queue once every notification has been posted
+ */
+- (void)startWithSpeed:(double)speed completionHandler:(dispatch_block_t)completionHandler;
+
+/*! Set when observers output events as soon as notifications are posted (i.e. JSON events), so that latency is measured once each notification is delivered */
+@property(nonatomic) BOOL outputsSynchronously;
+
+/*! Signal that pending events have been output, measuring the latency since the first pending notification was posted */
+- (void)didOutputEvents;
+
+/*! The time between posting the first and last notification */
+@property(nonatomic,readonly) NSTimeInterval duration;
+
+/*! The latency between notifications and output at the given percentile (0-100), or 0 if there were no measurements */
+- (NSTimeInterval)latencyAtPercentile:(double)percentile;
+
+@end
+
+NS_ASSUME_NONNULL_END
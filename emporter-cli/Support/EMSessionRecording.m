@@ -0,0 +1,564 @@
+//
+//  EMSessionRecording.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#import "EMSessionRecording.h"
+
+
+/*! Notifications are recorded using short names to keep recordings compact */
+static NSDictionary<NSNotificationName,NSString*> *_EMSessionNotificationCodes(void) {
+    static NSDictionary *codes = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        codes = @{EmporterDidLaunchNotification: @"launch",
+                  EmporterDidTerminateNotification: @"terminate",
+                  EmporterServiceStateDidChangeNotification: @"service",
+                  EmporterDidAddTunnelNotification: @"add",
+                  EmporterDidRemoveTunnelNotification: @"remove",
+                  EmporterTunnelStateDidChangeNotification: @"state",
+                  EmporterTunnelConfigurationDidChangeNotification: @"config"};
+    });
+    return codes;
+}
+
+static uint64_t _EMSessionNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+/*! Snapshot values are plist types except for URLs, which are encoded as {"$url": "..."} */
+static NSDictionary *_EMSessionEncodeValues(NSDictionary<NSString*,id> *values) {
+    NSMutableDictionary *encodedValues = [NSMutableDictionary dictionaryWithCapacity:values.count];
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+        encodedValues[key] = [value isKindOfClass:[NSURL class]] ? @{@"$url": [(NSURL *)value absoluteString]} : value;
+    }];
+    
+    return encodedValues;
+}
+
+static NSDictionary *_EMSessionDecodeValues(NSDictionary<NSString*,id> *values) {
+    NSMutableDictionary *decodedValues = [NSMutableDictionary dictionaryWithCapacity:values.count];
+    
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+        if ([value isKindOfClass:[NSDictionary class]] && [value[@"$url"] isKindOfClass:[NSString class]]) {
+            value = [NSURL URLWithString:value[@"$url"]] ?: [NSNull null];
+        }
+        
+        decodedValues[key] = value;
+    }];
+    
+    return decodedValues;
+}
+
+static NSError *_EMSessionInvalidRecordingError(NSString *path, NSUInteger line) {
+    NSString *description = [NSString stringWithFormat:@"Invalid recording at line %lu.", line];
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{NSFilePathErrorKey: path, NSLocalizedDescriptionKey: description}];
+}
+
+
+@implementation EMSessionRecorder {
+    FILE *_file;
+    uint64_t _startTime;
+    NSMutableArray *_observers;
+}
+
++ (instancetype)recorderWithSource:(id<EMSessionSource>)source path:(NSString *)path error:(NSError **)outError {
+    FILE *file = fopen(path.fileSystemRepresentation, "w");
+    
+    if (file == NULL) {
+        if (outError != NULL) {
+            (*outError) = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: path}];
+        }
+        return nil;
+    }
+    
+    return [[EMSessionRecorder alloc] _initWithSource:source file:file];
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)_initWithSource:(id<EMSessionSource>)source file:(FILE *)file {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _source = source;
+    _file = file;
+    _startTime = _EMSessionNow();
+    _observers = [NSMutableArray array];
+    
+    [self _writeRecord:@{@"format": @"emporter-session", @"version": @1}];
+    
+    __weak EMSessionRecorder *weakSelf = self;
+    
+    [_EMSessionNotificationCodes() enumerateKeysAndObjectsUsingBlock:^(NSNotificationName name, NSString *code, BOOL *stop) {
+        [self->_observers addObject:[[NSNotificationCenter defaultCenter] addObserverForName:name object:source queue:nil usingBlock:^(NSNotification *note) {
+            [weakSelf _repostNotification:note code:code];
+        }]];
+    }];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self close];
+}
+
+- (void)close {
+    for (id observer in _observers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+    [_observers removeAllObjects];
+    
+    if (_file != NULL) {
+        fclose(_file);
+        _file = NULL;
+    }
+}
+
+- (void)_writeRecord:(NSDictionary *)record {
+    if (_file == NULL) {
+        return;
+    }
+    
+    NSMutableDictionary *timedRecord = [record mutableCopy];
+    timedRecord[@"t"] = @((_EMSessionNow() - _startTime) / NSEC_PER_USEC);
+    
+    NSData *data = [NSJSONSerialization dataWithJSONObject:timedRecord options:0 error:NULL];
+    if (data != nil) {
+        fwrite(data.bytes, 1, data.length, _file);
+        fputc('\n', _file);
+    }
+}
+
+- (void)_repostNotification:(NSNotification *)note code:(NSString *)code {
+    NSString *tunnelId = note.userInfo[EmporterTunnelIdentifierUserInfoKey];
+    
+    _numberOfEvents++;
+    [self _writeRecord:tunnelId != nil ? @{@"n": code, @"id": tunnelId} : @{@"n": code}];
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:note.name object:self userInfo:note.userInfo];
+}
+
+#pragma mark - EMSessionSource
+
+- (EmporterServiceState)serviceState {
+    EmporterServiceState state = _source.serviceState;
+    [self _writeRecord:@{@"service": @(state)}];
+    return state;
+}
+
+- (NSString *)serviceConflictReason {
+    NSString *reason = _source.serviceConflictReason;
+    [self _writeRecord:@{@"reason": reason ?: [NSNull null]}];
+    return reason;
+}
+
+- (BOOL)isRunning {
+    return _source.isRunning;
+}
+
+- (void)launchInBackgroundWithCompletionHandler:(void (^)(NSError *))completionHandler {
+    [_source launchInBackgroundWithCompletionHandler:completionHandler];
+}
+
+- (NSArray<EMTunnelSnapshot *> *)fetchTunnelSnapshots {
+    NSArray<EMTunnelSnapshot *> *snapshots = [_source fetchTunnelSnapshots];
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:snapshots.count];
+    
+    for (EMTunnelSnapshot *snapshot in snapshots) {
+        [values addObject:_EMSessionEncodeValues(snapshot.values)];
+    }
+    
+    [self _writeRecord:@{@"all": values}];
+    return snapshots;
+}
+
+- (EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier {
+    EMTunnelSnapshot *snapshot = [_source fetchTunnelSnapshotWithIdentifier:identifier];
+    [self _writeRecord:@{@"id": identifier, @"v": snapshot != nil ? _EMSessionEncodeValues(snapshot.values) : [NSNull null]}];
+    return snapshot;
+}
+
+- (NSDictionary<NSString *,id> *)fetchValuesForKeys:(NSArray<NSString *> *)keys ofTunnelWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = [_source fetchValuesForKeys:keys ofTunnelWithIdentifier:identifier];
+    [self _writeRecord:@{@"id": identifier, @"k": values != nil ? _EMSessionEncodeValues(values) : [NSNull null]}];
+    return values;
+}
+
+@end
+
+
+/*! A recorded notification, along with the records read in response to it */
+@interface _EMSessionReplayEvent : NSObject
+@property(nonatomic) uint64_t time;
+@property(nonatomic) NSNotificationName name;
+@property(nonatomic,nullable) NSDictionary *userInfo;
+@property(nonatomic) NSMutableArray<NSDictionary*> *records;
+@end
+
+@implementation _EMSessionReplayEvent
+@end
+
+
+/*! Latency buckets are a fraction of a power of two nanoseconds wide, with an error of at most ~9% */
+#define _EMSessionLatencyBucketsPerPowerOfTwo 8
+#define _EMSessionLatencyBucketCount (64 * _EMSessionLatencyBucketsPerPowerOfTwo)
+
+static NSUInteger _EMSessionLatencyBucket(uint64_t latency) {
+    return (NSUInteger)MIN(log2((double)MAX(latency, 1)) * _EMSessionLatencyBucketsPerPowerOfTwo, _EMSessionLatencyBucketCount - 1);
+}
+
+@implementation EMSessionReplay {
+    NSArray<_EMSessionReplayEvent*> *_events;
+    NSArray<NSDictionary*> *_initialRecords;
+    NSUInteger _eventIndex;
+    NSUInteger _repeatIndex;
+    uint64_t _repeatTime;
+    
+    // Model of Emporter's state, in the order tunnels were fetched
+    NSMutableDictionary<NSString*,NSDictionary*> *_tunnelValues;
+    NSMutableArray<NSString*> *_tunnelIds;
+    EmporterServiceState _serviceState;
+    NSString *_serviceConflictReason;
+    
+    BOOL _isStarted;
+    double _speed;
+    uint64_t _startTime;
+    uint64_t _lastPostTime;
+    dispatch_block_t _completionHandler;
+    
+    uint64_t _pendingSince;
+    
+    // Latencies are counted in log-scale buckets so memory is constant regardless of how long the replay runs
+    uint64_t _latencyBuckets[_EMSessionLatencyBucketCount];
+    uint64_t _latencyCount;
+    uint64_t _maximumLatency;
+}
+
++ (instancetype)replayWithContentsOfFile:(NSString *)path error:(NSError **)outError {
+    NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:outError];
+    if (contents == nil) {
+        return nil;
+    }
+    
+    NSDictionary<NSString*,NSNotificationName> *names = [NSDictionary dictionaryWithObjects:_EMSessionNotificationCodes().allKeys forKeys:_EMSessionNotificationCodes().allValues];
+    NSMutableArray<_EMSessionReplayEvent*> *events = [NSMutableArray array];
+    NSMutableArray<NSDictionary*> *initialRecords = [NSMutableArray array];
+    __block NSUInteger lineNumber = 0;
+    __block NSError *error = nil;
+    
+    [contents enumerateLinesUsingBlock:^(NSString *line, BOOL *stop) {
+        lineNumber++;
+        
+        if (line.length == 0) {
+            return;
+        }
+        
+        NSDictionary *record = [NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:NULL];
+        
+        if (![record isKindOfClass:[NSDictionary class]] || (lineNumber == 1 && ![record[@"format"] isEqual:@"emporter-session"])) {
+            error = _EMSessionInvalidRecordingError(path, lineNumber);
+            *stop = YES;
+            return;
+        } else if (lineNumber == 1) {
+            return;
+        }
+        
+        NSString *code = record[@"n"];
+        
+        if (code == nil) {
+            [(events.lastObject.records ?: initialRecords) addObject:record];
+            return;
+        }
+        
+        _EMSessionReplayEvent *event = [[_EMSessionReplayEvent alloc] init];
+        event.name = [code isKindOfClass:[NSString class]] ? names[code] : nil;
+        event.time = [record[@"t"] unsignedLongLongValue] * NSEC_PER_USEC;
+        event.userInfo = [record[@"id"] isKindOfClass:[NSString class]] ? @{EmporterTunnelIdentifierUserInfoKey: record[@"id"]} : nil;
+        event.records = [NSMutableArray array];
+        
+        if (event.name == nil) {
+            error = _EMSessionInvalidRecordingError(path, lineNumber);
+            *stop = YES;
+            return;
+        }
+        
+        [events addObject:event];
+    }];
+    
+    if (error == nil && lineNumber == 0) {
+        error = _EMSessionInvalidRecordingError(path, 1);
+    }
+    
+    if (error != nil) {
+        if (outError != NULL) {
+            (*outError) = error;
+        }
+        return nil;
+    }
+    
+    return [[EMSessionReplay alloc] _initWithEvents:events initialRecords:initialRecords];
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)_initWithEvents:(NSArray<_EMSessionReplayEvent*> *)events initialRecords:(NSArray<NSDictionary*> *)initialRecords {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _events = [events copy];
+    _initialRecords = [initialRecords copy];
+    _repeatCount = 1;
+    _tunnelValues = [NSMutableDictionary dictionary];
+    _tunnelIds = [NSMutableArray array];
+    _serviceState = EmporterServiceStateSuspended;
+    
+    [self _applyRecords:initialRecords];
+    
+    return self;
+}
+
+- (NSUInteger)numberOfEvents {
+    return _events.count;
+}
+
+- (NSUInteger)numberOfPostedEvents {
+    return _repeatIndex * _events.count + _eventIndex;
+}
+
+#pragma mark - Replaying
+
+- (void)_applyRecords:(NSArray<NSDictionary*> *)records {
+    for (NSDictionary *record in records) {
+        id value;
+        
+        if ((value = record[@"service"]) != nil) {
+            _serviceState = (EmporterServiceState)[value unsignedIntValue];
+        } else if ((value = record[@"reason"]) != nil) {
+            _serviceConflictReason = [value isKindOfClass:[NSString class]] ? value : nil;
+        } else if ((value = record[@"all"]) != nil) {
+            [_tunnelValues removeAllObjects];
+            [_tunnelIds removeAllObjects];
+            
+            for (NSDictionary *values in value) {
+                NSString *tunnelId = values[@"id"];
+                
+                if ([tunnelId isKindOfClass:[NSString class]] && _tunnelValues[tunnelId] == nil) {
+                    [_tunnelIds addObject:tunnelId];
+                    _tunnelValues[tunnelId] = _EMSessionDecodeValues(values);
+                }
+            }
+        } else if ([record[@"id"] isKindOfClass:[NSString class]]) {
+            NSString *tunnelId = record[@"id"];
+            id values = record[@"v"] ?: record[@"k"];
+            
+            if (![values isKindOfClass:[NSDictionary class]]) {
+                // The tunnel no longer existed when it was read
+                if (_tunnelValues[tunnelId] != nil) {
+                    [_tunnelValues removeObjectForKey:tunnelId];
+                    [_tunnelIds removeObject:tunnelId];
+                }
+            } else if (record[@"v"] != nil || _tunnelValues[tunnelId] != nil) {
+                // Complete values replace the tunnel; partial values patch it
+                NSMutableDictionary *tunnelValues = record[@"v"] != nil ? [NSMutableDictionary dictionary] : [_tunnelValues[tunnelId] mutableCopy];
+                [tunnelValues addEntriesFromDictionary:_EMSessionDecodeValues(values)];
+                
+                if (_tunnelValues[tunnelId] == nil) {
+                    [_tunnelIds addObject:tunnelId];
+                }
+                
+                _tunnelValues[tunnelId] = tunnelValues;
+            }
+        }
+    }
+}
+
+- (void)startWithSpeed:(double)speed completionHandler:(dispatch_block_t)completionHandler {
+    if (_isStarted) {
+        return;
+    }
+    
+    _isStarted = YES;
+    _speed = MAX(speed, 0);
+    _completionHandler = [completionHandler copy];
+    _startTime = _EMSessionNow();
+    
+    dispatch_async(dispatch_get_main_queue(), ^{ [self _postDueEvents]; });
+}
+
+- (void)_postDueEvents {
+    // Events are posted in batches so that the run loop (and drawing) isn't starved while replaying as fast as possible
+    const NSUInteger maximumBatchSize = 1024;
+    uint64_t now = _EMSessionNow();
+    NSUInteger batchSize = 0;
+    
+    while (batchSize < maximumBatchSize && [self _hasEventsToPost]) {
+        _EMSessionReplayEvent *event = _events[_eventIndex];
+        
+        if (_speed > 0 && (double)(_repeatTime + event.time) / _speed > (double)(now - _startTime)) {
+            break;
+        }
+        
+        _eventIndex++;
+        batchSize++;
+        
+        [self _applyRecords:event.records];
+        
+        _lastPostTime = _EMSessionNow();
+        if (_pendingSince == 0) {
+            _pendingSince = _lastPostTime;
+        }
+        
+        [[NSNotificationCenter defaultCenter] postNotificationName:event.name object:self userInfo:event.userInfo];
+        
+        if (_outputsSynchronously) {
+            [self didOutputEvents];
+        }
+    }
+    
+    if (![self _hasEventsToPost]) {
+        dispatch_block_t completionHandler = _completionHandler;
+        _completionHandler = nil;
+        
+        if (completionHandler != nil) {
+            dispatch_async(dispatch_get_main_queue(), completionHandler);
+        }
+    } else if (_speed == 0 || batchSize == maximumBatchSize) {
+        dispatch_async(dispatch_get_main_queue(), ^{ [self _postDueEvents]; });
+    } else {
+        uint64_t dueTime = (uint64_t)((double)(_repeatTime + _events[_eventIndex].time) / _speed);
+        uint64_t elapsedTime = _EMSessionNow() - _startTime;
+        
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(dueTime > elapsedTime ? dueTime - elapsedTime : 0)), dispatch_get_main_queue(), ^{
+            [self _postDueEvents];
+        });
+    }
+}
+
+- (BOOL)_hasEventsToPost {
+    if (_eventIndex < _events.count) {
+        return YES;
+    } else if (_events.count == 0 || _repeatIndex + 1 >= _repeatCount) {
+        return NO;
+    }
+    
+    // Start over from the initial state, continuing from the time of the last event
+    _repeatIndex++;
+    _repeatTime += _events.lastObject.time;
+    _eventIndex = 0;
+    
+    [_tunnelValues removeAllObjects];
+    [_tunnelIds removeAllObjects];
+    _serviceState = EmporterServiceStateSuspended;
+    _serviceConflictReason = nil;
+    [self _applyRecords:_initialRecords];
+    
+    return YES;
+}
+
+- (NSTimeInterval)duration {
+    return _lastPostTime > _startTime ? (NSTimeInterval)(_lastPostTime - _startTime) / NSEC_PER_SEC : 0;
+}
+
+- (void)didOutputEvents {
+    if (_pendingSince == 0) {
+        return;
+    }
+    
+    uint64_t latency = _EMSessionNow() - _pendingSince;
+    _pendingSince = 0;
+    
+    _latencyBuckets[_EMSessionLatencyBucket(latency)]++;
+    _latencyCount++;
+    _maximumLatency = MAX(_maximumLatency, latency);
+}
+
+- (NSTimeInterval)latencyAtPercentile:(double)percentile {
+    if (_latencyCount == 0) {
+        return 0;
+    }
+    
+    uint64_t rank = (uint64_t)(MIN(MAX(percentile, 0), 100) / 100 * (double)(_latencyCount - 1) + 0.5) + 1;
+    uint64_t count = 0;
+    NSUInteger bucket = 0;
+    
+    while ((count += _latencyBuckets[bucket]) < rank) {
+        bucket++;
+    }
+    
+    // Use the upper bound of the bucket, which never exceeds the largest latency measured
+    double latency = MIN(exp2((double)(bucket + 1) / _EMSessionLatencyBucketsPerPowerOfTwo), (double)_maximumLatency);
+    return latency / NSEC_PER_SEC;
+}
+
+#pragma mark - EMSessionSource
+
+- (EmporterServiceState)serviceState {
+    return _serviceState;
+}
+
+- (NSString *)serviceConflictReason {
+    return _serviceConflictReason;
+}
+
+- (BOOL)isRunning {
+    return YES;
+}
+
+- (void)launchInBackgroundWithCompletionHandler:(void (^)(NSError *))completionHandler {
+    // The recording contains the notifications which followed the relaunch
+    dispatch_async(dispatch_get_main_queue(), ^{ completionHandler(nil); });
+}
+
+- (NSArray<EMTunnelSnapshot *> *)fetchTunnelSnapshots {
+    NSMutableArray *snapshots = [NSMutableArray arrayWithCapacity:_tunnelIds.count];
+    
+    for (NSString *tunnelId in _tunnelIds) {
+        [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:_tunnelValues[tunnelId]]];
+    }
+    
+    return snapshots;
+}
+
+- (EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = _tunnelValues[identifier];
+    return values != nil ? [[EMTunnelSnapshot alloc] initWithValues:values] : nil;
+}
+
+- (NSDictionary<NSString *,id> *)fetchValuesForKeys:(NSArray<NSString *> *)keys ofTunnelWithIdentifier:(NSString *)identifier {
+    NSDictionary *values = _tunnelValues[identifier];
+    if (values == nil) {
+        return nil;
+    }
+    
+    NSMutableDictionary *subset = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    for (NSString *key in keys) {
+        subset[key] = values[key] ?: [NSNull null];
+    }
+    
+    return subset;
+}
+
+@end
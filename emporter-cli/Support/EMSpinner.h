@@ -13,7 +13,12 @@ NS_ASSUME_NONNULL_BEGIN
 @class YDCommandOutput;
 @protocol YDCommandOutputWriter;
 
-/*! An thread-safe ascii spinner */
+/*!
+ An thread-safe ascii spinner, which can show the completion, throughput and estimated time remaining of a progress.
+ 
+ The spinner is redrawn in place at a limited rate, with each frame written at once. When the output isn't a terminal (i.e. logs),
+ the spinner isn't drawn at all: instead, a line is written each time the message changes.
+ */
 @interface EMSpinner : NSObject
 
 /*! The designated initializer.
@@ -28,6 +33,15 @@ NS_ASSUME_NONNULL_BEGIN
 /*! An optional message to show alongside the spinner. Can be updated when the spinner is active. */
 @property(nonatomic) NSString *__nullable message;
 
+/*! An optional progress to show alongside the message. Progress of kind \c NSProgressKindFile is measured in bytes. */
+@property(nonatomic) NSProgress *__nullable progress;
+
+/*! The maximum number of times the spinner is drawn per second (defaults to 8). Changes to the message are shown in the next frame. */
+@property(nonatomic) NSUInteger maximumFramesPerSecond;
+
+/*! Returns YES if the spinner is drawn in place, which defaults to YES if the output is a terminal */
+@property(nonatomic) BOOL isInteractive;
+
 /*! Returns YES if the receiver is spinning */
 @property(nonatomic,readonly) BOOL isSpinning;
 
@@ -39,4 +53,34 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+
+/*! Estimates the throughput and time remaining of a progress from periodic samples of its completion */
+@interface EMProgressEstimator : NSObject
+
+/*!
+ Add a sample, which is ignored if it follows the previous sample too closely. Throughput is smoothed over the last few seconds, so that
+ it doesn't jump between samples. The estimate is reset if the completed unit count decreases.
+ \param completedUnitCount  The number of completed units
+ \param totalUnitCount      The total number of units, or a negative value if it's unknown
+ \param timestamp           The time of the sample, in seconds
+ */
+- (void)addSampleWithCompletedUnitCount:(int64_t)completedUnitCount totalUnitCount:(int64_t)totalUnitCount timestamp:(NSTimeInterval)timestamp;
+
+/*! Remove all samples */
+- (void)reset;
+
+/*! The estimated number of units completed per second, or 0 if it's unknown */
+@property(nonatomic,readonly) double throughput;
+
+/*! The estimated number of seconds remaining, or a negative value if it's unknown */
+@property(nonatomic,readonly) NSTimeInterval estimatedTimeRemaining;
+
+/*!
+ A short description of the completion, throughput and time remaining (i.e. "42%  1.2 MB/s  0:12 left"), omitting unknown values.
+ \param countsBytes Returns YES if units are bytes. Throughput is otherwise omitted.
+ */
+- (NSString *)localizedDescriptionCountingBytes:(BOOL)countsBytes;
+
+@end
+
 NS_ASSUME_NONNULL_END
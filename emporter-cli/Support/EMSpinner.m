@@ -6,6 +6,9 @@
 //  Copyright © 2019 Young Dynasty. All rights reserved.
 //
 
+#include <math.h>
+#include <unistd.h>
+
 #import "EMSpinner.h"
 #import "YDCommandOutput.h"
 
@@ -13,6 +16,9 @@
 @implementation EMSpinner {
     NSTimer *_timer;
     YDCommandOutput *_output;
+    EMProgressEstimator *_estimator;
+    uint8_t _frameIndex;
+    BOOL _isSpinning;
 }
 
 - (instancetype)init {
@@ -25,6 +31,9 @@
         return nil;
     
     _output = output;
+    _estimator = [[EMProgressEstimator alloc] init];
+    _maximumFramesPerSecond = 8;
+    _isInteractive = isatty(output == YDStandardError ? STDERR_FILENO : STDOUT_FILENO) != 0;
     
     return self;
 }
@@ -40,12 +49,26 @@
         return dispatch_sync(dispatch_get_main_queue(), ^{ [self setMessage:message]; });
     }
     
-    if (_message != message) {
-        _message = message;
-        
-        if (_timer != nil) {
-            [_timer fire];
-        }
+    if (_message == message || [_message isEqualToString:message]) {
+        return;
+    }
+    
+    _message = [message copy];
+    
+    // Interactive spinners show the message in their next frame, while logs only get a line per message
+    if (_isSpinning && !_isInteractive && _message.length > 0) {
+        [_output appendFormat:@"%@\n", _message];
+    }
+}
+
+- (void)setProgress:(NSProgress *)progress {
+    if (![NSThread isMainThread]) {
+        return dispatch_sync(dispatch_get_main_queue(), ^{ [self setProgress:progress]; });
+    }
+    
+    if (_progress != progress) {
+        _progress = progress;
+        [_estimator reset];
     }
 }
 
@@ -58,38 +81,66 @@
         return isSpinning;
     }
     
-    return _timer != nil && [_timer isValid];
+    return _isSpinning;
 }
 
 - (void)startSpinning {
     if (![NSThread isMainThread]) {
         return dispatch_sync(dispatch_get_main_queue(), ^{ [self startSpinning]; });
     }
-
-    if (_timer != nil) {
+    
+    if (_isSpinning) {
         return;
     }
-
-    __block uint8 i = 0;
-    __weak EMSpinner *weakSelf = self;
     
-    _timer = [NSTimer timerWithTimeInterval:0.15 repeats:YES block:^(NSTimer *timer) {
-        EMSpinner *strongSelf = weakSelf;
-        if (strongSelf == nil) {
-            return;
-        }
+    _isSpinning = YES;
+    
+    if (_isInteractive) {
+        __weak EMSpinner *weakSelf = self;
+        NSTimeInterval interval = 1.0 / MAX(_maximumFramesPerSecond, 1);
         
-        [self.output appendString:@"\r\033[K"];
+        _timer = [NSTimer timerWithTimeInterval:interval repeats:YES block:^(NSTimer *timer) {
+            [weakSelf _drawFrame];
+        }];
         
-        [self.output applyStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeInvert) withinBlock:^(id<YDCommandOutputWriter> output) {
+        [[NSRunLoop mainRunLoop] addTimer:_timer forMode:NSDefaultRunLoopMode];
+        
+        // Draw the first frame right away, as the timer won't fire until the end of its interval
+        [self _drawFrame];
+    } else if (_message.length > 0) {
+        [_output appendFormat:@"%@\n", _message];
+    }
+}
+
+- (void)_drawFrame {
+    NSProgress *progress = _progress;
+    NSString *progressDescription = nil;
+    
+    if (progress != nil) {
+        [_estimator addSampleWithCompletedUnitCount:progress.completedUnitCount totalUnitCount:progress.totalUnitCount timestamp:[NSProcessInfo processInfo].systemUptime];
+        progressDescription = [_estimator localizedDescriptionCountingBytes:[progress.kind isEqualToString:NSProgressKindFile]];
+    }
+    
+    NSString *message = _message ?: @"";
+    uint8_t frameIndex = _frameIndex++;
+    
+    // The frame is composed before it's written, so that the terminal never shows a partial frame and each frame costs a single write
+    NSData *frame = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> output) {
+        [output appendString:@"\r\033[K"];
+        
+        [output applyStyle:YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeInvert) withinBlock:^(id<YDCommandOutputWriter> output) {
             static NSString *spinnerComponents[] = { @"\\", @"|", @"/", @"—" };
-            [output appendFormat:@" %@ ", spinnerComponents[(i++ % 4)]];
+            [output appendFormat:@" %@ ", spinnerComponents[(frameIndex % 4)]];
         }];
         
-        [self.output appendFormat:@" %@", strongSelf.message ?: @""];
+        [output appendFormat:@" %@", message];
+        
+        if (progressDescription.length > 0) {
+            [output appendFormat:@"  %@", progressDescription];
+        }
     }];
-
-    [[NSRunLoop mainRunLoop] addTimer:_timer forMode:NSDefaultRunLoopMode];
+    
+    [_output appendString:[[NSString alloc] initWithData:frame encoding:NSUTF8StringEncoding] ?: @""];
 }
 
 - (void)stopSpinning:(BOOL)resetLine {
@@ -97,6 +148,12 @@
         return dispatch_sync(dispatch_get_main_queue(), ^{ [self stopSpinning:resetLine]; });
     }
     
+    if (!_isSpinning) {
+        return;
+    }
+    
+    _isSpinning = NO;
+    
     if (_timer != nil) {
         [_timer invalidate];
         _timer = nil;
@@ -108,3 +165,100 @@
 }
 
 @end
+
+
+/*! Samples closer together than this (in seconds) are ignored, as their throughput is mostly noise */
+static const NSTimeInterval _EMProgressEstimatorMinimumSampleInterval = 0.25;
+
+/*! The interval (in seconds) over which throughput is smoothed: older samples have less than 37% of the weight of the estimate */
+static const NSTimeInterval _EMProgressEstimatorSmoothingInterval = 3.0;
+
+@implementation EMProgressEstimator {
+    int64_t _completedUnitCount;
+    int64_t _totalUnitCount;
+    
+    BOOL _hasSample;
+    BOOL _hasThroughput;
+    int64_t _sampleUnitCount;
+    NSTimeInterval _sampleTimestamp;
+}
+
+- (void)addSampleWithCompletedUnitCount:(int64_t)completedUnitCount totalUnitCount:(int64_t)totalUnitCount timestamp:(NSTimeInterval)timestamp {
+    if (_hasSample && completedUnitCount < _sampleUnitCount) {
+        [self reset];
+    }
+    
+    _completedUnitCount = completedUnitCount;
+    _totalUnitCount = totalUnitCount;
+    
+    if (!_hasSample) {
+        _hasSample = YES;
+        _sampleUnitCount = completedUnitCount;
+        _sampleTimestamp = timestamp;
+        return;
+    }
+    
+    NSTimeInterval elapsed = timestamp - _sampleTimestamp;
+    if (elapsed < _EMProgressEstimatorMinimumSampleInterval) {
+        return;
+    }
+    
+    // Samples are weighted by the time since the previous sample, so that the estimate doesn't depend on how often it's sampled
+    double throughput = (double)(completedUnitCount - _sampleUnitCount) / elapsed;
+    
+    if (_hasThroughput) {
+        _throughput += (throughput - _throughput) * (1 - exp(-elapsed / _EMProgressEstimatorSmoothingInterval));
+    } else {
+        _throughput = throughput;
+        _hasThroughput = YES;
+    }
+    
+    _sampleUnitCount = completedUnitCount;
+    _sampleTimestamp = timestamp;
+}
+
+- (void)reset {
+    _completedUnitCount = 0;
+    _totalUnitCount = 0;
+    _throughput = 0;
+    _hasSample = NO;
+    _hasThroughput = NO;
+}
+
+- (NSTimeInterval)estimatedTimeRemaining {
+    if (!_hasThroughput || _throughput <= 0 || _totalUnitCount <= 0) {
+        return -1;
+    }
+    
+    return (double)MAX(_totalUnitCount - _completedUnitCount, 0) / _throughput;
+}
+
+- (NSString *)localizedDescriptionCountingBytes:(BOOL)countsBytes {
+    NSMutableArray<NSString*> *components = [NSMutableArray arrayWithCapacity:3];
+    
+    if (_hasSample && _totalUnitCount > 0) {
+        double fractionCompleted = MIN(MAX((double)_completedUnitCount / (double)_totalUnitCount, 0), 1);
+        [components addObject:[NSString stringWithFormat:@"%d%%", (int)floor(fractionCompleted * 100)]];
+    }
+    
+    if (countsBytes && _hasThroughput && _throughput > 0) {
+        NSString *byteCount = [NSByteCountFormatter stringFromByteCount:(long long)_throughput countStyle:NSByteCountFormatterCountStyleFile];
+        [components addObject:[NSString stringWithFormat:@"%@/s", byteCount]];
+    }
+    
+    NSTimeInterval timeRemaining = self.estimatedTimeRemaining;
+    
+    if (timeRemaining >= 0) {
+        unsigned long seconds = (unsigned long)ceil(MIN(timeRemaining, 359999));
+        
+        if (seconds >= 3600) {
+            [components addObject:[NSString stringWithFormat:@"%lu:%02lu:%02lu left", seconds / 3600, (seconds / 60) % 60, seconds % 60]];
+        } else {
+            [components addObject:[NSString stringWithFormat:@"%lu:%02lu left", seconds / 60, seconds % 60]];
+        }
+    }
+    
+    return [components componentsJoinedByString:@"  "];
+}
+
+@end
@@ -0,0 +1,44 @@
+//
+//  EMStartupTrace.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! Phases of startup, in the order they're expected to occur */
+typedef NS_ENUM(NSUInteger, EMStartupPhase) {
+    /*! The main function was entered */
+    EMStartupPhaseMain,
+    /*! Command-line arguments were parsed */
+    EMStartupPhaseArgumentsParsed,
+    /*! Emporter was resolved (launched, if needed) */
+    EMStartupPhaseEmporterResolved,
+    /*! The first byte was written to stdout (only recorded when tracing is enabled) */
+    EMStartupPhaseFirstOutput,
+    /*! The command finished */
+    EMStartupPhaseExit,
+    
+    EMStartupPhaseCount
+};
+
+/*! Record the (monotonic) time of a phase. Only the first call for each phase is recorded, and calls are cheap enough to leave in place when tracing is disabled. */
+extern void EMStartupTraceMark(EMStartupPhase phase);
+
+/*!
+ Enable tracing, which watches stdout for the first output of the command.
+ 
+ Output is relayed through a pipe while tracing is enabled, so stdout is no longer a terminal. It's meant for timing runs, not interactive use.
+ 
+ \param outputJSON Whether or not the timings should be written as JSON
+ */
+extern void EMStartupTraceEnable(BOOL outputJSON);
+
+/*! Record the exit phase and write the timing of each phase to stderr (if tracing is enabled) */
+extern void EMStartupTraceFinish(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,165 @@
+//
+//  EMStartupTrace.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <sys/sysctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#import "EMStartupTrace.h"
+#import "YDCommand.h"
+
+
+static uint64_t _EMStartupPhaseTimes[EMStartupPhaseCount];
+static uint64_t _EMStartupLaunchDuration;
+
+static BOOL _EMStartupTraceEnabled;
+static BOOL _EMStartupTraceOutputJSON;
+static int _EMStartupTraceStdout = -1;
+static dispatch_group_t _EMStartupTraceGroup;
+
+static NSString *_EMStartupPhaseName(EMStartupPhase phase) {
+    switch (phase) {
+        case EMStartupPhaseMain:                return @"main";
+        case EMStartupPhaseArgumentsParsed:     return @"parse";
+        case EMStartupPhaseEmporterResolved:    return @"resolve";
+        case EMStartupPhaseFirstOutput:         return @"output";
+        case EMStartupPhaseExit:                return @"exit";
+        case EMStartupPhaseCount:               break;
+    }
+    
+    return @"";
+}
+
+/*! Time elapsed between the process starting (exec) and now. The start time is only available as wall clock time. */
+static uint64_t _EMProcessAge(void) {
+    int name[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+    struct kinfo_proc proc;
+    size_t length = sizeof(proc);
+    
+    if (sysctl(name, sizeof(name) / sizeof(*name), &proc, &length, NULL, 0) != 0 || length == 0) {
+        return 0;
+    }
+    
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    
+    int64_t age = ((int64_t)now.tv_sec - proc.kp_proc.p_starttime.tv_sec) * NSEC_PER_SEC + ((int64_t)now.tv_usec - proc.kp_proc.p_starttime.tv_usec) * NSEC_PER_USEC;
+    return age > 0 ? (uint64_t)age : 0;
+}
+
+void EMStartupTraceMark(EMStartupPhase phase) {
+    if (phase < EMStartupPhaseCount && _EMStartupPhaseTimes[phase] == 0) {
+        _EMStartupPhaseTimes[phase] = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    }
+}
+
+void EMStartupTraceEnable(BOOL outputJSON) {
+    if (_EMStartupTraceEnabled) {
+        return;
+    }
+    
+    _EMStartupTraceEnabled = YES;
+    _EMStartupTraceOutputJSON = outputJSON;
+    
+    uint64_t age = _EMProcessAge();
+    uint64_t sinceMain = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - _EMStartupPhaseTimes[EMStartupPhaseMain];
+    _EMStartupLaunchDuration = age > sinceMain ? age - sinceMain : 0;
+    
+    // Relay stdout through a pipe to see when the first byte is written
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return;
+    }
+    
+    fflush(stdout);
+    
+    int readFd = fds[0];
+    int writeFd = dup(STDOUT_FILENO);
+    
+    _EMStartupTraceStdout = writeFd;
+    _EMStartupTraceGroup = dispatch_group_create();
+    
+    dispatch_group_async(_EMStartupTraceGroup, dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0), ^{
+        char buffer[16 * 1024];
+        ssize_t count;
+        
+        while ((count = read(readFd, buffer, sizeof(buffer))) != 0) {
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            
+            EMStartupTraceMark(EMStartupPhaseFirstOutput);
+            
+            for (ssize_t offset = 0; offset < count;) {
+                ssize_t written = write(writeFd, buffer + offset, (size_t)(count - offset));
+                if (written < 0 && errno != EINTR) {
+                    break;
+                }
+                offset += MAX(written, 0);
+            }
+        }
+        
+        close(readFd);
+    });
+    
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+}
+
+void EMStartupTraceFinish(void) {
+    EMStartupTraceMark(EMStartupPhaseExit);
+    
+    if (!_EMStartupTraceEnabled) {
+        return;
+    }
+    
+    // Restore stdout, which closes the pipe so the relay can drain
+    if (_EMStartupTraceStdout >= 0) {
+        fflush(stdout);
+        dup2(_EMStartupTraceStdout, STDOUT_FILENO);
+        
+        dispatch_group_wait(_EMStartupTraceGroup, dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC));
+        
+        close(_EMStartupTraceStdout);
+        _EMStartupTraceStdout = -1;
+    }
+    
+    // Timings are relative to the process starting (or main, if its start time isn't available)
+    uint64_t origin = _EMStartupPhaseTimes[EMStartupPhaseMain] - _EMStartupLaunchDuration;
+    uint64_t previous = origin;
+    
+    NSMutableDictionary *phases = [NSMutableDictionary dictionary];
+    NSMutableString *lines = [NSMutableString string];
+    
+    for (EMStartupPhase phase = 0; phase < EMStartupPhaseCount; phase++) {
+        NSString *name = _EMStartupPhaseName(phase);
+        uint64_t time = _EMStartupPhaseTimes[phase];
+        
+        if (time == 0) {
+            phases[name] = [NSNull null];
+            [lines appendFormat:@"startup: %-8s %10s %10s\n", name.UTF8String, "-", "-"];
+            continue;
+        }
+        
+        double elapsed = (double)(time - origin) / NSEC_PER_MSEC;
+        double delta = (double)(time - previous) / NSEC_PER_MSEC;
+        previous = time;
+        
+        phases[name] = @(elapsed);
+        [lines appendFormat:@"startup: %-8s %+8.2fms %8.2fms\n", name.UTF8String, delta, elapsed];
+    }
+    
+    if (_EMStartupTraceOutputJSON) {
+        [YDStandardError appendJSONObject:@{@"event": @"trace.startup", @"data": phases}];
+    } else {
+        [YDStandardError appendString:lines];
+    }
+}
@@ -0,0 +1,74 @@
+//
+//  EMTarballReader.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A streaming reader for gzip-compressed tarballs which extracts a single file.
+ 
+ The archive is decompressed and parsed as data is appended, so that only the matching entry is ever written to disk (and memory use
+ doesn't depend on the size of the archive). Entries are matched by their path within the archive, ignoring any leading "./".
+ */
+@interface EMTarballReader : NSObject
+
+/*!
+ Extract a file from a tarball on disk.
+ 
+ The progress' total unit count is set to the size of the tarball and is advanced as compressed data is read. Canceling the progress
+ stops extraction with an \c NSUserCancelledError.
+ 
+ \param entryName       The path of the file within the archive
+ \param fileURL         The URL of the tarball
+ \param destinationURL  The URL to which the file is written
+ \param progress        An optional progress used to report progress and as a means of cancelation
+ \param outError        The error (if any) which occurred while reading the tarball or writing the file
+ 
+ \returns The reader used to extract the file, or nil if the archive could not be read. Check \c didExtractEntry to see if the file was found.
+ */
++ (nullable instancetype)readerByExtractingEntryWithName:(NSString *)entryName fromFileURL:(NSURL *)fileURL toURL:(NSURL *)destinationURL progress:(nullable NSProgress *)progress error:(NSError **)outError;
+
+/*!
+ The designated initializer.
+ \param entryName       The path of the file within the archive
+ \param destinationURL  The URL to which the file is written
+ \returns A new instance of \c EMTarballReader.
+ */
+- (instancetype)initWithEntryName:(NSString *)entryName destinationURL:(NSURL *)destinationURL NS_DESIGNATED_INITIALIZER;
+
+/*! The path of the file within the archive */
+@property(nonatomic,readonly) NSString *entryName;
+
+/*! The URL to which the file is written */
+@property(nonatomic,readonly) NSURL *destinationURL;
+
+/*! Returns YES once the file has been completely written to the destination URL. Additional data is ignored from then on. */
+@property(nonatomic,readonly) BOOL didExtractEntry;
+
+/*! The number of (compressed) bytes which have been appended */
+@property(nonatomic,readonly) uint64_t numberOfBytesRead;
+
+/*!
+ Append compressed data to the reader.
+ \returns NO if the data is corrupt or the file could not be written.
+ */
+- (BOOL)appendBytes:(const void *)bytes length:(size_t)length error:(NSError **)outError;
+
+/*!
+ Finish reading the archive, which fails if the archive was truncated. Partially written files are removed.
+ \returns NO if the archive was incomplete.
+ */
+- (BOOL)finishWithError:(NSError **)outError;
+
+/*! Stop reading the archive, removing partially written files. */
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,518 @@
+//
+//  EMTarballReader.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#import "EMTarballReader.h"
+
+
+#define EMTarBlockSize 512
+
+/*! The maximum size of metadata entries (long names and pax headers), which are buffered in memory */
+#define EMTarMaxMetadataSize (64 * 1024)
+
+#define EMTarballInflateBufferSize (64 * 1024)
+#define EMTarballReadBufferSize (256 * 1024)
+
+typedef NS_ENUM(NSUInteger, _EMTarEntryMode) {
+    _EMTarEntryModeSkip,
+    _EMTarEntryModeExtract,
+    _EMTarEntryModeLongName,
+    _EMTarEntryModePaxHeader,
+};
+
+static NSError *_EMTarballCorruptError(NSString *reason) {
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{NSLocalizedDescriptionKey: @"The archive is corrupt", NSLocalizedFailureReasonErrorKey: reason}];
+}
+
+static BOOL _EMTarParseNumber(const uint8_t *field, size_t length, uint64_t *outValue) {
+    uint64_t value = 0;
+    
+    if (field[0] & 0x80) {
+        // Large values are stored in base-256 (a GNU extension), flagged by the high bit. Negative values are invalid.
+        if (field[0] & 0x40) {
+            return NO;
+        }
+        
+        value = field[0] & 0x3f;
+        
+        for (size_t i = 1; i < length; i++) {
+            if (value > (UINT64_MAX >> 8)) {
+                return NO;
+            }
+            value = (value << 8) | field[i];
+        }
+    } else {
+        size_t i = 0;
+        
+        while (i < length && field[i] == ' ') {
+            i++;
+        }
+        
+        for (; i < length && field[i] >= '0' && field[i] <= '7'; i++) {
+            if (value > (UINT64_MAX >> 3)) {
+                return NO;
+            }
+            value = (value << 3) | (uint64_t)(field[i] - '0');
+        }
+        
+        // Octal values are terminated by a space or NUL
+        if (i < length && field[i] != ' ' && field[i] != '\0') {
+            return NO;
+        }
+    }
+    
+    (*outValue) = value;
+    return YES;
+}
+
+static uint64_t _EMTarChecksum(const uint8_t *header) {
+    uint64_t checksum = 0;
+    
+    for (size_t i = 0; i < EMTarBlockSize; i++) {
+        // The checksum field itself is summed as if it were filled with spaces
+        checksum += (i >= 148 && i < 156) ? ' ' : header[i];
+    }
+    
+    return checksum;
+}
+
+static BOOL _EMTarIsEmptyBlock(const uint8_t *header) {
+    for (size_t i = 0; i < EMTarBlockSize; i++) {
+        if (header[i] != 0) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+static NSString *_EMTarHeaderPath(const uint8_t *header) {
+    NSString *name = [[NSString alloc] initWithBytes:header length:strnlen((const char *)header, 100) encoding:NSUTF8StringEncoding];
+    
+    // ustar archives store long paths in two parts
+    if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != 0) {
+        NSString *prefix = [[NSString alloc] initWithBytes:header + 345 length:strnlen((const char *)header + 345, 155) encoding:NSUTF8StringEncoding];
+        return [NSString stringWithFormat:@"%@/%@", prefix ?: @"", name ?: @""];
+    }
+    
+    return name;
+}
+
+static NSString *_EMTarPaxPath(NSData *data) {
+    const char *bytes = data.bytes;
+    size_t length = data.length;
+    size_t offset = 0;
+    
+    // Each record is formatted as "<length> <key>=<value>\n", where the length includes the entire record
+    while (offset < length) {
+        size_t recordLength = 0;
+        size_t i = offset;
+        
+        while (i < length && bytes[i] >= '0' && bytes[i] <= '9' && recordLength <= length) {
+            recordLength = (recordLength * 10) + (size_t)(bytes[i++] - '0');
+        }
+        
+        if (i >= length || bytes[i] != ' ' || recordLength == 0 || recordLength > length - offset) {
+            break;
+        }
+        
+        const char *record = bytes + i + 1;
+        size_t recordRemaining = offset + recordLength - (i + 1);
+        
+        if (recordRemaining > 6 && memcmp(record, "path=", 5) == 0) {
+            return [[NSString alloc] initWithBytes:record + 5 length:recordRemaining - 6 encoding:NSUTF8StringEncoding];
+        }
+        
+        offset += recordLength;
+    }
+    
+    return nil;
+}
+
+static NSString *_EMTarNormalizedPath(NSString *path) {
+    while ([path hasPrefix:@"./"]) {
+        path = [path substringFromIndex:2];
+    }
+    
+    return path;
+}
+
+
+@implementation EMTarballReader {
+    z_stream _stream;
+    BOOL _isStreamInitialized;
+    BOOL _isStreamEnded;
+    uint8_t *_inflateBuffer;
+    
+    uint8_t _header[EMTarBlockSize];
+    size_t _headerLength;
+    BOOL _isArchiveEnded;
+    
+    _EMTarEntryMode _entryMode;
+    uint64_t _entryRemaining;
+    uint64_t _paddingRemaining;
+    mode_t _entryPermissions;
+    NSMutableData *_metadata;
+    NSString *_nextEntryPath;
+    
+    int _fd;
+    NSError *_error;
+}
+
++ (instancetype)readerByExtractingEntryWithName:(NSString *)entryName fromFileURL:(NSURL *)fileURL toURL:(NSURL *)destinationURL progress:(NSProgress *)progress error:(NSError **)outError {
+    NSInputStream *input = [NSInputStream inputStreamWithURL:fileURL];
+    [input open];
+    
+    if (input.streamStatus != NSStreamStatusOpen) {
+        if (outError != NULL) {
+            (*outError) = input.streamError;
+        }
+        return nil;
+    }
+    
+    NSNumber *fileSize = nil;
+    [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+    
+    progress.totalUnitCount = fileSize.longLongValue;
+    
+    EMTarballReader *reader = [[self alloc] initWithEntryName:entryName destinationURL:destinationURL];
+    NSMutableData *buffer = [NSMutableData dataWithLength:EMTarballReadBufferSize];
+    NSError *error = nil;
+    BOOL success = YES;
+    
+    // Stop reading as soon as the entry is extracted
+    while (success && !reader.didExtractEntry) {
+        if (progress.isCancelled) {
+            error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+            success = NO;
+            break;
+        }
+        
+        NSInteger length = [input read:buffer.mutableBytes maxLength:buffer.length];
+        
+        if (length < 0) {
+            error = input.streamError;
+            success = NO;
+        } else if (length == 0) {
+            success = [reader finishWithError:&error];
+            break;
+        } else {
+            success = [reader appendBytes:buffer.bytes length:(size_t)length error:&error];
+            progress.completedUnitCount = (int64_t)reader.numberOfBytesRead;
+        }
+    }
+    
+    [input close];
+    
+    if (!success) {
+        [reader cancel];
+        
+        if (outError != NULL) {
+            (*outError) = error;
+        }
+        return nil;
+    }
+    
+    progress.completedUnitCount = progress.totalUnitCount;
+    
+    return reader;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithEntryName:(NSString *)entryName destinationURL:(NSURL *)destinationURL {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _entryName = [_EMTarNormalizedPath(entryName) copy];
+    _destinationURL = [destinationURL copy];
+    _fd = -1;
+    
+    // Decode gzip headers (instead of raw deflate streams)
+    _isStreamInitialized = inflateInit2(&_stream, 16 + MAX_WBITS) == Z_OK;
+    _inflateBuffer = malloc(EMTarballInflateBufferSize);
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self _removePartialFile];
+    
+    if (_isStreamInitialized) {
+        inflateEnd(&_stream);
+    }
+    
+    free(_inflateBuffer);
+}
+
+- (BOOL)appendBytes:(const void *)bytes length:(size_t)length error:(NSError **)outError {
+    _numberOfBytesRead += length;
+    
+    if (_error == nil && !_isStreamInitialized) {
+        _error = _EMTarballCorruptError(@"Could not initialize the decompressor");
+    }
+    
+    if (_error == nil && !_didExtractEntry && !_isArchiveEnded) {
+        [self _inflateBytes:bytes length:length];
+    }
+    
+    if (_error != nil) {
+        [self _removePartialFile];
+        
+        if (outError != NULL) {
+            (*outError) = _error;
+        }
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (BOOL)finishWithError:(NSError **)outError {
+    if (_error == nil && !_didExtractEntry && !_isArchiveEnded) {
+        // Tolerate archives without end-of-archive blocks, so long as neither the stream nor the archive were truncated
+        BOOL isAtEntryBoundary = _headerLength == 0 && _entryRemaining == 0 && _paddingRemaining == 0;
+        
+        if (!_isStreamEnded || !isAtEntryBoundary) {
+            _error = _EMTarballCorruptError(@"Unexpected end of archive");
+        }
+    }
+    
+    [self _removePartialFile];
+    
+    if (_error != nil) {
+        if (outError != NULL) {
+            (*outError) = _error;
+        }
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)cancel {
+    if (_error == nil) {
+        _error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+    }
+    
+    [self _removePartialFile];
+}
+
+#pragma mark - Decompression
+
+- (void)_inflateBytes:(const uint8_t *)bytes length:(size_t)length {
+    while (length > 0 && _error == nil && !_didExtractEntry && !_isArchiveEnded) {
+        uInt chunkLength = (uInt)MIN(length, (size_t)UINT_MAX);
+        
+        _stream.next_in = (Bytef *)bytes;
+        _stream.avail_in = chunkLength;
+        
+        while (_stream.avail_in > 0 && _error == nil && !_didExtractEntry && !_isArchiveEnded) {
+            if (_isStreamEnded) {
+                // Concatenated gzip members are read as a single stream
+                inflateReset(&_stream);
+                _isStreamEnded = NO;
+            }
+            
+            _stream.next_out = _inflateBuffer;
+            _stream.avail_out = EMTarballInflateBufferSize;
+            
+            int status = inflate(&_stream, Z_NO_FLUSH);
+            
+            if (status == Z_STREAM_END) {
+                _isStreamEnded = YES;
+            } else if (status != Z_OK) {
+                _error = _EMTarballCorruptError(_stream.msg ? @(_stream.msg) : @"Invalid compressed data");
+                break;
+            }
+            
+            [self _readTarBytes:_inflateBuffer length:EMTarballInflateBufferSize - _stream.avail_out];
+        }
+        
+        bytes += chunkLength;
+        length -= chunkLength;
+    }
+}
+
+#pragma mark - Archive
+
+- (void)_readTarBytes:(const uint8_t *)bytes length:(size_t)length {
+    while (length > 0 && _error == nil && !_didExtractEntry && !_isArchiveEnded) {
+        size_t count;
+        
+        if (_entryRemaining > 0) {
+            count = (size_t)MIN((uint64_t)length, _entryRemaining);
+            
+            [self _readEntryBytes:bytes length:count];
+            _entryRemaining -= count;
+            
+            if (_entryRemaining == 0 && _error == nil) {
+                [self _finishEntry];
+            }
+        } else if (_paddingRemaining > 0) {
+            count = (size_t)MIN((uint64_t)length, _paddingRemaining);
+            _paddingRemaining -= count;
+        } else {
+            count = MIN(length, EMTarBlockSize - _headerLength);
+            memcpy(_header + _headerLength, bytes, count);
+            _headerLength += count;
+            
+            if (_headerLength == EMTarBlockSize) {
+                _headerLength = 0;
+                [self _readHeader];
+            }
+        }
+        
+        bytes += count;
+        length -= count;
+    }
+}
+
+- (void)_readHeader {
+    // The archive ends with empty blocks (anything following them is ignored)
+    if (_EMTarIsEmptyBlock(_header)) {
+        _isArchiveEnded = YES;
+        return;
+    }
+    
+    uint64_t checksum = 0;
+    uint64_t size = 0;
+    uint64_t mode = 0;
+    
+    if (!_EMTarParseNumber(_header + 148, 8, &checksum) || checksum != _EMTarChecksum(_header)) {
+        _error = _EMTarballCorruptError(@"Invalid header checksum");
+        return;
+    } else if (!_EMTarParseNumber(_header + 124, 12, &size) || !_EMTarParseNumber(_header + 100, 8, &mode)) {
+        _error = _EMTarballCorruptError(@"Invalid header");
+        return;
+    }
+    
+    NSString *path = _nextEntryPath ?: _EMTarHeaderPath(_header);
+    _nextEntryPath = nil;
+    
+    _entryMode = _EMTarEntryModeSkip;
+    _entryRemaining = size;
+    _paddingRemaining = (EMTarBlockSize - (size % EMTarBlockSize)) % EMTarBlockSize;
+    
+    switch (_header[156]) {
+        case 'L':
+        case 'x':
+            if (size > EMTarMaxMetadataSize) {
+                _error = _EMTarballCorruptError(@"Entry metadata is too large");
+                return;
+            }
+            
+            _entryMode = _header[156] == 'L' ? _EMTarEntryModeLongName : _EMTarEntryModePaxHeader;
+            _metadata = [NSMutableData dataWithCapacity:(NSUInteger)size];
+            break;
+        case '0':
+        case '7':
+        case '\0':
+            if ([_EMTarNormalizedPath(path) isEqualToString:_entryName]) {
+                _entryMode = _EMTarEntryModeExtract;
+                _entryPermissions = (mode_t)(mode & 0777);
+                
+                if (![self _openDestinationFile]) {
+                    return;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    
+    if (size == 0) {
+        [self _finishEntry];
+    }
+}
+
+- (void)_readEntryBytes:(const uint8_t *)bytes length:(size_t)length {
+    switch (_entryMode) {
+        case _EMTarEntryModeExtract:
+            while (length > 0) {
+                ssize_t count = write(_fd, bytes, length);
+                
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    
+                    _error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: _destinationURL.path}];
+                    return;
+                }
+                
+                bytes += count;
+                length -= (size_t)count;
+            }
+            break;
+        case _EMTarEntryModeLongName:
+        case _EMTarEntryModePaxHeader:
+            [_metadata appendBytes:bytes length:length];
+            break;
+        case _EMTarEntryModeSkip:
+            break;
+    }
+}
+
+- (void)_finishEntry {
+    switch (_entryMode) {
+        case _EMTarEntryModeExtract:
+            if (fchmod(_fd, _entryPermissions) != 0 || close(_fd) != 0) {
+                _error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: _destinationURL.path}];
+                return;
+            }
+            
+            _fd = -1;
+            _didExtractEntry = YES;
+            break;
+        case _EMTarEntryModeLongName:
+            _nextEntryPath = [[NSString alloc] initWithBytes:_metadata.bytes length:strnlen(_metadata.bytes, _metadata.length) encoding:NSUTF8StringEncoding];
+            break;
+        case _EMTarEntryModePaxHeader:
+            _nextEntryPath = _EMTarPaxPath(_metadata);
+            break;
+        case _EMTarEntryModeSkip:
+            break;
+    }
+    
+    _entryMode = _EMTarEntryModeSkip;
+    _metadata = nil;
+}
+
+#pragma mark - Destination
+
+- (BOOL)_openDestinationFile {
+    _fd = open(_destinationURL.fileSystemRepresentation, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    
+    if (_fd < 0) {
+        _error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: _destinationURL.path}];
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)_removePartialFile {
+    if (_fd >= 0) {
+        close(_fd);
+        unlink(_destinationURL.fileSystemRepresentation);
+        _fd = -1;
+    }
+}
+
+@end
@@ -0,0 +1,54 @@
+//
+//  EMTunnelFilter.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "EMTunnelSnapshot.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A set of filters which tunnel snapshots can be matched against.
+ 
+ Filters are compiled into indexes keyed by id, port, directory path and remote host, so that matching a snapshot costs a few hash
+ lookups regardless of the number of filters (and never requires an Apple Event). Ports are only indexed for local URLs; other URLs are
+ matched by their host. Globs which contain a path separator are matched
+ against directories, and are indexed by their literal parent directory. Other globs are matched against names.
+ 
+ A snapshot matches if it matches any filter. An empty filter matches every snapshot.
+ */
+@interface EMTunnelFilter : NSObject
+
+/*!
+ Add a filter.
+ \param input An id, port, directory, URL or glob (i.e. "~/Sites/blog-*" or "api-*")
+ \returns YES if the input could be parsed.
+ */
+- (BOOL)addFilterWithString:(NSString *)input;
+
+/*! The number of filters */
+@property(nonatomic,readonly) NSUInteger count;
+
+/*! Returns YES if every filter is a tunnel identifier (and there's at least one filter), meaning the set of matching tunnels can only shrink */
+@property(nonatomic,readonly) BOOL isStatic;
+
+/*! The identifiers of tunnels which are matched by id (as they were given, although they're matched case-insensitively) */
+@property(nonatomic,readonly) NSSet<NSString*> *tunnelIdentifiers;
+
+/*! A description of the filters suitable for display (or nil if there are no filters) */
+@property(nonatomic,readonly,nullable) NSString *filterDescription;
+
+/*! Returns YES if the snapshot matches any filter */
+- (BOOL)matchesSnapshot:(nullable EMTunnelSnapshot *)snapshot;
+
+/*! Returns the snapshots which match any filter (in order) */
+- (NSArray<EMTunnelSnapshot*> *)filteredSnapshots:(NSArray<EMTunnelSnapshot*> *)snapshots;
+
+@end
+
+NS_ASSUME_NONNULL_END
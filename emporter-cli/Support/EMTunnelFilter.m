@@ -0,0 +1,243 @@
+//
+//  EMTunnelFilter.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <fnmatch.h>
+
+#import "EMTunnelFilter.h"
+#import "EMUtils.h"
+
+
+static BOOL _EMStringIsGlob(NSString *input) {
+    return [input rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@"*?["]].location != NSNotFound;
+}
+
+static BOOL _EMHostIsLocal(NSString *host) {
+    return host == nil || [@[@"localhost", @"127.0.0.1"] containsObject:host.lowercaseString];
+}
+
+/*! The path of a directory used for matching, without resolving symlinks (which would require touching the file system) */
+static NSString *_EMDirectoryPath(NSURL *url) {
+    NSString *path = (url.isFileReferenceURL ? url.filePathURL : url).path;
+    return path.length > 1 && [path hasSuffix:@"/"] ? [path substringToIndex:path.length - 1] : path;
+}
+
+@implementation EMTunnelFilter {
+    // Identifiers are compared case-insensitively (keyed by their uppercase form), but are kept as they were given for fetching
+    NSMutableDictionary<NSString*,NSString*> *_ids;
+    NSMutableIndexSet *_ports;
+    NSMutableSet<NSString*> *_paths;
+    NSMutableSet<NSString*> *_remoteHosts;
+    
+    // Path globs keyed by the literal directory which precedes the first wildcard
+    NSMutableDictionary<NSString*,NSMutableArray<NSString*>*> *_pathGlobs;
+    NSMutableArray<NSString*> *_nameGlobs;
+    
+    NSMutableArray<NSString*> *_descriptions;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _ids = [NSMutableDictionary dictionary];
+    _ports = [NSMutableIndexSet indexSet];
+    _paths = [NSMutableSet set];
+    _remoteHosts = [NSMutableSet set];
+    _pathGlobs = [NSMutableDictionary dictionary];
+    _nameGlobs = [NSMutableArray array];
+    _descriptions = [NSMutableArray array];
+    
+    return self;
+}
+
+- (NSSet<NSString *> *)tunnelIdentifiers {
+    return [NSSet setWithArray:_ids.allValues];
+}
+
+- (BOOL)isStatic {
+    return _count > 0 && _count == _ids.count;
+}
+
+- (NSString *)filterDescription {
+    return _descriptions.count > 0 ? [_descriptions componentsJoinedByString:@", "] : nil;
+}
+
+#pragma mark - Compiling
+
+- (BOOL)addFilterWithString:(NSString *)input {
+    if (input.length == 0) {
+        return NO;
+    } else if (_EMStringIsGlob(input)) {
+        return [self _addGlob:input];
+    }
+    
+    EMSourceType type = EMSourceTypeGuess(input);
+    NSURL *url = EMSourceURLFromString(input, type);
+    
+    switch (type) {
+        case EMSourceTypeID:
+            _ids[input.uppercaseString] = input;
+            break;
+        case EMSourceTypePort:
+            [_ports addIndex:(NSUInteger)[input integerValue]];
+            break;
+        case EMSourceTypeDirectory:
+            if (url == nil) {
+                return NO;
+            }
+            
+            [_paths addObject:_EMDirectoryPath(url)];
+            break;
+        case EMSourceTypeURL:
+            if (url == nil) {
+                return NO;
+            } else if (_EMHostIsLocal(url.host)) {
+                [_ports addIndex:url.port ? url.port.unsignedIntegerValue : ([url.scheme isEqualToString:@"https"] ? 443 : 80)];
+            } else {
+                [_remoteHosts addObject:url.host.lowercaseString];
+            }
+            break;
+        default:
+            return NO;
+    }
+    
+    _count++;
+    [_descriptions addObject:EMSourceTypeDescriptionFromString(type, input)];
+    
+    return YES;
+}
+
+- (BOOL)_addGlob:(NSString *)pattern {
+    if ([pattern containsString:@"/"]) {
+        NSString *cwd = [[NSFileManager defaultManager] currentDirectoryPath];
+        
+        pattern = [pattern stringByExpandingTildeInPath];
+        if (![pattern isAbsolutePath]) {
+            pattern = [cwd stringByAppendingPathComponent:pattern];
+        }
+        
+        // Index by the directory which precedes the first wildcard
+        NSUInteger wildcardIndex = [pattern rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@"*?["]].location;
+        NSString *literalPrefix = [pattern substringToIndex:wildcardIndex];
+        NSString *key = [literalPrefix substringToIndex:[literalPrefix rangeOfString:@"/" options:NSBackwardsSearch].location];
+        
+        NSMutableArray *patterns = _pathGlobs[key];
+        if (patterns == nil) {
+            patterns = _pathGlobs[key] = [NSMutableArray array];
+        }
+        
+        [patterns addObject:pattern];
+        [_descriptions addObject:[pattern stringByAbbreviatingWithTildeInPath]];
+    } else {
+        [_nameGlobs addObject:pattern];
+        [_descriptions addObject:pattern];
+    }
+    
+    _count++;
+    
+    return YES;
+}
+
+#pragma mark - Matching
+
+- (BOOL)matchesSnapshot:(EMTunnelSnapshot *)snapshot {
+    if (snapshot == nil) {
+        return NO;
+    } else if (_count == 0) {
+        return YES;
+    }
+    
+    if (_ids.count > 0 && snapshot.id != nil && _ids[snapshot.id.uppercaseString] != nil) {
+        return YES;
+    }
+    
+    switch (snapshot.kind) {
+        case EmporterTunnelKindProxy:
+            if (snapshot.proxyPort != nil && [_ports containsIndex:snapshot.proxyPort.unsignedIntegerValue]) {
+                return YES;
+            }
+            break;
+        case EmporterTunnelKindDirectory:
+            if (snapshot.directory != nil && (_paths.count > 0 || _pathGlobs.count > 0)) {
+                NSString *path = _EMDirectoryPath(snapshot.directory);
+                
+                if ([_paths containsObject:path] || [self _pathMatchesGlob:path]) {
+                    return YES;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    
+    if (_remoteHosts.count > 0 && snapshot.remoteUrl != nil) {
+        NSString *host = [NSURL URLWithString:snapshot.remoteUrl].host.lowercaseString;
+        
+        if (host != nil && [_remoteHosts containsObject:host]) {
+            return YES;
+        }
+    }
+    
+    if (_nameGlobs.count > 0 && snapshot.name != nil) {
+        const char *name = snapshot.name.UTF8String;
+        
+        for (NSString *pattern in _nameGlobs) {
+            if (fnmatch(pattern.UTF8String, name, FNM_CASEFOLD) == 0) {
+                return YES;
+            }
+        }
+    }
+    
+    return NO;
+}
+
+- (BOOL)_pathMatchesGlob:(NSString *)path {
+    if (_pathGlobs.count == 0) {
+        return NO;
+    }
+    
+    const char *cPath = path.fileSystemRepresentation;
+    NSRange searchRange = NSMakeRange(0, path.length);
+    
+    // Only evaluate globs indexed by one of the path's ancestors
+    while (YES) {
+        NSUInteger separatorIndex = [path rangeOfString:@"/" options:0 range:searchRange].location;
+        NSString *ancestor = [path substringToIndex:(separatorIndex == NSNotFound ? path.length : separatorIndex)];
+        
+        for (NSString *pattern in _pathGlobs[ancestor]) {
+            if (fnmatch(pattern.fileSystemRepresentation, cPath, FNM_PATHNAME) == 0) {
+                return YES;
+            }
+        }
+        
+        if (separatorIndex == NSNotFound) {
+            return NO;
+        }
+        
+        searchRange = NSMakeRange(separatorIndex + 1, path.length - separatorIndex - 1);
+    }
+}
+
+- (NSArray<EMTunnelSnapshot *> *)filteredSnapshots:(NSArray<EMTunnelSnapshot *> *)snapshots {
+    if (_count == 0) {
+        return snapshots;
+    }
+    
+    NSMutableArray *filteredSnapshots = [NSMutableArray arrayWithCapacity:snapshots.count];
+    
+    for (EMTunnelSnapshot *snapshot in snapshots) {
+        if ([self matchesSnapshot:snapshot]) {
+            [filteredSnapshots addObject:snapshot];
+        }
+    }
+    
+    return filteredSnapshots;
+}
+
+@end
@@ -0,0 +1,51 @@
+//
+//  EMTunnelListView.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "YDCommandOutput.h"
+#import "EMTunnelSnapshot.h"
+#import "EMUpstreamProber.h"
+#import "EMWindow.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A scrollable list of tunnels, written in the same format as `emporter list`.
+
+ Rows are retained by tunnel id and only formatted again when a tunnel's snapshot changes. Only the rows which fit within the viewport
+ are written (below a header which stays in place while scrolling), so the cost of writing the list depends on its height rather than
+ the number of tunnels.
+ */
+@interface EMTunnelListView : NSObject
+
+/*! The tunnels in the list, in order */
+@property(nonatomic,copy) NSArray<EMTunnelSnapshot*> *tunnels;
+
+/*! The statistics of each tunnel's upstream, keyed by tunnel id, which are written in a column after the URL when present */
+@property(nonatomic,copy) NSDictionary<NSString*,EMUpstreamStatistics*> *upstreamStatistics;
+
+/*! The index of the first visible tunnel, which is clamped to the last page when written */
+@property(nonatomic) NSUInteger scrollOffset;
+
+/*!
+ Scroll in response to a key press, using the page size of the most recent write.
+ \returns True if the scroll offset changed.
+ */
+- (BOOL)scrollWithKey:(EMWindowKey)key;
+
+/*!
+ Write the header, the visible rows and any notes about the service.
+ \param output          The output to write to
+ \param numberOfLines   The maximum number of lines to write, or 0 to write every row
+ */
+- (void)writeToOutput:(id <YDCommandOutputWriter>)output numberOfLines:(NSUInteger)numberOfLines;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,360 @@
+//
+//  EMTunnelListView.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import "EMDisplayWidth.h"
+#import "EMTunnelListView.h"
+#import "EMUtils.h"
+
+
+/*! A formatted row, which is reused for as long as the snapshot of its tunnel is unchanged */
+@interface _EMTunnelListRow : NSObject
+- (instancetype)initWithSnapshot:(EMTunnelSnapshot *)snapshot;
+
+@property(nonatomic,readonly) EMTunnelSnapshot *snapshot;
+@property(nonatomic,readonly) NSString *stateDescription;
+@property(nonatomic,readonly) YDCommandOutputStyle stateStyle;
+@property(nonatomic,readonly) NSString *source;
+@property(nonatomic,readonly) NSString *detail;
+@property(nonatomic,readonly) YDCommandOutputStyle detailStyle;
+@property(nonatomic,readonly) BOOL isPartial;
+@property(nonatomic,readonly) BOOL isAtCapacity;
+
+/*! The number of terminal columns used to display each cell (the state is measured with its surrounding spaces) */
+@property(nonatomic,readonly) NSUInteger stateWidth;
+@property(nonatomic,readonly) NSUInteger sourceWidth;
+@property(nonatomic,readonly) NSUInteger detailWidth;
+@end
+
+
+static NSString *const _EMTunnelListSourceHeader = @"      SOURCE";
+static NSString *const _EMTunnelListDetailHeader = @"URL";
+static NSString *const _EMTunnelListUpstreamHeader = @"UPSTREAM";
+
+/*! The number of spaces between columns */
+static const NSUInteger _EMTunnelListColumnSpacing = 5;
+
+static NSString *_EMTunnelListPadding(NSUInteger length) {
+    return [@"" stringByPaddingToLength:length withString:@" " startingAtIndex:0];
+}
+
+/*! Describe an upstream's latencies (connect / first byte) or why it's unreachable, followed by the number of failed probes */
+static NSString *_EMTunnelListUpstreamDescription(EMUpstreamStatistics *statistics) {
+    NSString *description = nil;
+    
+    if (statistics.isReachable) {
+        description = [NSString stringWithFormat:@"%.1f / %.1f ms", statistics.connectLatency * 1000, statistics.firstByteLatency * 1000];
+    } else {
+        description = statistics.failureReason ?: @"unknown";
+    }
+    
+    if (statistics.numberOfFailures > 0) {
+        description = [description stringByAppendingFormat:@"  (%lu failed)", (unsigned long)statistics.numberOfFailures];
+    }
+    
+    return description;
+}
+
+@implementation EMTunnelListView {
+    NSArray<_EMTunnelListRow*> *_rows;
+    NSDictionary<NSString*,_EMTunnelListRow*> *_rowsByIdentifier;
+    
+    // Cells are padded to the widest cell of any row (not only visible rows), so that columns don't shift while scrolling.
+    // Widths are measured in terminal columns, so that wide characters (i.e. CJK directory names) don't misalign rows.
+    NSUInteger _stateWidth;
+    NSUInteger _sourceWidth;
+    NSUInteger _detailWidth;
+    
+    // Upstream descriptions are keyed by tunnel id. The column is only written when a tunnel in the list has statistics.
+    // Their widths are measured once, when they're formatted, and the widest of any row is kept for drawing.
+    NSDictionary<NSString*,NSString*> *_upstreamDescriptions;
+    NSDictionary<NSString*,NSNumber*> *_upstreamDescriptionWidths;
+    NSDictionary<NSString*,EMUpstreamStatistics*> *_upstreamStatisticsForDescriptions;
+    NSUInteger _upstreamWidth;
+    
+    BOOL _isServicePartial;
+    BOOL _didHitServiceLimits;
+    
+    NSUInteger _pageSize;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _tunnels = @[];
+    _rows = @[];
+    _rowsByIdentifier = @{};
+    _upstreamStatistics = @{};
+    _upstreamDescriptions = @{};
+    _upstreamDescriptionWidths = @{};
+    _pageSize = 1;
+    
+    return self;
+}
+
+- (void)setTunnels:(NSArray<EMTunnelSnapshot *> *)tunnels {
+    _tunnels = [tunnels copy];
+    
+    NSMutableArray<_EMTunnelListRow*> *rows = [NSMutableArray arrayWithCapacity:_tunnels.count];
+    NSMutableDictionary<NSString*,_EMTunnelListRow*> *rowsByIdentifier = [NSMutableDictionary dictionaryWithCapacity:_tunnels.count];
+    
+    _stateWidth = 0;
+    _sourceWidth = 0;
+    _detailWidth = 0;
+    _isServicePartial = NO;
+    _didHitServiceLimits = NO;
+    
+    for (EMTunnelSnapshot *tunnel in _tunnels) {
+        _EMTunnelListRow *row = tunnel.id != nil ? _rowsByIdentifier[tunnel.id] : nil;
+        
+        if (row == nil || (row.snapshot != tunnel && ![row.snapshot isEqual:tunnel])) {
+            row = [[_EMTunnelListRow alloc] initWithSnapshot:tunnel];
+        }
+        
+        if (tunnel.id != nil) {
+            rowsByIdentifier[tunnel.id] = row;
+        }
+        
+        [rows addObject:row];
+        
+        _stateWidth = MAX(_stateWidth, row.stateWidth);
+        _sourceWidth = MAX(_sourceWidth, row.sourceWidth);
+        _detailWidth = MAX(_detailWidth, row.detailWidth);
+        
+        // Partial URLs are only noted until the service's limits are hit, which takes precedence
+        _isServicePartial = _isServicePartial || (!_didHitServiceLimits && row.isPartial);
+        _didHitServiceLimits = _didHitServiceLimits || row.isAtCapacity;
+    }
+    
+    _rows = rows;
+    _rowsByIdentifier = rowsByIdentifier;
+    
+    [self _updateUpstreamWidth];
+}
+
+- (void)setUpstreamStatistics:(NSDictionary<NSString *,EMUpstreamStatistics *> *)upstreamStatistics {
+    _upstreamStatistics = [upstreamStatistics copy] ?: @{};
+    
+    // Descriptions are only formatted again for statistics which changed
+    NSMutableDictionary<NSString*,NSString*> *descriptions = [NSMutableDictionary dictionaryWithCapacity:_upstreamStatistics.count];
+    NSMutableDictionary<NSString*,NSNumber*> *widths = [NSMutableDictionary dictionaryWithCapacity:_upstreamStatistics.count];
+    
+    [_upstreamStatistics enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, EMUpstreamStatistics *statistics, BOOL *stop) {
+        if (self->_upstreamStatisticsForDescriptions[identifier] == statistics && self->_upstreamDescriptions[identifier] != nil) {
+            descriptions[identifier] = self->_upstreamDescriptions[identifier];
+            widths[identifier] = self->_upstreamDescriptionWidths[identifier];
+        } else {
+            NSString *description = _EMTunnelListUpstreamDescription(statistics);
+            descriptions[identifier] = description;
+            widths[identifier] = @(EMDisplayWidth(description));
+        }
+    }];
+    
+    _upstreamStatisticsForDescriptions = _upstreamStatistics;
+    _upstreamDescriptions = descriptions;
+    _upstreamDescriptionWidths = widths;
+    
+    [self _updateUpstreamWidth];
+}
+
+- (void)_updateUpstreamWidth {
+    // Upstreams are padded to the widest description of any row, like other cells
+    _upstreamWidth = 0;
+    
+    for (_EMTunnelListRow *row in _rows) {
+        NSNumber *width = row.snapshot.id != nil ? _upstreamDescriptionWidths[row.snapshot.id] : nil;
+        _upstreamWidth = MAX(_upstreamWidth, width.unsignedIntegerValue);
+    }
+}
+
+- (BOOL)scrollWithKey:(EMWindowKey)key {
+    NSUInteger maximumOffset = _rows.count > _pageSize ? _rows.count - _pageSize : 0;
+    NSUInteger offset = MIN(_scrollOffset, maximumOffset);
+    
+    switch (key) {
+        case EMWindowKeyUp:
+            offset = offset > 0 ? offset - 1 : 0;
+            break;
+        case EMWindowKeyDown:
+            offset = MIN(offset + 1, maximumOffset);
+            break;
+        case EMWindowKeyPageUp:
+            offset = offset > _pageSize ? offset - _pageSize : 0;
+            break;
+        case EMWindowKeyPageDown:
+            offset = MIN(offset + _pageSize, maximumOffset);
+            break;
+        case EMWindowKeyHome:
+            offset = 0;
+            break;
+        case EMWindowKeyEnd:
+            offset = maximumOffset;
+            break;
+    }
+    
+    if (offset == _scrollOffset) {
+        return NO;
+    }
+    
+    _scrollOffset = offset;
+    return YES;
+}
+
+- (void)writeToOutput:(id<YDCommandOutputWriter>)output numberOfLines:(NSUInteger)numberOfLines {
+    BOOL hasMarkers = _isServicePartial || _didHitServiceLimits;
+    NSUInteger numberOfNoteLines = hasMarkers ? (1 + (_isServicePartial ? 3 : 0) + (_didHitServiceLimits ? 1 : 0)) : 0;
+    
+    // Rows which don't fit are replaced by a line describing which rows are visible. Notes are dropped before rows are.
+    NSUInteger numberOfVisibleRows = _rows.count;
+    BOOL isScrollable = numberOfLines > 0 && (1 + _rows.count + numberOfNoteLines) > numberOfLines;
+    
+    if (isScrollable) {
+        NSUInteger availableLines = numberOfLines > 2 ? numberOfLines - 2 : 0;
+        
+        if (availableLines <= numberOfNoteLines) {
+            numberOfNoteLines = 0;
+        }
+        
+        numberOfVisibleRows = MAX(availableLines - numberOfNoteLines, 1);
+    }
+    
+    _pageSize = numberOfVisibleRows;
+    _scrollOffset = MIN(_scrollOffset, _rows.count - MIN(numberOfVisibleRows, _rows.count));
+    
+    NSArray<_EMTunnelListRow*> *visibleRows = [_rows subarrayWithRange:NSMakeRange(_scrollOffset, MIN(numberOfVisibleRows, _rows.count - _scrollOffset))];
+    
+    BOOL hasUpstreams = _upstreamWidth > 0;
+    
+    // The first column contains each row's state and source (padded so that sources line up), followed by the URL column
+    NSUInteger sourceColumnWidth = MAX(EMDisplayWidth(_EMTunnelListSourceHeader), 1 + _stateWidth + 2 + _sourceWidth) + _EMTunnelListColumnSpacing;
+    NSUInteger detailColumnWidth = MAX(EMDisplayWidth(_EMTunnelListDetailHeader), _detailWidth) + _EMTunnelListColumnSpacing;
+    NSUInteger upstreamColumnWidth = MAX(EMDisplayWidth(_EMTunnelListUpstreamHeader), _upstreamWidth) + _EMTunnelListColumnSpacing;
+    
+    [output appendString:_EMTunnelListSourceHeader];
+    [output appendString:_EMTunnelListPadding(sourceColumnWidth - EMDisplayWidth(_EMTunnelListSourceHeader))];
+    [output appendString:_EMTunnelListDetailHeader];
+    
+    if (hasUpstreams || hasMarkers) {
+        [output appendString:_EMTunnelListPadding(detailColumnWidth - EMDisplayWidth(_EMTunnelListDetailHeader))];
+    }
+    
+    if (hasUpstreams) {
+        [output appendString:_EMTunnelListUpstreamHeader];
+        
+        if (hasMarkers) {
+            [output appendString:_EMTunnelListPadding(upstreamColumnWidth - EMDisplayWidth(_EMTunnelListUpstreamHeader))];
+        }
+    }
+    
+    [output appendString:@"\n"];
+    
+    for (_EMTunnelListRow *row in visibleRows) {
+        [output appendString:@" "];
+        [output applyStyle:row.stateStyle withinBlock:^(id<YDCommandOutputWriter> output) {
+            [output appendFormat:@" %@ ", row.stateDescription];
+        }];
+        [output appendString:_EMTunnelListPadding(self->_stateWidth - row.stateWidth + 2)];
+        
+        [output appendString:row.source];
+        [output appendString:_EMTunnelListPadding(sourceColumnWidth - (1 + self->_stateWidth + 2 + row.sourceWidth))];
+        
+        [output applyStyle:row.detailStyle withinBlock:^(id<YDCommandOutputWriter> output) {
+            [output appendString:row.detail];
+        }];
+        
+        if (hasUpstreams || hasMarkers) {
+            [output appendString:_EMTunnelListPadding(detailColumnWidth - row.detailWidth)];
+        }
+        
+        if (hasUpstreams) {
+            EMUpstreamStatistics *statistics = row.snapshot.id != nil ? self->_upstreamStatistics[row.snapshot.id] : nil;
+            NSString *upstream = row.snapshot.id != nil ? self->_upstreamDescriptions[row.snapshot.id] : nil;
+            NSUInteger upstreamWidth = row.snapshot.id != nil ? self->_upstreamDescriptionWidths[row.snapshot.id].unsignedIntegerValue : 0;
+            
+            // Unreachable upstreams stand out, as requests to their URLs will fail
+            YDCommandOutputStyle upstreamStyle = (statistics != nil && !statistics.isReachable) ? YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeBold) : 0;
+            
+            [output applyStyle:upstreamStyle withinBlock:^(id<YDCommandOutputWriter> output) {
+                [output appendString:upstream ?: @""];
+            }];
+            
+            if (hasMarkers) {
+                [output appendString:_EMTunnelListPadding(upstreamColumnWidth - upstreamWidth)];
+            }
+        }
+        
+        if (hasMarkers) {
+            if (row.isPartial) {
+                [output appendString:@"*"];
+            } else if (row.isAtCapacity) {
+                [output appendString:@"**"];
+            }
+        }
+        
+        [output appendString:@"\n"];
+    }
+    
+    if (isScrollable) {
+        [output appendFormat:@"  %lu-%lu of %lu URLs (use ↑/↓ or page up/down to scroll)\n", _scrollOffset + 1, _scrollOffset + visibleRows.count, _rows.count];
+    }
+    
+    if (numberOfNoteLines > 0) {
+        [output appendString:@"\n"];
+        
+        if (_isServicePartial) {
+            [output appendString:@" *  Paid subscriptions are required to reserve URL names.\n"];
+        }
+        
+        if (_didHitServiceLimits) {
+            [output appendString:@" ** Too many URLs are active.\n"];
+        }
+        
+        if (_isServicePartial) {
+            [output appendString:@"\nPurchase a subscription within the app for custom names, faster speeds, and more URLs.\n"];
+        }
+    }
+}
+
+@end
+
+
+@implementation _EMTunnelListRow
+
+- (instancetype)initWithSnapshot:(EMTunnelSnapshot *)snapshot {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _snapshot = snapshot;
+    
+    YDCommandOutputStyle stateStyle = 0;
+    _stateDescription = EMTunnelStateDescription(snapshot, YES, &stateStyle);
+    _stateStyle = stateStyle;
+    
+    _source = EMTunnelSourceDescription(snapshot);
+    
+    NSString *remoteURL = snapshot.remoteUrl;
+    _isPartial = remoteURL != nil && ![remoteURL localizedCaseInsensitiveContainsString:snapshot.name ?: @""];
+    _isAtCapacity = [(snapshot.conflictReason ?: @"") containsString:@"Too many"];
+    
+    if (snapshot.state == EmporterTunnelStateConflicted && !_isAtCapacity) {
+        _detail = snapshot.conflictReason ?: @"";
+    } else {
+        _detail = remoteURL ?: @"";
+        _detailStyle = YDCommandOutputStyleWithAttribute(YDCommandOutputStyleAttributeUnderline);
+    }
+    
+    _stateWidth = EMDisplayWidth(_stateDescription) + 2;
+    _sourceWidth = EMDisplayWidth(_source);
+    _detailWidth = EMDisplayWidth(_detail);
+    
+    return self;
+}
+
+@end
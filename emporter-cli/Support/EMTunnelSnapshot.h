@@ -0,0 +1,104 @@
+//
+//  EMTunnelSnapshot.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "Emporter.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ An immutable record of a tunnel's properties at a point in time.
+ 
+ Reading properties from \c EmporterTunnel requires an Apple Event per property, whereas snapshots are plain values which can be
+ read (and compared) for free. Property names mirror \c EmporterTunnel so that tunnel predicates can be evaluated against snapshots.
+ */
+@interface EMTunnelSnapshot : NSObject <NSCopying>
+
+/*!
+ The designated initializer.
+ 
+ \param values  Property values keyed by property name (i.e. "state" or "remoteUrl"). Missing values (or \c NSNull) are treated as nil.
+ 
+ \returns A new instance of \c EMTunnelSnapshot.
+ */
+- (instancetype)initWithValues:(NSDictionary<NSString*,id> *)values NS_DESIGNATED_INITIALIZER;
+
+/*! Create a snapshot by reading every property of a tunnel */
+- (instancetype)initWithTunnel:(EmporterTunnel *)tunnel;
+
+/*! Create a snapshot by reading a subset of a tunnel's properties. Properties which aren't read are nil. */
+- (instancetype)initWithTunnel:(EmporterTunnel *)tunnel keys:(NSArray<NSString*> *)keys;
+
+/*!
+ Create snapshots for an array of tunnels by prefetching each property for every tunnel at once.
+
+ When \c tunnels is an \c SBElementArray (or otherwise responds to \c arrayByApplyingSelector:), each property is fetched for all
+ tunnels using a single request, so the cost is proportional to the number of keys rather than the number of tunnels × keys. Other
+ arrays fall back to reading each tunnel individually.
+
+ \param tunnels    The tunnels to snapshot
+ \param keys       The keys of properties to fetch. Properties which aren't fetched are nil.
+
+ \returns Snapshots in the same order as \c tunnels.
+ */
++ (NSArray<EMTunnelSnapshot*> *)snapshotsOfTunnels:(NSArray<EmporterTunnel*> *)tunnels keys:(NSArray<NSString*> *)keys;
+
+/*! Create snapshots for an array of tunnels by prefetching every property */
++ (NSArray<EMTunnelSnapshot*> *)snapshotsOfTunnels:(NSArray<EmporterTunnel*> *)tunnels;
+
+/*! Create a new snapshot by replacing property values of the receiver */
+- (EMTunnelSnapshot *)snapshotByApplyingValues:(NSDictionary<NSString*,id> *)values;
+
+/*! The keys of every property in a snapshot */
+@property(class,nonatomic,readonly) NSArray<NSString*> *allKeys;
+
+/*! The keys of properties which describe a tunnel's state (state, remoteUrl and conflictReason) */
+@property(class,nonatomic,readonly) NSArray<NSString*> *stateKeys;
+
+/*! The property values of the snapshot, using \c NSNull for nil values */
+@property(nonatomic,readonly) NSDictionary<NSString*,id> *values;
+
+@property(nonatomic,readonly,nullable) NSString *id;
+@property(nonatomic,readonly,nullable) NSString *name;
+@property(nonatomic,readonly,nullable) NSString *remoteUrl;
+@property(nonatomic,readonly) EmporterTunnelState state;
+@property(nonatomic,readonly,nullable) NSString *conflictReason;
+@property(nonatomic,readonly) BOOL isEnabled;
+@property(nonatomic,readonly) BOOL isAuthEnabled;
+@property(nonatomic,readonly) EmporterTunnelKind kind;
+@property(nonatomic,readonly,nullable) NSNumber *proxyPort;
+@property(nonatomic,readonly,nullable) NSString *proxyHostHeader;
+@property(nonatomic,readonly) BOOL shouldRewriteHostHeader;
+@property(nonatomic,readonly,nullable) NSURL *directory;
+@property(nonatomic,readonly,nullable) NSString *directoryIndexFile;
+@property(nonatomic,readonly) BOOL isBrowsingEnabled;
+@property(nonatomic,readonly) BOOL isLiveReloadEnabled;
+
+@end
+
+
+/*! A source of tunnel snapshots (i.e. Emporter, or a mock backend used for testing) */
+@protocol EMTunnelSnapshotSource <NSObject>
+
+/*! Fetch snapshots of all tunnels */
+- (NSArray<EMTunnelSnapshot*> *)fetchTunnelSnapshots;
+
+/*! Fetch a snapshot of a single tunnel, or nil if it doesn't exist */
+- (nullable EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier;
+
+/*! Fetch a subset of a tunnel's property values, or nil if it doesn't exist */
+- (nullable NSDictionary<NSString*,id> *)fetchValuesForKeys:(NSArray<NSString*> *)keys ofTunnelWithIdentifier:(NSString *)identifier;
+
+@end
+
+
+@interface Emporter (EMTunnelSnapshotSource) <EMTunnelSnapshotSource>
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,289 @@
+//
+//  EMTunnelSnapshot.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <ScriptingBridge/ScriptingBridge.h>
+
+#import "EMTunnelSnapshot.h"
+
+#define VALUE_OR_NIL(v)         (v == [NSNull null] ? nil : v)
+#define CLASS_OR_NIL(v, k)      (v != nil && [v isKindOfClass:[k class]] ? v : nil)
+
+
+/*! Read a single property from a tunnel for use within a snapshot */
+static id _EMTunnelSnapshotValueForKey(EmporterTunnel *tunnel, NSString *key) {
+    id value = nil;
+    
+    if ([key isEqualToString:@"name"]) {
+        // EmporterKit doesn't send the right AppleEvent to get the tunnel name (a ScriptingBridge.framework bug)
+        value = (tunnel.properties ?: @{})[@"name"] ?: tunnel.name;
+    } else if ([key isEqualToString:@"directory"]) {
+        value = tunnel.directory;
+        
+        if (value == nil) {
+            NSString *directoryPath = CLASS_OR_NIL(tunnel.properties[@"directoryPath"], NSString);
+            value = directoryPath ? [NSURL fileURLWithPath:directoryPath] : nil;
+        }
+    } else {
+        value = [tunnel valueForKey:key];
+    }
+    
+    return value ?: [NSNull null];
+}
+
+/*! Unwrap values which ScriptingBridge returns as raw Apple Event descriptors (i.e. enumerations and missing values) */
+static id _EMTunnelNormalizedValue(id value) {
+    if (![value isKindOfClass:[NSAppleEventDescriptor class]]) {
+        return value ?: [NSNull null];
+    }
+    
+    NSAppleEventDescriptor *descriptor = value;
+    
+    switch (descriptor.descriptorType) {
+        case typeNull:
+        case 'msng':
+            return [NSNull null];
+        case typeEnumerated:
+        case typeType:
+            return @(descriptor.enumCodeValue);
+        case typeTrue:
+        case typeFalse:
+        case typeBoolean:
+            return @(descriptor.booleanValue);
+        case typeSInt32:
+        case typeSInt16:
+            return @(descriptor.int32Value);
+        default:
+            return descriptor.stringValue ?: [NSNull null];
+    }
+}
+
+/*!
+ Fetch property values for every tunnel in an array using a single request per key, or nil if the array doesn't support batched
+ requests (or if tunnels were added or removed between requests).
+ */
+static NSArray<NSDictionary*> *_EMTunnelPrefetchValuesForKeys(NSArray<EmporterTunnel*> *tunnels, NSArray<NSString*> *keys) {
+    if (![tunnels respondsToSelector:@selector(arrayByApplyingSelector:)]) {
+        return nil;
+    }
+    
+    SBElementArray *elements = (SBElementArray *)tunnels;
+    NSArray *(^fetchValues)(NSString *) = ^NSArray *(NSString *key) {
+        return [elements arrayByApplyingSelector:NSSelectorFromString(key)];
+    };
+    
+    // Tunnel ids determine the number of tunnels; all other requests must match
+    NSArray *identifiers = fetchValues(@"id");
+    NSUInteger count = identifiers.count;
+    
+    NSMutableArray<NSMutableDictionary*> *valuesByTunnel = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [valuesByTunnel addObject:[NSMutableDictionary dictionaryWithObject:_EMTunnelNormalizedValue(identifiers[i]) forKey:@"id"]];
+    }
+    
+    // Tunnel names and directory paths are more reliable within the properties record (see _EMTunnelSnapshotValueForKey)
+    __block NSArray *properties = nil;
+    NSArray *(^fetchProperties)(void) = ^NSArray *{
+        if (properties == nil) {
+            properties = fetchValues(@"properties") ?: @[];
+        }
+        return properties;
+    };
+    
+    for (NSString *key in keys) {
+        if ([key isEqualToString:@"id"]) {
+            continue;
+        }
+        
+        NSArray *values = fetchValues(key);
+        NSArray *fallbackValues = nil;
+        
+        if ([key isEqualToString:@"name"] || [key isEqualToString:@"directory"]) {
+            fallbackValues = fetchProperties();
+        }
+        
+        if (values.count != count || (fallbackValues != nil && fallbackValues.count != count)) {
+            return nil;
+        }
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            id value = _EMTunnelNormalizedValue(values[i]);
+            NSDictionary *record = CLASS_OR_NIL(fallbackValues[i], NSDictionary);
+            
+            if ([key isEqualToString:@"name"]) {
+                value = record[@"name"] ?: value;
+            } else if ([key isEqualToString:@"directory"] && value == [NSNull null]) {
+                NSString *directoryPath = CLASS_OR_NIL(record[@"directoryPath"], NSString);
+                value = directoryPath ? [NSURL fileURLWithPath:directoryPath] : value;
+            }
+            
+            valuesByTunnel[i][key] = value;
+        }
+    }
+    
+    return valuesByTunnel;
+}
+
+
+@implementation EMTunnelSnapshot
+
++ (NSArray<NSString *> *)allKeys {
+    static NSArray *allKeys = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        allKeys = @[@"id", @"name", @"remoteUrl", @"state", @"conflictReason", @"isEnabled", @"isAuthEnabled", @"kind",
+                    @"proxyPort", @"proxyHostHeader", @"shouldRewriteHostHeader",
+                    @"directory", @"directoryIndexFile", @"isBrowsingEnabled", @"isLiveReloadEnabled"];
+    });
+    
+    return allKeys;
+}
+
++ (NSArray<NSString *> *)stateKeys {
+    return @[@"state", @"remoteUrl", @"conflictReason"];
+}
+
++ (NSArray<EMTunnelSnapshot *> *)snapshotsOfTunnels:(NSArray<EmporterTunnel *> *)tunnels {
+    return [self snapshotsOfTunnels:tunnels keys:EMTunnelSnapshot.allKeys];
+}
+
++ (NSArray<EMTunnelSnapshot *> *)snapshotsOfTunnels:(NSArray<EmporterTunnel *> *)tunnels keys:(NSArray<NSString *> *)keys {
+    NSArray<NSDictionary*> *prefetchedValues = _EMTunnelPrefetchValuesForKeys(tunnels, keys);
+    NSMutableArray *snapshots = [NSMutableArray arrayWithCapacity:tunnels.count];
+    
+    if (prefetchedValues != nil) {
+        for (NSDictionary *values in prefetchedValues) {
+            [snapshots addObject:[[EMTunnelSnapshot alloc] initWithValues:values]];
+        }
+    } else {
+        for (EmporterTunnel *tunnel in tunnels) {
+            [snapshots addObject:[[EMTunnelSnapshot alloc] initWithTunnel:tunnel keys:keys]];
+        }
+    }
+    
+    return snapshots;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithValues:(NSDictionary<NSString *,id> *)values {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    NSMutableDictionary *allValues = [NSMutableDictionary dictionaryWithCapacity:EMTunnelSnapshot.allKeys.count];
+    
+    for (NSString *key in EMTunnelSnapshot.allKeys) {
+        allValues[key] = values[key] ?: [NSNull null];
+    }
+    
+    _values = [allValues copy];
+    
+    return self;
+}
+
+- (instancetype)initWithTunnel:(EmporterTunnel *)tunnel {
+    return [self initWithTunnel:tunnel keys:EMTunnelSnapshot.allKeys];
+}
+
+- (instancetype)initWithTunnel:(EmporterTunnel *)tunnel keys:(NSArray<NSString *> *)keys {
+    NSMutableDictionary *values = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    
+    for (NSString *key in keys) {
+        values[key] = _EMTunnelSnapshotValueForKey(tunnel, key);
+    }
+    
+    return [self initWithValues:values];
+}
+
+- (EMTunnelSnapshot *)snapshotByApplyingValues:(NSDictionary<NSString *,id> *)values {
+    NSMutableDictionary *newValues = [_values mutableCopy];
+    [newValues addEntriesFromDictionary:values];
+    return [[EMTunnelSnapshot alloc] initWithValues:newValues];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+#pragma mark - Properties
+
+- (NSString *)id                    { return CLASS_OR_NIL(_values[@"id"], NSString); }
+- (NSString *)name                  { return CLASS_OR_NIL(_values[@"name"], NSString); }
+- (NSString *)remoteUrl             { return CLASS_OR_NIL(_values[@"remoteUrl"], NSString); }
+- (EmporterTunnelState)state        { return [CLASS_OR_NIL(_values[@"state"], NSNumber) unsignedIntValue]; }
+- (NSString *)conflictReason        { return CLASS_OR_NIL(_values[@"conflictReason"], NSString); }
+- (BOOL)isEnabled                   { return [CLASS_OR_NIL(_values[@"isEnabled"], NSNumber) boolValue]; }
+- (BOOL)isAuthEnabled               { return [CLASS_OR_NIL(_values[@"isAuthEnabled"], NSNumber) boolValue]; }
+- (EmporterTunnelKind)kind          { return [CLASS_OR_NIL(_values[@"kind"], NSNumber) unsignedIntValue]; }
+- (NSNumber *)proxyPort             { return CLASS_OR_NIL(_values[@"proxyPort"], NSNumber); }
+- (NSString *)proxyHostHeader       { return CLASS_OR_NIL(_values[@"proxyHostHeader"], NSString); }
+- (BOOL)shouldRewriteHostHeader     { return [CLASS_OR_NIL(_values[@"shouldRewriteHostHeader"], NSNumber) boolValue]; }
+- (NSURL *)directory                { return CLASS_OR_NIL(_values[@"directory"], NSURL); }
+- (NSString *)directoryIndexFile    { return CLASS_OR_NIL(_values[@"directoryIndexFile"], NSString); }
+- (BOOL)isBrowsingEnabled           { return [CLASS_OR_NIL(_values[@"isBrowsingEnabled"], NSNumber) boolValue]; }
+- (BOOL)isLiveReloadEnabled         { return [CLASS_OR_NIL(_values[@"isLiveReloadEnabled"], NSNumber) boolValue]; }
+
+- (id)valueForUndefinedKey:(NSString *)key {
+    // Predicates may reference properties which aren't captured by snapshots; treat them as nil rather than raising
+    return nil;
+}
+
+#pragma mark -
+
+- (BOOL)isEqual:(id)object {
+    if (object == self) {
+        return YES;
+    } else if (![object isKindOfClass:[EMTunnelSnapshot class]]) {
+        return NO;
+    }
+    
+    return [_values isEqualToDictionary:((EMTunnelSnapshot *)object).values];
+}
+
+- (NSUInteger)hash {
+    return [VALUE_OR_NIL(_values[@"id"]) hash];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p> %@ (%@)", self.className, self, self.id, self.remoteUrl];
+}
+
+@end
+
+
+@implementation Emporter (EMTunnelSnapshotSource)
+
+- (NSArray<EMTunnelSnapshot *> *)fetchTunnelSnapshots {
+    return [EMTunnelSnapshot snapshotsOfTunnels:self.tunnels ?: @[]];
+}
+
+- (EMTunnelSnapshot *)fetchTunnelSnapshotWithIdentifier:(NSString *)identifier {
+    EmporterTunnel *tunnel = [self tunnelWithIdentifier:identifier error:NULL];
+    tunnel = tunnel ? [tunnel get] : nil;
+    
+    return tunnel ? [[EMTunnelSnapshot alloc] initWithTunnel:tunnel] : nil;
+}
+
+- (NSDictionary<NSString *,id> *)fetchValuesForKeys:(NSArray<NSString *> *)keys ofTunnelWithIdentifier:(NSString *)identifier {
+    EmporterTunnel *tunnel = [self tunnelWithIdentifier:identifier error:NULL];
+    tunnel = tunnel ? [tunnel get] : nil;
+    
+    if (tunnel == nil) {
+        return nil;
+    }
+    
+    return [[[EMTunnelSnapshot alloc] initWithTunnel:tunnel keys:keys].values dictionaryWithValuesForKeys:keys];
+}
+
+@end
@@ -0,0 +1,53 @@
+//
+//  EMTunnelSnapshotStore.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "EMTunnelSnapshot.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ An in-process store of tunnel snapshots keyed by tunnel id.
+ 
+ The store is populated by a single bulk fetch (via \c reload) and is then patched as tunnels change, so that consumers of tunnel
+ notifications only need to fetch what's changed instead of every property of a tunnel.
+ */
+@interface EMTunnelSnapshotStore : NSObject
+
+/*!
+ The designated initializer.
+ \param source The source used to fetch snapshots
+ \returns A new instance of \c EMTunnelSnapshotStore.
+ */
+- (instancetype)initWithSource:(id <EMTunnelSnapshotSource>)source NS_DESIGNATED_INITIALIZER;
+
+/*! The source used to fetch snapshots */
+@property(nonatomic,readonly) id <EMTunnelSnapshotSource> source;
+
+/*! Replace all snapshots in the store using a bulk fetch from its source */
+- (void)reload;
+
+/*! All snapshots in the store, in the order in which they were fetched */
+@property(nonatomic,readonly) NSArray<EMTunnelSnapshot*> *snapshots;
+
+/*! The stored snapshot for a tunnel, or nil if it isn't stored */
+- (nullable EMTunnelSnapshot *)snapshotWithIdentifier:(NSString *)identifier;
+
+/*! Fetch and store a complete snapshot for a tunnel (i.e. when it's added or its configuration changes). Returns nil (and removes the tunnel from the store) if the tunnel no longer exists. */
+- (nullable EMTunnelSnapshot *)updateSnapshotWithIdentifier:(NSString *)identifier;
+
+/*! Patch a stored snapshot by fetching only its state properties. Complete snapshots are fetched for tunnels which aren't yet stored. */
+- (nullable EMTunnelSnapshot *)updateStateOfSnapshotWithIdentifier:(NSString *)identifier;
+
+/*! Remove a snapshot from the store, returning the last known snapshot (if any) */
+- (nullable EMTunnelSnapshot *)removeSnapshotWithIdentifier:(NSString *)identifier;
+
+@end
+
+NS_ASSUME_NONNULL_END
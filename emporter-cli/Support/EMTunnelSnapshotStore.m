@@ -0,0 +1,109 @@
+//
+//  EMTunnelSnapshotStore.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import "EMTunnelSnapshotStore.h"
+
+@implementation EMTunnelSnapshotStore {
+    NSMutableArray<NSString*> *_identifiers;
+    NSMutableDictionary<NSString*,EMTunnelSnapshot*> *_snapshotsByIdentifier;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithSource:(id<EMTunnelSnapshotSource>)source {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _source = source;
+    _identifiers = [NSMutableArray array];
+    _snapshotsByIdentifier = [NSMutableDictionary dictionary];
+    
+    return self;
+}
+
+- (void)reload {
+    [_identifiers removeAllObjects];
+    [_snapshotsByIdentifier removeAllObjects];
+    
+    for (EMTunnelSnapshot *snapshot in [_source fetchTunnelSnapshots]) {
+        [self _storeSnapshot:snapshot];
+    }
+}
+
+- (NSArray<EMTunnelSnapshot *> *)snapshots {
+    return [_snapshotsByIdentifier objectsForKeys:_identifiers notFoundMarker:[NSNull null]];
+}
+
+- (EMTunnelSnapshot *)snapshotWithIdentifier:(NSString *)identifier {
+    return _snapshotsByIdentifier[identifier];
+}
+
+- (EMTunnelSnapshot *)updateSnapshotWithIdentifier:(NSString *)identifier {
+    EMTunnelSnapshot *snapshot = [_source fetchTunnelSnapshotWithIdentifier:identifier];
+    
+    if (snapshot == nil) {
+        [self removeSnapshotWithIdentifier:identifier];
+        return nil;
+    }
+    
+    [self _storeSnapshot:snapshot];
+    
+    return snapshot;
+}
+
+- (EMTunnelSnapshot *)updateStateOfSnapshotWithIdentifier:(NSString *)identifier {
+    EMTunnelSnapshot *snapshot = _snapshotsByIdentifier[identifier];
+    
+    if (snapshot == nil) {
+        return [self updateSnapshotWithIdentifier:identifier];
+    }
+    
+    NSDictionary *values = [_source fetchValuesForKeys:EMTunnelSnapshot.stateKeys ofTunnelWithIdentifier:identifier];
+    
+    if (values == nil) {
+        [self removeSnapshotWithIdentifier:identifier];
+        return nil;
+    }
+    
+    snapshot = [snapshot snapshotByApplyingValues:values];
+    [self _storeSnapshot:snapshot];
+    
+    return snapshot;
+}
+
+- (EMTunnelSnapshot *)removeSnapshotWithIdentifier:(NSString *)identifier {
+    EMTunnelSnapshot *snapshot = _snapshotsByIdentifier[identifier];
+    
+    if (snapshot != nil) {
+        [_snapshotsByIdentifier removeObjectForKey:identifier];
+        [_identifiers removeObject:identifier];
+    }
+    
+    return snapshot;
+}
+
+- (void)_storeSnapshot:(EMTunnelSnapshot *)snapshot {
+    NSString *identifier = snapshot.id;
+    
+    if (identifier == nil) {
+        return;
+    } else if (_snapshotsByIdentifier[identifier] == nil) {
+        [_identifiers addObject:identifier];
+    }
+    
+    _snapshotsByIdentifier[identifier] = snapshot;
+}
+
+@end
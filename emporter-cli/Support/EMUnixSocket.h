@@ -0,0 +1,34 @@
+//
+//  EMUnixSocket.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Listen for connections on a Unix socket which only the current user can connect to. Stale sockets at the path are replaced.
+ 
+ \param path        The path of the socket
+ \param queue       The queue on which connections are handled
+ \param handler     A block invoked with each connection, which is closed once the block returns. Writes to a closed connection fail
+                    instead of raising SIGPIPE.
+ \param outError    An optional pointer to an error describing why the socket couldn't be created
+ 
+ \returns A (resumed) source which closes the socket when cancelled, or nil if the socket couldn't be created. The socket's path is left
+          in place, and should be removed once the source is cancelled.
+ */
+extern dispatch_source_t __nullable EMUnixSocketListen(NSString *path, dispatch_queue_t queue, void(^handler)(int fd), NSError **__nullable outError);
+
+/*!
+ Connect to a Unix socket. Writes to the returned file descriptor fail instead of raising SIGPIPE.
+ 
+ \returns A file descriptor (which the caller must close), or -1 if the socket couldn't be connected to.
+ */
+extern int EMUnixSocketConnect(NSString *path, NSError **__nullable outError);
+
+NS_ASSUME_NONNULL_END
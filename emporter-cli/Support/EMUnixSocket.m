@@ -0,0 +1,108 @@
+//
+//  EMUnixSocket.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#import "EMUnixSocket.h"
+
+
+static BOOL _EMUnixSocketFail(int code, int fd, NSError **outError) {
+    if (outError != NULL) {
+        (*outError) = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil];
+    }
+    
+    if (fd >= 0) {
+        close(fd);
+    }
+    
+    return NO;
+}
+
+static BOOL _EMUnixSocketAddress(NSString *path, struct sockaddr_un *addr, NSError **outError) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    
+    if (strlcpy(addr->sun_path, path.fileSystemRepresentation, sizeof(addr->sun_path)) >= sizeof(addr->sun_path)) {
+        return _EMUnixSocketFail(ENAMETOOLONG, -1, outError);
+    }
+    
+    return YES;
+}
+
+static void _EMUnixSocketConfigure(int fd) {
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+dispatch_source_t EMUnixSocketListen(NSString *path, dispatch_queue_t queue, void(^handler)(int fd), NSError **outError) {
+    struct sockaddr_un addr;
+    if (!_EMUnixSocketAddress(path, &addr, outError)) {
+        return nil;
+    }
+    
+    // Remove stale sockets (from servers which didn't stop cleanly)
+    unlink(addr.sun_path);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        _EMUnixSocketFail(errno, -1, outError);
+        return nil;
+    }
+    
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    
+    // Only the current user can connect
+    mode_t mask = umask(0077);
+    int bindResult = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(mask);
+    
+    if (bindResult != 0 || listen(fd, 16) != 0) {
+        _EMUnixSocketFail(errno, fd, outError);
+        return nil;
+    }
+    
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, queue);
+    dispatch_source_set_event_handler(source, ^{
+        int clientFd = accept(fd, NULL, NULL);
+        
+        if (clientFd >= 0) {
+            _EMUnixSocketConfigure(clientFd);
+            handler(clientFd);
+            close(clientFd);
+        }
+    });
+    dispatch_source_set_cancel_handler(source, ^{
+        close(fd);
+    });
+    dispatch_resume(source);
+    
+    return source;
+}
+
+int EMUnixSocketConnect(NSString *path, NSError **outError) {
+    struct sockaddr_un addr;
+    if (!_EMUnixSocketAddress(path, &addr, outError)) {
+        return -1;
+    }
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        _EMUnixSocketFail(errno, fd, outError);
+        return -1;
+    }
+    
+    _EMUnixSocketConfigure(fd);
+    
+    return fd;
+}
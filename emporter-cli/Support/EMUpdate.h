@@ -49,6 +49,16 @@ typedef NS_ENUM(NSUInteger, EMUpdateType) {
 /*! Assets related to the update. */
 @property(nonatomic,readonly) NSArray<NSURL*> *assetURLs;
 
+/*!
+ Find an asset which patches a previous version of the executable to this update.
+ 
+ Patches are created by bsdiff(1) and named by the versions they patch between (i.e. "emporter-0.3.0-0.4.0.bsdiff").
+ 
+ \param version The version to be patched (i.e. the embedded version)
+ \returns The URL of the patch, or nil if the update doesn't include one.
+ */
+- (nullable NSURL *)patchURLFromVersion:(EMVersion)version;
+
 @end
 
 /*! Return the update type for the string (github, key_values) */
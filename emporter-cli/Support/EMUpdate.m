@@ -84,6 +84,18 @@
     return self;
 }
 
+- (NSURL *)patchURLFromVersion:(EMVersion)version {
+    NSString *suffix = [NSString stringWithFormat:@"-%@-%@.bsdiff", EMVersionDescription(version), EMVersionDescription(_version)];
+    
+    for (NSURL *assetURL in _assetURLs) {
+        if ([assetURL.lastPathComponent hasSuffix:suffix]) {
+            return assetURL;
+        }
+    }
+    
+    return nil;
+}
+
 @end
 
 EMUpdateType EMUpdateTypeFromString(NSString *string) {
@@ -11,6 +11,13 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/*! Options used to read updates from a feed */
+typedef NS_OPTIONS(NSUInteger, EMUpdateFeedReadingOptions) {
+    
+    /*! Skip the body (release notes) of updates */
+    EMUpdateFeedReadingOmitsBody = 1 << 0
+};
+
 /*! A remote feed used to find updates */
 @interface EMUpdateFeed : NSObject
 
@@ -42,12 +49,46 @@ NS_ASSUME_NONNULL_BEGIN
 /*! The type of updates the feed provides */
 @property(nonatomic,readonly) EMUpdateType type;
 
+/*!
+ The directory used to cache the contents of remote feeds between reads, or nil if they shouldn't be cached.
+ 
+ Cached feeds are revalidated with the server (using their entity tag) once they're older than \c cacheTimeToLive, so that
+ unchanged feeds don't need to be downloaded again. The bundled feed is cached within the user's caches directory.
+ */
+@property(nonatomic,copy,nullable) NSURL *cacheDirectoryURL;
+
+/*! How long a cached feed is used before it's revalidated. Defaults to one hour. */
+@property(nonatomic) NSTimeInterval cacheTimeToLive;
+
 /*! Read the latest updates for the feed asynchronously.
  
  \param completionHandler The block to invoke once the feed has been read. If successful (error is nil), updates will be sorted in descending order.
  */
 - (void)readFeedWithCompletionHandler:(void(^)(NSArray<EMUpdate*>* __nullable updates, NSError *__nullable error))completionHandler;
 
+/*! Read the latest update for the feed asynchronously.
+ 
+ Updates are read without their bodies, and the update with the highest version is returned. Feeds are ordered by when updates were
+ published rather than by version, so the first update isn't necessarily the latest (i.e. a backport published after a newer release).
+ 
+ \param completionHandler The block to invoke once the feed has been read. The update is nil if the feed is empty.
+ */
+- (void)readLatestUpdateWithCompletionHandler:(void(^)(EMUpdate *__nullable update, NSError *__nullable error))completionHandler;
+
+/*!
+ Read updates from the contents of a feed.
+ 
+ Feeds are scanned without being fully deserialized. Only the properties needed by \c EMUpdate are read and the remainder are skipped.
+ 
+ \param data     The contents of the feed
+ \param type     The type of updates supplied by the feed
+ \param options  Options used to limit which updates (and properties) are read
+ \param outError An optional pointer to an error describing why the feed could not be read
+ 
+ \returns Updates in the order they appear in the feed, or nil if the feed is invalid.
+ */
++ (nullable NSArray<EMUpdate*> *)updatesFromData:(NSData *)data type:(EMUpdateType)type options:(EMUpdateFeedReadingOptions)options error:(NSError **__nullable)outError;
+
 @end
 
 NS_ASSUME_NONNULL_END
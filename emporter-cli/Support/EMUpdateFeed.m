@@ -10,6 +10,237 @@
 #import "EMUpdate.h"
 #import "EMVersion.h"
 
+#define CLASS_OR_NIL(v, k)      (v != nil && [v isKindOfClass:[k class]] ? v : nil)
+
+
+/*!
+ A forward-only scanner for JSON which skips over values without creating objects for them.
+ 
+ Feeds are large (mostly due to release notes and asset/author metadata) but only a few of their properties are used,
+ so they're scanned instead of being deserialized.
+ */
+typedef struct {
+    const uint8_t *bytes;
+    size_t length;
+    size_t position;
+} _EMJSONScanner;
+
+static inline uint8_t _EMJSONPeekByte(_EMJSONScanner *s) {
+    while (s->position < s->length) {
+        uint8_t c = s->bytes[s->position];
+        
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            return c;
+        }
+        
+        s->position++;
+    }
+    
+    return 0;
+}
+
+static inline BOOL _EMJSONScanByte(_EMJSONScanner *s, uint8_t c) {
+    if (_EMJSONPeekByte(s) != c) {
+        return NO;
+    }
+    
+    s->position++;
+    return YES;
+}
+
+/*! Scan a string, returning the range of its contents (which may contain escape sequences) */
+static BOOL _EMJSONScanStringRange(_EMJSONScanner *s, NSRange *outRange) {
+    if (!_EMJSONScanByte(s, '"')) {
+        return NO;
+    }
+    
+    size_t start = s->position;
+    
+    while (s->position < s->length) {
+        const uint8_t *quote = memchr(s->bytes + s->position, '"', s->length - s->position);
+        if (quote == NULL) {
+            return NO;
+        }
+        
+        size_t end = (size_t)(quote - s->bytes);
+        s->position = end + 1;
+        
+        // Quotes preceded by an odd number of backslashes are escaped
+        size_t backslashCount = 0;
+        while (end - backslashCount > start && s->bytes[end - backslashCount - 1] == '\\') {
+            backslashCount++;
+        }
+        
+        if (backslashCount % 2 == 0) {
+            if (outRange != NULL) {
+                (*outRange) = NSMakeRange(start, end - start);
+            }
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+static NSString *_EMJSONScanString(_EMJSONScanner *s) {
+    NSRange range;
+    if (!_EMJSONScanStringRange(s, &range)) {
+        return nil;
+    }
+    
+    const uint8_t *bytes = s->bytes + range.location;
+    
+    if (memchr(bytes, '\\', range.length) == NULL) {
+        return [[NSString alloc] initWithBytes:bytes length:range.length encoding:NSUTF8StringEncoding];
+    }
+    
+    // Escaped strings are uncommon for the properties we read, so they're left to NSJSONSerialization (including their quotes)
+    NSData *fragment = [NSData dataWithBytesNoCopy:(void *)(bytes - 1) length:range.length + 2 freeWhenDone:NO];
+    return CLASS_OR_NIL([NSJSONSerialization JSONObjectWithData:fragment options:NSJSONReadingAllowFragments error:NULL], NSString);
+}
+
+static BOOL _EMJSONSkipValue(_EMJSONScanner *s) {
+    uint8_t c = _EMJSONPeekByte(s);
+    
+    if (c == '"') {
+        return _EMJSONScanStringRange(s, NULL);
+    } else if (c == '{' || c == '[') {
+        size_t depth = 0;
+        
+        while (s->position < s->length) {
+            c = s->bytes[s->position];
+            
+            if (c == '"') {
+                if (!_EMJSONScanStringRange(s, NULL)) {
+                    return NO;
+                }
+                continue;
+            }
+            
+            s->position++;
+            
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return YES;
+            }
+        }
+        
+        return NO;
+    }
+    
+    // Numbers and literals end at the next delimiter
+    size_t start = s->position;
+    
+    while (s->position < s->length) {
+        c = s->bytes[s->position];
+        
+        if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            break;
+        }
+        
+        s->position++;
+    }
+    
+    return s->position > start;
+}
+
+/*! Scan an array, invoking the block to scan each of its values */
+static BOOL _EMJSONScanArray(_EMJSONScanner *s, BOOL(^block)(BOOL *stop)) {
+    if (!_EMJSONScanByte(s, '[')) {
+        return NO;
+    } else if (_EMJSONScanByte(s, ']')) {
+        return YES;
+    }
+    
+    BOOL stop = NO;
+    
+    do {
+        if (!block(&stop)) {
+            return NO;
+        } else if (stop) {
+            return YES;
+        }
+    } while (_EMJSONScanByte(s, ','));
+    
+    return _EMJSONScanByte(s, ']');
+}
+
+/*! Scan an object, invoking the block with the range of each key to scan its value */
+static BOOL _EMJSONScanObject(_EMJSONScanner *s, BOOL(^block)(NSRange key)) {
+    if (!_EMJSONScanByte(s, '{')) {
+        return NO;
+    } else if (_EMJSONScanByte(s, '}')) {
+        return YES;
+    }
+    
+    do {
+        NSRange key;
+        
+        if (!_EMJSONScanStringRange(s, &key) || !_EMJSONScanByte(s, ':') || !block(key)) {
+            return NO;
+        }
+    } while (_EMJSONScanByte(s, ','));
+    
+    return _EMJSONScanByte(s, '}');
+}
+
+static inline BOOL _EMJSONKeyEquals(_EMJSONScanner *s, NSRange key, const char *string) {
+    size_t length = strlen(string);
+    return key.length == length && memcmp(s->bytes + key.location, string, length) == 0;
+}
+
+/*! Scan a string value into a dictionary (unless it's null or another type) */
+static BOOL _EMJSONScanStringIntoDictionary(_EMJSONScanner *s, NSMutableDictionary *dictionary, NSString *key) {
+    if (_EMJSONPeekByte(s) != '"') {
+        return _EMJSONSkipValue(s);
+    }
+    
+    NSString *value = _EMJSONScanString(s);
+    dictionary[key] = value;
+    
+    return value != nil;
+}
+
+/*! Scan a GitHub release into a property list with the keys used by EMUpdate */
+static NSDictionary *_EMJSONScanGitHubRelease(_EMJSONScanner *s, EMUpdateFeedReadingOptions options) {
+    NSMutableDictionary *release = [NSMutableDictionary dictionary];
+    BOOL includeBody = (options & EMUpdateFeedReadingOmitsBody) == 0;
+    
+    BOOL isValid = _EMJSONScanObject(s, ^BOOL(NSRange key) {
+        if (_EMJSONKeyEquals(s, key, "tag_name")) {
+            return _EMJSONScanStringIntoDictionary(s, release, @"tag_name");
+        } else if (_EMJSONKeyEquals(s, key, "name")) {
+            return _EMJSONScanStringIntoDictionary(s, release, @"name");
+        } else if (_EMJSONKeyEquals(s, key, "published_at")) {
+            return _EMJSONScanStringIntoDictionary(s, release, @"published_at");
+        } else if (includeBody && _EMJSONKeyEquals(s, key, "body")) {
+            return _EMJSONScanStringIntoDictionary(s, release, @"body");
+        } else if (_EMJSONKeyEquals(s, key, "assets")) {
+            NSMutableArray *assets = [NSMutableArray array];
+            release[@"assets"] = assets;
+            
+            return _EMJSONScanArray(s, ^BOOL(BOOL *stop) {
+                NSMutableDictionary *asset = [NSMutableDictionary dictionary];
+                [assets addObject:asset];
+                
+                return _EMJSONScanObject(s, ^BOOL(NSRange assetKey) {
+                    if (_EMJSONKeyEquals(s, assetKey, "browser_download_url")) {
+                        return _EMJSONScanStringIntoDictionary(s, asset, @"browser_download_url");
+                    }
+                    
+                    return _EMJSONSkipValue(s);
+                });
+            });
+        }
+        
+        return _EMJSONSkipValue(s);
+    });
+    
+    return isValid ? release : nil;
+}
+
+
 @implementation EMUpdateFeed
 
 + (instancetype)bundledFeed {
@@ -26,6 +257,11 @@
                 EMUpdateType feedType = feedTypeString ? EMUpdateTypeFromString(feedTypeString) : EMUpdateTypeGitHubRelease;
                 
                 bundledFeed = [[self alloc] initWithURL:feedURL type:feedType];
+                
+                NSURL *cachesURL = [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask].firstObject;
+                NSString *identifier = NSBundle.mainBundle.bundleIdentifier ?: @"net.youngdynasty.emporter-cli";
+                
+                bundledFeed.cacheDirectoryURL = [[cachesURL URLByAppendingPathComponent:identifier] URLByAppendingPathComponent:@"Feeds"];
             }
         }
     });
@@ -48,12 +284,40 @@
     
     _url = url;
     _type = type;
+    _cacheTimeToLive = 60 * 60;
     
     return self;
 }
 
 - (void)readFeedWithCompletionHandler:(void (^)(NSArray<EMUpdate*> *, NSError *))completionHandler {
+    [self _readUpdatesWithOptions:0 completionHandler:^(NSArray<EMUpdate *> *updates, NSError *error) {
+        if (error != nil) {
+            completionHandler(nil, error);
+        } else {
+            completionHandler([updates sortedArrayUsingComparator:^NSComparisonResult(EMUpdate *u1, EMUpdate *u2) {
+                return EMVersionCompare(u2.version, u1.version);
+            }], nil);
+        }
+    }];
+}
+
+- (void)readLatestUpdateWithCompletionHandler:(void (^)(EMUpdate *, NSError *))completionHandler {
+    [self _readUpdatesWithOptions:EMUpdateFeedReadingOmitsBody completionHandler:^(NSArray<EMUpdate *> *updates, NSError *error) {
+        EMUpdate *latestUpdate = nil;
+        
+        for (EMUpdate *update in updates) {
+            if (latestUpdate == nil || EMVersionCompare(update.version, latestUpdate.version) == NSOrderedDescending) {
+                latestUpdate = update;
+            }
+        }
+        
+        completionHandler(latestUpdate, error);
+    }];
+}
+
+- (void)_readUpdatesWithOptions:(EMUpdateFeedReadingOptions)options completionHandler:(void (^)(NSArray<EMUpdate*> *, NSError *))completionHandler {
     NSURL *feedURL = _url;
+    EMUpdateType type = _type;
     
     if (_type == EMUpdateTypeGitHubRelease && [(feedURL.host ?: @"") isEqualToString:@"github.com"]) {
         NSString *feedPath = [[NSString stringWithFormat:@"/repos/%@", feedURL.path] stringByStandardizingPath];
@@ -65,68 +329,124 @@
         feedURL = [NSURL URLWithString:feedPath relativeToURL:[NSURL URLWithString:@"https://api.github.com"]];
     }
     
-    void(^handleFeedData)(NSData *, NSError *) = ^(NSData *data, NSError *error) {
+    [self _readDataFromURL:feedURL completionHandler:^(NSData *data, NSError *error) {
+        NSArray<EMUpdate*> *updates = data ? [EMUpdateFeed updatesFromData:data type:type options:options error:&error] : nil;
+        completionHandler(updates, updates ? nil : error);
+    }];
+}
+
+- (void)_readDataFromURL:(NSURL *)feedURL completionHandler:(void (^)(NSData *, NSError *))completionHandler {
+    if ([feedURL isFileURL]) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+            NSError *error = nil;
+            NSData *data = [NSData dataWithContentsOfURL:feedURL options:0 error:&error];
+            completionHandler(data, error);
+        });
+        
+        return;
+    }
+    
+    NSURL *cacheURL = [self _cacheURLForFeedURL:feedURL];
+    NSDictionary *cache = cacheURL ? [NSDictionary dictionaryWithContentsOfURL:cacheURL] : nil;
+    NSData *cachedData = CLASS_OR_NIL(cache[@"data"], NSData);
+    NSString *cachedEntityTag = CLASS_OR_NIL(cache[@"etag"], NSString);
+    NSDate *validationDate = CLASS_OR_NIL(cache[@"validated"], NSDate);
+    
+    // Recently validated feeds are used as-is
+    if (cachedData != nil && validationDate != nil && -validationDate.timeIntervalSinceNow < _cacheTimeToLive) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+            completionHandler(cachedData, nil);
+        });
+        
+        return;
+    }
+    
+    // Otherwise the feed is only downloaded if it's changed
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:feedURL cachePolicy:NSURLRequestReloadIgnoringLocalCacheData timeoutInterval:60];
+    
+    if (cachedData != nil && cachedEntityTag != nil) {
+        [request setValue:cachedEntityTag forHTTPHeaderField:@"If-None-Match"];
+    }
+    
+    [[[NSURLSession sharedSession] dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        NSHTTPURLResponse *httpResponse = [response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil;
+        NSInteger statusCode = httpResponse ? httpResponse.statusCode : 200;
+        
         if (error != nil) {
             return completionHandler(nil, error);
         }
         
-        NSArray<EMUpdate*> *items = nil;
-        
-        switch (self.type) {
-            case EMUpdateTypeGitHubRelease:
-                items = [self _updateItemsFromJSONData:data error:&error];
-                break;
-            default:
-                error = [NSError errorWithDomain:NSPOSIXErrorDomain code:EPROTONOSUPPORT userInfo:nil];
-                break;
+        if (statusCode == 304 && cachedData != nil) {
+            data = cachedData;
+        } else if (statusCode != 200) {
+            NSDictionary *userInfo = @{NSLocalizedDescriptionKey: [NSHTTPURLResponse localizedStringForStatusCode:statusCode], NSURLErrorFailingURLErrorKey: feedURL};
+            return completionHandler(nil, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:userInfo]);
         }
         
-        if (error != nil) {
-            completionHandler(nil, error);
-        } else {
-            completionHandler([items ?: @[] sortedArrayUsingComparator:^NSComparisonResult(EMUpdate *u1, EMUpdate *u2) {
-                return EMVersionCompare(u2.version, u1.version);
-            }], nil);
+        if (cacheURL != nil) {
+            NSMutableDictionary *newCache = [NSMutableDictionary dictionary];
+            newCache[@"data"] = data ?: [NSData data];
+            newCache[@"etag"] = httpResponse.allHeaderFields[@"ETag"] ?: (statusCode == 304 ? cachedEntityTag : nil);
+            newCache[@"validated"] = [NSDate date];
+            
+            NSData *cacheData = [NSPropertyListSerialization dataWithPropertyList:newCache format:NSPropertyListBinaryFormat_v1_0 options:0 error:NULL];
+            
+            if ([[NSFileManager defaultManager] createDirectoryAtURL:cacheURL.URLByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL]) {
+                [cacheData writeToURL:cacheURL options:NSDataWritingAtomic error:NULL];
+            }
         }
-    };
-    
-    if ([feedURL isFileURL]) {
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
-            NSError *error = nil;
-            NSData *data = [NSData dataWithContentsOfURL:feedURL options:0 error:&error];
-            handleFeedData(data, error);
-        });
-    } else {
-        [[[NSURLSession sharedSession] dataTaskWithURL:feedURL completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
-            handleFeedData(data, error);
-        }] resume];
+        
+        completionHandler(data, nil);
+    }] resume];
+}
+
+- (NSURL *)_cacheURLForFeedURL:(NSURL *)feedURL {
+    if (_cacheDirectoryURL == nil) {
+        return nil;
     }
+    
+    NSCharacterSet *invalidCharacters = [NSCharacterSet alphanumericCharacterSet].invertedSet;
+    NSString *name = [[feedURL.absoluteString componentsSeparatedByCharactersInSet:invalidCharacters] componentsJoinedByString:@"_"];
+    
+    return [_cacheDirectoryURL URLByAppendingPathComponent:[name stringByAppendingPathExtension:@"plist"]];
 }
 
-- (NSArray *)_updateItemsFromJSONData:(NSData *)data error:(NSError **)outError {
-    NSArray *plists = [NSJSONSerialization JSONObjectWithData:data options:0 error:outError];
-    if (plists == nil) {
+#pragma mark - Parsing
+
++ (NSArray<EMUpdate*> *)updatesFromData:(NSData *)data type:(EMUpdateType)type options:(EMUpdateFeedReadingOptions)options error:(NSError **)outError {
+    if (type != EMUpdateTypeGitHubRelease) {
+        if (outError != NULL) {
+            (*outError) = [NSError errorWithDomain:NSPOSIXErrorDomain code:EPROTONOSUPPORT userInfo:nil];
+        }
         return nil;
     }
     
-    NSMutableArray<EMUpdate*> *items = [NSMutableArray array];
+    _EMJSONScanner scanner = {data.bytes, data.length, 0};
+    _EMJSONScanner *s = &scanner;
     
-    for (NSDictionary *plist in plists) {
-        if (![plist isKindOfClass:[NSDictionary class]]) {
-            if (outError != NULL) {
-                (*outError) = [NSError errorWithDomain:NSPOSIXErrorDomain code:EINVAL userInfo:nil];
-            }
-            return nil;
+    NSMutableArray<EMUpdate*> *updates = [NSMutableArray array];
+    __block NSError *error = nil;
+    
+    BOOL isValid = _EMJSONScanArray(s, ^BOOL(BOOL *stop) {
+        NSDictionary *release = _EMJSONScanGitHubRelease(s, options);
+        EMUpdate *update = release ? [[EMUpdate alloc] initWithPropertyList:release type:type error:&error] : nil;
+        
+        if (update == nil) {
+            return NO;
         }
         
-        EMUpdate *item = [[EMUpdate alloc] initWithPropertyList:plist type:_type error:outError];
-        if (item == nil) {
-            return nil;
+        [updates addObject:update];
+        return YES;
+    });
+    
+    if (!isValid) {
+        if (outError != NULL) {
+            (*outError) = error ?: [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListReadCorruptError userInfo:@{NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"Invalid feed around character %zu.", scanner.position]}];
         }
-        [items addObject:item];
+        return nil;
     }
     
-    return items;
+    return updates;
 }
 
 @end
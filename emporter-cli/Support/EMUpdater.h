@@ -49,6 +49,28 @@ typedef NS_ENUM(NSUInteger, EMUpdaterState) {
  */
 + (void)applyWithURL:(NSURL *)url stateHandler:(void(^)(EMUpdaterState state, NSProgress *__nullable progress, NSError *__nullable error))stateHandler;
 
+/*!
+ Apply an update from a URL after verifying its SHA-256 digest against a manifest, preferring a binary patch when one is available.
+ 
+ Remote updates are extracted and digested as they're downloaded, so the extraction step only needs to verify the package once the
+ download is complete. Downloads are cached on disk, so an interrupted download is resumed (using an HTTP range request) on the next attempt.
+ 
+ The manifest is fetched alongside the update and is formatted like the output of shasum(1) (i.e. "<digest>  <name>"). The update is not
+ applied unless the manifest lists the package by name with a matching digest.
+ 
+ Patches (created by bsdiff(1)) are applied to the current executable, and the result is subject to the same code signature verification
+ as the executable in a package. If the patch can't be downloaded, verified or applied, the full package is used instead.
+ 
+ \param url                The URL used to apply an update
+ \param patchURL           An optional URL for a binary patch from the current executable to the update
+ \param digestManifestURL  An optional URL for the digest manifest which lists the update
+ \param stateHandler       The block to invoke (on a consistent background queue) for updates
+ */
++ (void)applyWithURL:(NSURL *)url patchURL:(nullable NSURL *)patchURL digestManifestURL:(nullable NSURL *)digestManifestURL stateHandler:(void(^)(EMUpdaterState state, NSProgress *__nullable progress, NSError *__nullable error))stateHandler;
+
 @end
 
+/*! Parse a digest manifest (in the format of shasum(1)) into a dictionary of SHA-256 digests keyed by file name. Returns nil if the manifest is malformed. */
+extern NSDictionary<NSString*,NSData*> *__nullable EMUpdaterDigestsFromManifest(NSString *manifest);
+
 NS_ASSUME_NONNULL_END
@@ -6,8 +6,27 @@
 //  Copyright © 2019 Young Dynasty. All rights reserved.
 //
 
+#include <CommonCrypto/CommonDigest.h>
+
 #import "EMUpdater.h"
 #import "EMCodeSignature.h"
+#import "EMTarballReader.h"
+#import "EMBinaryPatch.h"
+#import "EMDownload.h"
+
+
+/*! Extracts the executable from an update package and computes the package's digest as data is read */
+@interface _EMUpdatePipeline : NSObject
+- (instancetype)initWithReader:(EMTarballReader *)reader;
+@property(nonatomic,readonly) EMTarballReader *reader;
+@property(nonatomic,readonly) NSData *digest;
+@property(nonatomic,readonly) NSError *error;
+- (BOOL)appendBytes:(const void *)bytes length:(size_t)length;
+- (BOOL)appendData:(NSData *)data;
+- (BOOL)readFileURL:(NSURL *)fileURL progress:(NSProgress *)progress;
+- (BOOL)finish;
+- (void)failWithError:(NSError *)error;
+@end
 
 
 @interface EMUpdater() <NSFileManagerDelegate>
@@ -15,14 +34,26 @@
 @property(nonatomic,readonly) dispatch_queue_t _q;
 @end
 
-@implementation EMUpdater
+@implementation EMUpdater {
+    NSFileManager *_fileManager;
+    EMDownloadCache *_downloadCache;
+    
+    NSURL *_digestManifestURL;
+    NSDictionary<NSString*,NSData*> *_digests;
+    NSError *_digestManifestError;
+    dispatch_group_t _digestManifestGroup;
+}
 @synthesize _q = _q;
 @synthesize _executableURL = _executableURL;
 
 static void *qContext = &qContext;
 
 + (void)applyWithURL:(NSURL *)url stateHandler:(void(^)(EMUpdaterState state, NSProgress *__nullable progress, NSError *__nullable error))stateHandler {
-    [[[self alloc] init] applyWithURL:url stateHandler:stateHandler];
+    [[[self alloc] init] applyWithURL:url patchURL:nil digestManifestURL:nil stateHandler:stateHandler];
+}
+
++ (void)applyWithURL:(NSURL *)url patchURL:(NSURL *)patchURL digestManifestURL:(NSURL *)digestManifestURL stateHandler:(void(^)(EMUpdaterState state, NSProgress *__nullable progress, NSError *__nullable error))stateHandler {
+    [[[self alloc] init] applyWithURL:url patchURL:patchURL digestManifestURL:digestManifestURL stateHandler:stateHandler];
 }
 
 - (instancetype)init {
@@ -35,6 +66,12 @@ static void *qContext = &qContext;
     _q = dispatch_queue_create("net.youngdynasty.emporter-cli.updater", NULL);
     dispatch_queue_set_specific(_q, qContext, qContext, NULL);
     
+    _fileManager = [NSFileManager new];
+    _fileManager.delegate = self;
+    
+    _downloadCache = [EMDownloadCache defaultCache];
+    _digestManifestGroup = dispatch_group_create();
+    
     return self;
 }
 
@@ -48,98 +85,220 @@ static void *qContext = &qContext;
 
 typedef void(^_EMUpdaterStateHandler)(EMUpdaterState, NSProgress *, NSError *);
 
-- (void)applyWithURL:(NSURL *)url stateHandler:(_EMUpdaterStateHandler)block {
+- (void)applyWithURL:(NSURL *)url patchURL:(NSURL *)patchURL digestManifestURL:(NSURL *)digestManifestURL stateHandler:(_EMUpdaterStateHandler)block {
     dispatch_async(_q, ^{
-        if ([url isFileURL]) {
-            [self _extractFileURL:url withStateHandler:block];
+        // Fetch the manifest alongside the update so it's ready by the time the update needs to be verified
+        if (digestManifestURL != nil) {
+            [self _fetchDigestManifestFromURL:digestManifestURL];
+        }
+        
+        if (patchURL != nil) {
+            [self _applyPatchURL:patchURL fallbackURL:url withStateHandler:block];
         } else {
-            [self _downloadURL:url withStateHandler:block];
+            [self _applyPackageURL:url withStateHandler:block];
         }
     });
 }
 
-- (void)_downloadURL:(NSURL *)url withStateHandler:(_EMUpdaterStateHandler)block {
+- (NSURL *)_createTemporaryDirectoryWithError:(NSError **)outError {
+    // Extract to the same volume as the executable so it can be replaced atomically
+    return [_fileManager URLForDirectory:NSItemReplacementDirectory inDomain:NSUserDomainMask appropriateForURL:self._executableURL create:YES error:outError];
+}
+
+- (void)_fetchDigestManifestFromURL:(NSURL *)url {
     dispatch_assert_queue(_q);
     
-    __block NSURLSessionDownloadTask *download = [[NSURLSession sharedSession] downloadTaskWithURL:url completionHandler:^(NSURL *location, NSURLResponse *response, NSError *error) {
-        [self _sync:^{
-            if (error == nil) {
-                [self _extractFileURL:location withStateHandler:block];
-            } else {
-                if ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled) {
-                    block(EMUpdaterStateCanceled, nil, nil);
-                } else {
-                    block(EMUpdaterStateComplete, nil, error);
-                }
+    _digestManifestURL = url;
+    dispatch_group_enter(_digestManifestGroup);
+    
+    void(^handleManifestData)(NSData *, NSError *) = ^(NSData *data, NSError *error) {
+        NSString *manifest = data ? [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] : nil;
+        NSDictionary *digests = manifest ? EMUpdaterDigestsFromManifest(manifest) : nil;
+        
+        dispatch_async(self._q, ^{
+            self->_digests = digests;
+            self->_digestManifestError = error;
+            dispatch_group_leave(self->_digestManifestGroup);
+        });
+    };
+    
+    if ([url isFileURL]) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSError *error = nil;
+            NSData *data = [NSData dataWithContentsOfURL:url options:0 error:&error];
+            handleManifestData(data, error);
+        });
+    } else {
+        [[[NSURLSession sharedSession] dataTaskWithURL:url completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+            if (error == nil && [response isKindOfClass:[NSHTTPURLResponse class]] && ((NSHTTPURLResponse *)response).statusCode != 200) {
+                error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:@{NSURLErrorFailingURLErrorKey: url}];
             }
-        }];
-    }];
+            
+            handleManifestData(error ? nil : data, error);
+        }] resume];
+    }
+}
+
+- (NSError *)_digestErrorForData:(NSData *)digest named:(NSString *)name {
+    dispatch_assert_queue(_q);
     
-    [download resume];
+    if (_digestManifestURL == nil) {
+        return nil;
+    }
     
-    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
-    [progress addChild:download.progress withPendingUnitCount:1];
+    NSData *expectedDigest = _digests[name];
     
-    progress.cancellationHandler = ^{
-        if (download != nil) {
-            [download cancel];
-            download = nil;
-        }
-    };
+    if (expectedDigest != nil && [expectedDigest isEqualToData:digest]) {
+        return nil;
+    }
+    
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+    userInfo[NSLocalizedDescriptionKey] = expectedDigest ? @"Update package has an invalid checksum" : @"Could not verify update package";
+    
+    if (_digestManifestError != nil) {
+        userInfo[NSUnderlyingErrorKey] = _digestManifestError;
+    }
     
-    block(EMUpdaterStateDownloading, progress, nil);
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:userInfo];
 }
 
-- (void)_extractFileURL:(NSURL *)fileURL withStateHandler:(_EMUpdaterStateHandler)block {
+#pragma mark - Packages
+
+- (void)_applyPackageURL:(NSURL *)url withStateHandler:(_EMUpdaterStateHandler)block {
     dispatch_assert_queue(_q);
+    
+    NSError *error = nil;
+    NSURL *tempDir = [self _createTemporaryDirectoryWithError:&error];
+    if (tempDir == nil) {
+        return block(EMUpdaterStateComplete, nil, error);
+    }
+    
+    NSURL *executableURL = [tempDir URLByAppendingPathComponent:self._executableURL.lastPathComponent];
+    EMTarballReader *reader = [[EMTarballReader alloc] initWithEntryName:executableURL.lastPathComponent destinationURL:executableURL];
+    _EMUpdatePipeline *pipeline = [[_EMUpdatePipeline alloc] initWithReader:reader];
+    
+    if ([url isFileURL]) {
+        [self _extractFileURL:url intoPipeline:pipeline withStateHandler:block];
+    } else {
+        [self _downloadURL:url intoPipeline:pipeline withStateHandler:block];
+    }
+}
 
-    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:10];
-    NSTask *task = [NSTask new];
-    progress.cancellationHandler = ^{
-        // Cancel task synchronously so we can guarantee the task setup/teardown is handled correctly
+- (void)_downloadURL:(NSURL *)url intoPipeline:(_EMUpdatePipeline *)pipeline withStateHandler:(_EMUpdaterStateHandler)block {
+    dispatch_assert_queue(_q);
+    
+    // Data is extracted and digested as it's received (or read from the cache), so extraction overlaps the download
+    EMDownload *download = [[EMDownload alloc] initWithURL:url cache:_downloadCache];
+    EMDownloadCache *downloadCache = _downloadCache;
+    
+    download.dataHandler = ^BOOL(NSData *data) {
+        return [pipeline appendData:data];
+    };
+    
+    // Keep interrupted downloads so they can be resumed, but not packages which were used (or found to be invalid)
+    _EMUpdaterStateHandler downloadBlock = ^(EMUpdaterState state, NSProgress *progress, NSError *error) {
+        if (state == EMUpdaterStateComplete && ![error.domain isEqualToString:NSURLErrorDomain]) {
+            [downloadCache removeFilesForURL:url];
+        }
+        
+        block(state, progress, error);
+    };
+    
+    [download startWithCompletionHandler:^(NSURL *fileURL, NSError *error) {
+        if (error == nil) {
+            [pipeline finish];
+        }
+        
         [self _sync:^{
-            if ([task isRunning]) {
-                [task terminate];
+            if (error != nil || pipeline.error != nil) {
+                return [self _installFromPipeline:pipeline packageName:url.lastPathComponent progress:download.progress error:(pipeline.error ?: error) withStateHandler:downloadBlock];
             }
+            
+            // The package has already been extracted, so only verification remains
+            NSProgress *verifyProgress = [NSProgress discreteProgressWithTotalUnitCount:1];
+            downloadBlock(EMUpdaterStateExtracting, verifyProgress, nil);
+            
+            [self _installFromPipeline:pipeline packageName:url.lastPathComponent progress:verifyProgress error:nil withStateHandler:downloadBlock];
         }];
-    };
+    }];
+    
+    downloadBlock(EMUpdaterStateDownloading, download.progress, nil);
+}
 
+- (void)_extractFileURL:(NSURL *)fileURL intoPipeline:(_EMUpdatePipeline *)pipeline withStateHandler:(_EMUpdaterStateHandler)block {
+    dispatch_assert_queue(_q);
+    
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:10];
+    
     block(EMUpdaterStateExtracting, progress, nil);
     
-    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:fileURL.path error:nil];
-    NSProgress *unarchiveProgress = [NSProgress discreteProgressWithTotalUnitCount:attributes ? [attributes[NSFileSize] unsignedIntegerValue] : 0];
+    NSProgress *unarchiveProgress = [NSProgress discreteProgressWithTotalUnitCount:0];
     
     [progress addChild:unarchiveProgress withPendingUnitCount:8];
     
-    [self _unarchiveTarballAtFileURL:fileURL usingTask:task progress:unarchiveProgress completionHandler:^(NSArray<NSURL *> *contents, NSError *error) {
-        dispatch_assert_queue(self._q);
+    // Read the package in a different queue so we don't block our queue (to correctly handle cancelation)
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [pipeline readFileURL:fileURL progress:unarchiveProgress];
+        
+        dispatch_async(self._q, ^{
+            [self _installFromPipeline:pipeline packageName:fileURL.lastPathComponent progress:progress error:pipeline.error withStateHandler:block];
+        });
+    });
+}
+
+- (void)_installFromPipeline:(_EMUpdatePipeline *)pipeline packageName:(NSString *)packageName progress:(NSProgress *)progress error:(NSError *)readError withStateHandler:(_EMUpdaterStateHandler)block {
+    dispatch_assert_queue(_q);
+    
+    NSURL *tempDir = pipeline.reader.destinationURL.URLByDeletingLastPathComponent;
+    
+    void(^complete)(EMUpdaterState, NSError *) = ^(EMUpdaterState state, NSError *error) {
+        // Remove partially extracted files before the temporary directory
+        [pipeline.reader cancel];
+        [self->_fileManager removeItemAtURL:tempDir error:NULL];
+        
+        block(state, nil, error);
+    };
+    
+    if ([progress isCancelled]) {
+        return complete(EMUpdaterStateCanceled, nil);
+    } else if (readError != nil) {
+        return complete(EMUpdaterStateComplete, readError);
+    }
+    
+    // Wait for the manifest (if any) before verifying the package
+    dispatch_group_notify(_digestManifestGroup, _q, ^{
+        NSError *error = nil;
         
         if ([progress isCancelled]) {
-            return block(EMUpdaterStateCanceled, nil, nil);
+            return complete(EMUpdaterStateCanceled, nil);
         }
         
-        // Find executable
-        NSURL *newExecutableURL = nil;
-        for (NSURL *curURL in contents) {
-            if ([curURL.lastPathComponent isEqualToString:self._executableURL.lastPathComponent]) {
-                newExecutableURL = curURL;
-                break;
-            }
+        if ((error = [self _digestErrorForData:pipeline.digest named:packageName]) != nil) {
+            return complete(EMUpdaterStateComplete, error);
         }
         
-        if (newExecutableURL == nil) {
+        if (!pipeline.reader.didExtractEntry) {
             error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadNoSuchFileError userInfo:@{NSLocalizedDescriptionKey: @"Executable not found in update package"}];
-            return block(EMUpdaterStateComplete, nil, error);
+            return complete(EMUpdaterStateComplete, error);
         }
         
-        // Verify signature
-        BOOL isSignatureValid = NO;
-        EMCodeSignature *updateSignature = [[EMCodeSignature alloc] initWithFileURL:newExecutableURL error:&error];
-        if (updateSignature != nil) {
-            isSignatureValid = [[EMCodeSignature embeddedSignature] matches:updateSignature error:&error];
-        }
-        
-        if (!isSignatureValid) {
+        [self _installExecutableAtURL:pipeline.reader.destinationURL error:&error];
+        complete(EMUpdaterStateComplete, error);
+    });
+}
+
+- (BOOL)_installExecutableAtURL:(NSURL *)newExecutableURL error:(NSError **)outError {
+    NSError *error = nil;
+    
+    // Verify signature
+    BOOL isSignatureValid = NO;
+    EMCodeSignature *updateSignature = [[EMCodeSignature alloc] initWithFileURL:newExecutableURL error:&error];
+    if (updateSignature != nil) {
+        isSignatureValid = [[EMCodeSignature embeddedSignature] matches:updateSignature error:&error];
+    }
+    
+    if (!isSignatureValid) {
+        if (outError != NULL) {
             NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
             userInfo[NSLocalizedDescriptionKey] = @"Executable in update package has an invalid signature";
             
@@ -147,86 +306,274 @@ typedef void(^_EMUpdaterStateHandler)(EMUpdaterState, NSProgress *, NSError *);
                 userInfo[NSUnderlyingErrorKey] = error;
             }
             
-            error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSExecutableNotLoadableError userInfo:userInfo];
-            return block(EMUpdaterStateComplete, nil, error);
+            (*outError) = [NSError errorWithDomain:NSCocoaErrorDomain code:NSExecutableNotLoadableError userInfo:userInfo];
         }
-        
-        // Replace binary
-        [[NSFileManager defaultManager] replaceItemAtURL:self._executableURL
-                                           withItemAtURL:newExecutableURL
-                                          backupItemName:[NSString stringWithFormat:@".%@-temp", newExecutableURL.lastPathComponent]
-                                                 options:NSFileManagerItemReplacementUsingNewMetadataOnly
-                                        resultingItemURL:NULL
-                                                   error:&error];
-        
-        block(EMUpdaterStateComplete, nil, error);
+        return NO;
+    }
+    
+    // Replace binary
+    return [[NSFileManager defaultManager] replaceItemAtURL:self._executableURL
+                                              withItemAtURL:newExecutableURL
+                                             backupItemName:[NSString stringWithFormat:@".%@-temp", newExecutableURL.lastPathComponent]
+                                                    options:NSFileManagerItemReplacementUsingNewMetadataOnly
+                                           resultingItemURL:NULL
+                                                      error:outError];
+}
+
+#pragma mark - Patches
+
+- (void)_applyPatchURL:(NSURL *)patchURL fallbackURL:(NSURL *)url withStateHandler:(_EMUpdaterStateHandler)block {
+    dispatch_assert_queue(_q);
+    
+    EMDownload *download = [[EMDownload alloc] initWithURL:patchURL cache:_downloadCache];
+    
+    [download startWithCompletionHandler:^(NSURL *fileURL, NSError *error) {
+        [self _sync:^{
+            if ([download.progress isCancelled]) {
+                return block(EMUpdaterStateCanceled, nil, nil);
+            } else if (fileURL == nil) {
+                // Patches are an optimization, so the package is used if they're unavailable
+                return [self _applyPackageURL:url withStateHandler:block];
+            }
+            
+            NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
+            block(EMUpdaterStateExtracting, progress, nil);
+            
+            // Wait for the manifest (if any) before verifying the patch
+            dispatch_group_notify(self->_digestManifestGroup, self->_q, ^{
+                if ([progress isCancelled]) {
+                    return block(EMUpdaterStateCanceled, nil, nil);
+                }
+                
+                NSURL *tempDir = [self _createTemporaryDirectoryWithError:NULL];
+                BOOL didInstall = tempDir != nil && [self _installPatchAtURL:fileURL named:patchURL.lastPathComponent intoDirectory:tempDir error:NULL];
+                
+                [self->_downloadCache removeFilesForURL:patchURL];
+                
+                if (tempDir != nil) {
+                    [self->_fileManager removeItemAtURL:tempDir error:NULL];
+                }
+                
+                if (didInstall) {
+                    block(EMUpdaterStateComplete, nil, nil);
+                } else {
+                    // The executable may not be the one the patch was created from (or the patch is invalid)
+                    [self _applyPackageURL:url withStateHandler:block];
+                }
+            });
+        }];
     }];
+    
+    block(EMUpdaterStateDownloading, download.progress, nil);
 }
 
-- (void)_unarchiveTarballAtFileURL:(NSURL *)fileURL usingTask:(NSTask *)task progress:(NSProgress *)progress completionHandler:(void(^)(NSArray<NSURL*> *contents, NSError *error))block {
+- (BOOL)_installPatchAtURL:(NSURL *)patchFileURL named:(NSString *)patchName intoDirectory:(NSURL *)tempDir error:(NSError **)outError {
     dispatch_assert_queue(_q);
     
-    NSError *error = nil;
-    NSFileHandle *input = [NSFileHandle fileHandleForReadingFromURL:fileURL error:&error];
-    if (error != nil) {
-        return block(nil, error);
+    NSData *patch = [NSData dataWithContentsOfURL:patchFileURL options:NSDataReadingMappedIfSafe error:outError];
+    if (patch == nil) {
+        return NO;
+    }
+    
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(patch.bytes, (CC_LONG)patch.length, digest.mutableBytes);
+    
+    NSError *digestError = [self _digestErrorForData:digest named:patchName];
+    if (digestError != nil) {
+        if (outError != NULL) {
+            (*outError) = digestError;
+        }
+        return NO;
     }
     
-    NSFileManager *fileManager = [NSFileManager new];
-    fileManager.delegate = self;
+    NSData *base = [NSData dataWithContentsOfURL:self._executableURL options:NSDataReadingMappedIfSafe error:outError];
+    NSData *executable = base ? EMBinaryPatchApply(base, patch, outError) : nil;
+    if (executable == nil) {
+        return NO;
+    }
+    
+    NSURL *newExecutableURL = [tempDir URLByAppendingPathComponent:self._executableURL.lastPathComponent];
+    
+    if (![executable writeToURL:newExecutableURL options:0 error:outError] ||
+        ![_fileManager setAttributes:@{NSFilePosixPermissions: @(0755)} ofItemAtPath:newExecutableURL.path error:outError]) {
+        return NO;
+    }
+    
+    return [self _installExecutableAtURL:newExecutableURL error:outError];
+}
 
-    NSURL *tempDir = [fileManager URLForDirectory:NSItemReplacementDirectory inDomain:NSUserDomainMask appropriateForURL:_executableURL create:YES error:&error];
-    if (tempDir == nil) {
-        return block(nil, error);
+#pragma mark - NSFileManagerDelegate
+
+- (BOOL)fileManager:(NSFileManager *)fileManager shouldRemoveItemAtURL:(NSURL *)URL { return YES; }
+- (BOOL)fileManager:(NSFileManager *)fileManager shouldProceedAfterError:(NSError *)error removingItemAtURL:(NSURL *)URL { return YES; }
+
+@end
+
+
+@implementation _EMUpdatePipeline {
+    CC_SHA256_CTX _digestContext;
+}
+
+- (instancetype)initWithReader:(EMTarballReader *)reader {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _reader = reader;
+    CC_SHA256_Init(&_digestContext);
+    
+    return self;
+}
+
+- (BOOL)appendBytes:(const void *)bytes length:(size_t)length {
+    if (_error != nil) {
+        return NO;
+    }
+    
+    CC_SHA256_Update(&_digestContext, bytes, (CC_LONG)length);
+    
+    NSError *error = nil;
+    if (![_reader appendBytes:bytes length:length error:&error]) {
+        [self failWithError:error];
+        return NO;
     }
     
-    NSPipe *errorPipe = [NSPipe pipe];
-    NSPipe *inputPipe = [NSPipe pipe];
+    return YES;
+}
 
-    task.launchPath = @"/usr/bin/tar";
-    task.arguments = @[@"-zxC", tempDir.path];
-    task.standardInput = inputPipe;
-    task.standardOutput = nil;
-    task.standardError = errorPipe;
+- (BOOL)appendData:(NSData *)data {
+    __block BOOL success = YES;
     
-    [task launch];
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        success = [self appendBytes:bytes length:byteRange.length];
+        (*stop) = !success;
+    }];
+    
+    return success;
+}
+
+- (BOOL)readFileURL:(NSURL *)fileURL progress:(NSProgress *)progress {
+    NSInputStream *input = [NSInputStream inputStreamWithURL:fileURL];
+    [input open];
     
-    // Pipe data to task and wait for it to end in a different queue so we don't block our queue (to correctly handle cancelation)
-    dispatch_group_t ioGroup = dispatch_group_create();
+    if (input.streamStatus != NSStreamStatusOpen) {
+        [self failWithError:input.streamError ?: [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadUnknownError userInfo:@{NSURLErrorKey: fileURL}]];
+        return NO;
+    }
     
-    dispatch_group_async(ioGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-        NSData *chunk = nil;
-        
-        while (task.isRunning && (chunk = [input readDataOfLength:256*1024]).length > 0) {
-            [inputPipe.fileHandleForWriting writeData:chunk];
-            progress.completedUnitCount += chunk.length;
+    NSNumber *fileSize = nil;
+    [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+    
+    progress.totalUnitCount = fileSize.longLongValue;
+    
+    NSMutableData *buffer = [NSMutableData dataWithLength:256 * 1024];
+    
+    while (_error == nil) {
+        if (progress.isCancelled) {
+            [self failWithError:[NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil]];
+            break;
         }
         
-        [inputPipe.fileHandleForWriting closeFile];
-        [task waitUntilExit];
-    });
-    
-    // Wait for task to finish
-    dispatch_group_notify(ioGroup, _q, ^{
-        if (task.terminationStatus == 0) {
-            NSError *error = nil;
-            NSArray *contents = [fileManager contentsOfDirectoryAtURL:tempDir includingPropertiesForKeys:nil options:NSDirectoryEnumerationSkipsPackageDescendants error:&error];
-            
-            if (contents == nil) {
-                block(nil, error);
-            } else {
-                block(contents, nil);
-            }
+        NSInteger length = [input read:buffer.mutableBytes maxLength:buffer.length];
+        
+        if (length < 0) {
+            [self failWithError:input.streamError];
+        } else if (length == 0) {
+            [self finish];
+            break;
         } else {
-            NSString *errorMessage = [[NSString alloc] initWithData:[errorPipe.fileHandleForReading readDataToEndOfFile] encoding:NSUTF8StringEncoding];
-            block(nil, [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:@{ NSLocalizedFailureErrorKey: errorMessage }]);
+            [self appendBytes:buffer.bytes length:(size_t)length];
+            progress.completedUnitCount += length;
         }
-        
-        [fileManager removeItemAtURL:tempDir error:NULL];
-    });
+    }
+    
+    [input close];
+    
+    return _error == nil;
 }
 
-- (BOOL)fileManager:(NSFileManager *)fileManager shouldRemoveItemAtURL:(NSURL *)URL { return YES; }
-- (BOOL)fileManager:(NSFileManager *)fileManager shouldProceedAfterError:(NSError *)error removingItemAtURL:(NSURL *)URL { return YES; }
+- (BOOL)finish {
+    if (_error != nil) {
+        return NO;
+    }
+    
+    NSError *error = nil;
+    if (![_reader finishWithError:&error]) {
+        [self failWithError:error];
+        return NO;
+    }
+    
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest.mutableBytes, &_digestContext);
+    _digest = digest;
+    
+    return YES;
+}
+
+- (void)failWithError:(NSError *)error {
+    if (_error == nil) {
+        _error = error;
+    }
+    
+    [_reader cancel];
+}
 
 @end
+
+
+static NSData *_EMDataFromHexString(NSString *string) {
+    if (string.length % 2 != 0) {
+        return nil;
+    }
+    
+    NSMutableData *data = [NSMutableData dataWithLength:string.length / 2];
+    uint8_t *bytes = data.mutableBytes;
+    
+    for (NSUInteger i = 0; i < string.length; i++) {
+        unichar c = [string characterAtIndex:i];
+        uint8_t value;
+        
+        if (c >= '0' && c <= '9') {
+            value = (uint8_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value = (uint8_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value = (uint8_t)(c - 'A' + 10);
+        } else {
+            return nil;
+        }
+        
+        bytes[i / 2] |= (i % 2 == 0) ? (uint8_t)(value << 4) : value;
+    }
+    
+    return data;
+}
+
+NSDictionary<NSString*,NSData*> *EMUpdaterDigestsFromManifest(NSString *manifest) {
+    NSMutableDictionary *digests = [NSMutableDictionary dictionary];
+    __block BOOL isValid = YES;
+    
+    [manifest enumerateLinesUsingBlock:^(NSString *line, BOOL *stop) {
+        line = [line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        
+        if (line.length == 0 || [line hasPrefix:@"#"]) {
+            return;
+        }
+        
+        // Lines are formatted as "<digest>  <name>" (or "<digest> *<name>" for binary mode)
+        NSUInteger digestLength = CC_SHA256_DIGEST_LENGTH * 2;
+        NSData *digest = line.length > digestLength + 2 ? _EMDataFromHexString([line substringToIndex:digestLength]) : nil;
+        unichar separator = line.length > digestLength + 2 ? [line characterAtIndex:digestLength] : 0;
+        unichar mode = line.length > digestLength + 2 ? [line characterAtIndex:digestLength + 1] : 0;
+        
+        if (digest == nil || separator != ' ' || (mode != ' ' && mode != '*')) {
+            isValid = NO;
+            (*stop) = YES;
+            return;
+        }
+        
+        digests[[line substringFromIndex:digestLength + 2].lastPathComponent] = digest;
+    }];
+    
+    return isValid ? digests : nil;
+}
@@ -0,0 +1,92 @@
+//
+//  EMUpstreamProber.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! Rolling statistics of the probes made to an upstream */
+@interface EMUpstreamStatistics : NSObject
+
+/*! The number of probes which have completed */
+@property(nonatomic,readonly) NSUInteger numberOfProbes;
+
+/*! The number of probes which have failed */
+@property(nonatomic,readonly) NSUInteger numberOfFailures;
+
+/*! The number of probes which have failed since the last successful probe */
+@property(nonatomic,readonly) NSUInteger numberOfConsecutiveFailures;
+
+/*! The average time taken to connect over recent successful probes, in seconds, or a negative value if there are none */
+@property(nonatomic,readonly) NSTimeInterval connectLatency;
+
+/*! The average time between sending a request and receiving the first byte of its response over recent successful probes, in seconds, or a negative value if there are none */
+@property(nonatomic,readonly) NSTimeInterval firstByteLatency;
+
+/*! A short description of why the most recent probe failed (i.e. "refused" or "timed out"), or nil if it succeeded */
+@property(nonatomic,readonly,nullable) NSString *failureReason;
+
+/*! Returns YES if the most recent probe succeeded */
+@property(nonatomic,readonly) BOOL isReachable;
+
+/*! A JSON representation of the statistics, with latencies in milliseconds */
+- (NSDictionary<NSString*,id> *)JSONObject;
+
+@end
+
+
+/*!
+ Periodically probes local upstreams (i.e. the ports of proxy URLs) with an HTTP HEAD request, measuring how long each takes to connect
+ and to respond.
+ 
+ Probes use non-blocking sockets which are multiplexed by a reactor on a single thread, so the number of upstreams doesn't affect the
+ number of threads. Probes are spread out over the interval, and a limited number are in flight at once.
+ */
+@interface EMUpstreamProber : NSObject
+
+/*!
+ The designated initializer.
+ \param interval The number of seconds between probes of each upstream
+ \returns A new instance of \c EMUpstreamProber, which must be started.
+ */
+- (instancetype)initWithInterval:(NSTimeInterval)interval NS_DESIGNATED_INITIALIZER;
+
+/*! The number of seconds between probes of each upstream */
+@property(nonatomic,readonly) NSTimeInterval interval;
+
+/*! The number of seconds after which a probe fails (defaults to 5 or the interval, whichever is less). This must be set before starting. */
+@property(nonatomic) NSTimeInterval timeout;
+
+/*!
+ An optional block invoked on the main queue with the statistics of upstreams whose state changed, keyed by identifier. An upstream's state
+ changes when it's first probed, when it becomes reachable or unreachable, or when it fails for a different reason; changes in latency
+ alone aren't delivered (use \c statistics to read them). Changes are delivered in batches.
+ */
+@property(nonatomic,copy,nullable) void(^updateHandler)(NSDictionary<NSString*,EMUpstreamStatistics*> *statistics);
+
+/*!
+ The upstreams to probe, keyed by identifier (i.e. a tunnel's id). The statistics of upstreams which are unchanged are kept.
+ 
+ Each upstream's URL provides its port and the Host header of requests. Upstreams are connected to by address when their host is an IP
+ address. Otherwise they're connected to over the loopback interface (so that probes never wait for DNS), trying ::1 and then 127.0.0.1
+ until one connects. The address which last connected is tried first.
+ */
+@property(nonatomic,copy) NSDictionary<NSString*,NSURL*> *upstreamURLs;
+
+/*! The statistics of each upstream which has been probed, keyed by identifier */
+@property(nonatomic,readonly) NSDictionary<NSString*,EMUpstreamStatistics*> *statistics;
+
+/*! Start probing from a background thread, which retains the prober until it's stopped */
+- (void)start;
+
+/*! Stop probing, waiting for any probes in flight to be cancelled */
+- (void)stop;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,637 @@
+//
+//  EMUpstreamProber.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#import "EMReactor.h"
+#import "EMUpstreamProber.h"
+
+
+/*! The number of recent successful probes whose latencies are averaged */
+#define _EMUpstreamProbeSampleCount 8
+
+/*! The maximum number of probes in flight at once, which bounds the number of open sockets */
+static const NSUInteger _EMUpstreamProberMaximumConcurrentProbes = 64;
+
+/*! The number of seconds between checks for probes which are due (or have timed out) */
+static const NSTimeInterval _EMUpstreamProberTickInterval = 0.25;
+
+static NSTimeInterval _EMUpstreamProberNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (NSTimeInterval)now.tv_sec + (NSTimeInterval)now.tv_nsec / NSEC_PER_SEC;
+}
+
+static NSString *_EMUpstreamFailureReason(int error) {
+    switch (error) {
+        case ECONNREFUSED:
+            return @"refused";
+        case ECONNRESET:
+            return @"reset";
+        case ETIMEDOUT:
+            return @"timed out";
+        case EHOSTUNREACH:
+        case ENETUNREACH:
+            return @"unreachable";
+        default:
+            return [@(strerror(error)) lowercaseString];
+    }
+}
+
+
+/*! The maximum number of addresses tried for each upstream */
+#define _EMUpstreamProbeMaximumAddressCount 2
+
+/*! The state of an upstream, which is only accessed from the prober's thread */
+@interface _EMUpstreamProbe : NSObject {
+@public
+    // Addresses are tried in order, starting from the address which last connected
+    struct sockaddr_storage _addresses[_EMUpstreamProbeMaximumAddressCount];
+    socklen_t _addressLengths[_EMUpstreamProbeMaximumAddressCount];
+    NSUInteger _numberOfAddresses;
+    NSUInteger _preferredAddress;
+    NSUInteger _numberOfAttempts;
+    
+    int _fd;
+    EMReactorSource *_source;
+    
+    NSTimeInterval _startTime;
+    NSTimeInterval _connectTime;
+    NSTimeInterval _requestTime;
+    NSTimeInterval _deadline;
+    NSTimeInterval _nextProbeTime;
+    
+    NSUInteger _numberOfProbes;
+    NSUInteger _numberOfFailures;
+    NSUInteger _numberOfConsecutiveFailures;
+    NSString *_failureReason;
+    
+    // Latencies of recent successful probes, in a ring buffer
+    NSTimeInterval _connectLatencies[_EMUpstreamProbeSampleCount];
+    NSTimeInterval _firstByteLatencies[_EMUpstreamProbeSampleCount];
+    NSUInteger _numberOfSamples;
+    NSUInteger _nextSample;
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier URL:(NSURL *)url;
+
+@property(nonatomic,readonly) NSString *identifier;
+@property(nonatomic,readonly) NSURL *url;
+@property(nonatomic,readonly) NSData *request;
+
+@end
+
+
+@interface EMUpstreamStatistics()
+- (instancetype)_initWithProbe:(_EMUpstreamProbe *)probe;
+@end
+
+
+@implementation EMUpstreamProber {
+    NSLock *_lock;
+    EMReactor *_reactor;
+    dispatch_semaphore_t _finished;
+    BOOL _isStarted;
+    
+    // Guarded by the lock
+    BOOL _isStopping;
+    BOOL _needsUpstreamUpdate;
+    void(^_updateHandler)(NSDictionary<NSString*,EMUpstreamStatistics*> *);
+    NSMutableDictionary<NSString*,EMUpstreamStatistics*> *_statistics;
+    
+    // Only accessed from the prober's thread
+    NSMutableDictionary<NSString*,_EMUpstreamProbe*> *_probes;
+    EMReactorSource *_tickSource;
+    NSMutableSet<NSString*> *_changedIdentifiers;
+    NSUInteger _numberOfProbesInFlight;
+    NSUInteger _numberOfAddedProbes;
+}
+@synthesize upstreamURLs = _upstreamURLs;
+@synthesize updateHandler = _updateHandler;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithInterval:(NSTimeInterval)interval {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _interval = MAX(interval, _EMUpstreamProberTickInterval);
+    _timeout = MIN(_interval, 5);
+    
+    _lock = [[NSLock alloc] init];
+    _reactor = [[EMReactor alloc] init];
+    _upstreamURLs = @{};
+    _statistics = [NSMutableDictionary dictionary];
+    
+    _probes = [NSMutableDictionary dictionary];
+    _changedIdentifiers = [NSMutableSet set];
+    
+    return self;
+}
+
+- (void (^)(NSDictionary<NSString *,EMUpstreamStatistics *> *))updateHandler {
+    [_lock lock];
+    void(^updateHandler)(NSDictionary<NSString*,EMUpstreamStatistics*> *) = _updateHandler;
+    [_lock unlock];
+    
+    return updateHandler;
+}
+
+- (void)setUpdateHandler:(void (^)(NSDictionary<NSString *,EMUpstreamStatistics *> *))updateHandler {
+    updateHandler = [updateHandler copy];
+    
+    [_lock lock];
+    _updateHandler = updateHandler;
+    [_lock unlock];
+}
+
+- (NSDictionary<NSString *,NSURL *> *)upstreamURLs {
+    [_lock lock];
+    NSDictionary *upstreamURLs = _upstreamURLs;
+    [_lock unlock];
+    
+    return upstreamURLs;
+}
+
+- (void)setUpstreamURLs:(NSDictionary<NSString *,NSURL *> *)upstreamURLs {
+    upstreamURLs = [upstreamURLs copy] ?: @{};
+    
+    [_lock lock];
+    BOOL isChanged = ![_upstreamURLs isEqualToDictionary:upstreamURLs];
+    
+    if (isChanged) {
+        _upstreamURLs = upstreamURLs;
+        _needsUpstreamUpdate = YES;
+    }
+    [_lock unlock];
+    
+    // Upstreams are updated from the prober's thread
+    if (isChanged) {
+        [_reactor wakeUp];
+    }
+}
+
+- (NSDictionary<NSString *,EMUpstreamStatistics *> *)statistics {
+    [_lock lock];
+    NSDictionary *statistics = [_statistics copy];
+    [_lock unlock];
+    
+    return statistics;
+}
+
+- (void)start {
+    if (_isStarted) {
+        return;
+    }
+    
+    _isStarted = YES;
+    _isStopping = NO;
+    _finished = dispatch_semaphore_create(0);
+    
+    // The thread retains the prober until it's stopped
+    [NSThread detachNewThreadWithBlock:^{
+        [self _runProbeLoop];
+    }];
+}
+
+- (void)stop {
+    if (!_isStarted) {
+        return;
+    }
+    
+    _isStarted = NO;
+    
+    // The reactor may not be running yet, in which case it's stopped once it starts
+    [_lock lock];
+    _isStopping = YES;
+    [_lock unlock];
+    
+    [_reactor stop];
+    dispatch_semaphore_wait(_finished, DISPATCH_TIME_FOREVER);
+}
+
+#pragma mark - Probing
+
+- (void)_runProbeLoop {
+    [_reactor runWithBlock:^{
+        [self->_lock lock];
+        BOOL isStopping = self->_isStopping;
+        [self->_lock unlock];
+        
+        if (isStopping) {
+            return [self->_reactor stop];
+        }
+        
+        [self _updateUpstreams];
+        [self _publishChanges];
+    }];
+    
+    for (_EMUpstreamProbe *probe in _probes.allValues) {
+        [self _cancelProbe:probe];
+    }
+    
+    [_probes removeAllObjects];
+    _tickSource = nil;
+    [_reactor invalidate];
+    
+    dispatch_semaphore_signal(_finished);
+}
+
+- (void)_updateUpstreams {
+    [_lock lock];
+    NSDictionary<NSString*,NSURL*> *upstreamURLs = _needsUpstreamUpdate ? _upstreamURLs : nil;
+    _needsUpstreamUpdate = NO;
+    [_lock unlock];
+    
+    if (upstreamURLs == nil) {
+        return;
+    }
+    
+    NSTimeInterval now = _EMUpstreamProberNow();
+    
+    for (NSString *identifier in _probes.allKeys) {
+        _EMUpstreamProbe *probe = _probes[identifier];
+        
+        if (![probe.url isEqual:upstreamURLs[identifier]]) {
+            [self _cancelProbe:probe];
+            [_probes removeObjectForKey:identifier];
+            
+            [_lock lock];
+            [_statistics removeObjectForKey:identifier];
+            [_lock unlock];
+        }
+    }
+    
+    [upstreamURLs enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, NSURL *url, BOOL *stop) {
+        if (self->_probes[identifier] != nil) {
+            return;
+        }
+        
+        _EMUpstreamProbe *probe = [[_EMUpstreamProbe alloc] initWithIdentifier:identifier URL:url];
+        
+        // New upstreams are spread out so that they aren't all probed at once
+        probe->_nextProbeTime = now + MIN(self->_interval, 1) * (double)(self->_numberOfAddedProbes++ % 16) / 16;
+        
+        self->_probes[identifier] = probe;
+    }];
+    
+    // A single timer starts probes which are due and fails those which have timed out. It only runs while there are upstreams to probe.
+    if (_probes.count > 0 && _tickSource == nil) {
+        _tickSource = [_reactor addTimerWithInterval:_EMUpstreamProberTickInterval repeats:YES handler:^{
+            [self _probeUpstreams];
+        }];
+    } else if (_probes.count == 0 && _tickSource != nil) {
+        [_tickSource cancel];
+        _tickSource = nil;
+    }
+}
+
+- (void)_publishChanges {
+    // The handler may be replaced from another thread while probing
+    void(^updateHandler)(NSDictionary<NSString*,EMUpstreamStatistics*> *) = self.updateHandler;
+    
+    if (_changedIdentifiers.count == 0 || updateHandler == nil) {
+        [_changedIdentifiers removeAllObjects];
+        return;
+    }
+    
+    NSMutableDictionary<NSString*,EMUpstreamStatistics*> *statistics = [NSMutableDictionary dictionaryWithCapacity:_changedIdentifiers.count];
+    
+    [_lock lock];
+    for (NSString *identifier in _changedIdentifiers) {
+        statistics[identifier] = _statistics[identifier];
+    }
+    [_lock unlock];
+    
+    [_changedIdentifiers removeAllObjects];
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        updateHandler(statistics);
+    });
+}
+
+- (void)_probeUpstreams {
+    NSTimeInterval now = _EMUpstreamProberNow();
+    
+    for (_EMUpstreamProbe *probe in _probes.allValues) {
+        if (probe->_fd != -1) {
+            if (now >= probe->_deadline) {
+                [self _completeProbe:probe failureReason:@"timed out"];
+            }
+        } else if (now >= probe->_nextProbeTime && _numberOfProbesInFlight < _EMUpstreamProberMaximumConcurrentProbes) {
+            [self _startProbe:probe now:now];
+        }
+    }
+}
+
+- (void)_startProbe:(_EMUpstreamProbe *)probe now:(NSTimeInterval)now {
+    probe->_deadline = now + _timeout;
+    probe->_nextProbeTime = now + _interval;
+    probe->_numberOfAttempts = 0;
+    
+    [self _connectProbe:probe];
+}
+
+/*! Connect to the next address of the probe, which completes the probe if the connection fails and there are no addresses left */
+- (void)_connectProbe:(_EMUpstreamProbe *)probe {
+    NSUInteger index = (probe->_preferredAddress + probe->_numberOfAttempts) % probe->_numberOfAddresses;
+    
+    probe->_numberOfAttempts++;
+    probe->_startTime = _EMUpstreamProberNow();
+    
+    int fd = socket(probe->_addresses[index].ss_family, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return [self _completeProbe:probe failureReason:_EMUpstreamFailureReason(errno)];
+    }
+    
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    
+#if defined(SO_NOSIGPIPE)
+    int noSigPipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+    probe->_fd = fd;
+    _numberOfProbesInFlight++;
+    
+    if (connect(fd, (struct sockaddr *)&probe->_addresses[index], probe->_addressLengths[index]) == 0) {
+        return [self _probeDidConnect:probe toAddressAtIndex:index];
+    } else if (errno != EINPROGRESS) {
+        return [self _probe:probe didFailToConnectWithError:errno];
+    }
+    
+    probe->_source = [_reactor addWritableFileDescriptor:fd handler:^{
+        [self _probeDidFinishConnecting:probe toAddressAtIndex:index];
+    }];
+    
+    if (probe->_source == nil) {
+        [self _completeProbe:probe failureReason:_EMUpstreamFailureReason(errno)];
+    }
+}
+
+- (void)_probeDidFinishConnecting:(_EMUpstreamProbe *)probe toAddressAtIndex:(NSUInteger)index {
+    [probe->_source cancel];
+    probe->_source = nil;
+    
+    int error = 0;
+    socklen_t length = sizeof(error);
+    
+    if (getsockopt(probe->_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0) {
+        error = errno;
+    }
+    
+    if (error != 0) {
+        return [self _probe:probe didFailToConnectWithError:error];
+    }
+    
+    [self _probeDidConnect:probe toAddressAtIndex:index];
+}
+
+- (void)_probeDidConnect:(_EMUpstreamProbe *)probe toAddressAtIndex:(NSUInteger)index {
+    probe->_connectTime = _EMUpstreamProberNow();
+    probe->_preferredAddress = index;
+    
+    [self _sendRequestForProbe:probe];
+}
+
+- (void)_probe:(_EMUpstreamProbe *)probe didFailToConnectWithError:(int)error {
+    if (probe->_numberOfAttempts >= probe->_numberOfAddresses) {
+        return [self _completeProbe:probe failureReason:_EMUpstreamFailureReason(error)];
+    }
+    
+    // The probe stays in flight while the next address is tried
+    [self _cancelProbe:probe];
+    [self _connectProbe:probe];
+}
+
+- (void)_sendRequestForProbe:(_EMUpstreamProbe *)probe {
+#if defined(MSG_NOSIGNAL)
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+
+    // Requests are small enough to fit within the send buffer of a new socket
+    NSData *request = probe.request;
+    ssize_t count = send(probe->_fd, request.bytes, request.length, flags);
+    
+    if (count != (ssize_t)request.length) {
+        return [self _completeProbe:probe failureReason:count < 0 ? _EMUpstreamFailureReason(errno) : @"closed"];
+    }
+    
+    probe->_requestTime = _EMUpstreamProberNow();
+    probe->_source = [_reactor addReadableFileDescriptor:probe->_fd handler:^{
+        [self _probeDidReceiveResponse:probe];
+    }];
+    
+    if (probe->_source == nil) {
+        [self _completeProbe:probe failureReason:_EMUpstreamFailureReason(errno)];
+    }
+}
+
+- (void)_probeDidReceiveResponse:(_EMUpstreamProbe *)probe {
+    NSTimeInterval now = _EMUpstreamProberNow();
+    
+    // Only the first bytes of the status line are read, as the connection is closed once the response has started
+    char buffer[8];
+    ssize_t count = recv(probe->_fd, buffer, sizeof(buffer), 0);
+    
+    if (count < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    } else if (count < 0) {
+        return [self _completeProbe:probe failureReason:_EMUpstreamFailureReason(errno)];
+    } else if (count == 0) {
+        return [self _completeProbe:probe failureReason:@"closed"];
+    } else if (strncmp(buffer, "HTTP/", MIN((size_t)count, 5)) != 0) {
+        return [self _completeProbe:probe failureReason:@"not HTTP"];
+    }
+    
+    NSUInteger sample = probe->_nextSample;
+    probe->_connectLatencies[sample] = probe->_connectTime - probe->_startTime;
+    probe->_firstByteLatencies[sample] = now - probe->_requestTime;
+    probe->_nextSample = (sample + 1) % _EMUpstreamProbeSampleCount;
+    probe->_numberOfSamples = MIN(probe->_numberOfSamples + 1, _EMUpstreamProbeSampleCount);
+    
+    [self _completeProbe:probe failureReason:nil];
+}
+
+/*! Close the probe's socket without recording a result */
+- (void)_cancelProbe:(_EMUpstreamProbe *)probe {
+    // Sources are cancelled before the socket is closed, as a new socket may reuse its descriptor
+    [probe->_source cancel];
+    probe->_source = nil;
+    
+    if (probe->_fd != -1) {
+        close(probe->_fd);
+        probe->_fd = -1;
+        _numberOfProbesInFlight--;
+    }
+}
+
+- (void)_completeProbe:(_EMUpstreamProbe *)probe failureReason:(NSString *)failureReason {
+    [self _cancelProbe:probe];
+    
+    // Changes are only published when an upstream is first probed, or when it becomes reachable (or fails for a different reason)
+    BOOL isChanged = probe->_numberOfProbes == 0 || !((failureReason == nil && probe->_failureReason == nil) || [failureReason isEqualToString:probe->_failureReason]);
+    
+    probe->_numberOfProbes++;
+    probe->_failureReason = failureReason;
+    
+    if (failureReason != nil) {
+        probe->_numberOfFailures++;
+        probe->_numberOfConsecutiveFailures++;
+    } else {
+        probe->_numberOfConsecutiveFailures = 0;
+    }
+    
+    EMUpstreamStatistics *statistics = [[EMUpstreamStatistics alloc] _initWithProbe:probe];
+    
+    [_lock lock];
+    _statistics[probe.identifier] = statistics;
+    [_lock unlock];
+    
+    if (isChanged) {
+        [_changedIdentifiers addObject:probe.identifier];
+    }
+}
+
+@end
+
+
+@implementation _EMUpstreamProbe
+
+- (instancetype)initWithIdentifier:(NSString *)identifier URL:(NSURL *)url {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _identifier = [identifier copy];
+    _url = [url copy];
+    _fd = -1;
+    
+    NSString *host = url.host.length > 0 ? url.host : @"localhost";
+    uint16_t port = url.port != nil ? url.port.unsignedShortValue : 80;
+    
+    struct in6_addr address6;
+    struct in_addr address;
+    
+    // Hosts which aren't IP addresses are assumed to be local, and are tried over IPv6 and IPv4 loopback (as servers may only bind to one)
+    if (inet_pton(AF_INET6, host.UTF8String, &address6) == 1) {
+        [self _addAddress6:address6 port:port];
+    } else if (inet_pton(AF_INET, host.UTF8String, &address) == 1) {
+        [self _addAddress:address port:port];
+    } else {
+        [self _addAddress6:in6addr_loopback port:port];
+        [self _addAddress:(struct in_addr){ .s_addr = htonl(INADDR_LOOPBACK) } port:port];
+    }
+    
+    NSString *hostHeader = [host containsString:@":"] ? [NSString stringWithFormat:@"[%@]", host] : host;
+    if (url.port != nil) {
+        hostHeader = [hostHeader stringByAppendingFormat:@":%u", port];
+    }
+    
+    NSString *request = [NSString stringWithFormat:@"HEAD / HTTP/1.1\r\nHost: %@\r\nUser-Agent: emporter-cli\r\nAccept: */*\r\nConnection: close\r\n\r\n", hostHeader];
+    _request = [request dataUsingEncoding:NSUTF8StringEncoding];
+    
+    return self;
+}
+
+- (void)_addAddress:(struct in_addr)address port:(uint16_t)port {
+    struct sockaddr_in *socketAddress = (struct sockaddr_in *)&_addresses[_numberOfAddresses];
+    
+    socketAddress->sin_family = AF_INET;
+    socketAddress->sin_port = htons(port);
+    socketAddress->sin_addr = address;
+    
+    _addressLengths[_numberOfAddresses++] = sizeof(struct sockaddr_in);
+}
+
+- (void)_addAddress6:(struct in6_addr)address port:(uint16_t)port {
+    struct sockaddr_in6 *socketAddress = (struct sockaddr_in6 *)&_addresses[_numberOfAddresses];
+    
+    socketAddress->sin6_family = AF_INET6;
+    socketAddress->sin6_port = htons(port);
+    socketAddress->sin6_addr = address;
+    
+    _addressLengths[_numberOfAddresses++] = sizeof(struct sockaddr_in6);
+}
+
+@end
+
+
+@implementation EMUpstreamStatistics
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)_initWithProbe:(_EMUpstreamProbe *)probe {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _numberOfProbes = probe->_numberOfProbes;
+    _numberOfFailures = probe->_numberOfFailures;
+    _numberOfConsecutiveFailures = probe->_numberOfConsecutiveFailures;
+    _failureReason = probe->_failureReason;
+    _isReachable = probe->_numberOfProbes > 0 && probe->_failureReason == nil;
+    
+    _connectLatency = -1;
+    _firstByteLatency = -1;
+    
+    if (probe->_numberOfSamples > 0) {
+        NSTimeInterval connectLatency = 0, firstByteLatency = 0;
+        
+        for (NSUInteger i = 0; i < probe->_numberOfSamples; i++) {
+            connectLatency += probe->_connectLatencies[i];
+            firstByteLatency += probe->_firstByteLatencies[i];
+        }
+        
+        _connectLatency = connectLatency / probe->_numberOfSamples;
+        _firstByteLatency = firstByteLatency / probe->_numberOfSamples;
+    }
+    
+    return self;
+}
+
+- (NSDictionary<NSString *,id> *)JSONObject {
+    id (^milliseconds)(NSTimeInterval) = ^id(NSTimeInterval latency) {
+        return latency >= 0 ? @(round(latency * 1000 * 100) / 100) : [NSNull null];
+    };
+    
+    return @{@"isReachable": @(_isReachable),
+             @"connectLatencyMs": milliseconds(_connectLatency),
+             @"firstByteLatencyMs": milliseconds(_firstByteLatency),
+             @"probeCount": @(_numberOfProbes),
+             @"failureCount": @(_numberOfFailures),
+             @"consecutiveFailureCount": @(_numberOfConsecutiveFailures),
+             @"failureReason": _failureReason ?: [NSNull null]};
+}
+
+@end
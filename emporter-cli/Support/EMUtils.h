@@ -7,6 +7,7 @@
 //
 
 #import "Emporter.h"
+#import "EMTunnelSnapshot.h"
 #import "YDCommandOutput.h"
 #import "YDCommandVariable.h"
 
@@ -41,13 +42,19 @@ NSDictionary* EMJSONObjectForTunnel(EmporterTunnel *tunnel, BOOL includeState);
 /*! Create a JSON object for a tunnel's state */
 NSDictionary* EMJSONObjectForTunnelState(EmporterTunnel *tunnel);
 
+/*! Create a JSON object for a tunnel snapshot and optionally include its state */
+NSDictionary* EMJSONObjectForTunnelSnapshot(EMTunnelSnapshot *snapshot, BOOL includeState);
+
+/*! Create a JSON object for a tunnel snapshot's state */
+NSDictionary* EMJSONObjectForTunnelSnapshotState(EMTunnelSnapshot *snapshot);
+
 #pragma mark - Formatting Output
 
 /*! A description for a tunnel's state, suitable for output, with optional styling */
-NSString *EMTunnelStateDescription(EmporterTunnel *tunnel, BOOL ascii, YDCommandOutputStyle *__nullable outStyle);
+NSString *EMTunnelStateDescription(EMTunnelSnapshot *tunnel, BOOL ascii, YDCommandOutputStyle *__nullable outStyle);
 
 /*! A description of a tunnel's source, suitable for output */
-NSString *EMTunnelSourceDescription(EmporterTunnel *tunnel);
+NSString *EMTunnelSourceDescription(EMTunnelSnapshot *tunnel);
 
 /*! A description of the service state, suitable for output, with optional styling */
 NSString *EMServiceStateDescription(EmporterServiceState serviceState, BOOL ascii, YDCommandOutputStyle *__nullable outStyle);
@@ -113,4 +120,7 @@ extern void EMBlockRunLoopStop(void);
  */
 extern NSRunningApplication *__nullable EMHostApplication(void);
 
+/*! The resident memory size of the current process, in bytes, or 0 if it couldn't be read */
+extern uint64_t EMResidentMemorySize(void);
+
 NS_ASSUME_NONNULL_END
@@ -6,10 +6,13 @@
 //  Copyright © 2019 Young Dynasty. All rights reserved.
 //
 
+#include <mach/mach.h>
 #include <sys/sysctl.h>
 
 #import "EMUtils.h"
 #import "EMProcessNode.h"
+#import "EMReactor.h"
+#import "EMTunnelSnapshot.h"
 
 #import "YDCommandOutput.h"
 
@@ -22,36 +25,58 @@ EMJSONError EMJSONErrorCreateInternal(NSString *message, NSError *error) {
 }
 
 NSDictionary* EMJSONObjectForTunnelState(EmporterTunnel *tunnel) {
+    return EMJSONObjectForTunnelSnapshotState([[EMTunnelSnapshot alloc] initWithTunnel:tunnel keys:EMTunnelSnapshot.stateKeys]);
+}
+
+NSDictionary* EMJSONObjectForTunnel(EmporterTunnel *tunnel, BOOL includeState) {
+    // Only properties which are written are read, and those which depend on the kind of tunnel are read once its kind is known
+    EMTunnelSnapshot *snapshot = [[EMTunnelSnapshot alloc] initWithTunnel:tunnel keys:@[@"id", @"name", @"isEnabled", @"isAuthEnabled", @"kind"]];
+    NSMutableArray<NSString*> *keys = [NSMutableArray array];
+    
+    if (snapshot.kind == EmporterTunnelKindProxy) {
+        [keys addObjectsFromArray:@[@"proxyPort", @"proxyHostHeader", @"shouldRewriteHostHeader"]];
+    } else {
+        [keys addObjectsFromArray:@[@"directory", @"directoryIndexFile", @"isBrowsingEnabled", @"isLiveReloadEnabled"]];
+    }
+    
+    if (includeState) {
+        [keys addObjectsFromArray:EMTunnelSnapshot.stateKeys];
+    }
+    
+    NSDictionary *values = [[[EMTunnelSnapshot alloc] initWithTunnel:tunnel keys:keys].values dictionaryWithValuesForKeys:keys];
+    
+    return EMJSONObjectForTunnelSnapshot([snapshot snapshotByApplyingValues:values], includeState);
+}
+
+NSDictionary* EMJSONObjectForTunnelSnapshotState(EMTunnelSnapshot *snapshot) {
     NSMutableDictionary *tunnelProperties = [NSMutableDictionary dictionary];
     
-    tunnelProperties[@"state"] = EMTunnelStateDescription(tunnel, NO, NULL);
+    tunnelProperties[@"state"] = EMTunnelStateDescription(snapshot, NO, NULL);
     
-    if (tunnel.state == EmporterTunnelStateConflicted) {
-        tunnelProperties[@"conflictReason"] = tunnel.conflictReason ?: [NSNull null];
+    if (snapshot.state == EmporterTunnelStateConflicted) {
+        tunnelProperties[@"conflictReason"] = snapshot.conflictReason ?: [NSNull null];
     }
     
-    tunnelProperties[@"url"] = tunnel.remoteUrl ?: [NSNull null];
+    tunnelProperties[@"url"] = snapshot.remoteUrl ?: [NSNull null];
     
     return tunnelProperties;
 }
 
-NSDictionary* EMJSONObjectForTunnel(EmporterTunnel *tunnel, BOOL includeState) {
+NSDictionary* EMJSONObjectForTunnelSnapshot(EMTunnelSnapshot *snapshot, BOOL includeState) {
     NSMutableDictionary *tunnelProperties = [NSMutableDictionary dictionary];
     
-    tunnelProperties[@"_id"] = tunnel.id ?: [NSNull null];
+    tunnelProperties[@"_id"] = snapshot.id ?: [NSNull null];
+    tunnelProperties[@"name"] = snapshot.name ?: [NSNull null];
     
-    // EmporterKit doesn't send the right AppleEvent to get the tunnel name (a ScriptingBridge.framework bug)
-    tunnelProperties[@"name"] = (tunnel.properties ?: @{})[@"name"] ?: [NSNull null];
+    tunnelProperties[@"isEnabled"] = @(snapshot.isEnabled);
+    tunnelProperties[@"isAuthEnabled"] = @(snapshot.isAuthEnabled);
     
-    tunnelProperties[@"isEnabled"] = @(tunnel.isEnabled);
-    tunnelProperties[@"isAuthEnabled"] = @(tunnel.isAuthEnabled);
-    
-    if (tunnel.kind == EmporterTunnelKindProxy) {
+    if (snapshot.kind == EmporterTunnelKindProxy) {
         tunnelProperties[@"kind"] = @"proxy";
-        tunnelProperties[@"proxyPort"] = tunnel.proxyPort ?: [NSNull null];
-        tunnelProperties[@"proxyRewriteHostHeader"] = @(tunnel.shouldRewriteHostHeader);
+        tunnelProperties[@"proxyPort"] = snapshot.proxyPort ?: [NSNull null];
+        tunnelProperties[@"proxyRewriteHostHeader"] = @(snapshot.shouldRewriteHostHeader);
         
-        NSString *hostHeader = tunnel.proxyHostHeader;
+        NSString *hostHeader = snapshot.proxyHostHeader;
         if (hostHeader != nil && hostHeader.length == 0) {
             hostHeader = nil;
         }
@@ -59,12 +84,12 @@ NSDictionary* EMJSONObjectForTunnel(EmporterTunnel *tunnel, BOOL includeState) {
         tunnelProperties[@"proxyHostHeader"] = hostHeader ?: @"localhost";
     } else {
         tunnelProperties[@"kind"] = @"directory";
-        tunnelProperties[@"directory"] = tunnel.directory ? tunnel.directory.path : (tunnel.properties[@"directoryPath"] ?: [NSNull null]);
+        tunnelProperties[@"directory"] = snapshot.directory.path ?: [NSNull null];
         
-        tunnelProperties[@"isBrowsingEnabled"] = @(tunnel.isBrowsingEnabled);
-        tunnelProperties[@"isLiveReloadEnabled"] = @(tunnel.isLiveReloadEnabled);
+        tunnelProperties[@"isBrowsingEnabled"] = @(snapshot.isBrowsingEnabled);
+        tunnelProperties[@"isLiveReloadEnabled"] = @(snapshot.isLiveReloadEnabled);
 
-        NSString *indexFile = tunnel.directoryIndexFile;
+        NSString *indexFile = snapshot.directoryIndexFile;
         if (indexFile != nil && indexFile.length == 0) {
             indexFile = nil;
         }
@@ -73,7 +98,7 @@ NSDictionary* EMJSONObjectForTunnel(EmporterTunnel *tunnel, BOOL includeState) {
     }
 
     if (includeState) {
-        [tunnelProperties addEntriesFromDictionary:EMJSONObjectForTunnelState(tunnel)];
+        [tunnelProperties addEntriesFromDictionary:EMJSONObjectForTunnelSnapshotState(snapshot)];
     }
     
     return tunnelProperties;
@@ -100,14 +125,14 @@ static NSString *_EMTunnelStateDescription(EmporterTunnelState tunnelState, BOOL
     }
 }
 
-NSString *EMTunnelStateDescription(EmporterTunnel *tunnel, BOOL ascii, YDCommandOutputStyle *outStyle) {
+NSString *EMTunnelStateDescription(EMTunnelSnapshot *tunnel, BOOL ascii, YDCommandOutputStyle *outStyle) {
     EmporterTunnelState tunnelState = tunnel.state ?: EmporterTunnelStateDisconnected;
     NSString *description = _EMTunnelStateDescription(tunnelState, ascii);
     
     if (outStyle != NULL) {
         switch (tunnelState) {
             case EmporterTunnelStateConnected: {
-                NSString *name = tunnel.properties[@"name"] ?: tunnel.name ?: @"";
+                NSString *name = tunnel.name ?: @"";
                 NSString *urlString = tunnel.remoteUrl ?: @"";
                 
                 if ([urlString localizedCaseInsensitiveContainsString:name]) {
@@ -136,12 +161,12 @@ NSString *EMTunnelStateDescription(EmporterTunnel *tunnel, BOOL ascii, YDCommand
     return description;
 }
 
-YDCommandOutputStyle EMTunnelStateOutputStyle(EmporterTunnel *tunnel) {
+YDCommandOutputStyle EMTunnelStateOutputStyle(EMTunnelSnapshot *tunnel) {
     EmporterTunnelState tunnelState = tunnel.state ?: EmporterTunnelStateDisconnected;
     
     switch (tunnelState) {
         case EmporterTunnelStateConnected: {
-            NSString *name = tunnel.properties[@"name"] ?: tunnel.name ?: @"";
+            NSString *name = tunnel.name ?: @"";
             NSString *urlString = tunnel.remoteUrl ?: @"";
             
             if ([urlString localizedCaseInsensitiveContainsString:name]) {
@@ -162,7 +187,7 @@ YDCommandOutputStyle EMTunnelStateOutputStyle(EmporterTunnel *tunnel) {
     }
 }
 
-NSString *EMTunnelSourceDescription(EmporterTunnel *tunnel) {
+NSString *EMTunnelSourceDescription(EMTunnelSnapshot *tunnel) {
     switch (tunnel.kind) {
         case EmporterTunnelKindProxy:
             return [NSString stringWithFormat:@"%@:%@", tunnel.shouldRewriteHostHeader ? tunnel.proxyHostHeader : @"localhost", tunnel.proxyPort ?: @""];
@@ -420,53 +445,19 @@ id EMNotificationObserverBlock(NSNotificationName name, id object, void(^block)(
     return _EMDeferredBlock(^{ [[NSNotificationCenter defaultCenter] removeObserver:observer]; });
 }
 
-static void _NOOP(void *info) {}
-
 void EMBlockRunLoopRun(dispatch_block_t block) {
-    // Schedule run loop source so we can break our loop as needed
-    CFRunLoopRef runLoop = CFRunLoopGetCurrent();
-    CFRunLoopSourceContext runLoopCtx = { .perform = &_NOOP };
-    CFRunLoopSourceRef runLoopSource = CFRunLoopSourceCreate(NULL, 1, &runLoopCtx);
-    CFRunLoopAddSource(runLoop, runLoopSource, kCFRunLoopCommonModes);
-    
-    // Add termination termination signal handlers
-    __block BOOL isTerminated = NO;
-    NSMutableSet *signalSources = [NSMutableSet set];
+    // Signals, notifications and blocks on the main queue are handled on this thread without waking up periodically
+    EMReactor *reactor = [[EMReactor alloc] init];
     
     int signals[] = {SIGTERM, SIGINT, SIGUSR2, -1};
     for (int i = 0; signals[i] != -1; i++) {
-        struct sigaction action = { 0 };
-        action.sa_handler = SIG_IGN;
-        sigaction(signals[i], &action, NULL);
-        
-        dispatch_source_t sigSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, signals[i], 0, dispatch_get_main_queue());
-        dispatch_source_set_event_handler(sigSource, ^{
-            isTerminated = true;
-            CFRunLoopSourceSignal(runLoopSource);
-            CFRunLoopWakeUp(runLoop);
-        });
-        [signalSources addObject:sigSource];
-
-        dispatch_resume(sigSource);
+        [reactor addSignal:signals[i] handler:^{ [reactor stop]; }];
     }
     
-    do {
-        if (block != NULL) {
-            @autoreleasepool { block(); }
-        }
-    } while (!isTerminated && CFRunLoopRunInMode(kCFRunLoopDefaultMode, 5, true) != kCFRunLoopRunStopped);
+    [reactor runWithBlock:block];
     
     // Restore default signal actions
-    for (dispatch_source_t sigSource in signalSources) {
-        struct sigaction action = { 0 };
-        action.sa_handler = SIG_DFL;
-        sigaction((int)dispatch_source_get_handle(sigSource), &action, NULL);
-        
-        dispatch_source_cancel(sigSource);
-    }
-    
-    CFRunLoopRemoveSource(runLoop, runLoopSource, kCFRunLoopCommonModes);
-    CFRelease(runLoopSource);
+    [reactor invalidate];
 }
 
 void EMBlockRunLoopStop(void) { kill(getpid(), SIGUSR2); }
@@ -487,3 +478,14 @@ NSRunningApplication* EMHostApplication() {
     
     return hostApplication;
 }
+
+uint64_t EMResidentMemorySize() {
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    
+    return info.resident_size;
+}
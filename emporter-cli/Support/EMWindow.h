@@ -12,12 +12,30 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol EMWindowWriter;
+@protocol EMWindowCanvas;
 typedef void(^EMWindowWriterBlock)(id <EMWindowWriter> output);
 
+/*! Keys handled by a window (i.e. for scrolling) */
+typedef NS_ENUM(uint8, EMWindowKey) {
+    EMWindowKeyUp,
+    EMWindowKeyDown,
+    EMWindowKeyPageUp,
+    EMWindowKeyPageDown,
+    EMWindowKeyHome,
+    EMWindowKeyEnd
+};
+
 
 /*! EMWindow defines a simple window which can be presented in the terminal. */
 @interface EMWindow : NSObject
 
+/*!
+ Create a window which draws its contents into a canvas instead of the terminal (i.e. for testing).
+ 
+ The title, status and border of the window aren't drawn, and neither signals nor key presses are handled by its draw loop.
+ */
+- (instancetype)initWithCanvas:(id <EMWindowCanvas>)canvas;
+
 /*! An optional title string to be displayed in the top of the window */
 @property(nonatomic) NSString *__nullable title;
 
@@ -27,6 +45,20 @@ typedef void(^EMWindowWriterBlock)(id <EMWindowWriter> output);
 /*! Draw a border for the window */
 @property(nonatomic) BOOL drawsBorder;
 
+/*!
+ The maximum number of frames drawn per second, or 0 for no limit (the default).
+ 
+ Calls to \c setNeedsDisplay made before the frame budget has elapsed are coalesced into a single redraw.
+ */
+@property(nonatomic) NSUInteger maximumFramesPerSecond;
+
+/*!
+ An optional block invoked on the main thread when a key is pressed while the draw loop is running.
+ 
+ Arrow keys, page up/down and home/end are supported, as well as their less-style equivalents (k/j, b/space and g/G).
+ */
+@property(nonatomic,nullable) void(^keyHandler)(EMWindowKey key);
+
 /*!
  Run the main draw loop.
  
@@ -61,6 +93,9 @@ typedef void(^EMWindowWriterBlock)(id <EMWindowWriter> output);
 /*! Write output to the window */
 @protocol EMWindowWriter <YDCommandOutputWriter>
 
+/*! The number of rows in the window, which may be exceeded (in which case excess rows are not drawn) */
+@property(nonatomic,readonly) NSUInteger height;
+
 /*! Truncate contents to fit the window's current width within a block */
 - (void)applyTruncationWithinBlock:(YDCommandOutputWriterBlock)block;
 
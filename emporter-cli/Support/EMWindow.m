@@ -9,144 +9,237 @@
 #import <curses.h>
 #import <sys/ioctl.h>
 
+#import "EMDisplayWidth.h"
+#import "EMReactor.h"
 #import "EMWindow.h"
+#import "EMWindowBuffer.h"
 
 
+@interface _EMCursesCanvas : NSObject <EMWindowCanvas>
+- (instancetype)initWithWindow:(WINDOW *)w;
+@property(nonatomic,readonly) WINDOW *window;
+@end
+
+
+/*! Writes styled spans directly into a buffer, so that no style escapes need to be encoded or parsed */
 @interface _EMWindowWriter : NSObject
-- (instancetype)initWithWindow:(WINDOW *)w output:(id <YDCommandOutputWriter>)output;
+- (instancetype)initWithBuffer:(EMWindowSpanBuffer *)buffer width:(NSUInteger)width height:(NSUInteger)height style:(YDCommandOutputStyle)style;
 
-@property(nonatomic, readonly) WINDOW *window;
-@property(nonatomic, readonly) id<YDCommandOutputWriter> output;
+@property(nonatomic, readonly) EMWindowSpanBuffer *buffer;
+@property(nonatomic, readonly) NSUInteger width;
+@property(nonatomic, readonly) NSUInteger height;
 @end
 
 
 @interface EMWindow()
-@property(nonatomic,readonly) dispatch_queue_t _q;
 @property(nonatomic,setter=_setIsTerminated:) BOOL isTerminated;
-@property(nonatomic,setter=_setWakeUpBlock:) void(^_wakeUpBlock)(void);
 @end
 
+
+/*! Parse key presses from terminal input, ignoring anything unsupported */
+static void _EMWindowEnumerateKeys(const char *bytes, size_t length, void(^block)(EMWindowKey key)) {
+    for (size_t i = 0; i < length; i++) {
+        // Escape sequences: ESC [ A (or ESC O A in application mode), or ESC [ 5 ~
+        if (bytes[i] == '\033' && i + 2 < length && (bytes[i + 1] == '[' || bytes[i + 1] == 'O')) {
+            char code = bytes[i + 2];
+            i += 2;
+            
+            if (code >= '1' && code <= '8' && i + 1 < length && bytes[i + 1] == '~') {
+                i++;
+                
+                switch (code) {
+                    case '1': case '7': block(EMWindowKeyHome); break;
+                    case '4': case '8': block(EMWindowKeyEnd); break;
+                    case '5': block(EMWindowKeyPageUp); break;
+                    case '6': block(EMWindowKeyPageDown); break;
+                    default: break;
+                }
+            } else {
+                switch (code) {
+                    case 'A': block(EMWindowKeyUp); break;
+                    case 'B': block(EMWindowKeyDown); break;
+                    case 'H': block(EMWindowKeyHome); break;
+                    case 'F': block(EMWindowKeyEnd); break;
+                    default: break;
+                }
+            }
+            
+            continue;
+        }
+        
+        switch (bytes[i]) {
+            case 'k': block(EMWindowKeyUp); break;
+            case 'j': block(EMWindowKeyDown); break;
+            case 'b': block(EMWindowKeyPageUp); break;
+            case ' ': block(EMWindowKeyPageDown); break;
+            case 'g': block(EMWindowKeyHome); break;
+            case 'G': block(EMWindowKeyEnd); break;
+            default: break;
+        }
+    }
+}
+
+
 @implementation EMWindow {
+    EMReactor *_reactor;
+    
+    // Headless windows draw into a canvas; otherwise curses windows are used
+    id<EMWindowCanvas> _canvas;
+    
+    WINDOW *_mainWindow;
+    WINDOW *_contentWindow;
+    EMWindowBuffer *_buffer;
+    
+    BOOL _needsDisplay;
     BOOL _needsResize;
+    BOOL _needsChrome;
+    
+    CFAbsoluteTime _lastFrameTime;
+    EMReactorSource *_frameTimer;
 }
-@synthesize _q = _q;
 
-- (instancetype)init {
+- (instancetype)initWithCanvas:(id<EMWindowCanvas>)canvas {
     self = [super init];
     if (self == nil)
         return nil;
     
-    _q = dispatch_queue_create("net.youngdynasty.emporter-cli.window", NULL);
+    _canvas = canvas;
     
     return self;
 }
 
 - (void)setNeedsDisplay {
-    [self _wakeUp];
-}
-
-- (void)_setNeedsResize:(BOOL)flag {
-    _needsResize = flag;
-    [self _wakeUp];
+    _needsDisplay = YES;
+    [_reactor wakeUp];
 }
 
 - (void)setTitle:(NSString *)title {
+    if (title == _title || [title isEqualToString:_title]) {
+        return;
+    }
+    
     _title = title;
-    [self _wakeUp];
+    _needsChrome = YES;
+    [self setNeedsDisplay];
+}
+
+- (void)setStatus:(NSString *)status {
+    if (status == _status || [status isEqualToString:_status]) {
+        return;
+    }
+    
+    _status = status;
+    _needsChrome = YES;
+    [self setNeedsDisplay];
 }
 
 - (void)setDrawsBorder:(BOOL)drawsBorder {
     _drawsBorder = drawsBorder;
-    [self _wakeUp];
+    _needsChrome = YES;
+    [self setNeedsDisplay];
 }
 
 - (void)close {
     _isClosed = YES;
-    [self _wakeUp];
+    [_reactor wakeUp];
 }
 
 - (void)_setIsTerminated:(BOOL)isTerminated {
     _isTerminated = isTerminated;
-    [self _wakeUp];
+    [_reactor wakeUp];
 }
 
 - (void)runDrawLoopWithBlock:(void(^)(id <EMWindowWriter> output))block {
-    // Handle termination signals
-    dispatch_source_t sigIntSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGINT, 0, dispatch_get_main_queue());
-    dispatch_source_set_event_handler(sigIntSource, ^{ self.isTerminated = true; });
-
-    dispatch_source_t sigTermSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGTERM, 0, dispatch_get_main_queue());
-    dispatch_source_set_event_handler(sigTermSource, ^{ self.isTerminated = true; });
-
-    // Handle resize signals
-    dispatch_source_t sigResizeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGWINCH, 0, dispatch_get_main_queue());
-    dispatch_source_set_event_handler(sigResizeSource, ^{
-        struct winsize ws;
-        ioctl(0, TIOCGWINSZ, &ws);
-        
-        if (is_term_resized(ws.ws_row, ws.ws_col)) {
-            [self _setNeedsResize:YES];
-        }
-    });
+    // Signals, key presses, frame timers and wake ups (as well as app notifications delivered to the run loop) are all handled on
+    // this thread. The block is only invoked when something has changed, so the loop never wakes up while it's idle.
+    EMReactor *reactor = [[EMReactor alloc] init];
     
-    // Override default termination signals
-    {
-        struct sigaction action = { 0 };
-        action.sa_handler = SIG_IGN;
+    if (_canvas == nil) {
+        // Handle termination signals
+        [reactor addSignal:SIGINT handler:^{ self.isTerminated = YES; }];
+        [reactor addSignal:SIGTERM handler:^{ self.isTerminated = YES; }];
         
-        sigaction(SIGINT, &action, NULL);
-        sigaction(SIGTERM, &action, NULL);
+        // Handle resize signals
+        [reactor addSignal:SIGWINCH handler:^{
+            struct winsize ws;
+            ioctl(0, TIOCGWINSZ, &ws);
+            
+            if (is_term_resized(ws.ws_row, ws.ws_col)) {
+                self->_needsResize = YES;
+                [self setNeedsDisplay];
+            }
+        }];
+        
+        // Handle key presses (curses reads input unbuffered without echoing it once the draw loop has started)
+        if (isatty(STDIN_FILENO)) {
+            [self _startReadingKeysWithReactor:reactor];
+        }
     }
     
-    dispatch_resume(sigIntSource);
-    dispatch_resume(sigTermSource);
-    dispatch_resume(sigResizeSource);
-
     _isClosed = NO;
     _isTerminated = NO;
+    _reactor = reactor;
     
-    // Detach a new run loop so that only explicit calls to wake up our draw routine
-    // will cause redraws. We must also create a new run loop source so this method
-    // will block until the draw loop has exited.
-    __block BOOL isRunning = YES;
+    [self _openWindow];
     
-    CFRunLoopRef callerRunLoop = CFRunLoopGetCurrent();
-    CFRunLoopSourceContext context = { .perform = &_NOOPRunLoop };
-    CFRunLoopSourceRef wakeUpSource = CFRunLoopSourceCreate(NULL, 0, &context);
-    CFRunLoopAddSource(callerRunLoop, wakeUpSource, kCFRunLoopCommonModes);
+    _needsDisplay = YES;
+    _needsChrome = YES;
+    _lastFrameTime = 0;
     
-    [self _detachRunLoopWithinBlock:^{
-        [self _runDrawLoopBlock:block];
-
-        isRunning = NO;
-        CFRunLoopSourceSignal(wakeUpSource);
-        CFRunLoopWakeUp(callerRunLoop);
+    [reactor runWithBlock:^{
+        // Break when closed / terminated
+        if (self->_isTerminated || self->_isClosed) {
+            return [reactor stop];
+        }
+        
+        if (self->_needsDisplay) {
+            [self _drawFrameWithBlock:block];
+        }
     }];
     
-    while (isRunning) {
-        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 5, YES);
-    }
-
-    CFRunLoopRemoveSource(callerRunLoop, wakeUpSource, kCFRunLoopCommonModes);
-    CFRelease(wakeUpSource);
+    [self _closeWindow];
     
-    dispatch_source_cancel(sigIntSource);
-    dispatch_source_cancel(sigTermSource);
-    dispatch_source_cancel(sigResizeSource);
+    // Cancel sources (restoring default termination signals)
+    _reactor = nil;
+    _frameTimer = nil;
+    [reactor invalidate];
+}
+
+- (void)_startReadingKeysWithReactor:(EMReactor *)reactor {
+    // The reactor retains the source until it's cancelled (or invalidated), so the handler only needs a weak reference to it
+    __block __weak EMReactorSource *weakKeySource = nil;
     
-    // Restore default termination signals
-    {
-        struct sigaction action = { 0 };
-        action.sa_handler = SIG_DFL;
-        sigaction(SIGINT, &action, NULL);
-        sigaction(SIGTERM, &action, NULL);
-    }
+    weakKeySource = [reactor addReadableFileDescriptor:STDIN_FILENO handler:^{
+        char bytes[64];
+        ssize_t length = read(STDIN_FILENO, bytes, sizeof(bytes));
+        
+        if (length <= 0) {
+            // Stop reading once input is closed
+            if (length == 0 || errno != EAGAIN) {
+                [weakKeySource cancel];
+            }
+            return;
+        }
+        
+        _EMWindowEnumerateKeys(bytes, (size_t)length, ^(EMWindowKey key) {
+            if (self.keyHandler != nil) {
+                self.keyHandler(key);
+            }
+        });
+    }];
 }
 
-- (void)_runDrawLoopBlock:(void(^)(id <EMWindowWriter> output))block {
+- (void)_openWindow {
+    if (_canvas != nil) {
+        _buffer = [[EMWindowBuffer alloc] initWithCanvas:_canvas];
+        return;
+    }
+    
     // Initialize window
-    WINDOW *main = initscr();
+    _mainWindow = initscr();
     curs_set(0);
+    cbreak();
+    noecho();
     
     if (!YDCommandOutputStyleDisabled && has_colors()) {
         start_color();
@@ -160,27 +253,66 @@
             }
         }
     }
+}
+
+- (void)_closeWindow {
+    if (_canvas != nil) {
+        _buffer = nil;
+        return;
+    }
     
-    WINDOW *w = NULL;
-    
-    do {
-        // Wait until a draw event if we've already drawn our window
-        if (w != NULL && CFRunLoopRunInMode(kCFRunLoopDefaultMode, 5, true) == kCFRunLoopRunTimedOut) {
-            continue;
-        }
+    if (_contentWindow != NULL) {
+        werase(_contentWindow);
+        wnoutrefresh(_contentWindow);
+        delwin(_contentWindow);
         
-        // Break when closed / terminated
-        if (_isTerminated || _isClosed) {
-            break;
-        }
+        _contentWindow = NULL;
+        _buffer = nil;
+    }
+    
+    werase(_mainWindow);
+    wnoutrefresh(_mainWindow);
+    doupdate();
+    endwin();
+    
+    _mainWindow = NULL;
+}
+
+- (void)_drawFrameWithBlock:(void(^)(id <EMWindowWriter> output))block {
+    // Wait out the remainder of the frame budget so that bursts of events result in a single redraw
+    if (_maximumFramesPerSecond > 0 && _lastFrameTime > 0) {
+        CFTimeInterval remainingTime = (1.0 / _maximumFramesPerSecond) - (CFAbsoluteTimeGetCurrent() - _lastFrameTime);
         
-        if (_needsResize) {
-            struct winsize ws;
-            ioctl(0, TIOCGWINSZ, &ws);
-            resize_term(ws.ws_row, ws.ws_col);
+        if (remainingTime > 0) {
+            if (_frameTimer == nil) {
+                _frameTimer = [_reactor addTimerWithInterval:remainingTime repeats:NO handler:^{ self->_frameTimer = nil; }];
+            }
             
-            [self _setNeedsResize:NO];
+            return;
         }
+    }
+    
+    _needsDisplay = NO;
+    
+    if (_canvas != nil) {
+        return [self _drawContentsWithBlock:block width:_canvas.numberOfColumns height:_canvas.numberOfRows];
+    }
+    
+    if (_needsResize) {
+        struct winsize ws;
+        ioctl(0, TIOCGWINSZ, &ws);
+        resize_term(ws.ws_row, ws.ws_col);
+        
+        _needsChrome = YES;
+        _needsResize = NO;
+    }
+    
+    // Only redraw the outer window when its contents or geometry have changed. The inner window
+    // is redrawn row-by-row by our buffer, so we never need to clear the entire screen.
+    if (_needsChrome) {
+        _needsChrome = NO;
+        
+        WINDOW *main = _mainWindow;
         
         // Calculate screen / window boundaries
         int screenHeight = getmaxy(main);
@@ -189,17 +321,20 @@
         int winY = (_drawsBorder ? 1 : 0) + (_title ? 1 : 0);
         int winX = _drawsBorder ? 2 : 0;
         
-        int winHeight = screenHeight - winY*2;
-        int winWidth = screenWidth - winX*2;
+        int winHeight = MAX(screenHeight - winY*2, 1);
+        int winWidth = MAX(screenWidth - winX*2, 1);
         
-        if (w == NULL) {
-            w = newwin(winY, winX, winHeight, winWidth);
+        if (_contentWindow == NULL) {
+            _contentWindow = newwin(winHeight, winWidth, winY, winX);
+            _buffer = [[EMWindowBuffer alloc] initWithCanvas:[[_EMCursesCanvas alloc] initWithWindow:_contentWindow]];
         } else {
-            mvwin(w, winY, winX);
-            wresize(w, winHeight, winWidth);
+            wresize(_contentWindow, winHeight, winWidth);
+            mvwin(_contentWindow, winY, winX);
+            werase(_contentWindow);
+            [_buffer invalidate];
         }
         
-        wclear(main);
+        werase(main);
         
         // Draw outer window chrome
         if (_drawsBorder) {
@@ -208,50 +343,33 @@
         
         if (_title) {
             wattrset(main, A_STANDOUT);
-            mvwprintw(main, 0, (screenWidth - (int)_title.length - 2) / 2, " %s ", [_title UTF8String]);
+            mvwprintw(main, 0, (screenWidth - (int)EMDisplayWidth(_title) - 2) / 2, " %s ", [_title UTF8String]);
             wattrset(main, 0);
         }
         
         if (_status) {
-            mvwprintw(main, screenHeight - 1, (screenWidth - (int)_status.length - 2) / 2, " %s ", [_status UTF8String]);
-        }
-        
-        // Draw window contents using a pipe to our writer on the main thread
-        @autoreleasepool {
-            __block NSData *data = nil;
-            
-            // Invoke block from the main thread
-            dispatch_sync(dispatch_get_main_queue(), ^ {
-                data = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> pipe) {
-                    block((id<EMWindowWriter>) [[_EMWindowWriter alloc] initWithWindow:w output:pipe]);
-                }];
-            });
-            
-            NSString *contents = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"";
-            
-            wclear(w);
-            wattrset(w, 0);
-            
-            YDCommandOutputStyleStringEnumerateUsingBlock(contents, ^(NSString *substring, YDCommandOutputStyle *style, BOOL *stop) {
-                if (style != NULL) {
-                    wattrset(w, _windowAttributes(*style));
-                } else {
-                    wprintw(w, "%s", [substring UTF8String]);
-                }
-            });
+            mvwprintw(main, screenHeight - 1, (screenWidth - (int)EMDisplayWidth(_status) - 2) / 2, " %s ", [_status UTF8String]);
         }
         
-        // Refresh the screen
-        wrefresh(main);
-        wrefresh(w);
-    } while (true);
-    
-    if (w != NULL) {
-        wclear(w);
+        wnoutrefresh(main);
     }
     
-    wclear(main);
-    endwin();
+    [self _drawContentsWithBlock:block width:(NSUInteger)MAX(getmaxx(_contentWindow) - 1, 0) height:(NSUInteger)MAX(getmaxy(_contentWindow), 0)];
+    
+    // Refresh the screen with a single update
+    wnoutrefresh(_contentWindow);
+    doupdate();
+}
+
+- (void)_drawContentsWithBlock:(void(^)(id <EMWindowWriter> output))block width:(NSUInteger)width height:(NSUInteger)height {
+    // Draw window contents by writing spans to a buffer
+    EMWindowSpanBuffer *contents = [EMWindowSpanBuffer new];
+    block((id<EMWindowWriter>) [[_EMWindowWriter alloc] initWithBuffer:contents width:width height:height style:0]);
+    
+    // Only rows which differ from the previous frame are drawn
+    [_buffer drawLines:contents.lines];
+    
+    _lastFrameTime = CFAbsoluteTimeGetCurrent();
 }
 
 #pragma mark -
@@ -281,196 +399,142 @@ static int _windowAttributes(YDCommandOutputStyle style) {
     return attrs;
 }
 
-static void _NOOPRunLoop(void *info) {}
+@end
 
-- (void)_detachRunLoopWithinBlock:(void(^)(void))block {
-    [NSThread detachNewThreadWithBlock:^{
-        @autoreleasepool {
-            // Create a source which we can use to wake the thread up
-            CFRunLoopRef runLoop = CFRunLoopGetCurrent();
-            CFRunLoopSourceContext runLoopSourceCtx = { .perform = &_NOOPRunLoop };
-            CFRunLoopSourceRef runLoopSource = CFRunLoopSourceCreate(NULL, 0, &runLoopSourceCtx);
 
-            CFRunLoopAddSource(runLoop, runLoopSource, kCFRunLoopCommonModes);
-            CFRunLoopWakeUp(runLoop);
-            
-            // Signal the source so the first run of our loop will always return immediately
-            CFRunLoopSourceSignal(runLoopSource);
-
-            // Set block to wake up the runloop
-            dispatch_sync(self._q, ^{
-                self._wakeUpBlock = ^{
-                    CFRunLoopSourceSignal(runLoopSource);
-                    CFRunLoopWakeUp(runLoop);
-                };
-            });
-            
-            block();
-            
-            // Remove wake up block
-            dispatch_sync(self._q, ^{ self._wakeUpBlock = nil; });
-            
-            // Remove source
-            CFRunLoopRemoveSource(runLoop, runLoopSource, kCFRunLoopCommonModes);
-            CFRelease(runLoopSource);
-        }
-    }];
+@implementation _EMCursesCanvas
+
+- (instancetype)initWithWindow:(WINDOW *)w {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _window = w;
+    
+    return self;
 }
 
-- (void)_wakeUp {
-    dispatch_async(_q, ^{
-        if (self._wakeUpBlock != nil) {
-            self._wakeUpBlock();
-        }
-    });
+- (NSUInteger)numberOfColumns {
+    return (NSUInteger)MAX(getmaxx(_window), 0);
+}
+
+- (NSUInteger)numberOfRows {
+    return (NSUInteger)MAX(getmaxy(_window), 0);
+}
+
+- (void)clearRow:(NSUInteger)row {
+    wattrset(_window, 0);
+    wmove(_window, (int)row, 0);
+    wclrtoeol(_window);
+}
+
+- (void)drawString:(NSString *)string withStyle:(YDCommandOutputStyle)style atRow:(NSUInteger)row column:(NSUInteger)column {
+    wattrset(_window, _windowAttributes(style));
+    mvwaddstr(_window, (int)row, (int)column, [string UTF8String]);
 }
 
 @end
 
 
-@implementation _EMWindowWriter
+@implementation _EMWindowWriter {
+    YDCommandOutputStyle _style;
+}
 
-- (instancetype)initWithWindow:(WINDOW *)w output:(id <YDCommandOutputWriter>)output {
+- (instancetype)initWithBuffer:(EMWindowSpanBuffer *)buffer width:(NSUInteger)width height:(NSUInteger)height style:(YDCommandOutputStyle)style {
     self = [super init];
     if (self == nil)
         return nil;
     
-    _window = w;
-    _output = output;
+    _buffer = buffer;
+    _width = width;
+    _height = height;
+    _style = style;
     
     return self;
 }
 
-#pragma mark - YDCommandOutputWriter Proxy
-
-- (NSMethodSignature *)methodSignatureForSelector:(SEL)aSelector {
-    return [super methodSignatureForSelector:aSelector] ?: [(id)_output methodSignatureForSelector:aSelector];
+/*! Create a writer for a nested block whose spans are appended to the receiver's buffer once the block has finished */
+- (_EMWindowWriter *)_nestedWriter {
+    return [[_EMWindowWriter alloc] initWithBuffer:[_buffer bufferWithSharedArena] width:_width height:_height style:_style];
 }
 
-- (void)forwardInvocation:(NSInvocation *)invocation {
-    if ([(id)_output respondsToSelector:invocation.selector])
-        [invocation invokeWithTarget:_output];
-    else {
-        [super forwardInvocation:invocation];
-    }
-}
+#pragma mark - YDCommandOutputWriter
 
-#pragma mark -
+- (void)appendString:(NSString *)string {
+    [_buffer appendString:string withStyle:_style];
+}
 
-- (void)applyAlignment:(EMWindowTextAlignment)alignment withinBlock:(YDCommandOutputWriterBlock)block {
-    if (alignment == EMWindowTextAlignmentLeft) {
-        return block(_output);
-    }
-    
-    NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:block];
-    NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"";
-    NSUInteger windowWidth = MAX(getmaxx(_window) - 1, 0);
-    
-    if (windowWidth == 0) {
-        return [_output appendString:string];
-    }
+- (void)appendFormat:(NSString *)format, ... {
+    va_list args;
+    va_start(args, format);
+    NSString *string = [[NSString alloc] initWithFormat:format arguments:args];
+    va_end(args);
     
-    // Align each line captured by the block
-    [self _enumerateLinesInString:string usingBlock:^(NSString *line, NSString *linebreak, BOOL *stop) {
-        __block NSUInteger lineLength = 0;
-
-        // Discard color strings when calculating the line length (as they're invisible)
-        YDCommandOutputStyleStringEnumerateUsingBlock(line, ^(NSString *substring, YDCommandOutputStyle *style, BOOL *stop) {
-            if (style == NULL) {
-                lineLength += substring.length;
-            }
-        });
-        
-        // Calculate the padding needed for alignment based on the current window width
-        NSUInteger paddingSize = 0;
-
-        if (lineLength > 0 && lineLength < windowWidth) {
-            if (alignment == EMWindowTextAlignmentRight) {
-                paddingSize = windowWidth - lineLength;
-            } else if (alignment == EMWindowTextAlignmentCenter) {
-                paddingSize = (windowWidth - lineLength) / 2;
-            }
-        }
-        
-        // Pad the line using unstyled output; otherwise our padding may include background colors which would look weird
-        if (paddingSize > 0) {
-            [self.output applyStyle:0 withinBlock:^(id<YDCommandOutputWriter> unstyledOutput) {
-                [unstyledOutput appendString:[@"" stringByPaddingToLength:paddingSize withString:@" " startingAtIndex:0]];
-            }];
-        }
-        
-        // Truncate the line to fit the window
-        [self _appendTruncatedLine:line withEllipsis:YES];
-        
-        // Add the linebreak (don't assume \n)
-        [self.output appendString:linebreak];
-    }];
+    [_buffer appendString:string withStyle:_style];
 }
 
-- (void)applyTruncationWithinBlock:(YDCommandOutputWriterBlock)block {
-    NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:block];
-    NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"";
-    NSUInteger windowWidth = MAX(getmaxx(_window) - 1, 0);
+- (void)applyStyle:(YDCommandOutputStyle)style withinBlock:(YDCommandOutputWriterBlock)block {
+    YDCommandOutputStyle previousStyle = _style;
     
-    if (windowWidth == 0) {
-        return [_output appendString:string];
-    }
+    _style = style;
+    block((id<YDCommandOutputWriter>) self);
+    _style = previousStyle;
+}
+
+- (void)applyTabWidth:(NSUInteger)tabWidth withinBlock:(YDCommandOutputWriterBlock)block {
+    _EMWindowWriter *writer = [self _nestedWriter];
+    block((id<YDCommandOutputWriter>) writer);
     
-    // Truncate each line in the string captured by our block
-    [self _enumerateLinesInString:string usingBlock:^(NSString *line, NSString *linebreak, BOOL *stop) {
-        [self _appendTruncatedLine:line withEllipsis:YES];
-        [self.output appendString:linebreak];
-    }];
+    [_buffer appendBuffer:writer.buffer withTabWidth:tabWidth];
 }
 
-- (void)_appendTruncatedLine:(NSString *)line withEllipsis:(BOOL)ellipsis {
-    if (line.length == 0) {
-        return;
+#pragma mark - YDCommandOutputWriter Fallback
+
+// Methods we don't handle natively (i.e. JSON output) are written to a pipe, whose contents are parsed into spans
+
+- (NSMethodSignature *)methodSignatureForSelector:(SEL)aSelector {
+    return [super methodSignatureForSelector:aSelector] ?: [(id)YDStandardOut methodSignatureForSelector:aSelector];
+}
+
+- (void)forwardInvocation:(NSInvocation *)invocation {
+    if (![(id)YDStandardOut respondsToSelector:invocation.selector]) {
+        return [super forwardInvocation:invocation];
     }
     
-    // Calculate the window width and return if the terminal isn't defined
-    NSUInteger windowWidth = MAX(getmaxx(_window) - (ellipsis ? 2 : 1), 0);
-    if (windowWidth == 0) {
-        return [_output appendString:line];
-    }
+    NSData *data = [YDCommandOutput UTF8DataCapturedByBlock:^(id<YDCommandOutputWriter> pipe) {
+        [invocation invokeWithTarget:pipe];
+    }];
     
-    // Calculate line length without including styled strings as they don't affect the text column width
-    __block NSUInteger lineLength = 0;
+    __block YDCommandOutputStyle currentStyle = _style;
     
-    YDCommandOutputStyleStringEnumerateUsingBlock(line, ^(NSString *substring, YDCommandOutputStyle *style, BOOL *stop) {
+    YDCommandOutputStyleStringEnumerateUsingBlock([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"", ^(NSString *substring, YDCommandOutputStyle *style, BOOL *stop) {
         if (style != NULL) {
-            // Always append style strings, otherwise our styling will become corrupted
-            [self.output appendString:substring];
-        } else if (lineLength < windowWidth) {
-            // Append text content as long as it fits the window
-            NSString *chunk = [substring substringToIndex:MIN(substring.length, windowWidth - lineLength)];
-            [self.output appendString:chunk];
-            lineLength += chunk.length;
-            
-            // If our text has been truncated, add an ellipsis
-            if (chunk.length < substring.length && ellipsis) {
-                [self.output appendString:@"…"];
-            }
+            currentStyle = *style;
+        } else {
+            [self.buffer appendString:substring withStyle:currentStyle];
         }
     });
 }
 
-/*! Enumerate lines in a string along with the value which caused the line to break (don't assume \n) */
-- (void)_enumerateLinesInString:(NSString *)string usingBlock:(void(^)(NSString *line, NSString *linebreak, BOOL *stop))block {
-    NSRange range = NSMakeRange(0, 0);
-    BOOL stop = NO;
+#pragma mark - EMWindowWriter
+
+- (void)applyAlignment:(EMWindowTextAlignment)alignment withinBlock:(YDCommandOutputWriterBlock)block {
+    if (alignment == EMWindowTextAlignmentLeft) {
+        return block((id<YDCommandOutputWriter>) self);
+    }
     
-    do {
-        NSUInteger lineStart, lineEnd, contentsEnd;
-        [string getLineStart:&lineStart end:&lineEnd contentsEnd:&contentsEnd forRange:range];
-        
-        NSString *line = [string substringWithRange:NSMakeRange(lineStart, contentsEnd - lineStart)];
-        NSString *linebreak = [string substringWithRange:NSMakeRange(contentsEnd, lineEnd - contentsEnd)];
-        
-        block(line, linebreak, &stop);
-        
-        range.location = lineEnd;
-    } while (!stop && range.location < string.length);
+    _EMWindowWriter *writer = [self _nestedWriter];
+    block((id<YDCommandOutputWriter>) writer);
+    
+    // Padding is unstyled; otherwise it may include background colors which would look weird
+    [_buffer appendBuffer:writer.buffer withAlignment:alignment width:_width];
+}
+
+- (void)applyTruncationWithinBlock:(YDCommandOutputWriterBlock)block {
+    _EMWindowWriter *writer = [self _nestedWriter];
+    block((id<YDCommandOutputWriter>) writer);
+    
+    [_buffer appendBuffer:writer.buffer truncatedToWidth:_width];
 }
 
 @end
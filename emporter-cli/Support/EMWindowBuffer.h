@@ -0,0 +1,115 @@
+//
+//  EMWindowBuffer.h
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "YDCommandOutput.h"
+#import "EMWindow.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! A destination for rows drawn by \c EMWindowBuffer (i.e. a curses window, or a headless canvas used for testing) */
+@protocol EMWindowCanvas <NSObject>
+
+/*! The number of columns which can be drawn per row. Text exceeding the width is clipped. */
+@property(nonatomic,readonly) NSUInteger numberOfColumns;
+
+/*! The number of rows which can be drawn. Rows exceeding the height are discarded. */
+@property(nonatomic,readonly) NSUInteger numberOfRows;
+
+/*! Clear the contents of a row */
+- (void)clearRow:(NSUInteger)row;
+
+/*! Draw a string at a row/column using the given style */
+- (void)drawString:(NSString *)string withStyle:(YDCommandOutputStyle)style atRow:(NSUInteger)row column:(NSUInteger)column;
+
+@end
+
+
+/*! An immutable line of text with style runs. Lines are compared by value to determine which rows need to be redrawn. */
+@interface EMWindowLine : NSObject
+
+/*! Split a string containing style escapes into lines. Styles carry over between lines, just as they would in a terminal. */
++ (NSArray<EMWindowLine*> *)linesFromStyledString:(NSString *)string;
+
+/*! The visible text of the line */
+@property(nonatomic,readonly) NSString *text;
+
+/*! Enumerate the style runs in the line */
+- (void)enumerateRunsUsingBlock:(void(^)(NSString *text, YDCommandOutputStyle style, BOOL *stop))block;
+
+@end
+
+
+/*!
+ A buffer of styled text spans used to compose a frame without encoding (and later parsing) style escapes.
+ 
+ Text is appended to an arena which is shared by all buffers created using \c bufferWithSharedArena. Spans reference ranges
+ within the arena, so truncating, aligning or laying out spans from one buffer into another does not copy their text.
+ */
+@interface EMWindowSpanBuffer : NSObject
+
+/*! Create an empty buffer which appends text to the receiver's arena */
+- (EMWindowSpanBuffer *)bufferWithSharedArena;
+
+/*! Append a string using the given style. Line breaks (\n or \r\n) start a new line. */
+- (void)appendString:(NSString *)string withStyle:(YDCommandOutputStyle)style;
+
+/*! Append the spans of another buffer as-is */
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer;
+
+/*! Append the spans of another buffer, truncating each line with an ellipsis so that it fits within a width (or 0 to disable truncation) */
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer truncatedToWidth:(NSUInteger)width;
+
+/*! Append the spans of another buffer, padding each line (without styles) so that it's aligned within a width. Lines are also truncated to fit. */
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer withAlignment:(EMWindowTextAlignment)alignment width:(NSUInteger)width;
+
+/*! Append the spans of another buffer, replacing tabs with padding so that tab-separated columns line up across lines. Columns are separated by \c tabWidth spaces. */
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer withTabWidth:(NSUInteger)tabWidth;
+
+/*! Lines composed from the spans in the buffer */
+@property(nonatomic,readonly) NSArray<EMWindowLine*> *lines;
+
+@end
+
+
+/*! Statistics for a single frame drawn by \c EMWindowBuffer */
+typedef struct {
+    /*! The number of rows which were redrawn */
+    NSUInteger rows;
+    /*! The number of cells (columns) written */
+    NSUInteger cells;
+    /*! The number of (UTF-8) bytes written */
+    NSUInteger bytes;
+} EMWindowBufferFrameStatistics;
+
+
+/*! A retained buffer of lines which only redraws rows which have changed between frames. */
+@interface EMWindowBuffer : NSObject
+
+/*!
+ The designated initializer.
+ \param canvas The canvas used to draw rows
+ \returns A new instance of \c EMWindowBuffer.
+ */
+- (instancetype)initWithCanvas:(id <EMWindowCanvas>)canvas NS_DESIGNATED_INITIALIZER;
+
+/*! The canvas used to draw rows */
+@property(nonatomic,readonly) id <EMWindowCanvas> canvas;
+
+/*! Draw lines to the canvas, skipping rows which are identical to the previous frame. */
+- (void)drawLines:(NSArray<EMWindowLine*> *)lines;
+
+/*! Discard the retained frame so that the next call to \c drawLines: redraws every row (i.e. after the canvas is resized or cleared) */
+- (void)invalidate;
+
+/*! Statistics for the most recent frame */
+@property(nonatomic,readonly) EMWindowBufferFrameStatistics lastFrameStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,537 @@
+//
+//  EMWindowBuffer.m
+//  emporter-cli
+//
+//  Created by Mikey on 17/10/2026.
+//  Copyright © 2026 Young Dynasty. All rights reserved.
+//
+
+#include <string.h>
+
+#import "EMDisplayWidth.h"
+#import "EMWindowBuffer.h"
+
+
+typedef struct {
+    /*! The location of the span's UTF-8 text, in bytes */
+    NSUInteger location;
+    /*! The length of the span's UTF-8 text, in bytes */
+    NSUInteger length;
+    /*! The number of columns used to display the span's text */
+    NSUInteger width;
+    YDCommandOutputStyle style;
+    BOOL isLineBreak;
+} _EMWindowSpan;
+
+static const _EMWindowSpan _EMWindowLineBreakSpan = { .isLineBreak = YES };
+
+
+@interface EMWindowLine()
+- (instancetype)_initWithBytes:(NSData *)bytes runs:(NSData *)runs;
+@property(nonatomic,readonly) NSData *_bytes;
+@property(nonatomic,readonly) NSData *_runs;
+@end
+
+
+@implementation EMWindowLine {
+    NSString *_text;
+}
+@synthesize _bytes = _bytes;
+@synthesize _runs = _runs;
+
++ (NSArray<EMWindowLine *> *)linesFromStyledString:(NSString *)string {
+    EMWindowSpanBuffer *buffer = [EMWindowSpanBuffer new];
+    __block YDCommandOutputStyle currentStyle = 0;
+    
+    YDCommandOutputStyleStringEnumerateUsingBlock(string, ^(NSString *substring, YDCommandOutputStyle *style, BOOL *stop) {
+        if (style != NULL) {
+            currentStyle = *style;
+        } else {
+            [buffer appendString:substring withStyle:currentStyle];
+        }
+    });
+    
+    return buffer.lines;
+}
+
+- (instancetype)_initWithBytes:(NSData *)bytes runs:(NSData *)runs {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _bytes = [bytes copy];
+    _runs = [runs copy];
+    
+    return self;
+}
+
+- (NSString *)text {
+    // Lines are compared (and drawn) using their UTF-8 bytes, so text is only decoded when it's needed
+    if (_text == nil) {
+        _text = [[NSString alloc] initWithData:_bytes encoding:NSUTF8StringEncoding] ?: @"";
+    }
+    
+    return _text;
+}
+
+- (void)_enumerateRunsUsingBlock:(void (^)(const char *bytes, NSUInteger length, NSUInteger width, YDCommandOutputStyle style, BOOL *stop))block {
+    const char *bytes = _bytes.bytes;
+    const _EMWindowSpan *runs = _runs.bytes;
+    NSUInteger runCount = _runs.length / sizeof(_EMWindowSpan);
+    BOOL stop = NO;
+    
+    for (NSUInteger i = 0; i < runCount && !stop; i++) {
+        block(bytes + runs[i].location, runs[i].length, runs[i].width, runs[i].style, &stop);
+    }
+}
+
+- (void)enumerateRunsUsingBlock:(void (^)(NSString *, YDCommandOutputStyle, BOOL *))block {
+    [self _enumerateRunsUsingBlock:^(const char *bytes, NSUInteger length, NSUInteger width, YDCommandOutputStyle style, BOOL *stop) {
+        block([[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] ?: @"", style, stop);
+    }];
+}
+
+- (BOOL)isEqual:(id)object {
+    if (object == self) {
+        return YES;
+    } else if (![object isKindOfClass:[EMWindowLine class]]) {
+        return NO;
+    }
+    
+    EMWindowLine *otherLine = object;
+    return [_bytes isEqualToData:otherLine._bytes] && [_runs isEqualToData:otherLine._runs];
+}
+
+- (NSUInteger)hash {
+    return _bytes.hash;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p> %@", self.className, self, self.text];
+}
+
+@end
+
+
+@implementation EMWindowSpanBuffer {
+    NSMutableData *_arena;
+    NSMutableData *_spans;
+}
+
+- (instancetype)init {
+    return [self _initWithArena:[NSMutableData data]];
+}
+
+- (instancetype)_initWithArena:(NSMutableData *)arena {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _arena = arena;
+    _spans = [NSMutableData data];
+    
+    return self;
+}
+
+- (EMWindowSpanBuffer *)bufferWithSharedArena {
+    return [[EMWindowSpanBuffer alloc] _initWithArena:_arena];
+}
+
+#pragma mark - Appending
+
+- (void)_appendSpan:(_EMWindowSpan)span {
+    if (!span.isLineBreak && span.length == 0) {
+        return;
+    }
+    
+    NSUInteger spanCount = _spans.length / sizeof(_EMWindowSpan);
+    _EMWindowSpan *lastSpan = spanCount > 0 ? ((_EMWindowSpan *)_spans.mutableBytes) + spanCount - 1 : NULL;
+    
+    // Merge contiguous spans which share the same style
+    if (!span.isLineBreak && lastSpan != NULL && !lastSpan->isLineBreak && lastSpan->style == span.style && NSMaxRange(NSMakeRange(lastSpan->location, lastSpan->length)) == span.location) {
+        lastSpan->length += span.length;
+        lastSpan->width += span.width;
+    } else {
+        [_spans appendBytes:&span length:sizeof(span)];
+    }
+}
+
+- (void)_appendPadding:(NSUInteger)length {
+    static const char spaces[] = "                                                                                                                                ";
+    
+    while (length > 0) {
+        NSUInteger chunkLength = MIN(length, sizeof(spaces) - 1);
+        [self _appendSpan:(_EMWindowSpan){ .location = _arena.length, .length = chunkLength, .width = chunkLength }];
+        [_arena appendBytes:spaces length:chunkLength];
+        length -= chunkLength;
+    }
+}
+
+- (void)appendString:(NSString *)string withStyle:(YDCommandOutputStyle)style {
+    const char *utf8 = string.UTF8String ?: "";
+    NSUInteger length = strlen(utf8);
+    NSUInteger arenaLocation = _arena.length;
+    NSUInteger lineStart = 0;
+    
+    [_arena appendBytes:utf8 length:length];
+    
+    while (lineStart <= length) {
+        const char *lineBreak = memchr(utf8 + lineStart, '\n', length - lineStart);
+        NSUInteger lineEnd = lineBreak == NULL ? length : (NSUInteger)(lineBreak - utf8);
+        
+        // Don't assume \n
+        NSUInteger textEnd = lineEnd;
+        if (lineBreak != NULL && textEnd > lineStart && utf8[textEnd - 1] == '\r') {
+            textEnd--;
+        }
+        
+        [self _appendSpan:(_EMWindowSpan){ .location = arenaLocation + lineStart, .length = textEnd - lineStart, .width = EMDisplayWidthOfUTF8(utf8 + lineStart, textEnd - lineStart), .style = style }];
+        
+        if (lineBreak == NULL) {
+            break;
+        }
+        
+        [self _appendSpan:_EMWindowLineBreakSpan];
+        lineStart = lineEnd + 1;
+    }
+}
+
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer {
+    NSAssert(buffer->_arena == _arena, @"Buffers must share the same arena");
+    
+    const _EMWindowSpan *spans = buffer->_spans.bytes;
+    NSUInteger spanCount = buffer->_spans.length / sizeof(_EMWindowSpan);
+    
+    for (NSUInteger i = 0; i < spanCount; i++) {
+        [self _appendSpan:spans[i]];
+    }
+}
+
+#pragma mark - Layout
+
+/*! Enumerate lines of spans (excluding line breaks) */
+- (void)_enumerateLinesUsingBlock:(void(^)(const _EMWindowSpan *spans, NSUInteger spanCount, BOOL hasLineBreak))block {
+    const _EMWindowSpan *spans = _spans.bytes;
+    NSUInteger spanCount = _spans.length / sizeof(_EMWindowSpan);
+    NSUInteger lineStart = 0;
+    
+    for (NSUInteger i = 0; i < spanCount; i++) {
+        if (spans[i].isLineBreak) {
+            block(spans + lineStart, i - lineStart, YES);
+            lineStart = i + 1;
+        }
+    }
+    
+    if (lineStart < spanCount) {
+        block(spans + lineStart, spanCount - lineStart, NO);
+    }
+}
+
+static NSUInteger _EMWindowSpansWidth(const _EMWindowSpan *spans, NSUInteger spanCount) {
+    NSUInteger width = 0;
+    
+    for (NSUInteger i = 0; i < spanCount; i++) {
+        width += spans[i].width;
+    }
+    
+    return width;
+}
+
+static NSUInteger _EMWindowSpansLength(const _EMWindowSpan *spans, NSUInteger spanCount) {
+    NSUInteger length = 0;
+    
+    for (NSUInteger i = 0; i < spanCount; i++) {
+        length += spans[i].length;
+    }
+    
+    return length;
+}
+
+- (void)_appendSpans:(const _EMWindowSpan *)spans count:(NSUInteger)spanCount truncatedToWidth:(NSUInteger)width {
+    if (width == 0 || _EMWindowSpansWidth(spans, spanCount) <= width) {
+        for (NSUInteger i = 0; i < spanCount; i++) {
+            [self _appendSpan:spans[i]];
+        }
+        
+        return;
+    }
+    
+    // Leave room for an ellipsis
+    NSUInteger remainingWidth = width - 1;
+    
+    for (NSUInteger i = 0; i < spanCount; i++) {
+        _EMWindowSpan span = spans[i];
+        
+        if (span.width <= remainingWidth) {
+            [self _appendSpan:span];
+            remainingWidth -= span.width;
+            continue;
+        }
+        
+        // Truncate without splitting grapheme clusters (i.e. wide characters or emoji sequences)
+        span.length = EMDisplayPrefixLengthOfUTF8((const char *)_arena.bytes + span.location, span.length, remainingWidth, &span.width);
+        [self _appendSpan:span];
+        
+        static const char ellipsis[] = "…";
+        _EMWindowSpan ellipsisSpan = { .location = _arena.length, .length = sizeof(ellipsis) - 1, .width = 1, .style = span.style };
+        [_arena appendBytes:ellipsis length:ellipsisSpan.length];
+        [self _appendSpan:ellipsisSpan];
+        
+        break;
+    }
+}
+
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer truncatedToWidth:(NSUInteger)width {
+    NSAssert(buffer->_arena == _arena, @"Buffers must share the same arena");
+    
+    [buffer _enumerateLinesUsingBlock:^(const _EMWindowSpan *spans, NSUInteger spanCount, BOOL hasLineBreak) {
+        [self _appendSpans:spans count:spanCount truncatedToWidth:width];
+        
+        if (hasLineBreak) {
+            [self _appendSpan:_EMWindowLineBreakSpan];
+        }
+    }];
+}
+
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer withAlignment:(EMWindowTextAlignment)alignment width:(NSUInteger)width {
+    NSAssert(buffer->_arena == _arena, @"Buffers must share the same arena");
+    
+    [buffer _enumerateLinesUsingBlock:^(const _EMWindowSpan *spans, NSUInteger spanCount, BOOL hasLineBreak) {
+        NSUInteger lineWidth = _EMWindowSpansWidth(spans, spanCount);
+        NSUInteger padding = 0;
+        
+        if (lineWidth > 0 && lineWidth < width) {
+            switch (alignment) {
+                case EMWindowTextAlignmentLeft:
+                    break;
+                case EMWindowTextAlignmentRight:
+                    padding = width - lineWidth;
+                    break;
+                case EMWindowTextAlignmentCenter:
+                    padding = (width - lineWidth) / 2;
+                    break;
+            }
+        }
+        
+        [self _appendPadding:padding];
+        [self _appendSpans:spans count:spanCount truncatedToWidth:width - padding];
+        
+        if (hasLineBreak) {
+            [self _appendSpan:_EMWindowLineBreakSpan];
+        }
+    }];
+}
+
+/*! Enumerate tab-separated cells within a line of spans */
+- (void)_enumerateCellsInSpans:(const _EMWindowSpan *)spans count:(NSUInteger)spanCount usingBlock:(void(^)(NSUInteger column, NSUInteger width, BOOL isLastCell))block {
+    const char *arena = _arena.bytes;
+    NSUInteger column = 0;
+    NSUInteger cellWidth = 0;
+    
+    for (NSUInteger i = 0; i < spanCount; i++) {
+        const char *text = arena + spans[i].location;
+        const char *end = text + spans[i].length;
+        const char *tab = memchr(text, '\t', end - text);
+        
+        // Spans without tabs were measured when they were appended
+        if (tab == NULL) {
+            cellWidth += spans[i].width;
+            continue;
+        }
+        
+        while (tab != NULL) {
+            block(column++, cellWidth + EMDisplayWidthOfUTF8(text, tab - text), NO);
+            cellWidth = 0;
+            text = tab + 1;
+            tab = memchr(text, '\t', end - text);
+        }
+        
+        cellWidth += EMDisplayWidthOfUTF8(text, end - text);
+    }
+    
+    block(column, cellWidth, YES);
+}
+
+- (void)appendBuffer:(EMWindowSpanBuffer *)buffer withTabWidth:(NSUInteger)tabWidth {
+    NSAssert(buffer->_arena == _arena, @"Buffers must share the same arena");
+    
+    NSMutableData *columnWidthsData = [NSMutableData data];
+    
+    // Measure the widest cell within each column (excluding the last cell of each line, which isn't padded)
+    [buffer _enumerateLinesUsingBlock:^(const _EMWindowSpan *spans, NSUInteger spanCount, BOOL hasLineBreak) {
+        [self _enumerateCellsInSpans:spans count:spanCount usingBlock:^(NSUInteger column, NSUInteger width, BOOL isLastCell) {
+            if (isLastCell) {
+                return;
+            } else if (columnWidthsData.length < (column + 1) * sizeof(NSUInteger)) {
+                columnWidthsData.length = (column + 1) * sizeof(NSUInteger);
+            }
+            
+            NSUInteger *columnWidths = columnWidthsData.mutableBytes;
+            columnWidths[column] = MAX(columnWidths[column], width);
+        }];
+    }];
+    
+    const NSUInteger *columnWidths = columnWidthsData.bytes;
+    
+    [buffer _enumerateLinesUsingBlock:^(const _EMWindowSpan *spans, NSUInteger spanCount, BOOL hasLineBreak) {
+        NSUInteger column = 0;
+        NSUInteger cellWidth = 0;
+        
+        for (NSUInteger i = 0; i < spanCount; i++) {
+            _EMWindowSpan span = spans[i];
+            
+            while (span.length > 0) {
+                // Padding is appended to the arena, so its bytes must be read again after each cell
+                const char *text = (const char *)self->_arena.bytes + span.location;
+                const char *tab = memchr(text, '\t', span.length);
+                
+                if (tab == NULL) {
+                    [self _appendSpan:span];
+                    cellWidth += span.width;
+                    break;
+                }
+                
+                _EMWindowSpan cell = span;
+                cell.length = tab - text;
+                cell.width = EMDisplayWidthOfUTF8(text, cell.length);
+                [self _appendSpan:cell];
+                
+                [self _appendPadding:(columnWidths[column] - (cellWidth + cell.width)) + tabWidth];
+                column++;
+                cellWidth = 0;
+                
+                span.location += cell.length + 1;
+                span.length -= cell.length + 1;
+                span.width = EMDisplayWidthOfUTF8((const char *)self->_arena.bytes + span.location, span.length);
+            }
+        }
+        
+        if (hasLineBreak) {
+            [self _appendSpan:_EMWindowLineBreakSpan];
+        }
+    }];
+}
+
+#pragma mark - Lines
+
+- (NSArray<EMWindowLine *> *)lines {
+    NSMutableArray<EMWindowLine*> *lines = [NSMutableArray array];
+    const char *arena = _arena.bytes;
+    
+    [self _enumerateLinesUsingBlock:^(const _EMWindowSpan *spans, NSUInteger spanCount, BOOL hasLineBreak) {
+        NSMutableData *bytes = [NSMutableData dataWithCapacity:_EMWindowSpansLength(spans, spanCount)];
+        NSMutableData *runs = [NSMutableData dataWithCapacity:spanCount * sizeof(_EMWindowSpan)];
+        
+        for (NSUInteger i = 0; i < spanCount; i++) {
+            // Runs are compared byte-for-byte, so struct padding must be zeroed
+            _EMWindowSpan run;
+            bzero(&run, sizeof(run));
+            run.location = bytes.length;
+            run.length = spans[i].length;
+            run.width = spans[i].width;
+            run.style = spans[i].style;
+            
+            _EMWindowSpan *lastRun = runs.length > 0 ? ((_EMWindowSpan *)runs.mutableBytes) + (runs.length / sizeof(_EMWindowSpan)) - 1 : NULL;
+            
+            // Merge adjacent runs which share the same style (i.e. padding between unstyled cells)
+            if (lastRun != NULL && lastRun->style == run.style) {
+                lastRun->length += run.length;
+                lastRun->width += run.width;
+            } else {
+                [runs appendBytes:&run length:sizeof(run)];
+            }
+            
+            [bytes appendBytes:arena + spans[i].location length:spans[i].length];
+        }
+        
+        [lines addObject:[[EMWindowLine alloc] _initWithBytes:bytes runs:runs]];
+    }];
+    
+    return lines;
+}
+
+@end
+
+
+@implementation EMWindowBuffer {
+    NSArray<EMWindowLine*> *_lines;
+    BOOL _isInvalid;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init {
+    [NSException raise:NSInternalInconsistencyException format:@"-[%@ %@] cannot be called directly", self.className, NSStringFromSelector(_cmd)];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (instancetype)initWithCanvas:(id<EMWindowCanvas>)canvas {
+    self = [super init];
+    if (self == nil)
+        return nil;
+    
+    _canvas = canvas;
+    _lines = @[];
+    _isInvalid = YES;
+    
+    return self;
+}
+
+- (void)invalidate {
+    _isInvalid = YES;
+}
+
+- (void)drawLines:(NSArray<EMWindowLine *> *)lines {
+    NSUInteger numberOfRows = _canvas.numberOfRows;
+    NSUInteger numberOfColumns = _canvas.numberOfColumns;
+    NSUInteger lineCount = MIN(lines.count, numberOfRows);
+    NSUInteger rowCount = MAX(lineCount, MIN(_lines.count, numberOfRows));
+    
+    __block EMWindowBufferFrameStatistics stats = {0};
+    
+    for (NSUInteger row = 0; row < rowCount; row++) {
+        EMWindowLine *line = row < lineCount ? lines[row] : nil;
+        EMWindowLine *previousLine = row < _lines.count ? _lines[row] : nil;
+        
+        if (!_isInvalid && (line == previousLine || [line isEqual:previousLine])) {
+            continue;
+        }
+        
+        [_canvas clearRow:row];
+        stats.rows++;
+        
+        if (line == nil) {
+            continue;
+        }
+        
+        __block NSUInteger column = 0;
+        
+        [line _enumerateRunsUsingBlock:^(const char *bytes, NSUInteger length, NSUInteger width, YDCommandOutputStyle style, BOOL *stop) {
+            if (column >= numberOfColumns) {
+                (*stop) = YES;
+                return;
+            }
+            
+            // Clip text to fit the row without splitting grapheme clusters (i.e. wide characters or emoji sequences)
+            if (width > numberOfColumns - column) {
+                length = EMDisplayPrefixLengthOfUTF8(bytes, length, numberOfColumns - column, &width);
+            }
+            
+            NSString *text = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+            if (text != nil) {
+                [self.canvas drawString:text withStyle:style atRow:row column:column];
+            }
+            
+            column += width;
+            stats.cells += width;
+            stats.bytes += length;
+        }];
+    }
+    
+    _lines = [lines subarrayWithRange:NSMakeRange(0, lineCount)];
+    _lastFrameStatistics = stats;
+    _isInvalid = NO;
+}
+
+@end
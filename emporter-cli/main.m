@@ -13,8 +13,16 @@
 #import <locale.h>
 
 #import "EMMainCommand.h"
+#import "EMReactor.h"
+#import "EMStartupTrace.h"
 
 int main(int argc, const char * argv[]) {
+    EMStartupTraceMark(EMStartupPhaseMain);
+    
+    // Signals handled by reactors (the window's draw loop and EMBlockRunLoopRun) must be blocked before any threads are created
+    int reactorSignals[] = { SIGINT, SIGTERM, SIGWINCH, SIGUSR2 };
+    EMReactorBlockSignals(reactorSignals, sizeof(reactorSignals) / sizeof(*reactorSignals));
+    
     int erret = 0;
     if ((setupterm(NULL, 1, &erret) == ERR) || !has_colors()) {
         YDCommandOutputStyleDisabled = YES;
@@ -27,6 +35,7 @@ int main(int argc, const char * argv[]) {
     // Run main command in an autoreleasepool for any cleanup depending on dealloc
     @autoreleasepool {
         result = [[EMMainCommand new] run];
+        EMStartupTraceFinish();
     }
     
     return result;